@@ -436,7 +436,14 @@ struct OBSStudioAPI : obs_frontend_callbacks {
 					  Q_ARG(SavedProjectorInfo *, &proj));
 	}
 
-	void obs_frontend_save(void) override { main->SaveProject(); }
+	void obs_frontend_save(void) override
+	{
+		/* plugins can change anything, without a signal.  the saver
+		 * is gone once the exit event is sent */
+		if (main->saver)
+			main->saver->MarkAllChanged();
+		main->SaveProject();
+	}
 
 	void obs_frontend_defer_save_begin(void) override
 	{
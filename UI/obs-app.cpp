@@ -492,6 +492,15 @@ bool OBSApp::InitGlobalConfigDefaults()
 	config_set_default_bool(globalConfig, "BasicWindow",
 				"MultiviewDrawAreas", true);
 
+	config_set_default_int(globalConfig, "BasicWindow",
+			       "MultiviewThumbnailFPS", 10);
+
+	config_set_default_int(globalConfig, "BasicWindow",
+			       "MultiviewThumbnailsPerFrame", 4);
+
+	config_set_default_int(globalConfig, "BasicWindow",
+			       "RemuxParallelJobs", 2);
+
 #ifdef _WIN32
 	uint32_t winver = GetWindowsVersion();
 
@@ -2920,6 +2929,7 @@ int main(int argc, char *argv[])
 #endif
 
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+	bmem_log_tag_stats();
 	base_set_log_handler(nullptr, nullptr);
 	return ret;
 }
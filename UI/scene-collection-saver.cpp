@@ -0,0 +1,340 @@
+#include "scene-collection-saver.hpp"
+
+#include <util/array-serializer.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <cstring>
+
+using namespace std;
+
+#define FULL_SAVE_INTERVAL_NS 60000000000ULL
+
+/* signals that don't change anything that is saved */
+static const char *ignoredSignals[] = {
+	"activate",
+	"deactivate",
+	"show",
+	"hide",
+	"audio_activate",
+	"audio_deactivate",
+	"save",
+	"load",
+	"remove",
+	"update_properties",
+	"item_select",
+	"item_deselect",
+	"transition_start",
+	"transition_video_stop",
+	"transition_stop",
+};
+
+static bool SignalChangesSource(const char *signal)
+{
+	if (strncmp(signal, "media_", 6) == 0)
+		return false;
+
+	for (const char *ignored : ignoredSignals) {
+		if (strcmp(signal, ignored) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+SceneCollectionSaver::SceneCollectionSaver()
+	: thread(&SceneCollectionSaver::WriteThread, this)
+{
+}
+
+SceneCollectionSaver::~SceneCollectionSaver()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+
+	queueCond.notify_one();
+	thread.join();
+
+	vector<OBSWeakSourceAutoRelease> sources;
+	{
+		lock_guard<mutex> lock(cacheMutex);
+		for (auto &it : cache)
+			sources.push_back(move(it.second.weak));
+		cache.clear();
+	}
+
+	/* disconnect outside of the lock, as the signal callback locks it
+	 * while holding the signal handler's lock */
+	for (auto &weak : sources) {
+		OBSSourceAutoRelease source = obs_weak_source_get_source(weak);
+		if (source)
+			signal_handler_disconnect_global(
+				obs_source_get_signal_handler(source),
+				SourceSignal, this);
+	}
+
+	if (saves)
+		blog(LOG_INFO,
+		     "Scene collection saves: %zu, "
+		     "snapshot avg %.1f ms / max %.1f ms, "
+		     "write avg %.1f ms / max %.1f ms",
+		     saves, (double)snapshotTotal / saves / 1000000.0,
+		     (double)snapshotMax / 1000000.0,
+		     (double)writeTotal / saves / 1000000.0,
+		     (double)writeMax / 1000000.0);
+}
+
+void SceneCollectionSaver::SourceSignal(void *data, const char *signal,
+					calldata_t *params)
+{
+	SceneCollectionSaver *saver =
+		reinterpret_cast<SceneCollectionSaver *>(data);
+	obs_source_t *source = (obs_source_t *)calldata_ptr(params, "source");
+
+	if (!source)
+		return;
+
+	if (strcmp(signal, "destroy") == 0) {
+		lock_guard<mutex> lock(saver->cacheMutex);
+		saver->cache.erase(source);
+
+	} else if (strcmp(signal, "rename") == 0) {
+		/* other sources can refer to it by name, for example a
+		 * sidechain source in a compressor's settings */
+		saver->MarkAllChanged();
+
+	} else if (SignalChangesSource(signal)) {
+		saver->MarkChanged(source);
+	}
+}
+
+void SceneCollectionSaver::Track(obs_source_t *source)
+{
+	{
+		lock_guard<mutex> lock(cacheMutex);
+		if (cache.find(source) != cache.end())
+			return;
+
+		cache[source].weak = obs_source_get_weak_source(source);
+	}
+
+	signal_handler_connect_global(obs_source_get_signal_handler(source),
+				      SourceSignal, this);
+}
+
+void SceneCollectionSaver::MarkChanged(obs_source_t *source)
+{
+	lock_guard<mutex> lock(cacheMutex);
+
+	auto it = cache.find(source);
+	if (it == cache.end())
+		return;
+
+	it->second.data = nullptr;
+	it->second.changes++;
+
+	/* filters are saved as part of their parent */
+	if (obs_source_get_type(source) == OBS_SOURCE_TYPE_FILTER) {
+		it = cache.find(obs_filter_get_parent(source));
+		if (it != cache.end()) {
+			it->second.data = nullptr;
+			it->second.changes++;
+		}
+	}
+}
+
+void SceneCollectionSaver::MarkAllChanged()
+{
+	lock_guard<mutex> lock(cacheMutex);
+
+	for (auto &it : cache) {
+		it.second.data = nullptr;
+		it.second.changes++;
+	}
+}
+
+void SceneCollectionSaver::StartSave()
+{
+	uint64_t now = os_gettime_ns();
+
+	if (now - lastFullSave >= FULL_SAVE_INTERVAL_NS) {
+		MarkAllChanged();
+		lastFullSave = now;
+	}
+}
+
+static bool Cacheable(obs_source_t *source)
+{
+	/* scenes and groups also save their items, and most scene item
+	 * state has no signal.  they're cheap to save, so always save them */
+	if (obs_source_is_scene(source) || obs_source_is_group(source))
+		return false;
+
+	/* data saved by a plugin's own save callback can change at any
+	 * time, filters are saved as part of their parent */
+	bool cacheable = !obs_source_has_save_callback(source);
+	obs_source_enum_filters(
+		source,
+		[](obs_source_t *, obs_source_t *filter, void *param) {
+			if (obs_source_has_save_callback(filter))
+				*reinterpret_cast<bool *>(param) = false;
+		},
+		&cacheable);
+
+	return cacheable;
+}
+
+obs_data_t *SceneCollectionSaver::SaveSource(obs_source_t *source)
+{
+	uint64_t changes;
+
+	if (!Cacheable(source))
+		return obs_save_source(source);
+
+	Track(source);
+	obs_source_enum_filters(
+		source,
+		[](obs_source_t *, obs_source_t *filter, void *param) {
+			reinterpret_cast<SceneCollectionSaver *>(param)->Track(
+				filter);
+		},
+		this);
+
+	{
+		lock_guard<mutex> lock(cacheMutex);
+		CachedSource &cached = cache[source];
+
+		if (cached.data) {
+			obs_data_addref(cached.data);
+			return cached.data;
+		}
+
+		changes = cached.changes;
+	}
+
+	obs_data_t *data = obs_save_source(source);
+
+	/* only cache it if the source didn't change while saving it */
+	lock_guard<mutex> lock(cacheMutex);
+	auto it = cache.find(source);
+	if (it != cache.end() && it->second.changes == changes) {
+		obs_data_addref(data);
+		it->second.data = data;
+	}
+
+	return data;
+}
+
+obs_data_array_t *
+SceneCollectionSaver::SaveSources(const function<bool(obs_source_t *)> &filter)
+{
+	struct SaveSourcesData {
+		SceneCollectionSaver *saver;
+		const function<bool(obs_source_t *)> &filter;
+	};
+
+	SaveSourcesData data = {this, filter};
+
+	return obs_save_sources_custom(
+		[](void *param, obs_source_t *source) {
+			auto data = reinterpret_cast<SaveSourcesData *>(param);
+			return data->filter(source);
+		},
+		[](void *param, obs_source_t *source) {
+			auto data = reinterpret_cast<SaveSourcesData *>(param);
+			return data->saver->SaveSource(source);
+		},
+		&data);
+}
+
+void SceneCollectionSaver::Write(obs_data_t *data, const char *file,
+				 uint64_t start_ns)
+{
+	struct array_output_data output;
+	struct serializer s;
+	Snapshot snapshot;
+
+	array_output_serializer_init(&s, &output);
+	bool success = obs_data_write_binary(data, &s);
+
+	snapshot.file = file;
+	snapshot.data.assign(output.bytes.array,
+			     output.bytes.array + output.bytes.num);
+	snapshot.snapshot_ns = os_gettime_ns() - start_ns;
+	array_output_serializer_free(&output);
+
+	if (!success) {
+		blog(LOG_ERROR, "Could not save scene data to %s", file);
+		return;
+	}
+
+	lock_guard<mutex> lock(queueMutex);
+
+	/* a newer snapshot of the same file replaces a pending one */
+	if (!queue.empty() && queue.back().file == snapshot.file)
+		queue.back() = move(snapshot);
+	else
+		queue.push_back(move(snapshot));
+
+	queueCond.notify_one();
+}
+
+void SceneCollectionSaver::Flush()
+{
+	unique_lock<mutex> lock(queueMutex);
+	doneCond.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+void SceneCollectionSaver::WriteThread()
+{
+	os_set_thread_name("scene collection saver");
+
+	unique_lock<mutex> lock(queueMutex);
+
+	for (;;) {
+		queueCond.wait(lock,
+			       [this] { return stopping || !queue.empty(); });
+		if (queue.empty())
+			break;
+
+		Snapshot snapshot = move(queue.front());
+		queue.pop_front();
+		writing = true;
+		lock.unlock();
+
+		uint64_t start = os_gettime_ns();
+		struct array_input_data input;
+		struct serializer s;
+
+		array_input_serializer_init(&s, &input, snapshot.data.data(),
+					    snapshot.data.size());
+		OBSDataAutoRelease data = obs_data_create_from_binary(&s);
+		const char *file = snapshot.file.c_str();
+
+		if (!data || !obs_data_save_json_safe(data, file, "tmp", "bak"))
+			blog(LOG_ERROR, "Could not save scene data to %s",
+			     file);
+
+		uint64_t write_ns = os_gettime_ns() - start;
+
+		blog(LOG_DEBUG,
+		     "Saved scene collection to %s "
+		     "(snapshot: %.1f ms, write: %.1f ms)",
+		     file, (double)snapshot.snapshot_ns / 1000000.0,
+		     (double)write_ns / 1000000.0);
+
+		lock.lock();
+		saves++;
+		snapshotTotal += snapshot.snapshot_ns;
+		writeTotal += write_ns;
+		if (snapshot.snapshot_ns > snapshotMax)
+			snapshotMax = snapshot.snapshot_ns;
+		if (write_ns > writeMax)
+			writeMax = write_ns;
+
+		writing = false;
+		doneCond.notify_all();
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <obs.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Saves scene collections incrementally and in the background.
+ *
+ * The saved data of sources is cached and only regenerated for sources that
+ * signaled a change since.  Scenes, groups, and sources with a save callback
+ * are never cached, and state without a signal is marked changed by the
+ * code changing it.  The collection is snapshotted in binary on the UI
+ * thread, and converted to JSON and written to disk on a worker thread. */
+class SceneCollectionSaver {
+	struct CachedSource {
+		OBSWeakSourceAutoRelease weak;
+		OBSDataAutoRelease data;
+		uint64_t changes = 0;
+	};
+
+	struct Snapshot {
+		std::string file;
+		std::vector<uint8_t> data;
+		uint64_t snapshot_ns;
+	};
+
+	std::mutex cacheMutex;
+	std::unordered_map<obs_source_t *, CachedSource> cache;
+	uint64_t lastFullSave = 0;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCond;
+	std::condition_variable doneCond;
+	std::deque<Snapshot> queue;
+	bool writing = false;
+	bool stopping = false;
+
+	size_t saves = 0;
+	uint64_t snapshotTotal = 0;
+	uint64_t snapshotMax = 0;
+	uint64_t writeTotal = 0;
+	uint64_t writeMax = 0;
+
+	/* last, so it starts after everything else is initialized */
+	std::thread thread;
+
+	static void SourceSignal(void *data, const char *signal,
+				 calldata_t *params);
+
+	void Track(obs_source_t *source);
+	void WriteThread();
+
+public:
+	SceneCollectionSaver();
+	~SceneCollectionSaver();
+
+	/* called at the start of each save, saves every source in full now
+	 * and then, in case a change was missed */
+	void StartSave();
+
+	/* for changes to saved state that has no signal */
+	void MarkChanged(obs_source_t *source);
+	void MarkAllChanged();
+
+	/* returns the saved data of the source, with a reference */
+	obs_data_t *SaveSource(obs_source_t *source);
+	obs_data_array_t *
+	SaveSources(const std::function<bool(obs_source_t *)> &filter);
+
+	void Write(obs_data_t *data, const char *file, uint64_t start_ns);
+
+	/* waits for all pending writes to finish */
+	void Flush();
+};
@@ -9,8 +9,10 @@
 
 #include <obs-frontend-api.h>
 #include <obs.h>
+#include <util/profiler.hpp>
 
 #include <string>
+#include <algorithm>
 
 #include <QLabel>
 #include <QLineEdit>
@@ -20,6 +22,8 @@
 #include <QHBoxLayout>
 #include <QMouseEvent>
 #include <QAccessible>
+#include <QScrollBar>
+#include <QSet>
 
 #include <QStylePainter>
 #include <QStyleOptionFocusRect>
@@ -185,23 +189,7 @@ void SourceTreeItem::paintEvent(QPaintEvent *event)
 
 void SourceTreeItem::DisconnectSignals()
 {
-	sceneRemoveSignal.Disconnect();
-	itemRemoveSignal.Disconnect();
-	selectSignal.Disconnect();
-	deselectSignal.Disconnect();
-	visibleSignal.Disconnect();
-	lockedSignal.Disconnect();
 	renameSignal.Disconnect();
-	removeSignal.Disconnect();
-
-	if (obs_sceneitem_is_group(sceneitem))
-		groupReorderSignal.Disconnect();
-}
-
-void SourceTreeItem::Clear()
-{
-	DisconnectSignals();
-	sceneitem = nullptr;
 }
 
 void SourceTreeItem::ReconnectSignals()
@@ -213,92 +201,6 @@ void SourceTreeItem::ReconnectSignals()
 
 	/* --------------------------------------------------------- */
 
-	auto removeItem = [](void *data, calldata_t *cd) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		obs_sceneitem_t *curItem =
-			(obs_sceneitem_t *)calldata_ptr(cd, "item");
-
-		if (curItem == this_->sceneitem) {
-			QMetaObject::invokeMethod(this_->tree, "Remove",
-						  Q_ARG(OBSSceneItem, curItem));
-			curItem = nullptr;
-		}
-		if (!curItem)
-			QMetaObject::invokeMethod(this_, "Clear");
-	};
-
-	auto itemVisible = [](void *data, calldata_t *cd) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		obs_sceneitem_t *curItem =
-			(obs_sceneitem_t *)calldata_ptr(cd, "item");
-		bool visible = calldata_bool(cd, "visible");
-
-		if (curItem == this_->sceneitem)
-			QMetaObject::invokeMethod(this_, "VisibilityChanged",
-						  Q_ARG(bool, visible));
-	};
-
-	auto itemLocked = [](void *data, calldata_t *cd) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		obs_sceneitem_t *curItem =
-			(obs_sceneitem_t *)calldata_ptr(cd, "item");
-		bool locked = calldata_bool(cd, "locked");
-
-		if (curItem == this_->sceneitem)
-			QMetaObject::invokeMethod(this_, "LockedChanged",
-						  Q_ARG(bool, locked));
-	};
-
-	auto itemSelect = [](void *data, calldata_t *cd) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		obs_sceneitem_t *curItem =
-			(obs_sceneitem_t *)calldata_ptr(cd, "item");
-
-		if (curItem == this_->sceneitem)
-			QMetaObject::invokeMethod(this_, "Select");
-	};
-
-	auto itemDeselect = [](void *data, calldata_t *cd) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		obs_sceneitem_t *curItem =
-			(obs_sceneitem_t *)calldata_ptr(cd, "item");
-
-		if (curItem == this_->sceneitem)
-			QMetaObject::invokeMethod(this_, "Deselect");
-	};
-
-	auto reorderGroup = [](void *data, calldata_t *) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		QMetaObject::invokeMethod(this_->tree, "ReorderItems");
-	};
-
-	obs_scene_t *scene = obs_sceneitem_get_scene(sceneitem);
-	obs_source_t *sceneSource = obs_scene_get_source(scene);
-	signal_handler_t *signal = obs_source_get_signal_handler(sceneSource);
-
-	sceneRemoveSignal.Connect(signal, "remove", removeItem, this);
-	itemRemoveSignal.Connect(signal, "item_remove", removeItem, this);
-	visibleSignal.Connect(signal, "item_visible", itemVisible, this);
-	lockedSignal.Connect(signal, "item_locked", itemLocked, this);
-	selectSignal.Connect(signal, "item_select", itemSelect, this);
-	deselectSignal.Connect(signal, "item_deselect", itemDeselect, this);
-
-	if (obs_sceneitem_is_group(sceneitem)) {
-		obs_source_t *source = obs_sceneitem_get_source(sceneitem);
-		signal = obs_source_get_signal_handler(source);
-
-		groupReorderSignal.Connect(signal, "reorder", reorderGroup,
-					   this);
-	}
-
-	/* --------------------------------------------------------- */
-
 	auto renamed = [](void *data, calldata_t *cd) {
 		SourceTreeItem *this_ =
 			reinterpret_cast<SourceTreeItem *>(data);
@@ -308,18 +210,9 @@ void SourceTreeItem::ReconnectSignals()
 					  Q_ARG(QString, QT_UTF8(name)));
 	};
 
-	auto removeSource = [](void *data, calldata_t *) {
-		SourceTreeItem *this_ =
-			reinterpret_cast<SourceTreeItem *>(data);
-		this_->DisconnectSignals();
-		this_->sceneitem = nullptr;
-		QMetaObject::invokeMethod(this_->tree, "RefreshItems");
-	};
-
 	obs_source_t *source = obs_sceneitem_get_source(sceneitem);
-	signal = obs_source_get_signal_handler(source);
+	signal_handler_t *signal = obs_source_get_signal_handler(source);
 	renameSignal.Connect(signal, "rename", renamed, this);
-	removeSignal.Connect(signal, "remove", removeSource, this);
 }
 
 void SourceTreeItem::mouseDoubleClickEvent(QMouseEvent *event)
@@ -620,20 +513,6 @@ void SourceTreeItem::ExpandClicked(bool checked)
 		tree->GetStm()->CollapseGroup(sceneitem);
 }
 
-void SourceTreeItem::Select()
-{
-	tree->SelectItem(sceneitem, true);
-	OBSBasic::Get()->UpdateContextBarDeferred();
-	OBSBasic::Get()->UpdateEditMenu();
-}
-
-void SourceTreeItem::Deselect()
-{
-	tree->SelectItem(sceneitem, false);
-	OBSBasic::Get()->UpdateContextBarDeferred();
-	OBSBasic::Get()->UpdateEditMenu();
-}
-
 /* ========================================================================= */
 
 void SourceTreeModel::OBSFrontendEvent(enum obs_frontend_event event, void *ptr)
@@ -657,6 +536,8 @@ void SourceTreeModel::Clear()
 	items.clear();
 	endResetModel();
 
+	sceneSignals.clear();
+	signalSources.clear();
 	hasGroups = false;
 }
 
@@ -689,6 +570,8 @@ static bool enumItem(obs_scene_t *, obs_sceneitem_t *item, void *ptr)
 
 void SourceTreeModel::SceneChanged()
 {
+	ProfileScope("SourceTreeModel::SceneChanged");
+
 	OBSScene scene = GetCurrentScene();
 
 	beginResetModel();
@@ -699,14 +582,30 @@ void SourceTreeModel::SceneChanged()
 	UpdateGroupState(false);
 	st->ResetWidgets();
 
-	for (int i = 0; i < items.count(); i++) {
-		bool select = obs_sceneitem_selected(items[i]);
-		QModelIndex index = createIndex(i, 0);
+	SelectItems(0, items.count() - 1);
+}
 
-		st->selectionModel()->select(
-			index, select ? QItemSelectionModel::Select
-				      : QItemSelectionModel::Deselect);
+/* selects the rows of the given range whose scene items are selected, with a
+ * single selection change */
+void SourceTreeModel::SelectItems(int first, int last)
+{
+	QItemSelection selection;
+
+	for (int i = first; i <= last; i++) {
+		if (!obs_sceneitem_selected(items[i]))
+			continue;
+
+		int end = i;
+		while (end < last && obs_sceneitem_selected(items[end + 1]))
+			end++;
+
+		selection.select(createIndex(i, 0), createIndex(end, 0));
+		i = end;
 	}
+
+	if (!selection.isEmpty())
+		st->selectionModel()->select(selection,
+					     QItemSelectionModel::Select);
 }
 
 /* moves a scene item index (blame linux distros for using older Qt builds) */
@@ -718,88 +617,87 @@ static inline void MoveItem(QVector<OBSSceneItem> &items, int oldIdx,
 	items.insert(newIdx, item);
 }
 
-/* reorders list optimally with model reorder funcs */
+/* syncs the list with the scene, with fine-grained removes, inserts and moves
+ * rather than a reset, so the rows that didn't change keep their widgets */
 void SourceTreeModel::ReorderItems()
 {
+	ProfileScope("SourceTreeModel::ReorderItems");
+
 	OBSScene scene = GetCurrentScene();
 
 	QVector<OBSSceneItem> newitems;
 	obs_scene_enum_items(scene, enumItem, &newitems);
 
-	/* if item list has changed size, do full reset */
-	if (newitems.count() != items.count()) {
-		SceneChanged();
-		return;
-	}
+	QSet<obs_sceneitem_t *> newSet;
+	for (obs_sceneitem_t *item : newitems)
+		newSet.insert(item);
 
-	for (;;) {
-		int idx1Old = 0;
-		int idx1New = 0;
-		int count;
-		int i;
-
-		/* find first starting changed item index */
-		for (i = 0; i < newitems.count(); i++) {
-			obs_sceneitem_t *oldItem = items[i];
-			obs_sceneitem_t *newItem = newitems[i];
-			if (oldItem != newItem) {
-				idx1Old = i;
-				break;
-			}
-		}
+	/* remove items that are gone, adjacent rows at once */
+	for (int i = items.count() - 1; i >= 0; i--) {
+		if (newSet.contains(items[i]))
+			continue;
 
-		/* if everything is the same, break */
-		if (i == newitems.count()) {
-			break;
-		}
+		int last = i;
+		while (i > 0 && !newSet.contains(items[i - 1]))
+			i--;
 
-		/* find new starting index */
-		for (i = idx1Old + 1; i < newitems.count(); i++) {
-			obs_sceneitem_t *oldItem = items[idx1Old];
-			obs_sceneitem_t *newItem = newitems[i];
+		beginRemoveRows(QModelIndex(), i, last);
+		items.remove(i, last - i + 1);
+		endRemoveRows();
+	}
 
-			if (oldItem == newItem) {
-				idx1New = i;
-				break;
-			}
-		}
+	QSet<obs_sceneitem_t *> oldSet;
+	for (obs_sceneitem_t *item : items)
+		oldSet.insert(item);
 
-		/* if item could not be found, do full reset */
-		if (i == newitems.count()) {
-			SceneChanged();
-			return;
-		}
+	/* insert new items and move the others in place */
+	for (int i = 0; i < newitems.count(); i++) {
+		if (i < items.count() && items[i] == newitems[i])
+			continue;
 
-		/* get move count */
-		for (count = 1; (idx1New + count) < newitems.count(); count++) {
-			int oldIdx = idx1Old + count;
-			int newIdx = idx1New + count;
+		int count = 1;
 
-			obs_sceneitem_t *oldItem = items[oldIdx];
-			obs_sceneitem_t *newItem = newitems[newIdx];
+		if (!oldSet.contains(newitems[i])) {
+			while (i + count < newitems.count() &&
+			       !oldSet.contains(newitems[i + count]))
+				count++;
 
-			if (oldItem != newItem) {
-				break;
-			}
-		}
+			beginInsertRows(QModelIndex(), i, i + count - 1);
+			for (int j = 0; j < count; j++)
+				items.insert(i + j, newitems[i + j]);
+			endInsertRows();
 
-		/* move items */
-		beginMoveRows(QModelIndex(), idx1Old, idx1Old + count - 1,
-			      QModelIndex(), idx1New + count);
-		for (i = 0; i < count; i++) {
-			int to = idx1New + count;
-			if (to > idx1Old)
-				to--;
-			MoveItem(items, idx1Old, to);
+			SelectItems(i, i + count - 1);
+			i += count - 1;
+			continue;
 		}
+
+		int from = i + 1;
+		while (items[from] != newitems[i])
+			from++;
+
+		while (from + count < items.count() &&
+		       i + count < newitems.count() &&
+		       items[from + count] == newitems[i + count])
+			count++;
+
+		beginMoveRows(QModelIndex(), from, from + count - 1,
+			      QModelIndex(), i);
+		for (int j = 0; j < count; j++)
+			MoveItem(items, from + j, i + j);
 		endMoveRows();
+
+		i += count - 1;
 	}
+
+	UpdateGroupState(true);
+	st->UpdateWidgets();
 }
 
 void SourceTreeModel::Add(obs_sceneitem_t *item)
 {
 	if (obs_sceneitem_is_group(item)) {
-		SceneChanged();
+		ReorderItems();
 	} else {
 		beginInsertRows(QModelIndex(), 0, 0);
 		items.insert(0, item);
@@ -849,6 +747,170 @@ void SourceTreeModel::Remove(obs_sceneitem_t *item)
 		UpdateGroupState(true);
 }
 
+void SourceTreeModel::ConnectSceneSignals(obs_source_t *source, bool group)
+{
+	signal_handler_t *signal = obs_source_get_signal_handler(source);
+
+	auto itemRemove = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_sceneitem_t *item =
+			(obs_sceneitem_t *)calldata_ptr(cd, "item");
+
+		QMetaObject::invokeMethod(stm, "ItemRemoved",
+					  Q_ARG(OBSSceneItem, item));
+	};
+
+	auto itemVisible = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_sceneitem_t *item =
+			(obs_sceneitem_t *)calldata_ptr(cd, "item");
+		bool visible = calldata_bool(cd, "visible");
+
+		QMetaObject::invokeMethod(stm, "ItemVisible",
+					  Q_ARG(OBSSceneItem, item),
+					  Q_ARG(bool, visible));
+	};
+
+	auto itemLocked = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_sceneitem_t *item =
+			(obs_sceneitem_t *)calldata_ptr(cd, "item");
+		bool locked = calldata_bool(cd, "locked");
+
+		QMetaObject::invokeMethod(stm, "ItemLocked",
+					  Q_ARG(OBSSceneItem, item),
+					  Q_ARG(bool, locked));
+	};
+
+	auto itemSelect = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_sceneitem_t *item =
+			(obs_sceneitem_t *)calldata_ptr(cd, "item");
+
+		QMetaObject::invokeMethod(stm, "ItemSelected",
+					  Q_ARG(OBSSceneItem, item),
+					  Q_ARG(bool, true));
+	};
+
+	auto itemDeselect = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_sceneitem_t *item =
+			(obs_sceneitem_t *)calldata_ptr(cd, "item");
+
+		QMetaObject::invokeMethod(stm, "ItemSelected",
+					  Q_ARG(OBSSceneItem, item),
+					  Q_ARG(bool, false));
+	};
+
+	auto reorderGroup = [](void *data, calldata_t *) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		QMetaObject::invokeMethod(stm->st, "ReorderItems");
+	};
+
+	sceneSignals.emplace_back(signal, "item_remove", itemRemove, this);
+	sceneSignals.emplace_back(signal, "item_visible", itemVisible, this);
+	sceneSignals.emplace_back(signal, "item_locked", itemLocked, this);
+	sceneSignals.emplace_back(signal, "item_select", itemSelect, this);
+	sceneSignals.emplace_back(signal, "item_deselect", itemDeselect, this);
+
+	/* reordering the scene itself is handled by the main window */
+	if (group)
+		sceneSignals.emplace_back(signal, "reorder", reorderGroup,
+					  this);
+}
+
+void SourceTreeModel::ConnectSignals()
+{
+	OBSScene scene = GetCurrentScene();
+	std::vector<obs_source_t *> sources;
+
+	/* the scene first, then its groups, which are always in the list
+	 * even when collapsed */
+	if (scene) {
+		sources.push_back(obs_scene_get_source(scene));
+
+		for (auto &item : items) {
+			if (obs_sceneitem_is_group(item) &&
+			    obs_sceneitem_get_scene(item) == scene)
+				sources.push_back(
+					obs_sceneitem_get_source(item));
+		}
+	}
+
+	/* reconnecting is slow with many items, so only reconnect when the
+	 * scene or its set of groups changed */
+	auto connected = [this](obs_source_t *source) {
+		for (auto &weak : signalSources) {
+			if (obs_weak_source_references_source(weak, source))
+				return true;
+		}
+		return false;
+	};
+
+	if (sources.size() == signalSources.size() &&
+	    std::all_of(sources.begin(), sources.end(), connected))
+		return;
+
+	sceneSignals.clear();
+	signalSources.clear();
+
+	for (size_t i = 0; i < sources.size(); i++) {
+		ConnectSceneSignals(sources[i], i > 0);
+		signalSources.emplace_back(
+			obs_source_get_weak_source(sources[i]));
+	}
+}
+
+SourceTreeItem *SourceTreeModel::GetExistingWidget(obs_sceneitem_t *item)
+{
+	int idx = items.indexOf(item);
+	if (idx == -1)
+		return nullptr;
+
+	QWidget *widget = st->indexWidget(createIndex(idx, 0));
+	return reinterpret_cast<SourceTreeItem *>(widget);
+}
+
+void SourceTreeModel::ItemRemoved(OBSSceneItem item)
+{
+	if (items.indexOf(item) != -1)
+		st->Remove(item);
+}
+
+void SourceTreeModel::ItemVisible(OBSSceneItem item, bool visible)
+{
+	SourceTreeItem *widget = GetExistingWidget(item);
+	if (widget)
+		widget->VisibilityChanged(visible);
+}
+
+void SourceTreeModel::ItemLocked(OBSSceneItem item, bool locked)
+{
+	SourceTreeItem *widget = GetExistingWidget(item);
+	if (widget)
+		widget->LockedChanged(locked);
+}
+
+void SourceTreeModel::ItemSelected(OBSSceneItem item, bool select)
+{
+	if (items.indexOf(item) == -1)
+		return;
+
+	st->SelectItem(item, select);
+	OBSBasic::Get()->UpdateContextBarDeferred();
+	OBSBasic::Get()->UpdateEditMenu();
+}
+
+void SourceTreeModel::SourceRemoved(OBSSource source)
+{
+	for (obs_sceneitem_t *item : items) {
+		if (obs_sceneitem_get_source(item) == source) {
+			ReorderItems();
+			return;
+		}
+	}
+}
+
 OBSSceneItem SourceTreeModel::Get(int idx)
 {
 	if (idx == -1 || idx >= items.count())
@@ -860,6 +922,17 @@ SourceTreeModel::SourceTreeModel(SourceTree *st_)
 	: QAbstractListModel(st_), st(st_)
 {
 	obs_frontend_add_event_callback(OBSFrontendEvent, this);
+
+	auto sourceRemove = [](void *data, calldata_t *cd) {
+		SourceTreeModel *stm = reinterpret_cast<SourceTreeModel *>(data);
+		obs_source_t *source = (obs_source_t *)calldata_ptr(cd, "source");
+
+		QMetaObject::invokeMethod(stm, "SourceRemoved",
+					  Q_ARG(OBSSource, OBSSource(source)));
+	};
+
+	sourceRemoveSignal.Connect(obs_get_signal_handler(), "source_remove",
+				   sourceRemove, this);
 }
 
 SourceTreeModel::~SourceTreeModel()
@@ -985,6 +1058,7 @@ void SourceTreeModel::GroupSelectedItems(QModelIndexList &indices)
 	}
 
 	hasGroups = true;
+	ConnectSignals();
 	st->UpdateWidgets(true);
 
 	obs_sceneitem_select(item, true);
@@ -1007,7 +1081,7 @@ void SourceTreeModel::UngroupSelectedGroups(QModelIndexList &indices)
 		obs_sceneitem_group_ungroup(item);
 	}
 
-	SceneChanged();
+	ReorderItems();
 
 	OBSData redoData = main->BackupScene(scene);
 	main->CreateSceneUndoRedoAction(QTStr("Basic.Main.Ungroup"), undoData,
@@ -1065,6 +1139,8 @@ void SourceTreeModel::CollapseGroup(obs_sceneitem_t *item)
 
 void SourceTreeModel::UpdateGroupState(bool update)
 {
+	ConnectSignals();
+
 	bool nowHasGroups = false;
 	for (auto &item : items) {
 		if (obs_sceneitem_is_group(item)) {
@@ -1099,10 +1175,25 @@ SourceTree::SourceTree(QWidget *parent_) : QListView(parent_)
 
 	setMouseTracking(true);
 
+	/* all rows have the same height, which saves asking the delegate for
+	 * the size of every row on large scenes */
+	setUniformItemSizes(true);
+
 	UpdateNoSourcesMessage();
 	connect(App(), &OBSApp::StyleChanged, this,
 		&SourceTree::UpdateNoSourcesMessage);
 	connect(App(), &OBSApp::StyleChanged, this, &SourceTree::UpdateIcons);
+
+	connect(verticalScrollBar(), &QScrollBar::valueChanged, this,
+		&SourceTree::ScheduleVisibleWidgets);
+	connect(stm_, &QAbstractItemModel::rowsInserted, this,
+		&SourceTree::ScheduleVisibleWidgets);
+	connect(stm_, &QAbstractItemModel::rowsRemoved, this,
+		&SourceTree::ScheduleVisibleWidgets);
+	connect(stm_, &QAbstractItemModel::rowsMoved, this,
+		&SourceTree::ScheduleVisibleWidgets);
+	connect(stm_, &QAbstractItemModel::modelReset, this,
+		&SourceTree::ScheduleVisibleWidgets);
 }
 
 void SourceTree::UpdateIcons()
@@ -1121,15 +1212,9 @@ void SourceTree::SetIconsVisible(bool visible)
 
 void SourceTree::ResetWidgets()
 {
-	OBSScene scene = GetCurrentScene();
-
-	SourceTreeModel *stm = GetStm();
-	stm->UpdateGroupState(false);
-
-	for (int i = 0; i < stm->items.count(); i++) {
-		QModelIndex index = stm->createIndex(i, 0, nullptr);
-		setIndexWidget(index, new SourceTreeItem(this, stm->items[i]));
-	}
+	/* the reset deleted all widgets, only the ones of the rows that are
+	 * visible are created again */
+	CreateVisibleWidgets();
 }
 
 void SourceTree::UpdateWidget(const QModelIndex &idx, obs_sceneitem_t *item)
@@ -1142,17 +1227,74 @@ void SourceTree::UpdateWidgets(bool force)
 	SourceTreeModel *stm = GetStm();
 
 	for (int i = 0; i < stm->items.size(); i++) {
-		obs_sceneitem_t *item = stm->items[i];
-		SourceTreeItem *widget = GetItemWidget(i);
+		QWidget *widget = indexWidget(stm->createIndex(i, 0));
+		if (widget)
+			reinterpret_cast<SourceTreeItem *>(widget)->Update(
+				force);
+	}
 
-		if (!widget) {
-			UpdateWidget(stm->createIndex(i, 0), item);
-		} else {
-			widget->Update(force);
-		}
+	CreateVisibleWidgets();
+}
+
+SourceTreeItem *SourceTree::GetItemWidget(int idx)
+{
+	SourceTreeModel *stm = GetStm();
+	if (idx < 0 || idx >= stm->items.count())
+		return nullptr;
+
+	QModelIndex index = stm->createIndex(idx, 0);
+	QWidget *widget = indexWidget(index);
+
+	if (!widget) {
+		UpdateWidget(index, stm->items[idx]);
+		widget = indexWidget(index);
+	}
+
+	return reinterpret_cast<SourceTreeItem *>(widget);
+}
+
+void SourceTree::ScheduleVisibleWidgets()
+{
+	if (widgetsPending)
+		return;
+
+	widgetsPending = true;
+	QMetaObject::invokeMethod(this, "CreateVisibleWidgets",
+				  Qt::QueuedConnection);
+}
+
+void SourceTree::CreateVisibleWidgets()
+{
+	ProfileScope("SourceTree::CreateVisibleWidgets");
+
+	SourceTreeModel *stm = GetStm();
+	widgetsPending = false;
+
+	if (!stm->items.count())
+		return;
+
+	executeDelayedItemsLayout();
+
+	QRect rect = viewport()->rect();
+	QModelIndex first = indexAt(rect.topLeft());
+	QModelIndex last = indexAt(rect.bottomLeft());
+
+	int firstRow = first.isValid() ? first.row() : 0;
+	int lastRow = last.isValid() ? last.row() : stm->items.count() - 1;
+
+	for (int i = firstRow; i <= lastRow; i++) {
+		QModelIndex index = stm->createIndex(i, 0);
+		if (!indexWidget(index))
+			UpdateWidget(index, stm->items[i]);
 	}
 }
 
+void SourceTree::resizeEvent(QResizeEvent *event)
+{
+	QListView::resizeEvent(event);
+	ScheduleVisibleWidgets();
+}
+
 void SourceTree::SelectItem(obs_sceneitem_t *sceneitem, bool select)
 {
 	SourceTreeModel *stm = GetStm();
@@ -1586,8 +1728,7 @@ bool SourceTree::Edit(int row)
 		return false;
 
 	QModelIndex index = stm->createIndex(row, 0);
-	QWidget *widget = indexWidget(index);
-	SourceTreeItem *itemWidget = reinterpret_cast<SourceTreeItem *>(widget);
+	SourceTreeItem *itemWidget = GetItemWidget(row);
 	if (itemWidget->IsEditing())
 		return false;
 
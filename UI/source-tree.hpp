@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <QList>
 #include <QVector>
 #include <QPointer>
@@ -74,23 +76,13 @@ private:
 
 	SourceTree *tree;
 	OBSSceneItem sceneitem;
-	OBSSignal sceneRemoveSignal;
-	OBSSignal itemRemoveSignal;
-	OBSSignal groupReorderSignal;
-	OBSSignal selectSignal;
-	OBSSignal deselectSignal;
-	OBSSignal visibleSignal;
-	OBSSignal lockedSignal;
 	OBSSignal renameSignal;
-	OBSSignal removeSignal;
 
 	virtual void paintEvent(QPaintEvent *event) override;
 
 	void ExitEditModeInternal(bool save);
 
 private slots:
-	void Clear();
-
 	void EnterEditMode();
 	void ExitEditMode(bool save);
 
@@ -99,9 +91,6 @@ private slots:
 	void Renamed(const QString &name);
 
 	void ExpandClicked(bool checked);
-
-	void Select();
-	void Deselect();
 };
 
 class SourceTreeModel : public QAbstractListModel {
@@ -114,10 +103,21 @@ class SourceTreeModel : public QAbstractListModel {
 	QVector<OBSSceneItem> items;
 	bool hasGroups = false;
 
+	/* item signals of the current scene and its groups, connected once
+	 * here rather than for every item widget */
+	std::vector<OBSSignal> sceneSignals;
+	std::vector<OBSWeakSourceAutoRelease> signalSources;
+	OBSSignal sourceRemoveSignal;
+
 	static void OBSFrontendEvent(enum obs_frontend_event event, void *ptr);
 	void Clear();
 	void SceneChanged();
 	void ReorderItems();
+	void SelectItems(int first, int last);
+
+	void ConnectSignals();
+	void ConnectSceneSignals(obs_source_t *source, bool group);
+	SourceTreeItem *GetExistingWidget(obs_sceneitem_t *item);
 
 	void Add(obs_sceneitem_t *item);
 	void Remove(obs_sceneitem_t *item);
@@ -133,6 +133,13 @@ class SourceTreeModel : public QAbstractListModel {
 
 	void UpdateGroupState(bool update);
 
+private slots:
+	void ItemRemoved(OBSSceneItem item);
+	void ItemVisible(OBSSceneItem item, bool visible);
+	void ItemLocked(OBSSceneItem item, bool locked);
+	void ItemSelected(OBSSceneItem item, bool select);
+	void SourceRemoved(OBSSource source);
+
 public:
 	explicit SourceTreeModel(SourceTree *st);
 	~SourceTreeModel();
@@ -160,24 +167,27 @@ class SourceTree : public QListView {
 	OBSData undoSceneData;
 
 	bool iconsVisible = true;
+	bool widgetsPending = false;
 
 	void UpdateNoSourcesMessage();
 
 	void ResetWidgets();
 	void UpdateWidget(const QModelIndex &idx, obs_sceneitem_t *item);
 	void UpdateWidgets(bool force = false);
+	void ScheduleVisibleWidgets();
 
 	inline SourceTreeModel *GetStm() const
 	{
 		return reinterpret_cast<SourceTreeModel *>(model());
 	}
 
+private slots:
+	void CreateVisibleWidgets();
+
 public:
-	inline SourceTreeItem *GetItemWidget(int idx)
-	{
-		QWidget *widget = indexWidget(GetStm()->createIndex(idx, 0));
-		return reinterpret_cast<SourceTreeItem *>(widget);
-	}
+	/* item widgets are only created for visible rows, this creates the
+	 * widget of any other row on demand */
+	SourceTreeItem *GetItemWidget(int idx);
 
 	explicit SourceTree(QWidget *parent = nullptr);
 
@@ -199,7 +209,7 @@ public:
 
 public slots:
 	inline void ReorderItems() { GetStm()->ReorderItems(); }
-	inline void RefreshItems() { GetStm()->SceneChanged(); }
+	inline void RefreshItems() { GetStm()->ReorderItems(); }
 	void Remove(OBSSceneItem item);
 	void GroupSelectedItems();
 	void UngroupSelectedGroups();
@@ -213,6 +223,7 @@ protected:
 	virtual void mouseMoveEvent(QMouseEvent *event) override;
 	virtual void leaveEvent(QEvent *event) override;
 	virtual void paintEvent(QPaintEvent *event) override;
+	virtual void resizeEvent(QResizeEvent *event) override;
 
 	virtual void
 	selectionChanged(const QItemSelection &selected,
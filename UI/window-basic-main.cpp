@@ -479,7 +479,8 @@ OBSBasic::OBSBasic(QWidget *parent)
 }
 
 static void SaveAudioDevice(const char *name, int channel, obs_data_t *parent,
-			    vector<OBSSource> &audioSources)
+			    vector<OBSSource> &audioSources,
+			    SceneCollectionSaver *saver)
 {
 	OBSSourceAutoRelease source = obs_get_output_source(channel);
 	if (!source)
@@ -487,7 +488,7 @@ static void SaveAudioDevice(const char *name, int channel, obs_data_t *parent,
 
 	audioSources.push_back(source.Get());
 
-	OBSDataAutoRelease data = obs_save_source(source);
+	OBSDataAutoRelease data = saver->SaveSource(source);
 
 	obs_data_set_obj(parent, name, data);
 }
@@ -497,48 +498,39 @@ static obs_data_t *GenerateSaveData(obs_data_array_t *sceneOrder,
 				    int transitionDuration,
 				    obs_data_array_t *transitions,
 				    OBSScene &scene, OBSSource &curProgramScene,
-				    obs_data_array_t *savedProjectorList)
+				    obs_data_array_t *savedProjectorList,
+				    SceneCollectionSaver *saver)
 {
 	obs_data_t *saveData = obs_data_create();
 
 	vector<OBSSource> audioSources;
 	audioSources.reserve(6);
 
-	SaveAudioDevice(DESKTOP_AUDIO_1, 1, saveData, audioSources);
-	SaveAudioDevice(DESKTOP_AUDIO_2, 2, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_1, 3, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_2, 4, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_3, 5, saveData, audioSources);
-	SaveAudioDevice(AUX_AUDIO_4, 6, saveData, audioSources);
+	SaveAudioDevice(DESKTOP_AUDIO_1, 1, saveData, audioSources, saver);
+	SaveAudioDevice(DESKTOP_AUDIO_2, 2, saveData, audioSources, saver);
+	SaveAudioDevice(AUX_AUDIO_1, 3, saveData, audioSources, saver);
+	SaveAudioDevice(AUX_AUDIO_2, 4, saveData, audioSources, saver);
+	SaveAudioDevice(AUX_AUDIO_3, 5, saveData, audioSources, saver);
+	SaveAudioDevice(AUX_AUDIO_4, 6, saveData, audioSources, saver);
 
 	/* -------------------------------- */
 	/* save non-group sources           */
 
-	auto FilterAudioSources = [&](obs_source_t *source) {
-		if (obs_source_is_group(source))
-			return false;
-
-		return find(begin(audioSources), end(audioSources), source) ==
-		       end(audioSources);
-	};
-	using FilterAudioSources_t = decltype(FilterAudioSources);
+	obs_data_array_t *sourcesArray =
+		saver->SaveSources([&](obs_source_t *source) {
+			if (obs_source_is_group(source))
+				return false;
 
-	obs_data_array_t *sourcesArray = obs_save_sources_filtered(
-		[](void *data, obs_source_t *source) {
-			auto &func = *static_cast<FilterAudioSources_t *>(data);
-			return func(source);
-		},
-		static_cast<void *>(&FilterAudioSources));
+			return find(begin(audioSources), end(audioSources),
+				    source) == end(audioSources);
+		});
 
 	/* -------------------------------- */
 	/* save group sources separately    */
 
 	/* saving separately ensures they won't be loaded in older versions */
-	obs_data_array_t *groupsArray = obs_save_sources_filtered(
-		[](void *, obs_source_t *source) {
-			return obs_source_is_group(source);
-		},
-		nullptr);
+	obs_data_array_t *groupsArray = saver->SaveSources(
+		[](obs_source_t *source) { return obs_source_is_group(source); });
 
 	/* -------------------------------- */
 
@@ -691,6 +683,10 @@ obs_data_array_t *OBSBasic::SaveProjectors()
 
 void OBSBasic::Save(const char *file)
 {
+	uint64_t start = os_gettime_ns();
+
+	saver->StartSave();
+
 	OBSScene scene = GetCurrentScene();
 	OBSSource curProgramScene = OBSGetStrongRef(programScene);
 	if (!curProgramScene)
@@ -702,7 +698,8 @@ void OBSBasic::Save(const char *file)
 	OBSDataArrayAutoRelease savedProjectorList = SaveProjectors();
 	OBSDataAutoRelease saveData = GenerateSaveData(
 		sceneOrder, quickTrData, ui->transitionDuration->value(),
-		transitions, scene, curProgramScene, savedProjectorList);
+		transitions, scene, curProgramScene, savedProjectorList,
+		saver.get());
 
 	obs_data_set_bool(saveData, "preview_locked", ui->preview->Locked());
 	obs_data_set_bool(saveData, "scaling_enabled",
@@ -720,8 +717,8 @@ void OBSBasic::Save(const char *file)
 		obs_data_set_obj(saveData, "modules", moduleObj);
 	}
 
-	if (!obs_data_save_json_safe(saveData, file, "tmp", "bak"))
-		blog(LOG_ERROR, "Could not save scene data to %s", file);
+	/* serialized and written on the saver's thread */
+	saver->Write(saveData, file, start);
 }
 
 void OBSBasic::DeferSaveBegin()
@@ -1043,7 +1040,7 @@ void OBSBasic::LoadData(obs_data_t *data, const char *file)
 		UNUSED_PARAMETER(source);
 	};
 
-	obs_load_sources(sources, cb, files);
+	obs_load_sources_parallel(sources, cb, files);
 
 	if (transitions)
 		LoadTransitions(transitions, cb, files);
@@ -1596,6 +1593,8 @@ void OBSBasic::InitOBSCallbacks()
 				    OBSBasic::SourceAudioDeactivated, this);
 	signalHandlers.emplace_back(obs_get_signal_handler(), "source_rename",
 				    OBSBasic::SourceRenamed, this);
+
+	saver = make_unique<SceneCollectionSaver>();
 }
 
 void OBSBasic::InitPrimitives()
@@ -2714,8 +2713,13 @@ void OBSBasic::SaveProjectNow()
 	if (disableSaving)
 		return;
 
+	saver->MarkAllChanged();
+
 	projectChanged = true;
 	SaveProjectDeferred();
+
+	/* callers expect the file to be written when this returns */
+	saver->Flush();
 }
 
 void OBSBasic::SaveProject()
@@ -3266,6 +3270,7 @@ void OBSBasic::HideAudioControl()
 
 	if (!SourceMixerHidden(source)) {
 		SetSourceMixerHidden(source, true);
+		saver->MarkChanged(source);
 		DeactivateAudioSource(source);
 	}
 }
@@ -3280,6 +3285,7 @@ void OBSBasic::UnhideAllAudioControls()
 			return true;
 
 		SetSourceMixerHidden(source, false);
+		saver->MarkChanged(source);
 		ActivateAudioSource(source);
 		return true;
 	};
@@ -3304,6 +3310,8 @@ void OBSBasic::ToggleHideMixer()
 		SetSourceMixerHidden(source, false);
 		ActivateAudioSource(source);
 	}
+
+	saver->MarkChanged(source);
 }
 
 void OBSBasic::MixerRenameSource()
@@ -3362,6 +3370,7 @@ void OBSBasic::LockVolumeControl(bool lock)
 	OBSDataAutoRelease priv_settings =
 		obs_source_get_private_settings(source);
 	obs_data_set_bool(priv_settings, "volume_locked", lock);
+	saver->MarkChanged(source);
 
 	vol->EnableSlider(!lock);
 }
@@ -4718,6 +4727,9 @@ void OBSBasic::closeEvent(QCloseEvent *event)
 
 	disableSaving++;
 
+	/* waits for pending saves, and releases the saved source data */
+	saver.reset();
+
 	/* Clear all scene data (dialogs, widgets, widget sub-items, scenes,
 	 * sources, etc) so that all references are released before shutdown */
 	ClearSceneData();
@@ -5260,6 +5272,7 @@ void OBSBasic::SetDeinterlacingMode()
 	obs_source_t *source = obs_sceneitem_get_source(sceneItem);
 
 	obs_source_set_deinterlace_mode(source, mode);
+	saver->MarkChanged(source);
 }
 
 void OBSBasic::SetDeinterlacingOrder()
@@ -5271,6 +5284,7 @@ void OBSBasic::SetDeinterlacingOrder()
 	obs_source_t *source = obs_sceneitem_get_source(sceneItem);
 
 	obs_source_set_deinterlace_field_order(source, order);
+	saver->MarkChanged(source);
 }
 
 QMenu *OBSBasic::AddDeinterlacingMenu(QMenu *menu, obs_source_t *source)
@@ -9559,18 +9573,15 @@ void OBSBasic::ColorChange()
 SourceTreeItem *OBSBasic::GetItemWidgetFromSceneItem(obs_sceneitem_t *sceneItem)
 {
 	int i = 0;
-	SourceTreeItem *treeItem = ui->sources->GetItemWidget(i);
 	OBSSceneItem item = ui->sources->Get(i);
 	int64_t id = obs_sceneitem_get_id(sceneItem);
-	while (treeItem && obs_sceneitem_get_id(item) != id) {
+	while (item && obs_sceneitem_get_id(item) != id) {
 		i++;
-		treeItem = ui->sources->GetItemWidget(i);
 		item = ui->sources->Get(i);
 	}
-	if (treeItem)
-		return treeItem;
 
-	return nullptr;
+	/* only the matching row gets a widget created if it has none yet */
+	return item ? ui->sources->GetItemWidget(i) : nullptr;
 }
 
 void OBSBasic::on_autoConfigure_triggered()
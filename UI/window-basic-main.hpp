@@ -41,6 +41,7 @@
 #include "auth-base.hpp"
 #include "log-viewer.hpp"
 #include "undo-stack-obs.hpp"
+#include "scene-collection-saver.hpp"
 
 #include <obs-frontend-internal.hpp>
 
@@ -217,6 +218,7 @@ private:
 	bool loaded = false;
 	long disableSaving = 1;
 	bool projectChanged = false;
+	std::unique_ptr<SceneCollectionSaver> saver;
 	bool previewEnabled = true;
 	ContextBarSize contextBarSize = ContextBarSize_Normal;
 
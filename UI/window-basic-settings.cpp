@@ -416,6 +416,8 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 	HookWidget(ui->multiviewDrawNames,   CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->multiviewDrawAreas,   CHECK_CHANGED,  GENERAL_CHANGED);
 	HookWidget(ui->multiviewLayout,      COMBO_CHANGED,  GENERAL_CHANGED);
+	HookWidget(ui->multiviewThumbFPS,    SCROLL_CHANGED, GENERAL_CHANGED);
+	HookWidget(ui->multiviewThumbCount,  SCROLL_CHANGED, GENERAL_CHANGED);
 	HookWidget(ui->service,              COMBO_CHANGED,  STREAM1_CHANGED);
 	HookWidget(ui->server,               COMBO_CHANGED,  STREAM1_CHANGED);
 	HookWidget(ui->customServer,         EDIT_CHANGED,   STREAM1_CHANGED);
@@ -1433,6 +1435,12 @@ void OBSBasicSettings::LoadGeneralSettings()
 		QVariant::fromValue(config_get_int(
 			GetGlobalConfig(), "BasicWindow", "MultiviewLayout"))));
 
+	ui->multiviewThumbFPS->setValue(config_get_int(
+		GetGlobalConfig(), "BasicWindow", "MultiviewThumbnailFPS"));
+	ui->multiviewThumbCount->setValue(config_get_int(
+		GetGlobalConfig(), "BasicWindow",
+		"MultiviewThumbnailsPerFrame"));
+
 	prevLangIndex = ui->language->currentIndex();
 
 	if (obs_video_active())
@@ -3289,6 +3297,20 @@ void OBSBasicSettings::SaveGeneralSettings()
 		multiviewChanged = true;
 	}
 
+	if (WidgetChanged(ui->multiviewThumbFPS)) {
+		config_set_int(GetGlobalConfig(), "BasicWindow",
+			       "MultiviewThumbnailFPS",
+			       ui->multiviewThumbFPS->value());
+		multiviewChanged = true;
+	}
+
+	if (WidgetChanged(ui->multiviewThumbCount)) {
+		config_set_int(GetGlobalConfig(), "BasicWindow",
+			       "MultiviewThumbnailsPerFrame",
+			       ui->multiviewThumbCount->value());
+		multiviewChanged = true;
+	}
+
 	if (multiviewChanged)
 		OBSProjector::UpdateMultiviewProjectors();
 }
@@ -3757,6 +3779,8 @@ void OBSBasicSettings::SaveAudioSettings()
 
 		obs_source_enable_push_to_talk(source, pttCB->isChecked());
 		obs_source_set_push_to_talk_delay(source, pttSB->value());
+
+		main->saver->MarkChanged(source);
 	}
 
 	auto UpdateAudioDevice = [this](bool input, QComboBox *combo,
@@ -3802,6 +3826,9 @@ void OBSBasicSettings::SaveHotkeySettings()
 		config_set_string(config, "Hotkeys", hw.name.c_str(), json);
 	}
 
+	/* the bindings of source hotkeys are saved with the sources */
+	main->saver->MarkAllChanged();
+
 	if (!main->outputHandler || !main->outputHandler->replayBuffer)
 		return;
 
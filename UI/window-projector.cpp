@@ -9,6 +9,8 @@
 #include "qt-wrappers.hpp"
 #include "platform.hpp"
 
+#include <util/platform.h>
+
 static QList<OBSProjector *> multiviewProjectors;
 static QList<OBSProjector *> allProjectors;
 
@@ -16,6 +18,8 @@ static bool updatingMultiview = false, drawLabel, drawSafeArea, mouseSwitching,
 	    transitionOnDoubleClick;
 static MultiviewLayout multiviewLayout;
 static size_t maxSrcs, numSrcs;
+static uint64_t thumbnailInterval;
+static size_t thumbnailsPerFrame;
 
 OBSProjector::OBSProjector(QWidget *widget, obs_source_t *source_, int monitor,
 			   ProjectorType type_)
@@ -126,6 +130,7 @@ OBSProjector::~OBSProjector()
 		gs_vertexbuffer_destroy(leftLine);
 		gs_vertexbuffer_destroy(topLine);
 		gs_vertexbuffer_destroy(rightLine);
+		ResizeThumbnails(0);
 		obs_leave_graphics();
 	}
 
@@ -223,6 +228,99 @@ static inline uint32_t labelOffset(obs_source_t *label, uint32_t cx)
 	return (cx / 2) - w;
 }
 
+void OBSProjector::ResizeThumbnails(size_t count)
+{
+	for (size_t i = count; i < thumbnails.size(); i++)
+		gs_texrender_destroy(thumbnails[i].texrender);
+
+	while (thumbnails.size() < count) {
+		gs_texrender_t *texrender =
+			gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		thumbnails.push_back({texrender, 0});
+	}
+
+	thumbnails.resize(count);
+}
+
+static void RenderThumbnail(gs_texrender_t *texrender, obs_source_t *source,
+			    uint32_t cx, uint32_t cy, float fw, float fh)
+{
+	gs_texrender_reset(texrender);
+	if (!gs_texrender_begin(texrender, cx, cy))
+		return;
+
+	vec4 zero;
+	vec4_zero(&zero);
+
+	gs_clear(GS_CLEAR_COLOR, &zero, 0.0f, 0);
+	gs_ortho(0.0f, fw, 0.0f, fh, -100.0f, 100.0f);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	obs_source_video_render(source);
+	gs_blend_state_pop();
+
+	gs_texrender_end(texrender);
+}
+
+void OBSProjector::RenderThumbnails(float scale)
+{
+	size_t count = multiviewScenes.size();
+	uint64_t now = os_gettime_ns();
+
+	if (thumbnails.size() != count)
+		ResizeThumbnails(count);
+	if (!count)
+		return;
+
+	if (resetThumbnails) {
+		for (Thumbnail &thumbnail : thumbnails)
+			thumbnail.lastRenderTime = 0;
+		resetThumbnails = false;
+	}
+
+	/* rendered at the size they are displayed at, which is much smaller
+	 * than the canvas */
+	uint32_t cx = std::max(uint32_t(siCX * scale), 1u);
+	uint32_t cy = std::max(uint32_t(siCY * scale), 1u);
+	size_t rendered = 0;
+
+	for (size_t n = 0; n < count && rendered < thumbnailsPerFrame; n++) {
+		size_t i = (nextThumbnail + n) % count;
+		Thumbnail &thumbnail = thumbnails[i];
+
+		if (thumbnail.lastRenderTime &&
+		    now - thumbnail.lastRenderTime < thumbnailInterval)
+			continue;
+
+		OBSSource src = OBSGetStrongRef(multiviewScenes[i]);
+		if (src)
+			RenderThumbnail(thumbnail.texrender, src, cx, cy, fw,
+					fh);
+
+		thumbnail.lastRenderTime = now;
+		nextThumbnail = (i + 1) % count;
+		rendered++;
+	}
+}
+
+static void DrawThumbnail(gs_texrender_t *texrender, float cx, float cy)
+{
+	gs_texture_t *tex = gs_texrender_get_texture(texrender);
+	if (!tex)
+		return;
+
+	gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
+	gs_effect_set_texture(image, tex);
+
+	gs_blend_state_push();
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+	while (gs_effect_loop(effect, "Draw"))
+		gs_draw_sprite(tex, 0, (uint32_t)cx, (uint32_t)cy);
+	gs_blend_state_pop();
+}
+
 static inline void startRegion(int vX, int vY, int vCX, int vCY, float oL,
 			       float oR, float oT, float oB)
 {
@@ -255,6 +353,8 @@ void OBSProjector::OBSRenderMultiview(void *data, uint32_t cx, uint32_t cy)
 
 	GetScaleAndCenterPos(targetCX, targetCY, cx, cy, x, y, scale);
 
+	window->RenderThumbnails(scale);
+
 	OBSSource previewSrc = main->GetCurrentSceneSource();
 	OBSSource programSrc = main->GetProgramSource();
 	bool studioMode = main->IsPreviewProgramMode();
@@ -461,14 +561,15 @@ void OBSProjector::OBSRenderMultiview(void *data, uint32_t cx, uint32_t cy)
 
 		/* ----------- */
 
-		// Render the source
-		gs_matrix_push();
-		gs_matrix_translate3f(window->siX, window->siY, 0.0f);
-		gs_matrix_scale3f(window->siScaleX, window->siScaleY, 1.0f);
-		setRegion(window->siX, window->siY, window->siCX, window->siCY);
-		obs_source_video_render(src);
-		endRegion();
-		gs_matrix_pop();
+		// Draw the source from its thumbnail
+		if (i < window->thumbnails.size() &&
+		    window->thumbnails[i].lastRenderTime) {
+			gs_matrix_push();
+			gs_matrix_translate3f(window->siX, window->siY, 0.0f);
+			DrawThumbnail(window->thumbnails[i].texrender,
+				      window->siCX, window->siCY);
+			gs_matrix_pop();
+		}
 
 		/* ----------- */
 
@@ -998,6 +1099,16 @@ void OBSProjector::UpdateMultiview()
 	transitionOnDoubleClick = config_get_bool(
 		GetGlobalConfig(), "BasicWindow", "TransitionOnDoubleClick");
 
+	uint64_t thumbnailFPS = config_get_uint(GetGlobalConfig(), "BasicWindow",
+						"MultiviewThumbnailFPS");
+	thumbnailInterval = thumbnailFPS ? 1000000000ULL / thumbnailFPS : 0;
+
+	thumbnailsPerFrame = std::max<uint64_t>(
+		config_get_uint(GetGlobalConfig(), "BasicWindow",
+				"MultiviewThumbnailsPerFrame"),
+		1);
+	resetThumbnails = true;
+
 	switch (multiviewLayout) {
 	case MultiviewLayout::HORIZONTAL_TOP_18_SCENES:
 		pvwprgCX = fw / 2;
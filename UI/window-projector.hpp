@@ -60,6 +60,19 @@ private:
 		      siX, siY, siCX, siCY, ppiScaleX, ppiScaleY, siScaleX,
 		      siScaleY, fw, fh, ratio;
 
+	// Scene thumbnails are rendered into downscaled textures, only a few
+	// per frame, and drawn from there
+	struct Thumbnail {
+		gs_texrender_t *texrender;
+		uint64_t lastRenderTime;
+	};
+	std::vector<Thumbnail> thumbnails;
+	size_t nextThumbnail = 0;
+	bool resetThumbnails = false;
+
+	void RenderThumbnails(float scale);
+	void ResizeThumbnails(size_t count);
+
 	bool ready = false;
 
 	// argb colors
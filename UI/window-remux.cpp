@@ -289,6 +289,10 @@ QVariant RemuxQueueModel::data(const QModelIndex &index, int role) const
 	} else if (role == Qt::DecorationRole &&
 		   index.column() == RemuxEntryColumn::State) {
 		result = getIcon(queue[index.row()].state);
+	} else if (role == Qt::ToolTipRole &&
+		   index.column() == RemuxEntryColumn::State) {
+		if (!queue[index.row()].info.isEmpty())
+			result = queue[index.row()].info;
 	} else if (role == RemuxEntryRole::EntryStateRole) {
 		result = queue[index.row()].state;
 	}
@@ -582,7 +586,8 @@ void RemuxQueueModel::endProcessing()
 			 index(queue.length(), RemuxEntryColumn::State));
 }
 
-bool RemuxQueueModel::beginNextEntry(QString &inputPath, QString &outputPath)
+bool RemuxQueueModel::beginNextEntry(int &id, QString &inputPath,
+				     QString &outputPath)
 {
 	bool anyStarted = false;
 
@@ -590,7 +595,10 @@ bool RemuxQueueModel::beginNextEntry(QString &inputPath, QString &outputPath)
 		RemuxQueueEntry &entry = queue[row];
 		if (entry.state == RemuxEntryState::Pending) {
 			entry.state = RemuxEntryState::InProgress;
+			entry.id = nextId++;
+			entry.info.clear();
 
+			id = entry.id;
 			inputPath = entry.sourcePath;
 			outputPath = entry.targetPath;
 
@@ -606,16 +614,19 @@ bool RemuxQueueModel::beginNextEntry(QString &inputPath, QString &outputPath)
 	return anyStarted;
 }
 
-void RemuxQueueModel::finishEntry(bool success)
+void RemuxQueueModel::finishEntry(int id, bool success, const QString &info)
 {
 	for (int row = 0; row < queue.length(); row++) {
 		RemuxQueueEntry &entry = queue[row];
-		if (entry.state == RemuxEntryState::InProgress) {
+		if (entry.state == RemuxEntryState::InProgress &&
+		    entry.id == id) {
 			if (success)
 				entry.state = RemuxEntryState::Complete;
 			else
 				entry.state = RemuxEntryState::Error;
 
+			entry.info = info;
+
 			QModelIndex index =
 				this->index(row, RemuxEntryColumn::State);
 			emit dataChanged(index, index);
@@ -625,6 +636,17 @@ void RemuxQueueModel::finishEntry(bool success)
 	}
 }
 
+int RemuxQueueModel::countEntries(RemuxEntryState state) const
+{
+	int count = 0;
+
+	for (const RemuxQueueEntry &entry : queue)
+		if (entry.state == state)
+			count++;
+
+	return count;
+}
+
 /**********************************************************
   The actual remux window implementation
 **********************************************************/
@@ -632,7 +654,6 @@ void RemuxQueueModel::finishEntry(bool success)
 OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 	: QDialog(parent),
 	  queueModel(new RemuxQueueModel),
-	  worker(new RemuxWorker()),
 	  ui(new Ui::OBSRemux),
 	  recPath(path),
 	  autoRemux(autoRemux_)
@@ -653,6 +674,8 @@ OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 		ui->tableView->hide();
 		ui->buttonBox->hide();
 		ui->label->hide();
+		ui->parallelJobs->hide();
+		ui->parallelJobsLabel->hide();
 	}
 
 	ui->progressBar->setMinimum(0);
@@ -694,20 +717,13 @@ OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 	connect(ui->buttonBox->button(QDialogButtonBox::Close),
 		SIGNAL(clicked()), this, SLOT(close()));
 
-	worker->moveToThread(&remuxer);
-	remuxer.start();
+	int parallelJobs = (int)config_get_int(GetGlobalConfig(), "BasicWindow",
+					       "RemuxParallelJobs");
+	ui->parallelJobs->setValue(parallelJobs);
 
-	//gcc-4.8 can't use QPointer<RemuxWorker> below
-	RemuxWorker *worker_ = worker;
-	connect(worker_, &RemuxWorker::updateProgress, this,
-		&OBSRemux::updateProgress);
-	connect(&remuxer, &QThread::finished, worker_, &QObject::deleteLater);
-	connect(worker_, &RemuxWorker::remuxFinished, this,
-		&OBSRemux::remuxFinished);
-	connect(this, &OBSRemux::remux, worker_, &RemuxWorker::remux);
+	createWorker();
 
-	// Guessing the GCC bug mentioned above would also affect
-	// QPointer<RemuxQueueModel>? Unsure.
+	//gcc-4.8 can't use QPointer<RemuxQueueModel> below
 	RemuxQueueModel *queueModel_ = queueModel;
 	connect(queueModel_,
 		SIGNAL(rowsInserted(const QModelIndex &, int, int)), this,
@@ -721,15 +737,42 @@ OBSRemux::OBSRemux(const char *path, QWidget *parent, bool autoRemux_)
 				  Q_ARG(const QModelIndex &, index));
 }
 
+RemuxWorker *OBSRemux::createWorker()
+{
+	QThread *remuxer = new QThread();
+	RemuxWorker *worker = new RemuxWorker();
+
+	worker->moveToThread(remuxer);
+	remuxer->start();
+
+	connect(worker, &RemuxWorker::updateProgress, this,
+		&OBSRemux::updateProgress);
+	connect(remuxer, &QThread::finished, worker, &QObject::deleteLater);
+	connect(worker, &RemuxWorker::remuxFinished, this,
+		&OBSRemux::remuxFinished);
+
+	remuxers.append(remuxer);
+	workers.append(worker);
+	return worker;
+}
+
+bool OBSRemux::isWorking() const
+{
+	// Tracked here rather than with the workers' flags, those are
+	// reset before their remuxFinished signals arrive.
+	return !jobProgress.isEmpty();
+}
+
 bool OBSRemux::stopRemux()
 {
-	if (!worker->isWorking)
+	if (!isWorking())
 		return true;
 
-	// By locking the worker thread's mutex, we ensure that its
-	// update poll will be blocked as long as we're in here with
+	// By locking the worker threads' mutexes, we ensure that their
+	// update polls will be blocked as long as we're in here with
 	// the popup open.
-	QMutexLocker lock(&worker->updateMutex);
+	for (RemuxWorker *worker : workers)
+		worker->updateMutex.lock();
 
 	bool exit = false;
 
@@ -741,20 +784,30 @@ bool OBSRemux::stopRemux()
 	}
 
 	if (exit) {
-		// Inform the worker it should no longer be
-		// working. It will interrupt accordingly in
-		// its next update callback.
-		worker->isWorking = false;
+		// Inform the workers they should no longer be
+		// working. They will interrupt accordingly in
+		// their next update callback, and no further
+		// entries are started.
+		for (RemuxWorker *worker : workers)
+			worker->isWorking = false;
+		stopping = true;
 	}
 
+	for (RemuxWorker *worker : workers)
+		worker->updateMutex.unlock();
+
 	return exit;
 }
 
 OBSRemux::~OBSRemux()
 {
 	stopRemux();
-	remuxer.quit();
-	remuxer.wait();
+
+	for (QThread *remuxer : remuxers) {
+		remuxer->quit();
+		remuxer->wait();
+		delete remuxer;
+	}
 }
 
 void OBSRemux::rowCountChanged(const QModelIndex &, int, int)
@@ -822,13 +875,13 @@ void OBSRemux::dropEvent(QDropEvent *ev)
 
 void OBSRemux::dragEnterEvent(QDragEnterEvent *ev)
 {
-	if (ev->mimeData()->hasUrls() && !worker->isWorking)
+	if (ev->mimeData()->hasUrls() && !isWorking())
 		ev->accept();
 }
 
 void OBSRemux::beginRemux()
 {
-	if (worker->isWorking) {
+	if (isWorking()) {
 		stopRemux();
 		return;
 	}
@@ -855,51 +908,90 @@ void OBSRemux::beginRemux()
 	// Set all jobs to "pending" first.
 	queueModel->beginProcessing();
 
+	int parallelJobs = ui->parallelJobs->value();
+	config_set_int(GetGlobalConfig(), "BasicWindow", "RemuxParallelJobs",
+		       parallelJobs);
+
+	jobProgress.clear();
+	jobsTotal = queueModel->countEntries(RemuxEntryState::Pending);
+	jobsFinished = 0;
+	stopping = false;
+
+	ui->progressBar->setValue(0);
 	ui->progressBar->setVisible(true);
 	ui->buttonBox->button(QDialogButtonBox::Ok)
 		->setText(QTStr("Remux.Stop"));
+	ui->parallelJobs->setEnabled(false);
 	setAcceptDrops(false);
 
-	remuxNextEntry();
+	while (workers.size() < parallelJobs)
+		createWorker();
+
+	// Each worker starts the next pending entry once it is done,
+	// so at most parallelJobs entries are remuxed at a time.
+	for (int i = 0; i < parallelJobs; i++)
+		remuxNextEntry(workers[i]);
+
+	if (!isWorking())
+		finishRemux();
 }
 
 void OBSRemux::AutoRemux(QString inFile, QString outFile)
 {
 	if (inFile != "" && outFile != "" && autoRemux) {
 		ui->progressBar->setVisible(true);
-		emit remux(inFile, outFile);
+		jobsTotal = 1;
+		jobsFinished = 0;
+		startRemux(workers[0], -1, inFile, outFile);
 		autoRemuxFile = outFile;
 	}
 }
 
-void OBSRemux::remuxNextEntry()
+void OBSRemux::startRemux(RemuxWorker *worker, int id, const QString &source,
+			  const QString &target)
 {
+	// Set here rather than by the worker, so the job counts as
+	// running while it's still queued to the worker thread.
+	worker->isWorking = true;
 	worker->lastProgress = 0.f;
+	jobProgress[id] = 0.f;
 
+	QMetaObject::invokeMethod(worker, "remux", Q_ARG(int, id),
+				  Q_ARG(QString, source),
+				  Q_ARG(QString, target));
+}
+
+void OBSRemux::remuxNextEntry(RemuxWorker *worker)
+{
+	int id;
 	QString inputPath, outputPath;
-	if (queueModel->beginNextEntry(inputPath, outputPath)) {
-		emit remux(inputPath, outputPath);
-	} else {
-		queueModel->autoRemux = autoRemux;
-		queueModel->endProcessing();
-
-		if (!autoRemux) {
-			OBSMessageBox::information(
-				this, QTStr("Remux.FinishedTitle"),
-				queueModel->checkForErrors()
-					? QTStr("Remux.FinishedError")
-					: QTStr("Remux.Finished"));
-		}
 
-		ui->progressBar->setVisible(autoRemux);
-		ui->buttonBox->button(QDialogButtonBox::Ok)
-			->setText(QTStr("Remux.Remux"));
-		ui->buttonBox->button(QDialogButtonBox::RestoreDefaults)
-			->setEnabled(true);
-		ui->buttonBox->button(QDialogButtonBox::Reset)
-			->setEnabled(queueModel->canClearFinished());
-		setAcceptDrops(true);
+	if (!stopping &&
+	    queueModel->beginNextEntry(id, inputPath, outputPath))
+		startRemux(worker, id, inputPath, outputPath);
+}
+
+void OBSRemux::finishRemux()
+{
+	queueModel->autoRemux = autoRemux;
+	queueModel->endProcessing();
+
+	if (!autoRemux) {
+		OBSMessageBox::information(this, QTStr("Remux.FinishedTitle"),
+					   queueModel->checkForErrors()
+						   ? QTStr("Remux.FinishedError")
+						   : QTStr("Remux.Finished"));
 	}
+
+	ui->progressBar->setVisible(autoRemux);
+	ui->buttonBox->button(QDialogButtonBox::Ok)
+		->setText(QTStr("Remux.Remux"));
+	ui->buttonBox->button(QDialogButtonBox::RestoreDefaults)
+		->setEnabled(true);
+	ui->buttonBox->button(QDialogButtonBox::Reset)
+		->setEnabled(queueModel->canClearFinished());
+	ui->parallelJobs->setEnabled(true);
+	setAcceptDrops(true);
 }
 
 void OBSRemux::closeEvent(QCloseEvent *event)
@@ -918,16 +1010,33 @@ void OBSRemux::reject()
 	QDialog::reject();
 }
 
-void OBSRemux::updateProgress(float percent)
+void OBSRemux::updateProgress(int id, float percent)
 {
-	ui->progressBar->setValue(percent * 10);
+	if (!jobProgress.contains(id))
+		return;
+
+	jobProgress[id] = percent;
+
+	// Overall progress of the queue, the running jobs count by
+	// how far along they are.
+	float total = jobsFinished * 100.f;
+	for (float progress : jobProgress)
+		total += progress;
+
+	if (jobsTotal > 0)
+		ui->progressBar->setValue(total * 10 / jobsTotal);
 }
 
-void OBSRemux::remuxFinished(bool success)
+void OBSRemux::remuxFinished(int id, bool success, const QString &info)
 {
+	RemuxWorker *worker = qobject_cast<RemuxWorker *>(sender());
+
 	ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
 
-	queueModel->finishEntry(success);
+	jobProgress.remove(id);
+	jobsFinished++;
+
+	queueModel->finishEntry(id, success, info);
 
 	if (autoRemux && autoRemuxFile != "") {
 		QTimer::singleShot(3000, this, SLOT(close()));
@@ -938,7 +1047,11 @@ void OBSRemux::remuxFinished(bool success)
 				.arg(autoRemuxFile));
 	}
 
-	remuxNextEntry();
+	if (worker)
+		remuxNextEntry(worker);
+
+	if (!isWorking())
+		finishRemux();
 }
 
 void OBSRemux::clearFinished()
@@ -961,13 +1074,13 @@ void RemuxWorker::UpdateProgress(float percent)
 	if (abs(lastProgress - percent) < 0.1f)
 		return;
 
-	emit updateProgress(percent);
+	emit updateProgress(id, percent);
 	lastProgress = percent;
 }
 
-void RemuxWorker::remux(const QString &source, const QString &target)
+void RemuxWorker::remux(int id_, const QString &source, const QString &target)
 {
-	isWorking = true;
+	id = id_;
 
 	auto callback = [](void *data, float percent) {
 		RemuxWorker *rw = static_cast<RemuxWorker *>(data);
@@ -981,13 +1094,25 @@ void RemuxWorker::remux(const QString &source, const QString &target)
 
 	bool stopped = false;
 	bool success = false;
+	QString info;
 
 	media_remux_job_t mr_job = nullptr;
-	if (media_remux_job_create(&mr_job, QT_TO_UTF8(source),
-				   QT_TO_UTF8(target))) {
+	if (isWorking && media_remux_job_create(&mr_job, QT_TO_UTF8(source),
+						QT_TO_UTF8(target))) {
 
 		success = media_remux_job_process(mr_job, callback, this);
 
+		struct media_remux_stats stats;
+		media_remux_job_get_stats(mr_job, &stats);
+
+		double seconds = stats.duration_ns / 1000000000.0;
+		double mb = stats.bytes_read / (1024.0 * 1024.0);
+		info = QTStr("Remux.Throughput")
+			       .arg(mb, 0, 'f', 1)
+			       .arg(seconds, 0, 'f', 2)
+			       .arg(seconds > 0.0 ? mb / seconds : 0.0, 0, 'f',
+				    1);
+
 		media_remux_job_destroy(mr_job);
 
 		stopped = !isWorking;
@@ -995,5 +1120,5 @@ void RemuxWorker::remux(const QString &source, const QString &target)
 
 	isWorking = false;
 
-	emit remuxFinished(!stopped && success);
+	emit remuxFinished(id, !stopped && success, info);
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QFileInfo>
+#include <QHash>
 #include <QMutex>
 #include <QPointer>
 #include <QThread>
@@ -46,8 +47,14 @@ class OBSRemux : public QDialog {
 	Q_OBJECT
 
 	QPointer<RemuxQueueModel> queueModel;
-	QThread remuxer;
-	QPointer<RemuxWorker> worker;
+	QList<QThread *> remuxers;
+	QList<QPointer<RemuxWorker>> workers;
+
+	/* progress of the running jobs, by queue entry id */
+	QHash<int, float> jobProgress;
+	int jobsTotal = 0;
+	int jobsFinished = 0;
+	bool stopping = false;
 
 	std::unique_ptr<Ui::OBSRemux> ui;
 
@@ -72,21 +79,23 @@ protected:
 	virtual void dropEvent(QDropEvent *ev) override;
 	virtual void dragEnterEvent(QDragEnterEvent *ev) override;
 
-	void remuxNextEntry();
+	bool isWorking() const;
+	RemuxWorker *createWorker();
+	void startRemux(RemuxWorker *worker, int id, const QString &source,
+			const QString &target);
+	void remuxNextEntry(RemuxWorker *worker);
+	void finishRemux();
 
 private slots:
 	void rowCountChanged(const QModelIndex &parent, int first, int last);
 
 public slots:
-	void updateProgress(float percent);
-	void remuxFinished(bool success);
+	void updateProgress(int id, float percent);
+	void remuxFinished(int id, bool success, const QString &info);
 	void beginRemux();
 	bool stopRemux();
 	void clearFinished();
 	void clearAll();
-
-signals:
-	void remux(const QString &source, const QString &target);
 };
 
 class RemuxQueueModel : public QAbstractTableModel {
@@ -112,8 +121,9 @@ public:
 	bool checkForErrors() const;
 	void beginProcessing();
 	void endProcessing();
-	bool beginNextEntry(QString &inputPath, QString &outputPath);
-	void finishEntry(bool success);
+	bool beginNextEntry(int &id, QString &inputPath, QString &outputPath);
+	void finishEntry(int id, bool success, const QString &info);
+	int countEntries(RemuxEntryState state) const;
 	bool canClearFinished() const;
 	void clearFinished();
 	void clearAll();
@@ -123,13 +133,16 @@ public:
 private:
 	struct RemuxQueueEntry {
 		RemuxEntryState state;
+		int id = -1;
 
 		QString sourcePath;
 		QString targetPath;
+		QString info;
 	};
 
 	QList<RemuxQueueEntry> queue;
 	bool isProcessing;
+	int nextId = 0;
 
 	static QVariant getIcon(RemuxEntryState state);
 
@@ -142,19 +155,20 @@ class RemuxWorker : public QObject {
 	QMutex updateMutex;
 
 	bool isWorking;
+	int id;
 
 	float lastProgress;
 	void UpdateProgress(float percent);
 
-	explicit RemuxWorker() : isWorking(false) {}
+	explicit RemuxWorker() : isWorking(false), id(-1) {}
 	virtual ~RemuxWorker(){};
 
 private slots:
-	void remux(const QString &source, const QString &target);
+	void remux(int id, const QString &source, const QString &target);
 
 signals:
-	void updateProgress(float percent);
-	void remuxFinished(bool success);
+	void updateProgress(int id, float percent);
+	void remuxFinished(int id, bool success, const QString &info);
 
 	friend class OBSRemux;
 };
@@ -30,6 +30,12 @@ struct obs_script {
 	struct dstr path;
 	struct dstr file;
 	struct dstr desc;
+
+	/* written by the executor thread only */
+	struct obs_script_tick_stats tick_stats;
+	uint64_t tick_id;
+	uint64_t tick_ns;
+	uint64_t tick_warning_ts;
 };
 
 struct script_callback;
@@ -37,6 +43,15 @@ typedef void (*defer_call_cb)(void *param);
 
 extern void defer_call_post(defer_call_cb call, void *cb);
 
+/* ticks run on the scripting executor thread, not the graphics thread */
+typedef void (*script_tick_cb)(void *param, float seconds);
+
+extern void script_tick_add(script_tick_cb tick, void *param);
+extern void script_tick_remove(script_tick_cb tick, void *param);
+
+/* adds time a script spent running on the executor thread */
+extern void script_tick_time(obs_script_t *script, uint64_t ns);
+
 extern void script_log(obs_script_t *script, int level, const char *format,
 		       ...);
 extern void script_log_va(obs_script_t *script, int level, const char *format,
@@ -294,7 +294,11 @@ static void timer_call(struct script_callback *p_cb)
 		return;
 
 	lock_callback();
+	uint64_t start = os_gettime_ns();
 	call_func_(cb->script, cb->reg_idx, 0, 0, "timer_cb", __FUNCTION__);
+
+	/* the script can be destroyed as soon as it's unlocked */
+	script_tick_time(&current_lua_script->base, os_gettime_ns() - start);
 	unlock_callback();
 }
 
@@ -380,15 +384,19 @@ static void obs_lua_tick_callback(void *priv, float seconds)
 	lua_State *script = cb->script;
 
 	if (script_callback_removed(&cb->base)) {
-		obs_remove_tick_callback(obs_lua_tick_callback, cb);
+		script_tick_remove(obs_lua_tick_callback, cb);
 		return;
 	}
 
 	lock_callback();
+	uint64_t start = os_gettime_ns();
 
 	lua_pushnumber(script, (lua_Number)seconds);
 	call_func(obs_lua_tick_callback, 1, 0);
 
+	/* the script can be destroyed as soon as it's unlocked */
+	script_tick_time(&current_lua_script->base, os_gettime_ns() - start);
+
 	unlock_callback();
 }
 
@@ -405,7 +413,7 @@ static int obs_lua_remove_tick_callback(lua_State *script)
 
 static void defer_add_tick(void *cb)
 {
-	obs_add_tick_callback(obs_lua_tick_callback, cb);
+	script_tick_add(obs_lua_tick_callback, cb);
 }
 
 static int obs_lua_add_tick_callback(lua_State *script)
@@ -420,6 +428,32 @@ static int obs_lua_add_tick_callback(lua_State *script)
 
 /* -------------------------------------------- */
 
+static void graphics_task_call(void *p_cb)
+{
+	struct lua_obs_callback *cb = p_cb;
+
+	if (script_callback_removed(&cb->base))
+		return;
+
+	lock_callback();
+	call_func_(cb->script, cb->reg_idx, 0, 0, "graphics_task",
+		   __FUNCTION__);
+	remove_lua_obs_callback(cb);
+	unlock_callback();
+}
+
+static int queue_graphics_task(lua_State *script)
+{
+	if (!verify_args1(script, is_function))
+		return 0;
+
+	struct lua_obs_callback *cb = add_lua_obs_callback(script, 1);
+	obs_queue_task(OBS_TASK_GRAPHICS, graphics_task_call, cb, false);
+	return 0;
+}
+
+/* -------------------------------------------- */
+
 static void calldata_signal_callback(void *priv, calldata_t *cd)
 {
 	struct lua_obs_callback *cb = priv;
@@ -646,6 +680,223 @@ static int scene_enum_items(lua_State *script)
 
 /* -------------------------------------------- */
 
+static void ls_push_data(lua_State *script, obs_data_t *data);
+
+static void ls_push_data_item(lua_State *script, obs_data_item_t *item)
+{
+	switch (obs_data_item_gettype(item)) {
+	case OBS_DATA_STRING:
+		lua_pushstring(script, obs_data_item_get_string(item));
+		return;
+	case OBS_DATA_NUMBER:
+		lua_pushnumber(script, obs_data_item_get_double(item));
+		return;
+	case OBS_DATA_BOOLEAN:
+		lua_pushboolean(script, obs_data_item_get_bool(item));
+		return;
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		ls_push_data(script, obj);
+		obs_data_release(obj);
+		return;
+	}
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		size_t count = obs_data_array_count(array);
+
+		lua_createtable(script, (int)count, 0);
+		for (size_t i = 0; i < count; i++) {
+			obs_data_t *obj = obs_data_array_item(array, i);
+			ls_push_data(script, obj);
+			lua_rawseti(script, -2, (int)i + 1);
+			obs_data_release(obj);
+		}
+
+		obs_data_array_release(array);
+		return;
+	}
+	case OBS_DATA_NULL:
+		break;
+	}
+
+	lua_pushnil(script);
+}
+
+static void ls_push_data(lua_State *script, obs_data_t *data)
+{
+	obs_data_item_t *item;
+
+	lua_newtable(script);
+	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		ls_push_data_item(script, item);
+		lua_setfield(script, -2, obs_data_item_get_name(item));
+	}
+}
+
+static void ls_push_settings(lua_State *script, obs_source_t *source,
+			     int keys_idx)
+{
+	obs_data_t *settings = obs_source_get_settings(source);
+
+	if (!keys_idx) {
+		ls_push_data(script, settings);
+		obs_data_release(settings);
+		return;
+	}
+
+	lua_newtable(script);
+
+	int count = (int)lua_rawlen(script, keys_idx);
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(script, keys_idx, i);
+
+		const char *key = lua_tostring(script, -1);
+		obs_data_item_t *item = key ? obs_data_item_byname(settings, key)
+					    : NULL;
+
+		if (item) {
+			ls_push_data_item(script, item);
+			lua_setfield(script, -3, key);
+			obs_data_item_release(&item);
+		}
+
+		lua_pop(script, 1);
+	}
+
+	obs_data_release(settings);
+}
+
+#define ls_set_bool(name, val)                  \
+	do {                                    \
+		lua_pushboolean(script, val);   \
+		lua_setfield(script, -2, name); \
+	} while (false)
+#define ls_set_number(name, val)                           \
+	do {                                               \
+		lua_pushnumber(script, (lua_Number)(val)); \
+		lua_setfield(script, -2, name);            \
+	} while (false)
+#define ls_set_string(name, val)                \
+	do {                                    \
+		lua_pushstring(script, val);    \
+		lua_setfield(script, -2, name); \
+	} while (false)
+
+static void ls_push_source_state(lua_State *script, obs_source_t *source,
+				 int keys_idx)
+{
+	lua_createtable(script, 0, 10);
+	ls_set_string("name", obs_source_get_name(source));
+	ls_set_string("id", obs_source_get_id(source));
+	ls_set_number("width", obs_source_get_width(source));
+	ls_set_number("height", obs_source_get_height(source));
+	ls_set_bool("active", obs_source_active(source));
+	ls_set_bool("showing", obs_source_showing(source));
+	ls_set_bool("enabled", obs_source_enabled(source));
+	ls_set_bool("muted", obs_source_muted(source));
+	ls_set_number("volume", obs_source_get_volume(source));
+
+	ls_push_settings(script, source, keys_idx);
+	lua_setfield(script, -2, "settings");
+}
+
+static int get_source_states(lua_State *script)
+{
+	int keys_idx = 0;
+
+	if (!lua_istable(script, 1))
+		return 0;
+	if (lua_gettop(script) >= 2 && lua_istable(script, 2))
+		keys_idx = 2;
+
+	int count = (int)lua_rawlen(script, 1);
+	lua_createtable(script, count, 0);
+
+	for (int i = 1; i <= count; i++) {
+		lua_rawgeti(script, 1, i);
+
+		const char *name = lua_tostring(script, -1);
+		obs_source_t *source = name ? obs_get_source_by_name(name)
+					    : NULL;
+
+		lua_pop(script, 1);
+
+		/* false rather than nil so the table stays a sequence */
+		if (source)
+			ls_push_source_state(script, source, keys_idx);
+		else
+			lua_pushboolean(script, false);
+		lua_rawseti(script, -2, i);
+
+		obs_source_release(source);
+	}
+
+	return 1;
+}
+
+static void ls_set_vec2(lua_State *script, const char *name,
+			const struct vec2 *v)
+{
+	lua_createtable(script, 0, 2);
+	ls_set_number("x", v->x);
+	ls_set_number("y", v->y);
+	lua_setfield(script, -2, name);
+}
+
+static bool item_states_proc(obs_scene_t *scene, obs_sceneitem_t *item,
+			     void *param)
+{
+	lua_State *script = param;
+	obs_source_t *source = obs_sceneitem_get_source(item);
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+
+	UNUSED_PARAMETER(scene);
+
+	obs_sceneitem_get_info(item, &info);
+	obs_sceneitem_get_crop(item, &crop);
+
+	lua_createtable(script, 0, 12);
+	ls_set_number("id", obs_sceneitem_get_id(item));
+	ls_set_string("name", obs_source_get_name(source));
+	ls_set_bool("visible", obs_sceneitem_visible(item));
+	ls_set_bool("locked", obs_sceneitem_locked(item));
+	ls_set_vec2(script, "pos", &info.pos);
+	ls_set_number("rot", info.rot);
+	ls_set_vec2(script, "scale", &info.scale);
+	ls_set_number("alignment", info.alignment);
+	ls_set_number("bounds_type", info.bounds_type);
+	ls_set_number("bounds_alignment", info.bounds_alignment);
+	ls_set_vec2(script, "bounds", &info.bounds);
+
+	lua_createtable(script, 0, 4);
+	ls_set_number("left", crop.left);
+	ls_set_number("top", crop.top);
+	ls_set_number("right", crop.right);
+	ls_set_number("bottom", crop.bottom);
+	lua_setfield(script, -2, "crop");
+
+	lua_rawseti(script, -2, (int)lua_rawlen(script, -2) + 1);
+	return true;
+}
+
+#undef ls_set_bool
+#undef ls_set_number
+#undef ls_set_string
+
+static int scene_get_item_states(lua_State *script)
+{
+	obs_scene_t *scene;
+	if (!ls_get_libobs_obj(obs_scene_t, 1, &scene))
+		return 0;
+
+	lua_newtable(script);
+	obs_scene_enum_items(scene, item_states_proc, script);
+	return 1;
+}
+
+/* -------------------------------------------- */
+
 static void defer_hotkey_unregister(void *p_cb)
 {
 	obs_hotkey_unregister((obs_hotkey_id)(uintptr_t)p_cb);
@@ -1014,6 +1265,8 @@ static void add_hook_functions(lua_State *script)
 	add_func("obs_enum_sources", enum_sources);
 	add_func("obs_source_enum_filters", source_enum_filters);
 	add_func("obs_scene_enum_items", scene_enum_items);
+	add_func("obs_get_source_states", get_source_states);
+	add_func("obs_scene_get_item_states", scene_get_item_states);
 	add_func("source_list_release", source_list_release);
 	add_func("sceneitem_list_release", sceneitem_list_release);
 	add_func("calldata_source", calldata_source);
@@ -1024,6 +1277,7 @@ static void add_hook_functions(lua_State *script)
 		 obs_lua_remove_main_render_callback);
 	add_func("obs_add_tick_callback", obs_lua_add_tick_callback);
 	add_func("obs_remove_tick_callback", obs_lua_remove_tick_callback);
+	add_func("queue_graphics_task", queue_graphics_task);
 	add_func("signal_handler_connect", obs_lua_signal_handler_connect);
 	add_func("signal_handler_disconnect",
 		 obs_lua_signal_handler_disconnect);
@@ -1060,10 +1314,12 @@ static void lua_tick(void *param, float seconds)
 		current_lua_script = data;
 
 		pthread_mutex_lock(&data->mutex);
+		uint64_t start = os_gettime_ns();
 
 		lua_pushnumber(script, (double)seconds);
 		call_func_(script, data->tick, 1, 0, "tick", __FUNCTION__);
 
+		script_tick_time(&data->base, os_gettime_ns() - start);
 		pthread_mutex_unlock(&data->mutex);
 
 		data = data->next_tick;
@@ -1347,12 +1603,12 @@ void obs_lua_load(void)
 	dstr_printf(&tmp, startup_script_template, import_path, SCRIPT_DIR);
 	startup_script = tmp.array;
 
-	obs_add_tick_callback(lua_tick, NULL);
+	script_tick_add(lua_tick, NULL);
 }
 
 void obs_lua_unload(void)
 {
-	obs_remove_tick_callback(lua_tick, NULL);
+	script_tick_remove(lua_tick, NULL);
 
 	bfree(startup_script);
 	pthread_mutex_destroy(&tick_mutex);
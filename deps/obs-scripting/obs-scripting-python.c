@@ -435,9 +435,13 @@ static void timer_call(struct script_callback *p_cb)
 		return;
 
 	lock_callback(cb);
+	uint64_t start = os_gettime_ns();
 	PyObject *py_ret = PyObject_CallObject(cb->func, NULL);
 	py_error();
 	Py_XDECREF(py_ret);
+
+	/* the script can be destroyed as soon as it's unlocked */
+	script_tick_time(&cur_python_script->base, os_gettime_ns() - start);
 	unlock_callback();
 }
 
@@ -477,11 +481,12 @@ static void obs_python_tick_callback(void *priv, float seconds)
 	struct python_obs_callback *cb = priv;
 
 	if (script_callback_removed(&cb->base)) {
-		obs_remove_tick_callback(obs_python_tick_callback, cb);
+		script_tick_remove(obs_python_tick_callback, cb);
 		return;
 	}
 
 	lock_callback(cb);
+	uint64_t start = os_gettime_ns();
 
 	PyObject *args = Py_BuildValue("(f)", seconds);
 	PyObject *py_ret = PyObject_CallObject(cb->func, args);
@@ -489,6 +494,9 @@ static void obs_python_tick_callback(void *priv, float seconds)
 	Py_XDECREF(py_ret);
 	Py_XDECREF(args);
 
+	/* the script can be destroyed as soon as it's unlocked */
+	script_tick_time(&cur_python_script->base, os_gettime_ns() - start);
+
 	unlock_callback();
 }
 
@@ -536,7 +544,50 @@ static PyObject *obs_python_add_tick_callback(PyObject *self, PyObject *args)
 		return python_none();
 
 	struct python_obs_callback *cb = add_python_obs_callback(script, py_cb);
-	obs_add_tick_callback(obs_python_tick_callback, cb);
+	script_tick_add(obs_python_tick_callback, cb);
+	return python_none();
+}
+
+/* -------------------------------------------- */
+
+static void graphics_task_call(void *p_cb)
+{
+	struct python_obs_callback *cb = p_cb;
+
+	if (script_callback_removed(&cb->base))
+		return;
+
+	lock_callback(cb);
+
+	PyObject *py_ret = PyObject_CallObject(cb->func, NULL);
+	py_error();
+	Py_XDECREF(py_ret);
+
+	remove_python_obs_callback(cb);
+
+	unlock_callback();
+}
+
+static PyObject *queue_graphics_task(PyObject *self, PyObject *args)
+{
+	struct obs_python_script *script = cur_python_script;
+	PyObject *py_cb = NULL;
+
+	if (!script) {
+		PyErr_SetString(PyExc_RuntimeError,
+				"No active script, report this to Jim");
+		return NULL;
+	}
+
+	UNUSED_PARAMETER(self);
+
+	if (!parse_args(args, "O", &py_cb))
+		return python_none();
+	if (!py_cb || !PyFunction_Check(py_cb))
+		return python_none();
+
+	struct python_obs_callback *cb = add_python_obs_callback(script, py_cb);
+	obs_queue_task(OBS_TASK_GRAPHICS, graphics_task_call, cb, false);
 	return python_none();
 }
 
@@ -1151,6 +1202,247 @@ static PyObject *sceneitem_list_release(PyObject *self, PyObject *args)
 
 /* -------------------------------------------- */
 
+static PyObject *py_from_data(obs_data_t *data);
+
+static PyObject *py_from_data_item(obs_data_item_t *item)
+{
+	switch (obs_data_item_gettype(item)) {
+	case OBS_DATA_STRING:
+		return PyUnicode_FromString(obs_data_item_get_string(item));
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			return Py_BuildValue("L", obs_data_item_get_int(item));
+		return Py_BuildValue("d", obs_data_item_get_double(item));
+	case OBS_DATA_BOOLEAN:
+		return PyBool_FromLong(obs_data_item_get_bool(item));
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		PyObject *py_obj = py_from_data(obj);
+		obs_data_release(obj);
+		return py_obj;
+	}
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		size_t count = obs_data_array_count(array);
+		PyObject *list = PyList_New(0);
+
+		for (size_t i = 0; i < count; i++) {
+			obs_data_t *obj = obs_data_array_item(array, i);
+			PyObject *py_obj = py_from_data(obj);
+			PyList_Append(list, py_obj);
+			Py_DECREF(py_obj);
+			obs_data_release(obj);
+		}
+
+		obs_data_array_release(array);
+		return list;
+	}
+	case OBS_DATA_NULL:
+		break;
+	}
+
+	return python_none();
+}
+
+static void py_dict_set_item(PyObject *dict, const char *name,
+			     obs_data_item_t *item)
+{
+	PyObject *py_val = item ? py_from_data_item(item) : python_none();
+	PyDict_SetItemString(dict, name, py_val);
+	Py_DECREF(py_val);
+}
+
+static PyObject *py_from_data(obs_data_t *data)
+{
+	PyObject *dict = PyDict_New();
+	obs_data_item_t *item;
+
+	for (item = obs_data_first(data); item; obs_data_item_next(&item))
+		py_dict_set_item(dict, obs_data_item_get_name(item), item);
+
+	return dict;
+}
+
+static PyObject *py_from_settings(obs_source_t *source, PyObject *keys)
+{
+	obs_data_t *settings = obs_source_get_settings(source);
+	PyObject *dict;
+
+	if (!keys) {
+		dict = py_from_data(settings);
+		obs_data_release(settings);
+		return dict;
+	}
+
+	dict = PyDict_New();
+
+	Py_ssize_t count = PyList_Size(keys);
+	for (Py_ssize_t i = 0; i < count; i++) {
+		const char *key = PyBytes_AS_STRING(PyList_GetItem(keys, i));
+		obs_data_item_t *item = obs_data_item_byname(settings, key);
+
+		py_dict_set_item(dict, key, item);
+		obs_data_item_release(&item);
+	}
+
+	obs_data_release(settings);
+	return dict;
+}
+
+/* returns a list of UTF-8 byte strings, so the keys only have to be converted
+ * once for all sources */
+static PyObject *py_utf8_list(PyObject *list)
+{
+	Py_ssize_t count = PyList_Size(list);
+	PyObject *utf8 = PyList_New(0);
+
+	for (Py_ssize_t i = 0; i < count; i++) {
+		PyObject *py_str = PyList_GetItem(list, i);
+		PyObject *py_bytes;
+
+		if (!py_str || !PyUnicode_Check(py_str))
+			goto fail;
+
+		py_bytes = PyUnicode_AsUTF8String(py_str);
+		if (!py_bytes)
+			goto fail;
+
+		PyList_Append(utf8, py_bytes);
+		Py_DECREF(py_bytes);
+	}
+
+	return utf8;
+
+fail:
+	Py_DECREF(utf8);
+	return NULL;
+}
+
+static PyObject *py_source_state(obs_source_t *source, PyObject *keys)
+{
+	return Py_BuildValue(
+		"{s:s,s:s,s:I,s:I,s:N,s:N,s:N,s:N,s:d,s:N}", "name",
+		obs_source_get_name(source), "id", obs_source_get_id(source),
+		"width", obs_source_get_width(source), "height",
+		obs_source_get_height(source), "active",
+		PyBool_FromLong(obs_source_active(source)), "showing",
+		PyBool_FromLong(obs_source_showing(source)), "enabled",
+		PyBool_FromLong(obs_source_enabled(source)), "muted",
+		PyBool_FromLong(obs_source_muted(source)), "volume",
+		(double)obs_source_get_volume(source), "settings",
+		py_from_settings(source, keys));
+}
+
+static PyObject *get_source_states(PyObject *self, PyObject *args)
+{
+	PyObject *py_names;
+	PyObject *py_keys = NULL;
+	PyObject *names = NULL;
+	PyObject *keys = NULL;
+	PyObject *list = NULL;
+
+	UNUSED_PARAMETER(self);
+
+	if (!parse_args(args, "O|O", &py_names, &py_keys))
+		return python_none();
+	if (!PyList_Check(py_names) ||
+	    (py_keys && py_keys != Py_None && !PyList_Check(py_keys))) {
+		PyErr_SetString(PyExc_TypeError, "expected a list of names");
+		return NULL;
+	}
+
+	names = py_utf8_list(py_names);
+	if (!names)
+		goto fail;
+	if (py_keys && py_keys != Py_None) {
+		keys = py_utf8_list(py_keys);
+		if (!keys)
+			goto fail;
+	}
+
+	list = PyList_New(0);
+
+	Py_ssize_t count = PyList_Size(names);
+	for (Py_ssize_t i = 0; i < count; i++) {
+		const char *name = PyBytes_AS_STRING(PyList_GetItem(names, i));
+		obs_source_t *source = obs_get_source_by_name(name);
+		PyObject *py_state;
+
+		py_state = source ? py_source_state(source, keys)
+				  : python_none();
+		obs_source_release(source);
+
+		if (!py_state) {
+			Py_CLEAR(list);
+			break;
+		}
+
+		PyList_Append(list, py_state);
+		Py_DECREF(py_state);
+	}
+
+fail:
+	if (!list && !PyErr_Occurred())
+		PyErr_SetString(PyExc_TypeError, "expected a list of strings");
+	Py_XDECREF(names);
+	Py_XDECREF(keys);
+	return list;
+}
+
+static bool item_states_proc(obs_scene_t *scene, obs_sceneitem_t *item,
+			     void *param)
+{
+	obs_source_t *source = obs_sceneitem_get_source(item);
+	struct obs_transform_info info;
+	struct obs_sceneitem_crop crop;
+	PyObject *list = param;
+	PyObject *py_state;
+
+	obs_sceneitem_get_info(item, &info);
+	obs_sceneitem_get_crop(item, &crop);
+
+	py_state = Py_BuildValue(
+		"{s:L,s:s,s:N,s:N,s:(dd),s:d,s:(dd),s:I,s:i,s:I,s:(dd),"
+		"s:(iiii)}",
+		"id", (long long)obs_sceneitem_get_id(item), "name",
+		obs_source_get_name(source), "visible",
+		PyBool_FromLong(obs_sceneitem_visible(item)), "locked",
+		PyBool_FromLong(obs_sceneitem_locked(item)), "pos",
+		(double)info.pos.x, (double)info.pos.y, "rot", (double)info.rot,
+		"scale", (double)info.scale.x, (double)info.scale.y,
+		"alignment", info.alignment, "bounds_type",
+		(int)info.bounds_type, "bounds_alignment",
+		info.bounds_alignment, "bounds", (double)info.bounds.x,
+		(double)info.bounds.y, "crop", crop.left, crop.top, crop.right,
+		crop.bottom);
+	if (py_state) {
+		PyList_Append(list, py_state);
+		Py_DECREF(py_state);
+	}
+
+	UNUSED_PARAMETER(scene);
+	return true;
+}
+
+static PyObject *scene_get_item_states(PyObject *self, PyObject *args)
+{
+	PyObject *py_scene;
+	obs_scene_t *scene;
+
+	UNUSED_PARAMETER(self);
+
+	if (!parse_args(args, "O", &py_scene))
+		return python_none();
+	if (!py_to_libobs(obs_scene_t, py_scene, &scene))
+		return python_none();
+
+	PyObject *list = PyList_New(0);
+	obs_scene_enum_items(scene, item_states_proc, list);
+	return list;
+}
+
+/* -------------------------------------------- */
+
 struct dstr cur_py_log_chunk = {0};
 
 static PyObject *py_script_log_internal(PyObject *self, PyObject *args,
@@ -1234,9 +1526,12 @@ static void add_hook_functions(PyObject *module)
 		DEF_FUNC("sceneitem_list_release", sceneitem_list_release),
 		DEF_FUNC("obs_enum_sources", enum_sources),
 		DEF_FUNC("obs_scene_enum_items", scene_enum_items),
+		DEF_FUNC("obs_get_source_states", get_source_states),
+		DEF_FUNC("obs_scene_get_item_states", scene_get_item_states),
 		DEF_FUNC("obs_remove_tick_callback",
 			 obs_python_remove_tick_callback),
 		DEF_FUNC("obs_add_tick_callback", obs_python_add_tick_callback),
+		DEF_FUNC("queue_graphics_task", queue_graphics_task),
 		DEF_FUNC("signal_handler_disconnect",
 			 obs_python_signal_handler_disconnect),
 		DEF_FUNC("signal_handler_connect",
@@ -1522,6 +1817,7 @@ static void python_tick(void *param, float seconds)
 		pthread_mutex_lock(&tick_mutex);
 		data = first_tick_script;
 		while (data) {
+			uint64_t start = os_gettime_ns();
 			cur_python_script = data;
 
 			PyObject *py_ret =
@@ -1529,6 +1825,7 @@ static void python_tick(void *param, float seconds)
 			Py_XDECREF(py_ret);
 			py_error();
 
+			script_tick_time(&data->base, os_gettime_ns() - start);
 			data = data->next_tick;
 		}
 
@@ -1730,7 +2027,7 @@ out:
 	python_loaded_at_all = success;
 
 	if (python_loaded)
-		obs_add_tick_callback(python_tick, NULL);
+		script_tick_add(python_tick, NULL);
 
 	return python_loaded;
 }
@@ -1754,7 +2051,7 @@ void obs_python_unload(void)
 
 	/* ---------------------- */
 
-	obs_remove_tick_callback(python_tick, NULL);
+	script_tick_remove(python_tick, NULL);
 
 	for (size_t i = 0; i < python_paths.num; i++)
 		bfree(python_paths.array[i]);
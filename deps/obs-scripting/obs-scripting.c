@@ -20,6 +20,8 @@
 #include <util/platform.h>
 #include <util/threading.h>
 #include <util/circlebuf.h>
+#include <util/darray.h>
+#include <inttypes.h>
 
 #include "obs-scripting-internal.h"
 #include "obs-scripting-callback.h"
@@ -118,6 +120,218 @@ void defer_call_post(defer_call_cb call, void *cb)
 	os_sem_post(defer_call_semaphore);
 }
 
+/* -------------------------------------------- */
+/* Script ticks and timers run on their own thread instead of the graphics
+ * thread, so that a slow script can't hold up rendering.  If the scripts
+ * take longer than a frame, ticks are merged. */
+
+#define TICK_WARNING_INTERVAL_NS 10000000000ULL
+
+struct script_tick {
+	script_tick_cb tick;
+	void *param;
+};
+
+static pthread_mutex_t tick_mutex;
+static DARRAY(struct script_tick) ticks;
+
+static pthread_mutex_t exec_mutex;
+static os_event_t *exec_event;
+static pthread_t exec_thread;
+static bool exec_exit = false;
+static bool exec_pending = false;
+static float exec_seconds = 0.0f;
+static uint64_t exec_skipped = 0;
+
+/* only used by the executor thread */
+static uint64_t exec_tick_id = 0;
+static uint64_t exec_budget_ns = 0;
+static uint64_t exec_skip_warning_ts = 0;
+
+static pthread_mutex_t stats_mutex;
+
+void script_tick_add(script_tick_cb tick, void *param)
+{
+	struct script_tick info = {tick, param};
+
+	pthread_mutex_lock(&tick_mutex);
+	da_push_back(ticks, &info);
+	pthread_mutex_unlock(&tick_mutex);
+}
+
+void script_tick_remove(script_tick_cb tick, void *param)
+{
+	struct script_tick info = {tick, param};
+
+	pthread_mutex_lock(&tick_mutex);
+	da_erase_item(ticks, &info);
+	pthread_mutex_unlock(&tick_mutex);
+}
+
+void script_tick_time(obs_script_t *script, uint64_t ns)
+{
+	uint64_t now;
+
+	pthread_mutex_lock(&stats_mutex);
+
+	if (script->tick_id != exec_tick_id) {
+		script->tick_id = exec_tick_id;
+		script->tick_ns = 0;
+		script->tick_stats.ticks++;
+	}
+
+	script->tick_ns += ns;
+	script->tick_stats.total_ns += ns;
+	if (script->tick_ns > script->tick_stats.max_ns)
+		script->tick_stats.max_ns = script->tick_ns;
+
+	pthread_mutex_unlock(&stats_mutex);
+
+	if (script->tick_ns <= exec_budget_ns)
+		return;
+
+	now = os_gettime_ns();
+	if (now - script->tick_warning_ts < TICK_WARNING_INTERVAL_NS)
+		return;
+
+	script->tick_warning_ts = now;
+	script_warn(script,
+		    "Took %.1f ms in one tick, more than its budget of "
+		    "%.1f ms",
+		    (double)script->tick_ns / 1000000.0,
+		    (double)exec_budget_ns / 1000000.0);
+}
+
+/* graphics thread */
+static void exec_graphics_tick(void *param, float seconds)
+{
+	pthread_mutex_lock(&exec_mutex);
+	if (exec_pending)
+		exec_skipped++;
+	exec_seconds += seconds;
+	exec_pending = true;
+	pthread_mutex_unlock(&exec_mutex);
+
+	os_event_signal(exec_event);
+
+	UNUSED_PARAMETER(param);
+}
+
+static void exec_warn_skipped(uint64_t skipped)
+{
+	uint64_t now = os_gettime_ns();
+
+	if (now - exec_skip_warning_ts < TICK_WARNING_INTERVAL_NS)
+		return;
+
+	exec_skip_warning_ts = now;
+	blog(LOG_WARNING,
+	     "[Scripting] Scripts are falling behind, merged %" PRIu64
+	     " ticks",
+	     skipped);
+}
+
+static void *exec_thread_loop(void *unused)
+{
+	DARRAY(struct script_tick) cur_ticks;
+
+	os_set_thread_name("obs-scripting: executor");
+	da_init(cur_ticks);
+
+	while (os_event_wait(exec_event) == 0) {
+		uint64_t skipped;
+		float seconds;
+		bool pending;
+
+		pthread_mutex_lock(&exec_mutex);
+		if (exec_exit) {
+			pthread_mutex_unlock(&exec_mutex);
+			break;
+		}
+
+		pending = exec_pending;
+		seconds = exec_seconds;
+		skipped = exec_skipped;
+		exec_pending = false;
+		exec_seconds = 0.0f;
+		exec_skipped = 0;
+		pthread_mutex_unlock(&exec_mutex);
+
+		if (!pending)
+			continue;
+		if (skipped)
+			exec_warn_skipped(skipped);
+
+		exec_tick_id++;
+		exec_budget_ns = obs_get_frame_interval_ns() / 2;
+
+		/* callbacks can add or remove ticks */
+		pthread_mutex_lock(&tick_mutex);
+		da_copy(cur_ticks, ticks);
+		pthread_mutex_unlock(&tick_mutex);
+
+		for (size_t i = cur_ticks.num; i > 0; i--) {
+			struct script_tick *tick = &cur_ticks.array[i - 1];
+			tick->tick(tick->param, seconds);
+		}
+	}
+
+	da_free(cur_ticks);
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+static bool exec_start(void)
+{
+	if (pthread_mutex_init(&tick_mutex, NULL) != 0)
+		return false;
+	if (pthread_mutex_init(&exec_mutex, NULL) != 0)
+		goto fail_exec_mutex;
+	if (pthread_mutex_init(&stats_mutex, NULL) != 0)
+		goto fail_stats_mutex;
+	if (os_event_init(&exec_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail_event;
+
+	exec_exit = false;
+	if (pthread_create(&exec_thread, NULL, exec_thread_loop, NULL) != 0)
+		goto fail_thread;
+
+	obs_add_tick_callback(exec_graphics_tick, NULL);
+	return true;
+
+fail_thread:
+	os_event_destroy(exec_event);
+fail_event:
+	pthread_mutex_destroy(&stats_mutex);
+fail_stats_mutex:
+	pthread_mutex_destroy(&exec_mutex);
+fail_exec_mutex:
+	pthread_mutex_destroy(&tick_mutex);
+	return false;
+}
+
+/* no more ticks are run once this returns */
+static void exec_stop(void)
+{
+	obs_remove_tick_callback(exec_graphics_tick, NULL);
+
+	pthread_mutex_lock(&exec_mutex);
+	exec_exit = true;
+	pthread_mutex_unlock(&exec_mutex);
+
+	os_event_signal(exec_event);
+	pthread_join(exec_thread, NULL);
+}
+
+static void exec_free(void)
+{
+	os_event_destroy(exec_event);
+	pthread_mutex_destroy(&stats_mutex);
+	pthread_mutex_destroy(&exec_mutex);
+	pthread_mutex_destroy(&tick_mutex);
+	da_free(ticks);
+}
+
 /* -------------------------------------------- */
 
 bool obs_scripting_load(void)
@@ -137,7 +351,16 @@ bool obs_scripting_load(void)
 		return false;
 	}
 
+	if (!exec_start()) {
+		os_sem_destroy(defer_call_semaphore);
+		pthread_mutex_destroy(&defer_call_mutex);
+		pthread_mutex_destroy(&detach_mutex);
+		return false;
+	}
+
 	if (pthread_create(&defer_call_thread, NULL, defer_thread, NULL) != 0) {
+		exec_stop();
+		exec_free();
 		os_sem_destroy(defer_call_semaphore);
 		pthread_mutex_destroy(&defer_call_mutex);
 		pthread_mutex_destroy(&detach_mutex);
@@ -161,12 +384,19 @@ bool obs_scripting_load(void)
 	return true;
 }
 
+static void graphics_tasks_drained(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+}
+
 void obs_scripting_unload(void)
 {
 	if (!scripting_loaded)
 		return;
 
-		/* ---------------------- */
+	exec_stop();
+
+	/* ---------------------- */
 
 #if defined(LUAJIT_FOUND)
 	obs_lua_unload();
@@ -180,6 +410,13 @@ void obs_scripting_unload(void)
 
 	/* ---------------------- */
 
+	/* graphics tasks queued by scripts still point to their callbacks,
+	 * let them run before the callbacks are freed.  tasks are run in
+	 * order, so once this one has run, all of them have */
+	if (obs_get_video())
+		obs_queue_task(OBS_TASK_GRAPHICS, graphics_tasks_drained, NULL,
+			       true);
+
 	int total_detached = 0;
 
 	pthread_mutex_lock(&detach_mutex);
@@ -216,6 +453,8 @@ void obs_scripting_unload(void)
 	pthread_mutex_destroy(&defer_call_mutex);
 	os_sem_destroy(defer_call_semaphore);
 
+	exec_free();
+
 	scripting_loaded = false;
 }
 
@@ -415,6 +654,18 @@ out:
 	return script->loaded;
 }
 
+bool obs_script_get_tick_stats(const obs_script_t *script,
+			       struct obs_script_tick_stats *stats)
+{
+	if (!ptr_valid(script) || !ptr_valid(stats))
+		return false;
+
+	pthread_mutex_lock(&stats_mutex);
+	*stats = script->tick_stats;
+	pthread_mutex_unlock(&stats_mutex);
+	return true;
+}
+
 bool obs_script_loaded(const obs_script_t *script)
 {
 	return ptr_valid(script) ? script->loaded : false;
@@ -65,6 +65,18 @@ EXPORT void obs_script_update(obs_script_t *script, obs_data_t *settings);
 EXPORT bool obs_script_loaded(const obs_script_t *script);
 EXPORT bool obs_script_reload(obs_script_t *script);
 
+struct obs_script_tick_stats {
+	/* number of ticks the script ran in */
+	uint64_t ticks;
+	/* time spent in script_tick, timers and tick callbacks */
+	uint64_t total_ns;
+	/* longest time spent in a single tick */
+	uint64_t max_ns;
+};
+
+EXPORT bool obs_script_get_tick_stats(const obs_script_t *script,
+				      struct obs_script_tick_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,642 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "../util/bmem.h"
+#include "../util/sse-intrin.h"
+#include "audio-convert.h"
+
+/* filter length per side for upsampling, scaled up for downsampling */
+#define HALF_TAPS 16
+#define MAX_PHASES 640
+#define MAX_DECIMATION 4
+
+#define KAISER_BETA 9.0
+#define CUTOFF 0.97
+
+#define PI 3.14159265358979323846
+
+struct audio_convert {
+	size_t channels;
+	enum audio_format in_format;
+	enum audio_format out_format;
+	uint32_t in_rate;
+
+	/* polyphase filter, output rate / input rate = up / down */
+	bool resample;
+	uint32_t up;
+	uint32_t down;
+	uint32_t taps;
+	uint32_t half_taps;
+	float *coeffs;
+
+	/* per channel input history, pos is the input sample the next output
+	 * sample is centered on, phase its fractional part in 1/up units */
+	float *history[MAX_AUDIO_CHANNELS];
+	size_t history_len;
+	size_t history_size;
+	size_t pos;
+	uint32_t phase;
+
+	float *planes[MAX_AUDIO_CHANNELS];
+	size_t planes_size;
+
+	float *scratch;
+	size_t scratch_size;
+
+	uint8_t *output[MAX_AV_PLANES];
+	size_t output_size;
+};
+
+/* ------------------------------------------------------------------------- */
+/* sample conversion of contiguous runs, same rounding and clipping as
+ * libswresample */
+
+static inline __m128 epi16_lo_to_ps(__m128i v)
+{
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+static inline __m128 epi16_hi_to_ps(__m128i v)
+{
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+static void u8_to_float(float *dst, const uint8_t *src, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias);
+		__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(v, zero), bias);
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(epi16_lo_to_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4,
+			      _mm_mul_ps(epi16_hi_to_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 8,
+			      _mm_mul_ps(epi16_lo_to_ps(hi), scale));
+		_mm_storeu_ps(dst + i + 12,
+			      _mm_mul_ps(epi16_hi_to_ps(hi), scale));
+	}
+
+	for (; i < count; i++)
+		dst[i] = (float)((int)src[i] - 128) * (1.0f / 128.0f);
+}
+
+static void s16_to_float(float *dst, const int16_t *src, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+		_mm_storeu_ps(dst + i, _mm_mul_ps(epi16_lo_to_ps(v), scale));
+		_mm_storeu_ps(dst + i + 4,
+			      _mm_mul_ps(epi16_hi_to_ps(v), scale));
+	}
+
+	for (; i < count; i++)
+		dst[i] = (float)src[i] * (1.0f / 32768.0f);
+}
+
+static void s32_to_float(float *dst, const int32_t *src, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+	}
+
+	for (; i < count; i++)
+		dst[i] = (float)src[i] * (1.0f / 2147483648.0f);
+}
+
+static inline int clamp_int(int val, int min_val, int max_val)
+{
+	return val < min_val ? min_val : (val > max_val ? max_val : val);
+}
+
+static void float_to_u8(uint8_t *dst, const float *src, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(128.0f);
+	const __m128i bias = _mm_set1_epi16(128);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_cvtps_epi32(
+			_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+		__m128i hi = _mm_cvtps_epi32(
+			_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+		__m128i v = _mm_adds_epi16(_mm_packs_epi32(lo, hi), bias);
+
+		_mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(v, v));
+	}
+
+	for (; i < count; i++)
+		dst[i] = (uint8_t)clamp_int((int)lrintf(src[i] * 128.0f) + 128,
+					    0, 255);
+}
+
+static void float_to_s16(int16_t *dst, const float *src, size_t count)
+{
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_cvtps_epi32(
+			_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+		__m128i hi = _mm_cvtps_epi32(
+			_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_packs_epi32(lo, hi));
+	}
+
+	for (; i < count; i++)
+		dst[i] = (int16_t)clamp_int((int)lrintf(src[i] * 32768.0f),
+					    -32768, 32767);
+}
+
+static void float_to_s32(int32_t *dst, const float *src, size_t count)
+{
+	/* largest float below 2^31, converting anything above overflows */
+	const __m128 max_val = _mm_set1_ps(2147483520.0f);
+	const __m128 min_val = _mm_set1_ps(-2147483648.0f);
+	const __m128 scale = _mm_set1_ps(2147483648.0f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		v = _mm_max_ps(_mm_min_ps(v, max_val), min_val);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_cvtps_epi32(v));
+	}
+
+	for (; i < count; i++) {
+		float v = src[i] * 2147483648.0f;
+		v = v > 2147483520.0f ? 2147483520.0f : v;
+		v = v < -2147483648.0f ? -2147483648.0f : v;
+		dst[i] = (int32_t)lrintf(v);
+	}
+}
+
+static void to_float(float *dst, const uint8_t *src, enum audio_format format,
+		     size_t count)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		u8_to_float(dst, src, count);
+		break;
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		s16_to_float(dst, (const int16_t *)src, count);
+		break;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		s32_to_float(dst, (const int32_t *)src, count);
+		break;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		memcpy(dst, src, count * sizeof(float));
+		break;
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+}
+
+static void from_float(uint8_t *dst, const float *src,
+		       enum audio_format format, size_t count)
+{
+	switch (format) {
+	case AUDIO_FORMAT_U8BIT:
+	case AUDIO_FORMAT_U8BIT_PLANAR:
+		float_to_u8(dst, src, count);
+		break;
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		float_to_s16((int16_t *)dst, src, count);
+		break;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		float_to_s32((int32_t *)dst, src, count);
+		break;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		memcpy(dst, src, count * sizeof(float));
+		break;
+	case AUDIO_FORMAT_UNKNOWN:
+		break;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* (de)interleaving */
+
+static void deinterleave(float *const *dst, const float *src, size_t channels,
+			 size_t frames)
+{
+	size_t i = 0;
+
+	if (channels == 2) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(src + i * 2);
+			__m128 b = _mm_loadu_ps(src + i * 2 + 4);
+
+			_mm_storeu_ps(dst[0] + i,
+				      _mm_shuffle_ps(a, b,
+						     _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(dst[1] + i,
+				      _mm_shuffle_ps(a, b,
+						     _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	}
+
+	for (; i < frames; i++)
+		for (size_t ch = 0; ch < channels; ch++)
+			dst[ch][i] = src[i * channels + ch];
+}
+
+static void interleave(float *dst, const float *const *src, size_t channels,
+		       size_t frames)
+{
+	size_t i = 0;
+
+	if (channels == 2) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128 l = _mm_loadu_ps(src[0] + i);
+			__m128 r = _mm_loadu_ps(src[1] + i);
+
+			_mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));
+		}
+	}
+
+	for (; i < frames; i++)
+		for (size_t ch = 0; ch < channels; ch++)
+			dst[i * channels + ch] = src[ch][i];
+}
+
+static float *get_scratch(struct audio_convert *ac, size_t count)
+{
+	if (count > ac->scratch_size) {
+		bfree(ac->scratch);
+		ac->scratch = bmalloc(count * sizeof(float));
+		ac->scratch_size = count;
+	}
+	return ac->scratch;
+}
+
+/* input of any format to float planes starting at dst[ch] */
+static void unpack_input(struct audio_convert *ac, float *const *dst,
+			 const uint8_t *const *input, uint32_t frames)
+{
+	size_t channels = ac->channels;
+
+	if (is_audio_planar(ac->in_format)) {
+		for (size_t ch = 0; ch < channels; ch++)
+			to_float(dst[ch], input[ch], ac->in_format, frames);
+
+	} else if (ac->in_format == AUDIO_FORMAT_FLOAT) {
+		deinterleave(dst, (const float *)input[0], channels, frames);
+
+	} else {
+		float *tmp = get_scratch(ac, frames * channels);
+		to_float(tmp, input[0], ac->in_format, frames * channels);
+		deinterleave(dst, tmp, channels, frames);
+	}
+}
+
+/* float planes to the output format */
+static void pack_output(struct audio_convert *ac, uint8_t *const *output,
+			const float *const *src, uint32_t frames)
+{
+	size_t channels = ac->channels;
+
+	if (is_audio_planar(ac->out_format)) {
+		for (size_t ch = 0; ch < channels; ch++)
+			from_float(output[ch], src[ch], ac->out_format,
+				   frames);
+
+	} else if (ac->out_format == AUDIO_FORMAT_FLOAT) {
+		interleave((float *)output[0], src, channels, frames);
+
+	} else {
+		float *tmp = get_scratch(ac, frames * channels);
+		interleave(tmp, src, channels, frames);
+		from_float(output[0], tmp, ac->out_format, frames * channels);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* polyphase resampling */
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+	while (b) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/* coeffs[phase * taps + j] weights input sample pos - (half_taps - 1) + j
+ * for an output sample at pos + phase / up */
+static void build_filter(struct audio_convert *ac)
+{
+	double cutoff = CUTOFF;
+	double i0_beta = bessel_i0(KAISER_BETA);
+	uint32_t half = ac->half_taps;
+
+	if (ac->down > ac->up)
+		cutoff *= (double)ac->up / (double)ac->down;
+
+	ac->coeffs = bmalloc(sizeof(float) * ac->taps * ac->up);
+
+	for (uint32_t p = 0; p < ac->up; p++) {
+		float *c = ac->coeffs + p * ac->taps;
+		double sum = 0.0;
+
+		for (uint32_t j = 0; j < ac->taps; j++) {
+			double d = (double)j - (double)(half - 1) -
+				   (double)p / (double)ac->up;
+			double x = d / (double)half;
+			double w = 0.0;
+			double s = 1.0;
+
+			if (x > -1.0 && x < 1.0)
+				w = bessel_i0(KAISER_BETA * sqrt(1.0 - x * x)) /
+				    i0_beta;
+			if (d != 0.0)
+				s = sin(PI * cutoff * d) / (PI * cutoff * d);
+
+			c[j] = (float)(cutoff * s * w);
+			sum += c[j];
+		}
+
+		/* unity gain at DC for every phase */
+		for (uint32_t j = 0; j < ac->taps; j++)
+			c[j] = (float)(c[j] / sum);
+	}
+}
+
+static inline float dot_product(const float *a, const float *b, size_t count)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+
+	for (size_t i = 0; i < count; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i),
+						   _mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4),
+						   _mm_loadu_ps(b + i + 4)));
+	}
+
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+	return _mm_cvtss_f32(sum0);
+}
+
+static void reserve_history(struct audio_convert *ac, size_t size)
+{
+	if (size <= ac->history_size)
+		return;
+
+	size = size * 3 / 2;
+	for (size_t ch = 0; ch < ac->channels; ch++)
+		ac->history[ch] =
+			brealloc(ac->history[ch], size * sizeof(float));
+	ac->history_size = size;
+}
+
+static void reserve_planes(struct audio_convert *ac, size_t frames)
+{
+	if (frames <= ac->planes_size)
+		return;
+
+	bfree(ac->planes[0]);
+	ac->planes[0] = bmalloc(frames * ac->channels * sizeof(float));
+	for (size_t ch = 1; ch < ac->channels; ch++)
+		ac->planes[ch] = ac->planes[0] + frames * ch;
+	ac->planes_size = frames;
+}
+
+static uint32_t resample(struct audio_convert *ac, uint32_t in_frames)
+{
+	size_t half = ac->half_taps;
+	size_t max_out = ((size_t)in_frames + ac->taps) * ac->up / ac->down + 2;
+	uint32_t out = 0;
+	size_t pos = ac->pos;
+	uint32_t phase = ac->phase;
+	size_t consumed;
+
+	reserve_planes(ac, max_out);
+
+	while (pos + half < ac->history_len) {
+		const float *c = ac->coeffs + phase * ac->taps;
+		size_t start = pos - (half - 1);
+
+		for (size_t ch = 0; ch < ac->channels; ch++)
+			ac->planes[ch][out] = dot_product(
+				ac->history[ch] + start, c, ac->taps);
+		out++;
+
+		phase += ac->down;
+		pos += phase / ac->up;
+		phase %= ac->up;
+	}
+
+	/* keep what the next output samples still need */
+	consumed = pos - (half - 1);
+	if (consumed > ac->history_len)
+		consumed = ac->history_len;
+
+	for (size_t ch = 0; ch < ac->channels; ch++)
+		memmove(ac->history[ch], ac->history[ch] + consumed,
+			(ac->history_len - consumed) * sizeof(float));
+
+	ac->history_len -= consumed;
+	ac->pos = pos - consumed;
+	ac->phase = phase;
+	return out;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool format_supported(enum audio_format format)
+{
+	return format != AUDIO_FORMAT_UNKNOWN;
+}
+
+struct audio_convert *audio_convert_create(const struct resample_info *dst,
+					   const struct resample_info *src)
+{
+	struct audio_convert *ac;
+	uint32_t div;
+
+	if (src->speakers != dst->speakers ||
+	    src->speakers == SPEAKERS_UNKNOWN)
+		return NULL;
+	if (!format_supported(src->format) || !format_supported(dst->format))
+		return NULL;
+	if (!src->samples_per_sec || !dst->samples_per_sec)
+		return NULL;
+
+	div = gcd(dst->samples_per_sec, src->samples_per_sec);
+	if (dst->samples_per_sec / div > MAX_PHASES)
+		return NULL;
+	if (src->samples_per_sec / div >
+	    MAX_DECIMATION * (dst->samples_per_sec / div))
+		return NULL;
+
+	ac = bzalloc(sizeof(struct audio_convert));
+	ac->channels = get_audio_channels(src->speakers);
+	ac->in_format = src->format;
+	ac->out_format = dst->format;
+	ac->in_rate = src->samples_per_sec;
+	ac->up = dst->samples_per_sec / div;
+	ac->down = src->samples_per_sec / div;
+	ac->resample = ac->up != ac->down;
+
+	if (ac->resample) {
+		uint32_t scale = (ac->down + ac->up - 1) / ac->up;
+
+		ac->half_taps = HALF_TAPS * scale;
+		ac->taps = ac->half_taps * 2;
+		build_filter(ac);
+
+		/* start centered on the first input sample */
+		reserve_history(ac, ac->taps * 2);
+		for (size_t ch = 0; ch < ac->channels; ch++)
+			memset(ac->history[ch], 0,
+			       (ac->half_taps - 1) * sizeof(float));
+		ac->history_len = ac->half_taps - 1;
+		ac->pos = ac->half_taps - 1;
+	}
+
+	return ac;
+}
+
+void audio_convert_destroy(struct audio_convert *ac)
+{
+	if (!ac)
+		return;
+
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		bfree(ac->history[ch]);
+	bfree(ac->planes[0]);
+	bfree(ac->coeffs);
+	bfree(ac->scratch);
+	bfree(ac->output[0]);
+	bfree(ac);
+}
+
+static void reserve_output(struct audio_convert *ac, uint8_t *output[],
+			   uint32_t frames)
+{
+	size_t planes = is_audio_planar(ac->out_format) ? ac->channels : 1;
+	size_t plane_size = get_audio_bytes_per_channel(ac->out_format) *
+			    frames * (planes == 1 ? ac->channels : 1);
+
+	if (frames > ac->output_size) {
+		bfree(ac->output[0]);
+		ac->output[0] = bmalloc(plane_size * planes);
+		ac->output_size = frames;
+	}
+
+	for (size_t i = 0; i < planes; i++)
+		output[i] = ac->output[0] + plane_size * i;
+}
+
+bool audio_convert_process(struct audio_convert *ac, uint8_t *output[],
+			   uint32_t *out_frames, uint64_t *ts_offset,
+			   const uint8_t *const input[], uint32_t in_frames)
+{
+	uint32_t frames = in_frames;
+
+	if (!ac->resample) {
+		*ts_offset = 0;
+
+		/* straight to or from float planar when possible */
+		if (ac->out_format == AUDIO_FORMAT_FLOAT_PLANAR) {
+			reserve_output(ac, output, frames);
+			unpack_input(ac, (float *const *)output, input, frames);
+
+		} else if (ac->in_format == AUDIO_FORMAT_FLOAT_PLANAR) {
+			reserve_output(ac, output, frames);
+			pack_output(ac, output, (const float *const *)input,
+				    frames);
+
+		} else {
+			reserve_planes(ac, frames);
+			reserve_output(ac, output, frames);
+			unpack_input(ac, ac->planes, input, frames);
+			pack_output(ac, output, (const float *const *)ac->planes,
+				    frames);
+		}
+
+		*out_frames = frames;
+		return true;
+	}
+
+	/* delay of the next output sample relative to the new input */
+	*ts_offset = (uint64_t)(((double)(ac->history_len - ac->pos) -
+				 (double)ac->phase / (double)ac->up) *
+				1000000000.0 / (double)ac->in_rate);
+
+	reserve_history(ac, ac->history_len + in_frames);
+	{
+		float *dst[MAX_AUDIO_CHANNELS];
+
+		for (size_t ch = 0; ch < ac->channels; ch++)
+			dst[ch] = ac->history[ch] + ac->history_len;
+		unpack_input(ac, dst, input, in_frames);
+		ac->history_len += in_frames;
+	}
+
+	frames = resample(ac, in_frames);
+
+	reserve_output(ac, output, frames);
+	pack_output(ac, output, (const float *const *)ac->planes, frames);
+
+	*out_frames = frames;
+	return true;
+}
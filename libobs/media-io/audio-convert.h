@@ -0,0 +1,48 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "audio-resampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Native audio conversion used by the audio resampler for the common cases
+ * that don't need libswresample: any sample format to any other with the
+ * same speaker layout, either at the same sample rate or at a small rational
+ * ratio such as 44.1 kHz <-> 48 kHz (polyphase windowed sinc filter).
+ */
+
+struct audio_convert;
+
+/* returns NULL if the conversion is not supported natively */
+extern struct audio_convert *
+audio_convert_create(const struct resample_info *dst,
+		     const struct resample_info *src);
+extern void audio_convert_destroy(struct audio_convert *ac);
+
+extern bool audio_convert_process(struct audio_convert *ac, uint8_t *output[],
+				  uint32_t *out_frames, uint64_t *ts_offset,
+				  const uint8_t *const input[],
+				  uint32_t in_frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,6 +23,7 @@
 #include "../util/circlebuf.h"
 #include "../util/platform.h"
 #include "../util/profiler.h"
+#include "../util/arena.h"
 #include "../util/util_uint64.h"
 
 #include "audio-io.h"
@@ -71,6 +72,8 @@ struct audio_output {
 	os_event_t *stop_event;
 
 	bool initialized;
+	bool catch_up;
+	volatile bool realtime;
 
 	audio_input_callback_t input_cb;
 	void *input_param;
@@ -201,6 +204,26 @@ static void input_and_output(struct audio_output *audio, uint64_t audio_time,
 		do_audio_output(audio, i, new_ts, AUDIO_OUTPUT_FRAMES);
 }
 
+static inline uint64_t clock_get_time(const struct audio_output_clock *clock)
+{
+	return clock ? clock->get_time_ns(clock->param) : os_gettime_ns();
+}
+
+static inline uint64_t clock_to_system(const struct audio_output_clock *clock,
+				       uint64_t time)
+{
+	return clock ? clock->to_system_ns(clock->param, time) : time;
+}
+
+static inline void clock_sleep_to(const struct audio_output_clock *clock,
+				  uint64_t time)
+{
+	if (clock)
+		clock->sleep_to_ns(clock->param, time);
+	else
+		os_sleepto_ns(time);
+}
+
 static void *audio_thread(void *param)
 {
 #ifdef _WIN32
@@ -209,16 +232,18 @@ static void *audio_thread(void *param)
 #endif
 
 	struct audio_output *audio = param;
+	const struct audio_output_clock *clock = audio->info.clock;
 	size_t rate = audio->info.samples_per_sec;
 	uint64_t samples = 0;
-	uint64_t start_time = os_gettime_ns();
-	uint64_t prev_time = start_time;
+	uint64_t start_time = clock_get_time(clock);
+	uint64_t clock_time = start_time;
+	uint64_t prev_time = clock_to_system(clock, start_time);
 	uint64_t audio_time = prev_time;
-	uint32_t audio_wait_time =
-		(uint32_t)(audio_frames_to_ns(rate, AUDIO_OUTPUT_FRAMES) /
-			   1000000);
+	bool realtime = false;
+	os_arena_t *frame_arena = os_arena_create(0);
 
 	os_set_thread_name("audio-io: audio thread");
+	os_set_thread_frame_arena(frame_arena);
 
 	const char *audio_thread_name =
 		profile_store_name(obs_get_profiler_name_store(),
@@ -227,25 +252,54 @@ static void *audio_thread(void *param)
 	while (os_event_try(audio->stop_event) == EAGAIN) {
 		uint64_t cur_time;
 
-		os_sleep_ms(audio_wait_time);
+		if (realtime != os_atomic_load_bool(&audio->realtime)) {
+			realtime = !realtime;
+			if (!os_set_thread_realtime(realtime))
+				blog(LOG_WARNING,
+				     "audio-io: Failed to change the "
+				     "scheduling of the audio thread");
+		}
+
+		/* sleep to the next tick's deadline rather than a fixed
+		 * interval so late wakeups don't add up.  like video frames,
+		 * ticks are scheduled in the time of the master clock and
+		 * timestamped in system time. */
+		clock_sleep_to(clock, clock_time);
 
 		profile_start(audio_thread_name);
 
-		cur_time = os_gettime_ns();
-		while (audio_time <= cur_time) {
+		cur_time = clock_get_time(clock);
+		while (clock_time <= cur_time) {
 			samples += AUDIO_OUTPUT_FRAMES;
-			audio_time =
+			clock_time =
 				start_time + audio_frames_to_ns(rate, samples);
+			audio_time = clock_to_system(clock, clock_time);
+
+			/* the mapping of a jittery clock to system time must
+			 * not run backwards */
+			if (audio_time <= prev_time)
+				audio_time = prev_time +
+					     audio_frames_to_ns(
+						     rate, AUDIO_OUTPUT_FRAMES);
 
 			input_and_output(audio, audio_time, prev_time);
 			prev_time = audio_time;
+
+			while (audio->catch_up) {
+				audio->catch_up = false;
+				input_and_output(audio, audio_time, prev_time);
+			}
 		}
 
 		profile_end(audio_thread_name);
 
 		profile_reenable_thread();
+
+		os_arena_reset(frame_arena);
 	}
 
+	os_arena_destroy(frame_arena);
+
 #ifdef _WIN32
 	if (handle)
 		AvRevertMmThreadCharacteristics(handle);
@@ -453,6 +507,18 @@ bool audio_output_active(const audio_t *audio)
 	return false;
 }
 
+void audio_output_catch_up(audio_t *audio)
+{
+	if (audio)
+		audio->catch_up = true;
+}
+
+void audio_output_set_realtime(audio_t *audio, bool realtime)
+{
+	if (audio)
+		os_atomic_set_bool(&audio->realtime, realtime);
+}
+
 size_t audio_output_get_block_size(const audio_t *audio)
 {
 	return audio ? audio->block_size : 0;
@@ -90,6 +90,15 @@ typedef bool (*audio_input_callback_t)(void *param, uint64_t start_ts,
 				       uint32_t active_mixers,
 				       struct audio_output_data *mixes);
 
+/* clock the audio thread is paced by, one window is mixed per tick of the
+ * clock.  window timestamps are still in system time. */
+struct audio_output_clock {
+	uint64_t (*get_time_ns)(void *param);
+	uint64_t (*to_system_ns)(void *param, uint64_t time_ns);
+	bool (*sleep_to_ns)(void *param, uint64_t time_ns);
+	void *param;
+};
+
 struct audio_output_info {
 	const char *name;
 
@@ -99,6 +108,9 @@ struct audio_output_info {
 
 	audio_input_callback_t input_callback;
 	void *input_param;
+
+	/* optional, the system clock is used if NULL */
+	const struct audio_output_clock *clock;
 };
 
 struct audio_convert_info {
@@ -222,6 +234,15 @@ EXPORT void audio_output_disconnect(audio_t *video, size_t mix_idx,
 
 EXPORT bool audio_output_active(const audio_t *audio);
 
+/* Called from within the input callback to have it called once more right
+ * away for the same time slot, so the input side can output a tick it had
+ * buffered ahead and reduce its latency. */
+EXPORT void audio_output_catch_up(audio_t *audio);
+
+/* Opts the audio thread in or out of real-time scheduling, see
+ * os_set_thread_realtime. */
+EXPORT void audio_output_set_realtime(audio_t *audio, bool realtime);
+
 EXPORT size_t audio_output_get_block_size(const audio_t *audio);
 EXPORT size_t audio_output_get_planes(const audio_t *audio);
 EXPORT size_t audio_output_get_channels(const audio_t *audio);
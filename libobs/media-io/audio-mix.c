@@ -0,0 +1,128 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <string.h>
+
+#include "../util/sse-intrin.h"
+#include "audio-mix.h"
+
+static void copy_gain_channel(float *dst, const float *src, float gain,
+			      size_t frames)
+{
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 8 <= frames; i += 8) {
+		__m128 a = _mm_loadu_ps(src + i);
+		__m128 b = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(a, g));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(b, g));
+	}
+	for (; i < frames; i++)
+		dst[i] = src[i] * gain;
+}
+
+static void copy_gain_mono(float *const dst[], const float *const src[],
+			   size_t channels, const float gain[], size_t frames)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= frames; i += 4) {
+		__m128 sum = _mm_mul_ps(_mm_loadu_ps(src[0] + i),
+					_mm_set1_ps(gain[0]));
+
+		for (size_t ch = 1; ch < channels; ch++)
+			sum = _mm_add_ps(sum,
+					 _mm_mul_ps(_mm_loadu_ps(src[ch] + i),
+						    _mm_set1_ps(gain[ch])));
+
+		for (size_t ch = 0; ch < channels; ch++)
+			_mm_storeu_ps(dst[ch] + i, sum);
+	}
+
+	for (; i < frames; i++) {
+		float sum = src[0][i] * gain[0];
+
+		for (size_t ch = 1; ch < channels; ch++)
+			sum += src[ch][i] * gain[ch];
+		for (size_t ch = 0; ch < channels; ch++)
+			dst[ch][i] = sum;
+	}
+}
+
+void audio_mix_copy_gain(float *const dst[], const float *const src[],
+			 size_t channels, const float gain[], bool downmix_mono,
+			 size_t frames)
+{
+	if (!channels)
+		return;
+
+	if (downmix_mono && channels > 1) {
+		copy_gain_mono(dst, src, channels, gain, frames);
+		return;
+	}
+
+	for (size_t ch = 0; ch < channels; ch++) {
+		if (gain[ch] == 1.0f)
+			memcpy(dst[ch], src[ch], frames * sizeof(float));
+		else
+			copy_gain_channel(dst[ch], src[ch], gain[ch], frames);
+	}
+}
+
+void audio_mix_mul(float *data, float gain, size_t count)
+{
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a = _mm_loadu_ps(data + i);
+		__m128 b = _mm_loadu_ps(data + i + 4);
+		_mm_storeu_ps(data + i, _mm_mul_ps(a, g));
+		_mm_storeu_ps(data + i + 4, _mm_mul_ps(b, g));
+	}
+	for (; i < count; i++)
+		data[i] *= gain;
+}
+
+void audio_mix_mul_vec(float *data, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 a = _mm_loadu_ps(data + i);
+		_mm_storeu_ps(data + i, _mm_mul_ps(a, _mm_loadu_ps(gain + i)));
+	}
+	for (; i < count; i++)
+		data[i] *= gain[i];
+}
+
+void audio_mix_add(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m128 a = _mm_add_ps(_mm_loadu_ps(dst + i),
+				      _mm_loadu_ps(src + i));
+		__m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4),
+				      _mm_loadu_ps(src + i + 4));
+		_mm_storeu_ps(dst + i, a);
+		_mm_storeu_ps(dst + i + 4, b);
+	}
+	for (; i < count; i++)
+		dst[i] += src[i];
+}
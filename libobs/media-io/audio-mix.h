@@ -0,0 +1,49 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Vectorized kernels for planar float audio, used for per-source processing
+ * and mixing.  None of the pointers need any particular alignment.
+ */
+
+/* copies each channel multiplied by its gain.  when downmixing to mono, every
+ * output channel receives the sum of all gained input channels instead, so
+ * fold the 1/channels average into the gains. */
+EXPORT void audio_mix_copy_gain(float *const dst[], const float *const src[],
+				size_t channels, const float gain[],
+				bool downmix_mono, size_t frames);
+
+/* data *= gain */
+EXPORT void audio_mix_mul(float *data, float gain, size_t count);
+
+/* data *= gain, with a separate gain per sample */
+EXPORT void audio_mix_mul_vec(float *data, const float *gain, size_t count);
+
+/* dst += src */
+EXPORT void audio_mix_add(float *dst, const float *src, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -25,6 +25,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
 
 #if LIBAVCODEC_VERSION_MAJOR >= 58
 #define CODEC_FLAG_GLOBAL_H AV_CODEC_FLAG_GLOBAL_HEADER
@@ -32,11 +33,121 @@
 #define CODEC_FLAG_GLOBAL_H CODEC_FLAG_GLOBAL_HEADER
 #endif
 
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+#define AVIO_WRITE_CONST const
+#else
+#define AVIO_WRITE_CONST
+#endif
+
+/* remuxing is mostly large sequential reads and writes, the default avio
+ * buffers of 32 KiB cause a lot of small file system calls on big files */
+#define REMUX_IO_BUFFER_SIZE (4 * 1024 * 1024)
+
+struct remux_io {
+	FILE *file;
+	AVIOContext *avio;
+	uint64_t bytes;
+};
+
 struct media_remux_job {
 	int64_t in_size;
 	AVFormatContext *ifmt_ctx, *ofmt_ctx;
+	struct remux_io in, out;
+	uint64_t duration_ns;
 };
 
+static int read_packet(void *opaque, uint8_t *buf, int size)
+{
+	struct remux_io *io = opaque;
+	size_t ret = fread(buf, 1, size, io->file);
+
+	if (ret == 0)
+		return ferror(io->file) ? AVERROR(EIO) : AVERROR_EOF;
+
+	io->bytes += ret;
+	return (int)ret;
+}
+
+static int write_packet(void *opaque, AVIO_WRITE_CONST uint8_t *buf, int size)
+{
+	struct remux_io *io = opaque;
+
+	if (fwrite(buf, 1, size, io->file) != (size_t)size)
+		return AVERROR(EIO);
+
+	io->bytes += size;
+	return size;
+}
+
+static int64_t seek_io(void *opaque, int64_t offset, int whence)
+{
+	struct remux_io *io = opaque;
+
+	if (whence & AVSEEK_SIZE) {
+		int64_t pos = os_ftelli64(io->file);
+		int64_t size;
+
+		if (os_fseeki64(io->file, 0, SEEK_END) != 0)
+			return AVERROR(EIO);
+
+		size = os_ftelli64(io->file);
+		os_fseeki64(io->file, pos, SEEK_SET);
+		return size;
+	}
+
+	if (os_fseeki64(io->file, offset, whence & ~AVSEEK_FORCE) != 0)
+		return AVERROR(EIO);
+
+	return os_ftelli64(io->file);
+}
+
+static bool open_io(struct remux_io *io, const char *filename, bool write)
+{
+	uint8_t *buf;
+
+	io->file = os_fopen(filename, write ? "wb" : "rb");
+	if (!io->file)
+		return false;
+
+	/* the avio buffer already batches the I/O, stdio buffering on top of
+	 * it would only add another copy */
+	setvbuf(io->file, NULL, _IONBF, 0);
+
+	buf = av_malloc(REMUX_IO_BUFFER_SIZE);
+	if (!buf)
+		return false;
+
+	io->avio = avio_alloc_context(buf, REMUX_IO_BUFFER_SIZE, write, io,
+				      write ? NULL : read_packet,
+				      write ? write_packet : NULL, seek_io);
+	if (!io->avio) {
+		av_free(buf);
+		return false;
+	}
+
+	return true;
+}
+
+static void close_io(struct remux_io *io)
+{
+	if (io->avio) {
+		if (io->avio->write_flag)
+			avio_flush(io->avio);
+
+		av_freep(&io->avio->buffer);
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 80, 100)
+		avio_context_free(&io->avio);
+#else
+		av_freep(&io->avio);
+#endif
+	}
+
+	if (io->file) {
+		fclose(io->file);
+		io->file = NULL;
+	}
+}
+
 static inline void init_size(media_remux_job_t job, const char *in_filename)
 {
 #ifdef _MSC_VER
@@ -51,7 +162,19 @@ static inline void init_size(media_remux_job_t job, const char *in_filename)
 
 static inline bool init_input(media_remux_job_t job, const char *in_filename)
 {
-	int ret = avformat_open_input(&job->ifmt_ctx, in_filename, NULL, NULL);
+	int ret;
+
+	job->ifmt_ctx = avformat_alloc_context();
+	if (!job->ifmt_ctx || !open_io(&job->in, in_filename, false)) {
+		blog(LOG_ERROR, "media_remux: Could not open input file '%s'",
+		     in_filename);
+		return false;
+	}
+
+	job->ifmt_ctx->pb = job->in.avio;
+	job->ifmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+	ret = avformat_open_input(&job->ifmt_ctx, in_filename, NULL, NULL);
 	if (ret < 0) {
 		blog(LOG_ERROR, "media_remux: Could not open input file '%s'",
 		     in_filename);
@@ -126,15 +249,16 @@ static inline bool init_output(media_remux_job_t job, const char *out_filename)
 #endif
 
 	if (!(job->ofmt_ctx->oformat->flags & AVFMT_NOFILE)) {
-		ret = avio_open(&job->ofmt_ctx->pb, out_filename,
-				AVIO_FLAG_WRITE);
-		if (ret < 0) {
+		if (!open_io(&job->out, out_filename, true)) {
 			blog(LOG_ERROR,
 			     "media_remux: Failed to open output"
 			     " file '%s'",
 			     out_filename);
 			return false;
 		}
+
+		job->ofmt_ctx->pb = job->out.avio;
+		job->ofmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
 	}
 
 	return true;
@@ -242,10 +366,13 @@ bool media_remux_job_process(media_remux_job_t job,
 {
 	int ret;
 	bool success = false;
+	uint64_t start_time;
 
 	if (!job)
 		return success;
 
+	start_time = os_gettime_ns();
+
 	ret = avformat_write_header(job->ofmt_ctx, NULL);
 	if (ret < 0) {
 		blog(LOG_ERROR, "media_remux: Error opening output file: %s",
@@ -266,23 +393,49 @@ bool media_remux_job_process(media_remux_job_t job,
 		success = false;
 	}
 
+	if (job->out.avio)
+		avio_flush(job->out.avio);
+
+	job->duration_ns = os_gettime_ns() - start_time;
+
+	double seconds = (double)job->duration_ns / 1000000000.0;
+	double mb = (double)job->in.bytes / (1024.0 * 1024.0);
+	blog(LOG_INFO,
+	     "media_remux: Remuxed %.1f MB in %.2f seconds (%.1f MB/s)", mb,
+	     seconds, seconds > 0.0 ? mb / seconds : 0.0);
+
 	if (callback != NULL)
 		callback(data, 100.f);
 
 	return success;
 }
 
-void media_remux_job_destroy(media_remux_job_t job)
+void media_remux_job_get_stats(media_remux_job_t job,
+			       struct media_remux_stats *stats)
 {
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
 	if (!job)
 		return;
 
-	avformat_close_input(&job->ifmt_ctx);
+	stats->bytes_read = job->in.bytes;
+	stats->bytes_written = job->out.bytes;
+	stats->duration_ns = job->duration_ns;
+}
 
-	if (job->ofmt_ctx && !(job->ofmt_ctx->oformat->flags & AVFMT_NOFILE))
-		avio_close(job->ofmt_ctx->pb);
+void media_remux_job_destroy(media_remux_job_t job)
+{
+	if (!job)
+		return;
 
+	avformat_close_input(&job->ifmt_ctx);
 	avformat_free_context(job->ofmt_ctx);
 
+	/* custom I/O contexts aren't freed along with the format contexts */
+	close_io(&job->in);
+	close_io(&job->out);
+
 	bfree(job);
 }
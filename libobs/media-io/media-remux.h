@@ -24,6 +24,12 @@ typedef struct media_remux_job *media_remux_job_t;
 
 typedef bool(media_remux_progress_callback)(void *data, float percent);
 
+struct media_remux_stats {
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	uint64_t duration_ns;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,6 +40,8 @@ EXPORT bool media_remux_job_create(media_remux_job_t *job,
 EXPORT bool media_remux_job_process(media_remux_job_t job,
 				    media_remux_progress_callback callback,
 				    void *data);
+EXPORT void media_remux_job_get_stats(media_remux_job_t job,
+				      struct media_remux_stats *stats);
 EXPORT void media_remux_job_destroy(media_remux_job_t job);
 
 #ifdef __cplusplus
@@ -0,0 +1,581 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * Audio buses.
+ *
+ * A bus is an audio source whose audio is the sum of the post-fader audio of
+ * its inputs.  Because it is a regular audio source, a bus has its own filter
+ * chain, volume, monitoring and track (mixer) assignment, and it can itself be
+ * an input of another bus.
+ *
+ * Every source that feeds at least one bus gets a send buffer (taken from a
+ * pool) which the audio thread fills with the source's post-fader audio right
+ * after the source is rendered.  Buses are rendered after all of their inputs
+ * by pushing the bus graph into the audio render order in topological order,
+ * and are mixed into the output tracks as root nodes.
+ */
+
+#include <inttypes.h>
+#include "obs-internal.h"
+#include "util/util_uint64.h"
+
+#define SEND_BUFFER_SIZE \
+	(sizeof(float) * AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS)
+
+struct audio_bus_input {
+	obs_source_t *source;
+	float gain;
+};
+
+struct audio_bus {
+	obs_source_t *source;
+
+	/* protects inputs; the graph as a whole is protected by the core
+	 * buses_mutex, which must be locked first */
+	pthread_mutex_t mutex;
+	DARRAY(struct audio_bus_input) inputs;
+
+	/* set by the audio thread before the bus is rendered */
+	uint64_t tick_ts;
+};
+
+static bool audio_bus_mix(void *data, uint64_t *ts_out,
+			  struct audio_output_data *audio_output,
+			  size_t channels, size_t sample_rate);
+
+static inline struct audio_bus *get_bus(const obs_source_t *source)
+{
+	return source && source->info.audio_mix == audio_bus_mix
+		       ? source->context.data
+		       : NULL;
+}
+
+bool obs_source_is_audio_bus(const obs_source_t *source)
+{
+	return get_bus(source) != NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* send buffer pool, protected by buses_mutex */
+
+static float *send_buffer_acquire(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	float *buf;
+
+	if (audio->bus_buffer_pool.num) {
+		buf = audio->bus_buffer_pool.array[audio->bus_buffer_pool.num -
+						   1];
+		da_pop_back(audio->bus_buffer_pool);
+		memset(buf, 0, SEND_BUFFER_SIZE);
+		return buf;
+	}
+
+	return bzalloc(SEND_BUFFER_SIZE);
+}
+
+static void send_buffer_release(float *buf)
+{
+	if (buf)
+		da_push_back(obs->audio.bus_buffer_pool, &buf);
+}
+
+static void add_send(obs_source_t *source)
+{
+	if (source->audio_send_refs++ == 0) {
+		float *buf = send_buffer_acquire();
+
+		pthread_mutex_lock(&source->audio_buf_mutex);
+		source->audio_send_buf = buf;
+		pthread_mutex_unlock(&source->audio_buf_mutex);
+	}
+}
+
+static void remove_send(obs_source_t *source)
+{
+	if (--source->audio_send_refs == 0) {
+		float *buf;
+
+		pthread_mutex_lock(&source->audio_buf_mutex);
+		buf = source->audio_send_buf;
+		source->audio_send_buf = NULL;
+		pthread_mutex_unlock(&source->audio_buf_mutex);
+
+		send_buffer_release(buf);
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* graph, protected by buses_mutex */
+
+static bool bus_feeds(struct audio_bus *bus, struct audio_bus *target)
+{
+	if (bus == target)
+		return true;
+
+	for (size_t i = 0; i < target->inputs.num; i++) {
+		struct audio_bus *input = get_bus(target->inputs.array[i].source);
+		if (input && bus_feeds(bus, input))
+			return true;
+	}
+
+	return false;
+}
+
+/* length of the longest chain of buses feeding this bus */
+static size_t bus_depth(struct audio_bus *bus)
+{
+	size_t depth = 0;
+
+	if (!bus)
+		return 0;
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_bus *input = get_bus(bus->inputs.array[i].source);
+		if (input) {
+			size_t input_depth = bus_depth(input) + 1;
+			if (input_depth > depth)
+				depth = input_depth;
+		}
+	}
+
+	return depth;
+}
+
+/* sorts the bus list so that every bus comes after the buses feeding it */
+static void update_bus_order(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	size_t num = audio->buses.num;
+	size_t *depth = bmalloc(sizeof(size_t) * (num ? num : 1));
+
+	for (size_t i = 0; i < num; i++)
+		depth[i] = bus_depth(get_bus(audio->buses.array[i]));
+
+	/* stable insertion sort, the bus count is small */
+	for (size_t i = 1; i < num; i++) {
+		obs_source_t *source = audio->buses.array[i];
+		size_t d = depth[i];
+		size_t j = i;
+
+		for (; j > 0 && depth[j - 1] > d; j--) {
+			audio->buses.array[j] = audio->buses.array[j - 1];
+			depth[j] = depth[j - 1];
+		}
+
+		audio->buses.array[j] = source;
+		depth[j] = d;
+	}
+
+	bfree(depth);
+}
+
+static void bus_input_removed(void *data, calldata_t *cd);
+
+static void remove_input_internal(struct audio_bus *bus, size_t idx)
+{
+	obs_source_t *input = bus->inputs.array[idx].source;
+	signal_handler_t *sh = obs_source_get_signal_handler(input);
+
+	signal_handler_disconnect(sh, "remove", bus_input_removed, bus);
+
+	pthread_mutex_lock(&bus->mutex);
+	da_erase(bus->inputs, idx);
+	pthread_mutex_unlock(&bus->mutex);
+
+	remove_send(input);
+	obs_source_release(input);
+}
+
+static size_t find_input(struct audio_bus *bus, obs_source_t *input)
+{
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		if (bus->inputs.array[i].source == input)
+			return i;
+	}
+
+	return DARRAY_INVALID;
+}
+
+static void bus_input_removed(void *data, calldata_t *cd)
+{
+	struct audio_bus *bus = data;
+	obs_source_t *input = calldata_ptr(cd, "source");
+
+	obs_audio_bus_remove_input(bus->source, input);
+}
+
+/* ------------------------------------------------------------------------- */
+/* audio thread */
+
+void audio_bus_push_render_order(uint64_t ts, obs_source_enum_proc_t push,
+				 void *param)
+{
+	struct obs_core_audio *audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->buses_mutex);
+
+	for (size_t i = 0; i < audio->buses.num; i++) {
+		obs_source_t *source = audio->buses.array[i];
+		struct audio_bus *bus = get_bus(source);
+
+		/* still being created, or being destroyed */
+		if (!bus || !obs_source_get_ref(source))
+			continue;
+
+		pthread_mutex_lock(&bus->mutex);
+		for (size_t j = 0; j < bus->inputs.num; j++) {
+			obs_source_t *input = bus->inputs.array[j].source;
+			obs_source_enum_active_tree(input, push, param);
+			push(source, input, param);
+		}
+		pthread_mutex_unlock(&bus->mutex);
+
+		bus->tick_ts = ts;
+
+		/* the render order holds a reference until the end of the tick,
+		 * which keeps the root node valid */
+		push(NULL, source, param);
+		da_push_back(audio->root_nodes, &source);
+		obs_source_release(source);
+	}
+
+	pthread_mutex_unlock(&audio->buses_mutex);
+}
+
+static void mix_input(float *const *mix, obs_source_t *input, float gain,
+		      size_t channels, size_t sample_rate, uint64_t ts)
+{
+	uint64_t end_ts = ts + util_mul_div64(AUDIO_OUTPUT_FRAMES,
+					      1000000000ULL, sample_rate);
+	size_t start_point = 0;
+
+	pthread_mutex_lock(&input->audio_buf_mutex);
+
+	if (!input->audio_send_buf || input->audio_pending ||
+	    input->audio_ts < ts || end_ts <= input->audio_ts)
+		goto unlock;
+
+	if (input->audio_ts != ts) {
+		start_point = (size_t)util_mul_div64(input->audio_ts - ts,
+						     sample_rate,
+						     1000000000ULL);
+		if (start_point >= AUDIO_OUTPUT_FRAMES)
+			goto unlock;
+	}
+
+	for (size_t ch = 0; ch < channels; ch++) {
+		const float *in =
+			input->audio_send_buf + AUDIO_OUTPUT_FRAMES * ch;
+		float *out = mix[ch] + start_point;
+		size_t frames = AUDIO_OUTPUT_FRAMES - start_point;
+
+		for (size_t i = 0; i < frames; i++)
+			out[i] += in[i] * gain;
+	}
+
+unlock:
+	pthread_mutex_unlock(&input->audio_buf_mutex);
+}
+
+static bool audio_bus_mix(void *data, uint64_t *ts_out,
+			  struct audio_output_data *audio_output,
+			  size_t channels, size_t sample_rate)
+{
+	struct audio_bus *bus = data;
+
+	/* not part of the render order yet */
+	if (!bus->tick_ts)
+		return false;
+
+	pthread_mutex_lock(&bus->mutex);
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_bus_input *input = &bus->inputs.array[i];
+		mix_input(audio_output->data, input->source, input->gain,
+			  channels, sample_rate, bus->tick_ts);
+	}
+	pthread_mutex_unlock(&bus->mutex);
+
+	*ts_out = bus->tick_ts;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* source type */
+
+static const char *audio_bus_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "Audio bus";
+}
+
+static void *audio_bus_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct audio_bus *bus = bzalloc(sizeof(*bus));
+	bus->source = source;
+
+	pthread_mutex_init_value(&bus->mutex);
+	if (pthread_mutex_init(&bus->mutex, NULL) != 0) {
+		bfree(bus);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&obs->audio.buses_mutex);
+	da_push_back(obs->audio.buses, &source);
+	pthread_mutex_unlock(&obs->audio.buses_mutex);
+
+	UNUSED_PARAMETER(settings);
+	return bus;
+}
+
+static void audio_bus_destroy(void *data)
+{
+	struct audio_bus *bus = data;
+	struct obs_core_audio *audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->buses_mutex);
+
+	while (bus->inputs.num)
+		remove_input_internal(bus, bus->inputs.num - 1);
+
+	da_erase_item(audio->buses, &bus->source);
+
+	pthread_mutex_unlock(&audio->buses_mutex);
+
+	da_free(bus->inputs);
+	pthread_mutex_destroy(&bus->mutex);
+	bfree(bus);
+}
+
+static void audio_bus_save(void *data, obs_data_t *settings)
+{
+	struct audio_bus *bus = data;
+	obs_data_array_t *array = obs_data_array_create();
+
+	pthread_mutex_lock(&obs->audio.buses_mutex);
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_bus_input *input = &bus->inputs.array[i];
+		obs_data_t *item = obs_data_create();
+
+		obs_data_set_string(item, "name",
+				    obs_source_get_name(input->source));
+		obs_data_set_double(item, "gain", input->gain);
+		obs_data_array_push_back(array, item);
+		obs_data_release(item);
+	}
+
+	pthread_mutex_unlock(&obs->audio.buses_mutex);
+
+	obs_data_set_array(settings, "inputs", array);
+	obs_data_array_release(array);
+}
+
+/* inputs are restored by name in load() rather than create(), because load()
+ * is only called once every saved source exists */
+static void audio_bus_load(void *data, obs_data_t *settings)
+{
+	struct audio_bus *bus = data;
+	obs_data_array_t *array = obs_data_get_array(settings, "inputs");
+	size_t count = obs_data_array_count(array);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const char *name = obs_data_get_string(item, "name");
+		obs_source_t *input = obs_get_source_by_name(name);
+
+		if (input) {
+			obs_audio_bus_add_input(
+				bus->source, input,
+				(float)obs_data_get_double(item, "gain"));
+			obs_source_release(input);
+		} else {
+			blog(LOG_WARNING,
+			     "Audio bus '%s': input '%s' not found",
+			     obs_source_get_name(bus->source), name);
+		}
+
+		obs_data_release(item);
+	}
+
+	obs_data_array_release(array);
+}
+
+const struct obs_source_info audio_bus_info = {
+	.id = "audio_bus",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_CAP_DISABLED,
+	.get_name = audio_bus_name,
+	.create = audio_bus_create,
+	.destroy = audio_bus_destroy,
+	.audio_mix = audio_bus_mix,
+	.save = audio_bus_save,
+	.load = audio_bus_load,
+};
+
+/* ------------------------------------------------------------------------- */
+/* public API */
+
+obs_source_t *obs_audio_bus_create(const char *name, obs_data_t *settings)
+{
+	return obs_source_create("audio_bus", name, settings, NULL);
+}
+
+bool obs_audio_bus_add_input(obs_source_t *bus_source, obs_source_t *input,
+			     float gain)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct audio_bus *bus = get_bus(bus_source);
+	struct audio_bus *input_bus;
+	signal_handler_t *sh;
+	bool success = false;
+
+	if (!obs_ptr_valid(bus, "obs_audio_bus_add_input"))
+		return false;
+	if (!obs_source_valid(input, "obs_audio_bus_add_input"))
+		return false;
+
+	if ((input->info.output_flags & OBS_SOURCE_AUDIO) == 0 ||
+	    input->info.audio_render) {
+		blog(LOG_WARNING,
+		     "Audio bus '%s': '%s' cannot be used as an input, only "
+		     "audio sources and other buses can",
+		     obs_source_get_name(bus_source),
+		     obs_source_get_name(input));
+		return false;
+	}
+
+	pthread_mutex_lock(&audio->buses_mutex);
+
+	if (find_input(bus, input) != DARRAY_INVALID)
+		goto unlock;
+
+	input_bus = get_bus(input);
+	if (input_bus && bus_feeds(bus, input_bus)) {
+		blog(LOG_WARNING,
+		     "Audio bus '%s': adding '%s' would create a loop",
+		     obs_source_get_name(bus_source),
+		     obs_source_get_name(input));
+		goto unlock;
+	}
+
+	input = obs_source_get_ref(input);
+	if (!input)
+		goto unlock;
+
+	add_send(input);
+
+	struct audio_bus_input item = {input, gain};
+	pthread_mutex_lock(&bus->mutex);
+	da_push_back(bus->inputs, &item);
+	pthread_mutex_unlock(&bus->mutex);
+
+	sh = obs_source_get_signal_handler(input);
+	signal_handler_connect(sh, "remove", bus_input_removed, bus);
+
+	if (input_bus)
+		update_bus_order();
+	success = true;
+
+unlock:
+	pthread_mutex_unlock(&audio->buses_mutex);
+	return success;
+}
+
+void obs_audio_bus_remove_input(obs_source_t *bus_source, obs_source_t *input)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct audio_bus *bus = get_bus(bus_source);
+	size_t idx;
+
+	if (!obs_ptr_valid(bus, "obs_audio_bus_remove_input"))
+		return;
+
+	pthread_mutex_lock(&audio->buses_mutex);
+
+	idx = find_input(bus, input);
+	if (idx != DARRAY_INVALID)
+		remove_input_internal(bus, idx);
+
+	pthread_mutex_unlock(&audio->buses_mutex);
+}
+
+void obs_audio_bus_set_input_gain(obs_source_t *bus_source,
+				  obs_source_t *input, float gain)
+{
+	struct audio_bus *bus = get_bus(bus_source);
+	size_t idx;
+
+	if (!obs_ptr_valid(bus, "obs_audio_bus_set_input_gain"))
+		return;
+
+	pthread_mutex_lock(&obs->audio.buses_mutex);
+	pthread_mutex_lock(&bus->mutex);
+
+	idx = find_input(bus, input);
+	if (idx != DARRAY_INVALID)
+		bus->inputs.array[idx].gain = gain;
+
+	pthread_mutex_unlock(&bus->mutex);
+	pthread_mutex_unlock(&obs->audio.buses_mutex);
+}
+
+void obs_audio_bus_enum_inputs(obs_source_t *bus_source,
+			       obs_audio_bus_enum_proc_t enum_proc,
+			       void *param)
+{
+	struct audio_bus *bus = get_bus(bus_source);
+
+	if (!obs_ptr_valid(bus, "obs_audio_bus_enum_inputs"))
+		return;
+
+	pthread_mutex_lock(&obs->audio.buses_mutex);
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_bus_input *input = &bus->inputs.array[i];
+		if (!enum_proc(param, input->source, input->gain))
+			break;
+	}
+
+	pthread_mutex_unlock(&obs->audio.buses_mutex);
+}
+
+void obs_enum_audio_buses(bool (*enum_proc)(void *, obs_source_t *),
+			  void *param)
+{
+	pthread_mutex_lock(&obs->audio.buses_mutex);
+
+	for (size_t i = 0; i < obs->audio.buses.num; i++) {
+		if (!enum_proc(param, obs->audio.buses.array[i]))
+			break;
+	}
+
+	pthread_mutex_unlock(&obs->audio.buses_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void audio_bus_free_pool(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+
+	for (size_t i = 0; i < audio->bus_buffer_pool.num; i++)
+		bfree(audio->bus_buffer_pool.array[i]);
+	da_free(audio->bus_buffer_pool);
+	da_free(audio->buses);
+}
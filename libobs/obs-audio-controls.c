@@ -63,14 +63,60 @@ struct meter_cb {
 	void *param;
 };
 
+struct loudness_cb {
+	obs_volmeter_loudness_updated_t callback;
+	void *param;
+};
+
+/* EBU R128 loudness is measured over 100 ms blocks.  Momentary loudness uses
+ * the last 4 blocks, short-term loudness the last 30 blocks, and integrated
+ * loudness gates overlapping 400 ms windows through a histogram with 0.1 LU
+ * bins between -70 and +30 LUFS. */
+#define LOUDNESS_SHORT_TERM_BLOCKS 30
+#define LOUDNESS_MOMENTARY_BLOCKS 4
+#define LOUDNESS_HIST_BINS 1000
+#define LOUDNESS_ABS_GATE -70.0
+#define LOUDNESS_REL_GATE -10.0
+#define LOUDNESS_GROUPS (MAX_AUDIO_CHANNELS / 4)
+
+struct volmeter_loudness {
+	uint32_t sample_rate;
+	enum speaker_layout speakers;
+	float weight[MAX_AUDIO_CHANNELS];
+
+	/* K-weighting filter: a high shelf followed by a high pass, each a
+	 * transposed direct form II biquad.  Four channels are filtered at
+	 * once, one per vector lane. */
+	float b[2][3];
+	float a[2][2];
+	__m128 z[LOUDNESS_GROUPS][2][2];
+
+	__m128 block_sum[LOUDNESS_GROUPS];
+	size_t block_frames;
+	size_t block_pos;
+
+	double blocks[LOUDNESS_SHORT_TERM_BLOCKS];
+	size_t block_idx;
+	size_t block_count;
+
+	uint64_t hist_count[LOUDNESS_HIST_BINS];
+	double hist_energy[LOUDNESS_HIST_BINS];
+
+	struct obs_volmeter_loudness values;
+};
+
 struct obs_volmeter {
 	pthread_mutex_t mutex;
 	obs_source_t *source;
 	enum obs_fader_type type;
 	float cur_db;
 
+	bool mix_attached;
+	size_t mix_idx;
+
 	pthread_mutex_t callback_mutex;
 	DARRAY(struct meter_cb) callbacks;
+	DARRAY(struct loudness_cb) loudness_callbacks;
 
 	enum obs_peak_meter_type peak_meter_type;
 	unsigned int update_ms;
@@ -78,6 +124,8 @@ struct obs_volmeter {
 
 	float magnitude[MAX_AUDIO_CHANNELS];
 	float peak[MAX_AUDIO_CHANNELS];
+
+	struct volmeter_loudness *loudness;
 };
 
 static float cubic_def_to_db(const float def)
@@ -212,6 +260,17 @@ static void signal_levels_updated(struct obs_volmeter *volmeter,
 	pthread_mutex_unlock(&volmeter->callback_mutex);
 }
 
+static void signal_loudness_updated(struct obs_volmeter *volmeter,
+				    const struct obs_volmeter_loudness *loudness)
+{
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	for (size_t i = volmeter->loudness_callbacks.num; i > 0; i--) {
+		struct loudness_cb cb = volmeter->loudness_callbacks.array[i - 1];
+		cb.callback(cb.param, loudness);
+	}
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+}
+
 static void fader_source_volume_changed(void *vptr, calldata_t *calldata)
 {
 	struct obs_fader *fader = (struct obs_fader *)vptr;
@@ -313,6 +372,26 @@ static int get_nr_channels_from_audio_data(const struct audio_data *data)
 		r = fmaxf(r, x4_mem[3]);   \
 	} while (false)
 
+/* x4(d, c, b, a)  -->  a + b + c + d
+ */
+static inline float hsum_ps(__m128 x4)
+{
+	float x4_mem[4];
+	_mm_storeu_ps(x4_mem, x4);
+	return (x4_mem[0] + x4_mem[1]) + (x4_mem[2] + x4_mem[3]);
+}
+
+/* Sum of squares of the samples that don't fill a whole vector.
+ */
+static inline float sum_sq_tail(const float *samples, size_t i,
+				size_t nr_samples)
+{
+	float sum = 0.0f;
+	for (; i < nr_samples; i++)
+		sum += samples[i] * samples[i];
+	return sum;
+}
+
 /* Calculate the true peak over a set of samples.
  * The algorithm implements 5x oversampling by using Whittaker–Shannon
  * interpolation over four samples.
@@ -320,13 +399,17 @@ static int get_nr_channels_from_audio_data(const struct audio_data *data)
  * The four samples have location t=-1.5, -0.5, +0.5, +1.5
  * The oversamples are taken at locations t=-0.3, -0.1, +0.1, +0.3
  *
+ * The sum of the squares of the samples is accumulated in the same pass, for
+ * the magnitude.
+ *
  * @param previous_samples  Last 4 samples from the previous iteration.
  * @param samples           The samples to find the peak in.
  * @param nr_samples        Number of sets of 4 samples.
+ * @param sum_sq            Receives the sum of squares of the samples.
  * @returns 5 times oversampled true-peak from the set of samples.
  */
 static float get_true_peak(__m128 previous_samples, const float *samples,
-			   size_t nr_samples)
+			   size_t nr_samples, float *sum_sq)
 {
 	/* These are normalized-sinc parameters for interpolating over sample
 	 * points which are located at x-coords: -1.5, -0.5, +0.5, +1.5.
@@ -342,10 +425,14 @@ static float get_true_peak(__m128 previous_samples, const float *samples,
 
 	__m128 work = previous_samples;
 	__m128 peak = previous_samples;
-	for (size_t i = 0; (i + 3) < nr_samples; i += 4) {
+	__m128 sum = _mm_setzero_ps();
+	size_t i = 0;
+	for (; (i + 3) < nr_samples; i += 4) {
 		__m128 new_work = _mm_load_ps(&samples[i]);
 		__m128 intrp_samples;
 
+		sum = _mm_add_ps(sum, _mm_mul_ps(new_work, new_work));
+
 		/* Include the actual sample values in the peak. */
 		__m128 abs_new_work = abs_ps(new_work);
 		peak = _mm_max_ps(peak, abs_new_work);
@@ -368,6 +455,8 @@ static float get_true_peak(__m128 previous_samples, const float *samples,
 		peak = _mm_max_ps(peak, abs_ps(intrp_samples));
 	}
 
+	*sum_sq = hsum_ps(sum) + sum_sq_tail(samples, i, nr_samples);
+
 	float r;
 	hmax_ps(r, peak);
 	return r;
@@ -377,14 +466,19 @@ static float get_true_peak(__m128 previous_samples, const float *samples,
  * over. They will have come from a previous iteration.
  */
 static float get_sample_peak(__m128 previous_samples, const float *samples,
-			     size_t nr_samples)
+			     size_t nr_samples, float *sum_sq)
 {
 	__m128 peak = previous_samples;
-	for (size_t i = 0; (i + 3) < nr_samples; i += 4) {
+	__m128 sum = _mm_setzero_ps();
+	size_t i = 0;
+	for (; (i + 3) < nr_samples; i += 4) {
 		__m128 new_work = _mm_load_ps(&samples[i]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(new_work, new_work));
 		peak = _mm_max_ps(peak, abs_ps(new_work));
 	}
 
+	*sum_sq = hsum_ps(sum) + sum_sq_tail(samples, i, nr_samples);
+
 	float r;
 	hmax_ps(r, peak);
 	return r;
@@ -433,6 +527,7 @@ static void volmeter_process_peak_last_samples(obs_volmeter_t *volmeter,
 	}
 }
 
+/* Computes peak and magnitude of every channel in one pass over the samples */
 static void volmeter_process_peak(obs_volmeter_t *volmeter,
 				  const struct audio_data *data,
 				  int nr_channels)
@@ -449,6 +544,9 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 			       "peak volume measurement.\n",
 			       plane_nr, samples);
 			volmeter->peak[channel_nr] = 1.0;
+			volmeter->magnitude[channel_nr] = sqrtf(
+				sum_sq_tail(samples, 0, nr_samples) /
+				nr_samples);
 			channel_nr++;
 			continue;
 		}
@@ -459,16 +557,17 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 			_mm_loadu_ps(volmeter->prev_samples[channel_nr]);
 
 		float peak;
+		float sum_sq;
 		switch (volmeter->peak_meter_type) {
 		case TRUE_PEAK_METER:
 			peak = get_true_peak(previous_samples, samples,
-					     nr_samples);
+					     nr_samples, &sum_sq);
 			break;
 
 		case SAMPLE_PEAK_METER:
 		default:
 			peak = get_sample_peak(previous_samples, samples,
-					       nr_samples);
+					       nr_samples, &sum_sq);
 			break;
 		}
 
@@ -476,6 +575,7 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 						   samples, nr_samples);
 
 		volmeter->peak[channel_nr] = peak;
+		volmeter->magnitude[channel_nr] = sqrtf(sum_sq / nr_samples);
 
 		channel_nr++;
 	}
@@ -486,28 +586,293 @@ static void volmeter_process_peak(obs_volmeter_t *volmeter,
 	}
 }
 
-static void volmeter_process_magnitude(obs_volmeter_t *volmeter,
-				       const struct audio_data *data,
-				       int nr_channels)
+/* BS.1770 channel weights, in the channel order used by libobs */
+static void loudness_set_weights(struct volmeter_loudness *ld)
+{
+	static const float surround = 1.41f;
+	float *w = ld->weight;
+
+	memset(w, 0, sizeof(ld->weight));
+
+	switch (ld->speakers) {
+	case SPEAKERS_MONO:
+		w[0] = 1.0f;
+		break;
+	case SPEAKERS_2POINT1:
+		w[0] = w[1] = 1.0f; /* LFE is not measured */
+		break;
+	case SPEAKERS_4POINT0:
+		w[0] = w[1] = w[2] = w[3] = 1.0f;
+		break;
+	case SPEAKERS_4POINT1:
+		w[0] = w[1] = w[2] = w[4] = 1.0f;
+		break;
+	case SPEAKERS_5POINT1:
+		w[0] = w[1] = w[2] = 1.0f;
+		w[4] = w[5] = surround;
+		break;
+	case SPEAKERS_7POINT1:
+		w[0] = w[1] = w[2] = 1.0f;
+		w[4] = w[5] = w[6] = w[7] = surround;
+		break;
+	case SPEAKERS_STEREO:
+	case SPEAKERS_UNKNOWN:
+	default:
+		w[0] = w[1] = 1.0f;
+		break;
+	}
+}
+
+/* K-weighting filter coefficients for any sample rate, matching the BS.1770
+ * reference coefficients at 48 kHz */
+static void loudness_set_filter(struct volmeter_loudness *ld)
+{
+	double rate = (double)ld->sample_rate;
+	double f0, q, k, a0;
+
+	/* high shelf, +4 dB above ~1.7 kHz */
+	f0 = 1681.974450955533;
+	q = 0.7071752369554196;
+	const double g = 3.999843853973347;
+	const double vh = pow(10.0, g / 20.0);
+	const double vb = pow(vh, 0.4996667741545416);
+
+	k = tan(M_PI * f0 / rate);
+	a0 = 1.0 + k / q + k * k;
+	ld->b[0][0] = (float)((vh + vb * k / q + k * k) / a0);
+	ld->b[0][1] = (float)(2.0 * (k * k - vh) / a0);
+	ld->b[0][2] = (float)((vh - vb * k / q + k * k) / a0);
+	ld->a[0][0] = (float)(2.0 * (k * k - 1.0) / a0);
+	ld->a[0][1] = (float)((1.0 - k / q + k * k) / a0);
+
+	/* high pass at ~38 Hz */
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+
+	k = tan(M_PI * f0 / rate);
+	a0 = 1.0 + k / q + k * k;
+	ld->b[1][0] = 1.0f;
+	ld->b[1][1] = -2.0f;
+	ld->b[1][2] = 1.0f;
+	ld->a[1][0] = (float)(2.0 * (k * k - 1.0) / a0);
+	ld->a[1][1] = (float)((1.0 - k / q + k * k) / a0);
+}
+
+static void loudness_reset(struct volmeter_loudness *ld)
+{
+	const struct audio_output_info *info =
+		audio_output_get_info(obs->audio.audio);
+	memset(ld, 0, sizeof(*ld));
+
+	ld->sample_rate = info ? info->samples_per_sec : 48000;
+	ld->speakers = info ? info->speakers : SPEAKERS_STEREO;
+	ld->block_frames = ld->sample_rate / 10;
+
+	loudness_set_weights(ld);
+	loudness_set_filter(ld);
+
+	ld->values.momentary = -INFINITY;
+	ld->values.short_term = -INFINITY;
+	ld->values.integrated = -INFINITY;
+}
+
+static inline double energy_to_lufs(double energy)
+{
+	return energy > 0.0 ? -0.691 + 10.0 * log10(energy) : -INFINITY;
+}
+
+static inline double lufs_to_energy(double lufs)
+{
+	return pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+static double loudness_mean(const struct volmeter_loudness *ld, size_t count)
+{
+	double sum = 0.0;
+
+	if (count > ld->block_count)
+		count = ld->block_count;
+	if (!count)
+		return 0.0;
+
+	for (size_t i = 1; i <= count; i++) {
+		size_t idx = (ld->block_idx + LOUDNESS_SHORT_TERM_BLOCKS - i) %
+			     LOUDNESS_SHORT_TERM_BLOCKS;
+		sum += ld->blocks[idx];
+	}
+
+	return sum / (double)count;
+}
+
+static double loudness_integrated(const struct volmeter_loudness *ld)
+{
+	uint64_t count = 0;
+	double energy = 0.0;
+	int first_bin;
+
+	for (int i = 0; i < LOUDNESS_HIST_BINS; i++) {
+		count += ld->hist_count[i];
+		energy += ld->hist_energy[i];
+	}
+	if (!count)
+		return -INFINITY;
+
+	/* relative gate, 10 LU below the absolute-gated loudness */
+	double gate = energy_to_lufs(energy / (double)count) + LOUDNESS_REL_GATE;
+	first_bin = (int)ceil((gate - LOUDNESS_ABS_GATE) * 10.0);
+	if (first_bin < 0)
+		first_bin = 0;
+
+	count = 0;
+	energy = 0.0;
+	for (int i = first_bin; i < LOUDNESS_HIST_BINS; i++) {
+		count += ld->hist_count[i];
+		energy += ld->hist_energy[i];
+	}
+
+	return count ? energy_to_lufs(energy / (double)count) : -INFINITY;
+}
+
+static void loudness_finish_block(struct volmeter_loudness *ld, float mul)
 {
-	size_t nr_samples = data->frames;
+	float sums[MAX_AUDIO_CHANNELS];
+	double energy = 0.0;
+
+	for (int g = 0; g < LOUDNESS_GROUPS; g++) {
+		_mm_storeu_ps(&sums[g * 4], ld->block_sum[g]);
+		ld->block_sum[g] = _mm_setzero_ps();
+
+		/* flush denormals out of the filter state so silence
+		 * doesn't slow down the filter */
+		const __m128 tiny = _mm_set1_ps(1e-15f);
+		for (int st = 0; st < 2; st++) {
+			for (int n = 0; n < 2; n++) {
+				__m128 z = ld->z[g][st][n];
+				__m128 keep = _mm_cmpge_ps(abs_ps(z), tiny);
+				ld->z[g][st][n] = _mm_and_ps(z, keep);
+			}
+		}
+	}
+
+	for (int ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		energy += (double)ld->weight[ch] * (double)sums[ch];
+	energy *= (double)mul * (double)mul / (double)ld->block_frames;
+
+	ld->blocks[ld->block_idx] = energy;
+	ld->block_idx = (ld->block_idx + 1) % LOUDNESS_SHORT_TERM_BLOCKS;
+	if (ld->block_count < LOUDNESS_SHORT_TERM_BLOCKS)
+		ld->block_count++;
+
+	double momentary = loudness_mean(ld, LOUDNESS_MOMENTARY_BLOCKS);
+	double short_term = loudness_mean(ld, LOUDNESS_SHORT_TERM_BLOCKS);
+
+	/* gating blocks are 400 ms long and overlap by 75% */
+	if (ld->block_count >= LOUDNESS_MOMENTARY_BLOCKS) {
+		double lufs = energy_to_lufs(momentary);
+		if (lufs > LOUDNESS_ABS_GATE) {
+			int bin = (int)((lufs - LOUDNESS_ABS_GATE) * 10.0);
+			if (bin >= LOUDNESS_HIST_BINS)
+				bin = LOUDNESS_HIST_BINS - 1;
+			ld->hist_count[bin]++;
+			ld->hist_energy[bin] += momentary;
+		}
+	}
+
+	ld->values.momentary = (float)energy_to_lufs(momentary);
+	ld->values.short_term = (float)energy_to_lufs(short_term);
+	ld->values.integrated = (float)loudness_integrated(ld);
+}
+
+/* Runs the K-weighting filter over four channels at a time and accumulates
+ * the squared output per 100 ms block.  Returns true if a block finished. */
+static bool volmeter_process_loudness(obs_volmeter_t *volmeter,
+				      const struct audio_data *data,
+				      int nr_channels, float mul)
+{
+	struct volmeter_loudness *ld = volmeter->loudness;
+	uint32_t sample_rate = audio_output_get_sample_rate(obs->audio.audio);
+	const float *planes[MAX_AUDIO_CHANNELS] = {0};
+	bool finished = false;
+	int groups;
+
+	if (ld->sample_rate != sample_rate)
+		loudness_reset(ld);
 
 	int channel_nr = 0;
 	for (int plane_nr = 0; channel_nr < nr_channels; plane_nr++) {
-		float *samples = (float *)data->data[plane_nr];
-		if (!samples) {
-			continue;
+		if (data->data[plane_nr])
+			planes[channel_nr++] =
+				(const float *)data->data[plane_nr];
+	}
+	groups = (nr_channels + 3) / 4;
+
+	const __m128 b0[2] = {_mm_set1_ps(ld->b[0][0]),
+			      _mm_set1_ps(ld->b[1][0])};
+	const __m128 b1[2] = {_mm_set1_ps(ld->b[0][1]),
+			      _mm_set1_ps(ld->b[1][1])};
+	const __m128 b2[2] = {_mm_set1_ps(ld->b[0][2]),
+			      _mm_set1_ps(ld->b[1][2])};
+	const __m128 a1[2] = {_mm_set1_ps(ld->a[0][0]),
+			      _mm_set1_ps(ld->a[1][0])};
+	const __m128 a2[2] = {_mm_set1_ps(ld->a[0][1]),
+			      _mm_set1_ps(ld->a[1][1])};
+
+	uint32_t frame = 0;
+	while (frame < data->frames) {
+		uint32_t end = data->frames;
+		if (end - frame > ld->block_frames - ld->block_pos)
+			end = frame + (uint32_t)(ld->block_frames -
+						 ld->block_pos);
+
+		for (int g = 0; g < groups; g++) {
+			const float *p0 = planes[g * 4];
+			const float *p1 = planes[g * 4 + 1];
+			const float *p2 = planes[g * 4 + 2];
+			const float *p3 = planes[g * 4 + 3];
+			__m128 z[2][2];
+			__m128 sum = ld->block_sum[g];
+
+			memcpy(z, ld->z[g], sizeof(z));
+
+			for (uint32_t i = frame; i < end; i++) {
+				__m128 x = _mm_set_ps(p3 ? p3[i] : 0.0f,
+						      p2 ? p2[i] : 0.0f,
+						      p1 ? p1[i] : 0.0f,
+						      p0[i]);
+
+				for (int st = 0; st < 2; st++) {
+					__m128 y = _mm_add_ps(
+						_mm_mul_ps(b0[st], x),
+						z[st][0]);
+					z[st][0] = _mm_add_ps(
+						_mm_sub_ps(
+							_mm_mul_ps(b1[st], x),
+							_mm_mul_ps(a1[st], y)),
+						z[st][1]);
+					z[st][1] = _mm_sub_ps(
+						_mm_mul_ps(b2[st], x),
+						_mm_mul_ps(a2[st], y));
+					x = y;
+				}
+
+				sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+			}
+
+			memcpy(ld->z[g], z, sizeof(z));
+			ld->block_sum[g] = sum;
 		}
 
-		float sum = 0.0;
-		for (size_t i = 0; i < nr_samples; i++) {
-			float sample = samples[i];
-			sum += sample * sample;
-		}
-		volmeter->magnitude[channel_nr] = sqrtf(sum / nr_samples);
+		ld->block_pos += end - frame;
+		frame = end;
 
-		channel_nr++;
+		if (ld->block_pos == ld->block_frames) {
+			ld->block_pos = 0;
+			loudness_finish_block(ld, mul);
+			finished = true;
+		}
 	}
+
+	return finished;
 }
 
 static void volmeter_process_audio_data(obs_volmeter_t *volmeter,
@@ -516,27 +881,37 @@ static void volmeter_process_audio_data(obs_volmeter_t *volmeter,
 	int nr_channels = get_nr_channels_from_audio_data(data);
 
 	volmeter_process_peak(volmeter, data, nr_channels);
-	volmeter_process_magnitude(volmeter, data, nr_channels);
 }
 
-static void volmeter_source_data_received(void *vptr, obs_source_t *source,
-					  const struct audio_data *data,
-					  bool muted)
+static void volmeter_process(struct obs_volmeter *volmeter,
+			     const struct audio_data *data, bool apply_volume,
+			     bool muted)
 {
-	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
 	float mul;
 	float magnitude[MAX_AUDIO_CHANNELS];
 	float peak[MAX_AUDIO_CHANNELS];
 	float input_peak[MAX_AUDIO_CHANNELS];
+	struct obs_volmeter_loudness loudness;
+	bool loudness_updated = false;
 
 	pthread_mutex_lock(&volmeter->mutex);
 
 	volmeter_process_audio_data(volmeter, data);
 
+	if (muted)
+		mul = 0.0f;
+	else
+		mul = apply_volume ? db_to_mul(volmeter->cur_db) : 1.0f;
+
+	if (volmeter->loudness) {
+		int nr_channels = get_nr_channels_from_audio_data(data);
+		loudness_updated = volmeter_process_loudness(
+			volmeter, data, nr_channels, mul);
+		loudness = volmeter->loudness->values;
+	}
+
 	// Adjust magnitude/peak based on the volume level set by the user.
 	// And convert to dB.
-	mul = muted && !obs_source_muted(source) ? 0.0f
-						 : db_to_mul(volmeter->cur_db);
 	for (int channel_nr = 0; channel_nr < MAX_AUDIO_CHANNELS;
 	     channel_nr++) {
 		magnitude[channel_nr] =
@@ -551,8 +926,29 @@ static void volmeter_source_data_received(void *vptr, obs_source_t *source,
 	pthread_mutex_unlock(&volmeter->mutex);
 
 	signal_levels_updated(volmeter, magnitude, peak, input_peak);
+	if (loudness_updated)
+		signal_loudness_updated(volmeter, &loudness);
+}
+
+static void volmeter_source_data_received(void *vptr, obs_source_t *source,
+					  const struct audio_data *data,
+					  bool muted)
+{
+	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
+
+	volmeter_process(volmeter, data, true,
+			 muted && !obs_source_muted(source));
+}
 
-	UNUSED_PARAMETER(source);
+static void volmeter_mix_data_received(void *vptr, size_t mix_idx,
+				       struct audio_data *data)
+{
+	struct obs_volmeter *volmeter = (struct obs_volmeter *)vptr;
+
+	/* output mixes already have every volume applied */
+	volmeter_process(volmeter, data, false, false);
+
+	UNUSED_PARAMETER(mix_idx);
 }
 
 obs_fader_t *obs_fader_create(enum obs_fader_type type)
@@ -797,6 +1193,8 @@ void obs_volmeter_destroy(obs_volmeter_t *volmeter)
 
 	obs_volmeter_detach_source(volmeter);
 	da_free(volmeter->callbacks);
+	da_free(volmeter->loudness_callbacks);
+	bfree(volmeter->loudness);
 	pthread_mutex_destroy(&volmeter->callback_mutex);
 	pthread_mutex_destroy(&volmeter->mutex);
 
@@ -832,10 +1230,27 @@ bool obs_volmeter_attach_source(obs_volmeter_t *volmeter, obs_source_t *source)
 	return true;
 }
 
+bool obs_volmeter_attach_mix(obs_volmeter_t *volmeter, size_t mix_idx)
+{
+	if (!volmeter || mix_idx >= MAX_AUDIO_MIXES || !obs->audio.audio)
+		return false;
+
+	obs_volmeter_detach_source(volmeter);
+
+	pthread_mutex_lock(&volmeter->mutex);
+	volmeter->mix_attached = true;
+	volmeter->mix_idx = mix_idx;
+	pthread_mutex_unlock(&volmeter->mutex);
+
+	return audio_output_connect(obs->audio.audio, mix_idx, NULL,
+				    volmeter_mix_data_received, volmeter);
+}
+
 void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 {
 	signal_handler_t *sh;
 	obs_source_t *source;
+	bool mix_attached;
 
 	if (!volmeter)
 		return;
@@ -843,8 +1258,14 @@ void obs_volmeter_detach_source(obs_volmeter_t *volmeter)
 	pthread_mutex_lock(&volmeter->mutex);
 	source = volmeter->source;
 	volmeter->source = NULL;
+	mix_attached = volmeter->mix_attached;
+	volmeter->mix_attached = false;
 	pthread_mutex_unlock(&volmeter->mutex);
 
+	if (mix_attached && obs->audio.audio)
+		audio_output_disconnect(obs->audio.audio, volmeter->mix_idx,
+					volmeter_mix_data_received, volmeter);
+
 	if (!source)
 		return;
 
@@ -896,6 +1317,8 @@ int obs_volmeter_get_nr_channels(obs_volmeter_t *volmeter)
 	if (volmeter->source) {
 		source_nr_audio_channels = get_audio_channels(
 			volmeter->source->sample_info.speakers);
+	} else if (volmeter->mix_attached) {
+		source_nr_audio_channels = MAX_AUDIO_CHANNELS;
 	} else {
 		source_nr_audio_channels = 1;
 	}
@@ -936,6 +1359,81 @@ void obs_volmeter_remove_callback(obs_volmeter_t *volmeter,
 	pthread_mutex_unlock(&volmeter->callback_mutex);
 }
 
+void obs_volmeter_add_loudness_callback(
+	obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+	void *param)
+{
+	struct loudness_cb cb = {callback, param};
+
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_add_loudness_callback"))
+		return;
+
+	/* loudness is only measured while someone is listening */
+	pthread_mutex_lock(&volmeter->mutex);
+	if (!volmeter->loudness) {
+		volmeter->loudness = bmalloc(sizeof(struct volmeter_loudness));
+		loudness_reset(volmeter->loudness);
+	}
+	pthread_mutex_unlock(&volmeter->mutex);
+
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	da_push_back(volmeter->loudness_callbacks, &cb);
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+}
+
+void obs_volmeter_remove_loudness_callback(
+	obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+	void *param)
+{
+	struct loudness_cb cb = {callback, param};
+	bool empty;
+
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_remove_loudness_callback"))
+		return;
+
+	pthread_mutex_lock(&volmeter->callback_mutex);
+	da_erase_item(volmeter->loudness_callbacks, &cb);
+	empty = volmeter->loudness_callbacks.num == 0;
+	pthread_mutex_unlock(&volmeter->callback_mutex);
+
+	if (empty) {
+		pthread_mutex_lock(&volmeter->mutex);
+		bfree(volmeter->loudness);
+		volmeter->loudness = NULL;
+		pthread_mutex_unlock(&volmeter->mutex);
+	}
+}
+
+void obs_volmeter_reset_loudness(obs_volmeter_t *volmeter)
+{
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_reset_loudness"))
+		return;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	if (volmeter->loudness)
+		loudness_reset(volmeter->loudness);
+	pthread_mutex_unlock(&volmeter->mutex);
+}
+
+bool obs_volmeter_get_loudness(obs_volmeter_t *volmeter,
+			       struct obs_volmeter_loudness *loudness)
+{
+	bool success = false;
+
+	if (!obs_ptr_valid(volmeter, "obs_volmeter_get_loudness") ||
+	    !obs_ptr_valid(loudness, "obs_volmeter_get_loudness"))
+		return false;
+
+	pthread_mutex_lock(&volmeter->mutex);
+	if (volmeter->loudness) {
+		*loudness = volmeter->loudness->values;
+		success = true;
+	}
+	pthread_mutex_unlock(&volmeter->mutex);
+
+	return success;
+}
+
 float obs_mul_to_db(float mul)
 {
 	return mul_to_db(mul);
@@ -217,7 +217,18 @@ EXPORT bool obs_volmeter_attach_source(obs_volmeter_t *volmeter,
 				       obs_source_t *source);
 
 /**
- * @brief Detach the volume meter from the currently attached source
+ * @brief Attach the volume meter to an output mix
+ * @param volmeter pointer to the volume meter object
+ * @param mix_idx index of the audio mix (track) to measure
+ * @return true on success
+ *
+ * The levels of the mix are reported as they are sent to the outputs, after
+ * the volume of every source has been applied.
+ */
+EXPORT bool obs_volmeter_attach_mix(obs_volmeter_t *volmeter, size_t mix_idx);
+
+/**
+ * @brief Detach the volume meter from the currently attached source or mix
  * @param volmeter pointer to the volume meter object
  */
 EXPORT void obs_volmeter_detach_source(obs_volmeter_t *volmeter);
@@ -279,6 +290,45 @@ EXPORT void obs_volmeter_remove_callback(obs_volmeter_t *volmeter,
 					 obs_volmeter_updated_t callback,
 					 void *param);
 
+/**
+ * @brief EBU R128 loudness values, in LUFS
+ *
+ * Values are -INFINITY until enough audio has been measured.
+ */
+struct obs_volmeter_loudness {
+	float momentary;  /**< 400 ms window */
+	float short_term; /**< 3 s window */
+	float integrated; /**< gated, since the last reset */
+};
+
+typedef void (*obs_volmeter_loudness_updated_t)(
+	void *param, const struct obs_volmeter_loudness *loudness);
+
+/**
+ * @brief Add a loudness callback
+ *
+ * Loudness is only measured while at least one loudness callback is
+ * registered.  Callbacks are called every 100 ms of audio.
+ */
+EXPORT void obs_volmeter_add_loudness_callback(
+	obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+	void *param);
+EXPORT void obs_volmeter_remove_loudness_callback(
+	obs_volmeter_t *volmeter, obs_volmeter_loudness_updated_t callback,
+	void *param);
+
+/**
+ * @brief Restart the loudness measurement (integrated loudness included)
+ */
+EXPORT void obs_volmeter_reset_loudness(obs_volmeter_t *volmeter);
+
+/**
+ * @brief Get the latest loudness values
+ * @return false if loudness is not being measured
+ */
+EXPORT bool obs_volmeter_get_loudness(obs_volmeter_t *volmeter,
+				      struct obs_volmeter_loudness *loudness);
+
 EXPORT float obs_mul_to_db(float mul);
 EXPORT float obs_db_to_mul(float db);
 
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "media-io/audio-mix.h"
 
 struct ts_info {
 	uint64_t start;
@@ -28,6 +29,9 @@ struct ts_info {
 #define DEBUG_LAGGED_AUDIO 0
 #define MAX_BUFFERING_TICKS 45
 
+/* headroom required on top of one tick before buffering is reduced */
+#define BUFFERING_SHRINK_MARGIN 10000000ULL
+
 static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 {
 	struct obs_core_audio *audio = p;
@@ -67,16 +71,10 @@ static inline void mix_audio(struct audio_output_data *mixes,
 
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
-
-			mix += start_point;
-			end = aud + total_floats;
+			float *mix = mixes[mix_idx].data[ch] + start_point;
+			float *aud = source->audio_output_buf[mix_idx][ch];
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			audio_mix_add(mix, aud, total_floats);
 		}
 	}
 }
@@ -101,10 +99,9 @@ static bool ignore_audio(obs_source_t *source, size_t channels,
 
 	if (num_floats) {
 		/* round up the number of samples to drop */
-		size_t drop =
-			(size_t)util_mul_div64(start_ts - source->audio_ts - 1,
-					       sample_rate, 1000000000ULL) +
-			1;
+		size_t drop = obs_source_audio_frame_at(source, sample_rate,
+							start_ts - 1) +
+			      1;
 		if (drop > num_floats)
 			drop = num_floats;
 
@@ -330,6 +327,16 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	     "audio buffering is now %d milliseconds"
 	     " (source: %s)\n",
 	     (int)ms, (int)total_ms, buffering_name);
+
+	pthread_mutex_lock(&audio->buffering_mutex);
+	audio->buffering_stats.buffering_ms = (uint32_t)total_ms;
+	if (audio->buffering_stats.max_buffering_ms < (uint32_t)total_ms)
+		audio->buffering_stats.max_buffering_ms = (uint32_t)total_ms;
+	audio->buffering_stats.headroom_ms = 0;
+	audio->buffering_stats.increases++;
+	pthread_mutex_unlock(&audio->buffering_mutex);
+
+	audio->buffering_stable_ts = 0;
 #if DEBUG_AUDIO == 1
 	blog(LOG_DEBUG,
 	     "min_ts (%" PRIu64 ") < start timestamp "
@@ -436,26 +443,119 @@ static inline const char *calc_min_ts(struct obs_core_data *data,
 	return buffering_name;
 }
 
+/* how far past end_ts the audio of every source already reaches */
+static uint64_t min_audio_headroom(struct obs_core_data *data,
+				   size_t sample_rate, uint64_t end_ts)
+{
+	uint64_t headroom = UINT64_MAX;
+
+	struct obs_source *source = data->first_audio_source;
+	while (source) {
+		if (!source->info.audio_render && !source->audio_pending &&
+		    source->audio_ts) {
+			size_t frames =
+				source->audio_input_buf[0].size / sizeof(float);
+			uint64_t buf_end =
+				source->audio_ts +
+				audio_frames_to_ns(sample_rate, frames);
+			uint64_t cur = buf_end > end_ts ? buf_end - end_ts : 0;
+
+			if (cur < headroom)
+				headroom = cur;
+		}
+
+		source = (struct obs_source *)source->next_audio_source;
+	}
+
+	return headroom;
+}
+
+/* Buffering can only be removed without dropping audio by outputting a
+ * buffered tick early, which needs every source to already have the audio
+ * of the next tick.  Only do so after that has been true for a while. */
+static void shrink_audio_buffering(struct obs_core_audio *audio,
+				   struct obs_core_data *data,
+				   size_t sample_rate, const struct ts_info *ts)
+{
+	uint64_t delay =
+		(uint64_t)os_atomic_load_long(&audio->buffering_shrink_ms) *
+		1000000ULL;
+	uint64_t tick = audio_frames_to_ns(sample_rate, AUDIO_OUTPUT_FRAMES);
+	uint64_t headroom;
+	int total_ms;
+
+	if (!delay || !audio->total_buffering_ticks) {
+		audio->buffering_stable_ts = 0;
+		return;
+	}
+
+	pthread_mutex_lock(&data->audio_sources_mutex);
+	headroom = min_audio_headroom(data, sample_rate, ts->end);
+	pthread_mutex_unlock(&data->audio_sources_mutex);
+
+	if (headroom < tick + BUFFERING_SHRINK_MARGIN) {
+		audio->buffering_stable_ts = 0;
+		return;
+	}
+
+	if (!audio->buffering_stable_ts) {
+		audio->buffering_stable_ts = ts->end;
+		audio->buffering_min_headroom = headroom;
+	} else if (headroom < audio->buffering_min_headroom) {
+		audio->buffering_min_headroom = headroom;
+	}
+
+	if (ts->end - audio->buffering_stable_ts < delay)
+		return;
+
+	audio->total_buffering_ticks--;
+	audio->buffering_stable_ts = 0;
+	audio->buffering_catch_up = true;
+	audio_output_catch_up(audio->audio);
+
+	total_ms = (int)(audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES *
+			 1000 / sample_rate);
+	headroom = audio->buffering_min_headroom == UINT64_MAX
+			   ? 0
+			   : audio->buffering_min_headroom / 1000000;
+
+	blog(LOG_INFO,
+	     "removing %d milliseconds of audio buffering, total "
+	     "audio buffering is now %d milliseconds"
+	     " (minimum headroom: %d milliseconds)",
+	     (int)(AUDIO_OUTPUT_FRAMES * 1000 / sample_rate), total_ms,
+	     (int)headroom);
+
+	pthread_mutex_lock(&audio->buffering_mutex);
+	audio->buffering_stats.buffering_ms = (uint32_t)total_ms;
+	audio->buffering_stats.headroom_ms = (uint32_t)headroom;
+	audio->buffering_stats.decreases++;
+	pthread_mutex_unlock(&audio->buffering_mutex);
+}
+
 static inline void release_audio_sources(struct obs_core_audio *audio)
 {
 	for (size_t i = 0; i < audio->render_order.num; i++)
 		obs_source_release(audio->render_order.array[i]);
 }
 
+/* tasks are run without task_mutex, see execute_graphics_tasks */
 static inline void execute_audio_tasks(void)
 {
 	struct obs_core_audio *audio = &obs->audio;
-	bool tasks_remaining = true;
 
-	while (tasks_remaining) {
+	for (;;) {
+		struct obs_task_info info;
+
 		pthread_mutex_lock(&audio->task_mutex);
-		if (audio->tasks.size) {
-			struct obs_task_info info;
-			circlebuf_pop_front(&audio->tasks, &info, sizeof(info));
-			info.task(info.param);
+		if (!audio->tasks.size) {
+			pthread_mutex_unlock(&audio->task_mutex);
+			break;
 		}
-		tasks_remaining = !!audio->tasks.size;
+		circlebuf_pop_front(&audio->tasks, &info, sizeof(info));
 		pthread_mutex_unlock(&audio->task_mutex);
+
+		info.task(info.param);
 	}
 }
 
@@ -475,7 +575,13 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
 
-	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
+	/* when catching up, the next buffered tick is output within the same
+	 * time slot, so there is no new time range to queue */
+	if (audio->buffering_catch_up)
+		audio->buffering_catch_up = false;
+	else
+		circlebuf_push_back(&audio->buffered_timestamps, &ts,
+				    sizeof(ts));
 	circlebuf_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
 	min_ts = ts.start;
 
@@ -488,6 +594,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	/* ------------------------------------------------ */
 	/* build audio render order
 	 * NOTE: these are source channels, not audio channels */
+	audio_bus_push_render_order(ts.start, push_audio_tree, audio);
+
 	for (uint32_t i = 0; i < MAX_CHANNELS; i++) {
 		obs_source_t *source = obs_get_output_source(i);
 		if (source) {
@@ -533,11 +641,9 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 				assert(false);
 #endif
 			} else {
-				pthread_mutex_lock(&source->audio_buf_mutex);
 				bool rerender = ignore_audio(source, channels,
 							     sample_rate,
 							     ts.start);
-				pthread_mutex_unlock(&source->audio_buf_mutex);
 
 				/* if we (potentially) recovered, re-render */
 				if (rerender)
@@ -570,13 +676,9 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 			if (source->audio_pending)
 				continue;
 
-			pthread_mutex_lock(&source->audio_buf_mutex);
-
 			if (source->audio_output_buf[0][0] && source->audio_ts)
 				mix_audio(mixes, source, channels, sample_rate,
 					  &ts);
-
-			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
 	}
 
@@ -586,9 +688,10 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	source = data->first_audio_source;
 	while (source) {
-		pthread_mutex_lock(&source->audio_buf_mutex);
+		/* sources that were not rendered this tick still need their
+		 * pending audio moved over so it can be discarded */
+		obs_source_drain_audio_ring(source, channels);
 		discard_audio(audio, source, channels, sample_rate, &ts);
-		pthread_mutex_unlock(&source->audio_buf_mutex);
 
 		source = (struct obs_source *)source->next_audio_source;
 	}
@@ -599,6 +702,13 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	/* release audio sources */
 	release_audio_sources(audio);
 
+	/* ------------------------------------------------ */
+	/* mix monitored sources for the monitoring bus */
+	audio_monitoring_bus_tick(ts.start);
+
+	if (!audio->buffering_wait_ticks)
+		shrink_audio_buffering(audio, data, sample_rate, &ts);
+
 	circlebuf_pop_front(&audio->buffered_timestamps, NULL, sizeof(ts));
 
 	*out_ts = ts.start;
@@ -613,3 +723,34 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	UNUSED_PARAMETER(param);
 	return true;
 }
+
+void obs_set_audio_buffering_shrink_delay(uint32_t ms)
+{
+	if (!obs)
+		return;
+
+	os_atomic_set_long(&obs->audio.buffering_shrink_ms, (long)ms);
+}
+
+uint32_t obs_get_audio_buffering_shrink_delay(void)
+{
+	return obs ? (uint32_t)os_atomic_load_long(
+			     &obs->audio.buffering_shrink_ms)
+		   : 0;
+}
+
+bool obs_get_audio_buffering_stats(struct obs_audio_buffering_stats *stats)
+{
+	struct obs_core_audio *audio;
+
+	if (!obs || !stats || !obs->audio.audio)
+		return false;
+
+	audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->buffering_mutex);
+	*stats = audio->buffering_stats;
+	pthread_mutex_unlock(&audio->buffering_mutex);
+
+	return true;
+}
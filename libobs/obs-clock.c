@@ -0,0 +1,213 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "obs-internal.h"
+
+/* changes of the offset between the master clock and the system clock beyond
+ * this, plus 1000 ppm of the time between samples, are treated as
+ * discontinuities of the master clock */
+#define MAX_CLOCK_JUMP_NS 50000000LL
+
+static uint64_t software_clock_time(void *data)
+{
+	struct obs_core_clock *clock = data;
+	uint64_t elapsed = os_gettime_ns() - clock->software_start;
+
+	return clock->software_start +
+	       (uint64_t)((double)elapsed * clock->software_rate);
+}
+
+static inline uint64_t raw_clock_time(struct obs_core_clock *clock)
+{
+	return clock->info.get_time_ns
+		       ? clock->info.get_time_ns(clock->info.data)
+		       : os_gettime_ns();
+}
+
+/* assumes clock mutex */
+static uint64_t sample_clock(struct obs_core_clock *clock, uint64_t *sys_time)
+{
+	uint64_t sys = os_gettime_ns();
+	uint64_t time = raw_clock_time(clock) + clock->adjust;
+	int64_t offset = (int64_t)(sys - time);
+	int64_t change = offset - clock->last_offset;
+	int64_t max_change = MAX_CLOCK_JUMP_NS +
+			     (int64_t)((sys - clock->last_sys_time) / 1000);
+
+	if (change > max_change || change < -max_change) {
+		clock->adjust += change;
+		time += change;
+		offset = clock->last_offset;
+		clock->resyncs++;
+	}
+
+	clock->last_offset = offset;
+	clock->last_sys_time = sys;
+	*sys_time = sys;
+	return time;
+}
+
+static void set_clock(const struct obs_clock_info *info, double software_rate)
+{
+	struct obs_core_clock *clock = &obs->clock;
+	uint64_t sys, time;
+
+	pthread_mutex_lock(&clock->mutex);
+	time = sample_clock(clock, &sys);
+
+	if (info)
+		clock->info = *info;
+	else
+		memset(&clock->info, 0, sizeof(clock->info));
+
+	clock->software_start = sys;
+	clock->software_rate = software_rate;
+
+	/* continue from the current time of the previous clock */
+	clock->adjust = (int64_t)(time - raw_clock_time(clock));
+	clock->last_offset = (int64_t)(sys - time);
+	clock->last_sys_time = sys;
+	clock->base_offset = clock->last_offset;
+	clock->base_sys_time = sys;
+	clock->resyncs = 0;
+	pthread_mutex_unlock(&clock->mutex);
+}
+
+bool obs_init_clock(void)
+{
+	struct obs_core_clock *clock = &obs->clock;
+
+	if (pthread_mutex_init(&clock->mutex, NULL) != 0)
+		return false;
+
+	clock->last_sys_time = os_gettime_ns();
+	set_clock(NULL, 1.0);
+	return true;
+}
+
+void obs_free_clock(void)
+{
+	pthread_mutex_destroy(&obs->clock.mutex);
+}
+
+uint64_t obs_clock_get_time_ns(void)
+{
+	struct obs_core_clock *clock = &obs->clock;
+	uint64_t sys, time;
+
+	pthread_mutex_lock(&clock->mutex);
+	time = sample_clock(clock, &sys);
+	pthread_mutex_unlock(&clock->mutex);
+
+	return time;
+}
+
+uint64_t obs_clock_to_system_ns(uint64_t time)
+{
+	struct obs_core_clock *clock = &obs->clock;
+	uint64_t sys, now;
+
+	pthread_mutex_lock(&clock->mutex);
+	if (clock->info.get_time_ns) {
+		now = sample_clock(clock, &sys);
+		sys += time - now;
+	} else {
+		/* exact for the system clock, so timestamps stay regular */
+		sys = time - clock->adjust;
+	}
+	pthread_mutex_unlock(&clock->mutex);
+
+	return sys;
+}
+
+bool obs_clock_sleep_to_ns(uint64_t time, uint64_t spin_ns)
+{
+	if (obs_clock_get_time_ns() >= time)
+		return false;
+
+	do {
+		os_sleepto_ns_spin(obs_clock_to_system_ns(time), spin_ns);
+	} while (obs_clock_get_time_ns() < time);
+
+	return true;
+}
+
+static uint64_t audio_clock_get_time(void *param)
+{
+	UNUSED_PARAMETER(param);
+	return obs_clock_get_time_ns();
+}
+
+static uint64_t audio_clock_to_system(void *param, uint64_t time)
+{
+	UNUSED_PARAMETER(param);
+	return obs_clock_to_system_ns(time);
+}
+
+static bool audio_clock_sleep_to(void *param, uint64_t time)
+{
+	UNUSED_PARAMETER(param);
+	return obs_clock_sleep_to_ns(time, 0);
+}
+
+const struct audio_output_clock obs_audio_clock = {
+	.get_time_ns = audio_clock_get_time,
+	.to_system_ns = audio_clock_to_system,
+	.sleep_to_ns = audio_clock_sleep_to,
+};
+
+void obs_set_master_clock(const struct obs_clock_info *info)
+{
+	set_clock(info, 1.0);
+}
+
+void obs_set_software_master_clock(double drift_ppm)
+{
+	struct obs_clock_info info = {
+		.get_time_ns = software_clock_time,
+		.data = &obs->clock,
+	};
+
+	set_clock(&info, 1.0 + drift_ppm / 1000000.0);
+}
+
+uint64_t obs_get_master_clock_time(void)
+{
+	return obs_clock_get_time_ns();
+}
+
+void obs_get_master_clock_stats(struct obs_clock_stats *stats)
+{
+	struct obs_core_clock *clock = &obs->clock;
+	uint64_t sys, elapsed;
+	int64_t correction;
+
+	if (!stats)
+		return;
+
+	pthread_mutex_lock(&clock->mutex);
+	sample_clock(clock, &sys);
+	elapsed = sys - clock->base_sys_time;
+	correction = clock->base_offset - clock->last_offset;
+
+	stats->drift_ppm = elapsed ? (double)correction / (double)elapsed *
+					     1000000.0
+				   : 0.0;
+	stats->correction_ns = correction;
+	stats->resyncs = clock->resyncs;
+	pthread_mutex_unlock(&clock->mutex);
+}
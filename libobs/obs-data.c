@@ -20,6 +20,7 @@
 #include "util/dstr.h"
 #include "util/darray.h"
 #include "util/platform.h"
+#include "util/file-serializer.h"
 #include "graphics/vec2.h"
 #include "graphics/vec3.h"
 #include "graphics/vec4.h"
@@ -27,6 +28,9 @@
 #include "obs-data.h"
 
 #include <jansson.h>
+#include <locale.h>
+#include <errno.h>
+#include <math.h>
 
 struct obs_data_item {
 	volatile long ref;
@@ -470,69 +474,680 @@ obs_data_item_set_autoselect_data(struct obs_data_item **p_item,
 
 /* ------------------------------------------------------------------------- */
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json);
+/* Streaming json reader.  Items are created directly from the input instead
+ * of going through a jansson tree first, and files are read in chunks. */
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+#define JSON_CHUNK_SIZE (64 * 1024)
+#define JSON_MAX_DEPTH 2048
+
+struct json_reader {
+	const char *pos;
+	const char *end;
+	FILE *file;
+	char *buf;
+
+	int line;
+	int depth;
+	char error[160];
+
+	/* names of the members currently being read, by offset */
+	DARRAY(char) keys;
+	/* the last string or number read */
+	DARRAY(char) str;
+};
+
+static bool jr_error(struct json_reader *r, const char *format, ...)
 {
-	const char *item_key;
-	json_t *jitem;
+	va_list args;
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+	if (!*r->error) {
+		va_start(args, format);
+		vsnprintf(r->error, sizeof(r->error), format, args);
+		va_end(args);
 	}
+
+	return false;
+}
+
+static bool jr_fill(struct json_reader *r)
+{
+	size_t size;
+
+	if (!r->file)
+		return false;
+
+	size = fread(r->buf, 1, JSON_CHUNK_SIZE, r->file);
+	if (!size)
+		return false;
+
+	r->pos = r->buf;
+	r->end = r->buf + size;
+	return true;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key,
-					    json_t *jobj)
+/* returns -1 at the end of the input */
+static inline int jr_peek(struct json_reader *r)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	if (r->pos == r->end && !jr_fill(r))
+		return -1;
+	return (unsigned char)*r->pos;
+}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+static inline int jr_get(struct json_reader *r)
+{
+	int c = jr_peek(r);
+	if (c != -1)
+		r->pos++;
+	return c;
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key,
-				    json_t *jarray)
+static int jr_skip_ws(struct json_reader *r)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	int c;
+
+	while ((c = jr_peek(r)) != -1) {
+		if (c == '\n')
+			r->line++;
+		else if (c != ' ' && c != '\t' && c != '\r')
+			break;
+		r->pos++;
+	}
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+	return c;
+}
 
-		if (!json_is_object(jitem))
-			continue;
+static bool jr_literal(struct json_reader *r, const char *literal)
+{
+	for (const char *ch = literal; *ch; ch++) {
+		if (jr_get(r) != *ch)
+			return jr_error(r, "invalid token, expected '%s'",
+					literal);
+	}
+
+	return true;
+}
+
+static inline void jr_push_utf8(struct json_reader *r, uint32_t cp)
+{
+	char out[4];
+	size_t size;
+
+	if (cp < 0x80) {
+		out[0] = (char)cp;
+		size = 1;
+	} else if (cp < 0x800) {
+		out[0] = (char)(0xC0 | (cp >> 6));
+		out[1] = (char)(0x80 | (cp & 0x3F));
+		size = 2;
+	} else if (cp < 0x10000) {
+		out[0] = (char)(0xE0 | (cp >> 12));
+		out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (cp & 0x3F));
+		size = 3;
+	} else {
+		out[0] = (char)(0xF0 | (cp >> 18));
+		out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[3] = (char)(0x80 | (cp & 0x3F));
+		size = 4;
+	}
+
+	da_push_back_array(r->str, out, size);
+}
+
+static bool jr_hex4(struct json_reader *r, uint32_t *val)
+{
+	*val = 0;
+
+	for (int i = 0; i < 4; i++) {
+		int c = jr_get(r);
+
+		*val <<= 4;
+		if (c >= '0' && c <= '9')
+			*val |= (uint32_t)(c - '0');
+		else if (c >= 'a' && c <= 'f')
+			*val |= (uint32_t)(c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F')
+			*val |= (uint32_t)(c - 'A' + 10);
+		else
+			return jr_error(r, "invalid escape");
+	}
+
+	return true;
+}
+
+static bool jr_escape(struct json_reader *r)
+{
+	uint32_t cp, low;
+	char ch;
+
+	switch (jr_get(r)) {
+	case '"':
+		ch = '"';
+		break;
+	case '\\':
+		ch = '\\';
+		break;
+	case '/':
+		ch = '/';
+		break;
+	case 'b':
+		ch = '\b';
+		break;
+	case 'f':
+		ch = '\f';
+		break;
+	case 'n':
+		ch = '\n';
+		break;
+	case 'r':
+		ch = '\r';
+		break;
+	case 't':
+		ch = '\t';
+		break;
+	case 'u':
+		if (!jr_hex4(r, &cp))
+			return false;
+
+		if (cp >= 0xD800 && cp <= 0xDBFF) {
+			if (jr_get(r) != '\\' || jr_get(r) != 'u' ||
+			    !jr_hex4(r, &low) || low < 0xDC00 || low > 0xDFFF)
+				return jr_error(r, "invalid Unicode '\\u%04X'",
+						cp);
+
+			cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+
+		} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+			return jr_error(r, "invalid Unicode '\\u%04X'", cp);
+
+		} else if (cp == 0) {
+			return jr_error(r, "\\u0000 is not allowed");
+		}
+
+		jr_push_utf8(r, cp);
+		return true;
+	default:
+		return jr_error(r, "invalid escape");
+	}
+
+	da_push_back(r->str, &ch);
+	return true;
+}
+
+/* copies a multi-byte utf-8 sequence, rejecting overlong and surrogate
+ * encodings the same way jansson does */
+static bool jr_utf8(struct json_reader *r, int lead)
+{
+	char seq[4] = {(char)lead};
+	uint32_t cp;
+	int count;
+
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		count = 2;
+		cp = lead & 0x1F;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		count = 3;
+		cp = lead & 0x0F;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		count = 4;
+		cp = lead & 0x07;
+	} else {
+		return jr_error(r, "unable to decode byte 0x%x", lead);
+	}
+
+	for (int i = 1; i < count; i++) {
+		int c = jr_get(r);
+
+		if (c == -1 || (c & 0xC0) != 0x80)
+			return jr_error(r, "unable to decode byte 0x%x", lead);
+
+		seq[i] = (char)c;
+		cp = (cp << 6) | (c & 0x3F);
+	}
+
+	if ((count == 3 && cp < 0x800) || (count == 4 && cp < 0x10000) ||
+	    cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return jr_error(r, "unable to decode byte 0x%x", lead);
+
+	da_push_back_array(r->str, seq, count);
+	return true;
+}
+
+/* reads a string (the opening quote was already read) into r->str */
+static bool jr_string(struct json_reader *r)
+{
+	bool success = true;
+	int c;
+
+	da_resize(r->str, 0);
+
+	for (;;) {
+		const char *start = r->pos;
+
+		/* copy plain ascii in bulk */
+		while (r->pos < r->end) {
+			unsigned char ch = (unsigned char)*r->pos;
+			if (ch == '"' || ch == '\\' || ch < 0x20 || ch >= 0x80)
+				break;
+			r->pos++;
+		}
+
+		if (r->pos != start)
+			da_push_back_array(r->str, start, r->pos - start);
+
+		c = jr_get(r);
+		if (c == '"')
+			break;
+
+		if (c == -1)
+			return jr_error(r, "premature end of input");
+		else if (c < 0x20)
+			return jr_error(r, "control character 0x%x", c);
+
+		if (c == '\\')
+			success = jr_escape(r);
+		else if (c >= 0x80)
+			success = jr_utf8(r, c);
+		else
+			da_push_back(r->str, &(char){(char)c});
+
+		if (!success)
+			return false;
+	}
+
+	da_push_back(r->str, &(char){0});
+	return true;
+}
+
+static inline bool jr_is_digit(const char *ch)
+{
+	return *ch >= '0' && *ch <= '9';
+}
+
+/* validates the number in r->str against the json grammar */
+static bool jr_check_number(const char *ch, bool *is_int)
+{
+	*is_int = true;
+
+	if (*ch == '-')
+		ch++;
+
+	if (*ch == '0')
+		ch++;
+	else if (jr_is_digit(ch))
+		while (jr_is_digit(ch))
+			ch++;
+	else
+		return false;
+
+	if (*ch == '.') {
+		*is_int = false;
+		if (!jr_is_digit(++ch))
+			return false;
+		while (jr_is_digit(ch))
+			ch++;
+	}
+
+	if (*ch == 'e' || *ch == 'E') {
+		*is_int = false;
+		ch++;
+		if (*ch == '+' || *ch == '-')
+			ch++;
+		if (!jr_is_digit(ch))
+			return false;
+		while (jr_is_digit(ch))
+			ch++;
+	}
+
+	return !*ch;
+}
+
+static bool jr_number(struct json_reader *r, struct obs_data_number *num)
+{
+	bool is_int;
+	int c;
+
+	da_resize(r->str, 0);
+
+	while ((c = jr_peek(r)) != -1 &&
+	       ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+		c == 'e' || c == 'E')) {
+		da_push_back(r->str, &(char){(char)c});
+		r->pos++;
+	}
+	da_push_back(r->str, &(char){0});
+
+	if (!jr_check_number(r->str.array, &is_int))
+		return jr_error(r, "invalid number '%s'", r->str.array);
+
+	errno = 0;
+
+	if (is_int) {
+		num->type = OBS_DATA_NUM_INT;
+		num->int_val = strtoll(r->str.array, NULL, 10);
+		if (errno == ERANGE)
+			return jr_error(r, "too big integer");
+	} else {
+		struct lconv *conv = localeconv();
+		char *point;
+
+		/* strtod is locale dependent */
+		if (*conv->decimal_point != '.' &&
+		    (point = strchr(r->str.array, '.')) != NULL)
+			*point = *conv->decimal_point;
+
+		num->type = OBS_DATA_NUM_DOUBLE;
+		num->double_val = strtod(r->str.array, NULL);
+		if (errno == ERANGE && fabs(num->double_val) > 1.0)
+			return jr_error(r, "real number overflow");
+	}
+
+	return true;
+}
+
+/* items of an object are kept sorted by name, and usually already are in the
+ * file, so new items are normally just appended after the last one */
+static bool jr_insert_item(struct obs_data *data, struct obs_data_item **last,
+			   struct obs_data_item *item)
+{
+	const char *name = get_item_name(item);
+	struct obs_data_item **prev_next = &data->first_item;
+	int cmp = 1;
+
+	if (*last && strcmp(get_item_name(*last), name) < 0) {
+		prev_next = &(*last)->next;
+	} else {
+		while (*prev_next &&
+		       (cmp = strcmp(get_item_name(*prev_next), name)) < 0)
+			prev_next = &(*prev_next)->next;
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+		if (*prev_next && cmp == 0)
+			return false;
 	}
 
-	obs_data_set_array(data, key, array);
+	item->parent = data;
+	item->next = *prev_next;
+	*prev_next = item;
+
+	if (!item->next)
+		*last = item;
+	return true;
+}
+
+static bool jr_object(struct json_reader *r, struct obs_data *data);
+static bool jr_array(struct json_reader *r, struct obs_data_array *array);
+
+/* reads a member value and adds it to data under the last key, values are
+ * only validated if data is NULL */
+static bool jr_member(struct json_reader *r, struct obs_data *data,
+		      struct obs_data_item **last, size_t key)
+{
+	struct obs_data_item *item;
+	struct obs_data_number num;
+	obs_data_array_t *array = NULL;
+	obs_data_t *obj = NULL;
+	enum obs_data_type type;
+	const void *ptr;
+	size_t size;
+	bool val;
+	int c;
+
+	c = jr_skip_ws(r);
+	r->pos += c != -1;
+
+	if (c == '"') {
+		if (!jr_string(r))
+			return false;
+		type = OBS_DATA_STRING;
+		ptr = r->str.array;
+		size = r->str.num;
+
+	} else if (c == '{') {
+		obj = data ? obs_data_create() : NULL;
+		if (!jr_object(r, obj)) {
+			obs_data_release(obj);
+			return false;
+		}
+		type = OBS_DATA_OBJECT;
+		ptr = &obj;
+		size = sizeof(obj);
+
+	} else if (c == '[') {
+		array = data ? obs_data_array_create() : NULL;
+		if (!jr_array(r, array)) {
+			obs_data_array_release(array);
+			return false;
+		}
+		type = OBS_DATA_ARRAY;
+		ptr = &array;
+		size = sizeof(array);
+
+	} else if (c == '-' || (c >= '0' && c <= '9')) {
+		r->pos--;
+		if (!jr_number(r, &num))
+			return false;
+		type = OBS_DATA_NUMBER;
+		ptr = &num;
+		size = sizeof(num);
+
+	} else if (c == 't' || c == 'f') {
+		r->pos--;
+		val = c == 't';
+		if (!jr_literal(r, val ? "true" : "false"))
+			return false;
+		type = OBS_DATA_BOOLEAN;
+		ptr = &val;
+		size = sizeof(val);
+
+	} else if (c == 'n') {
+		r->pos--;
+		return jr_literal(r, "null");
+
+	} else if (c == -1) {
+		return jr_error(r, "premature end of input");
+
+	} else {
+		return jr_error(r, "invalid token");
+	}
+
+	if (!data)
+		return true;
+
+	/* the key buffer may have moved while reading the value */
+	item = obs_data_item_create(r->keys.array + key, ptr, size, type,
+				    false, false);
+	obs_data_release(obj);
 	obs_data_array_release(array);
+
+	if (!jr_insert_item(data, last, item)) {
+		obs_data_item_release(&item);
+		return jr_error(r, "duplicate object key");
+	}
+
+	return true;
+}
+
+/* the opening brace was already read */
+static bool jr_object(struct json_reader *r, struct obs_data *data)
+{
+	struct obs_data_item *last = NULL;
+	size_t key;
+	int c;
+
+	if (++r->depth > JSON_MAX_DEPTH)
+		return jr_error(r, "maximum parsing depth reached");
+
+	c = jr_skip_ws(r);
+	if (c == '}') {
+		r->pos++;
+		r->depth--;
+		return true;
+	}
+
+	for (;;) {
+		if (c != '"')
+			return jr_error(r, "string or '}' expected");
+
+		r->pos++;
+		if (!jr_string(r))
+			return false;
+
+		key = r->keys.num;
+		da_push_back_array(r->keys, r->str.array, r->str.num);
+
+		if (jr_skip_ws(r) != ':')
+			return jr_error(r, "':' expected");
+
+		r->pos++;
+		if (!jr_member(r, data, &last, key))
+			return false;
+
+		da_resize(r->keys, key);
+
+		c = jr_skip_ws(r);
+		r->pos++;
+		if (c == '}')
+			break;
+		if (c != ',')
+			return jr_error(r, "'}' expected");
+
+		c = jr_skip_ws(r);
+	}
+
+	r->depth--;
+	return true;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key,
-				   json_t *json)
+/* only objects are kept, like with set_array, other values are validated and
+ * skipped */
+static bool jr_array(struct json_reader *r, struct obs_data_array *array)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	struct obs_data_item *last = NULL;
+	int c;
+
+	if (++r->depth > JSON_MAX_DEPTH)
+		return jr_error(r, "maximum parsing depth reached");
+
+	c = jr_skip_ws(r);
+	if (c == ']') {
+		r->pos++;
+		r->depth--;
+		return true;
+	}
+
+	for (;;) {
+		if (c == '{') {
+			obs_data_t *obj = array ? obs_data_create() : NULL;
+			bool success;
+
+			r->pos++;
+			success = jr_object(r, obj);
+			if (success && obj)
+				da_push_back(array->objects, &obj);
+			else
+				obs_data_release(obj);
+
+			if (!success)
+				return false;
+
+		} else {
+			/* members are read with an empty key */
+			size_t key = r->keys.num;
+
+			da_push_back(r->keys, &(char){0});
+			if (!jr_member(r, NULL, &last, key))
+				return false;
+			da_resize(r->keys, key);
+		}
+
+		c = jr_skip_ws(r);
+		r->pos++;
+		if (c == ']')
+			break;
+		if (c != ',')
+			return jr_error(r, "']' expected");
+
+		c = jr_skip_ws(r);
+	}
+
+	r->depth--;
+	return true;
+}
+
+static obs_data_t *json_read(struct json_reader *r)
+{
+	obs_data_t *data = obs_data_create();
+	bool success;
+	int c;
+
+	r->line = 1;
+
+	/* skip the utf-8 byte order mark */
+	if (jr_peek(r) == 0xEF) {
+		r->pos++;
+		if (jr_get(r) != 0xBB || jr_get(r) != 0xBF)
+			jr_error(r, "unable to decode byte 0xef");
+	}
+
+	c = jr_skip_ws(r);
+	r->pos += c != -1;
+
+	if (*r->error)
+		success = false;
+	else if (c == '{')
+		success = jr_object(r, data);
+	else if (c == '[')
+		success = jr_array(r, NULL);
+	else
+		success = jr_error(r, "'[' or '{' expected");
+
+	if (success && jr_skip_ws(r) != -1)
+		success = jr_error(r, "end of file expected");
+
+	if (!success) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_json] "
+		     "Failed reading json string (%d): %s",
+		     r->line, r->error);
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	da_free(r->keys);
+	da_free(r->str);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_json(const char *json_string)
+{
+	struct json_reader r = {0};
+
+	if (!json_string)
+		return NULL;
+
+	r.pos = json_string;
+	r.end = json_string + strlen(json_string);
+	return json_read(&r);
+}
+
+obs_data_t *obs_data_create_from_json_file(const char *json_file)
+{
+	struct json_reader r = {0};
+	obs_data_t *data;
+
+	r.file = os_fopen(json_file, "rb");
+	if (!r.file)
+		return NULL;
+
+	r.buf = bmalloc(JSON_CHUNK_SIZE);
+	r.pos = r.end = r.buf;
+
+	data = json_read(&r);
+
+	bfree(r.buf);
+	fclose(r.file);
+	return data;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -630,64 +1245,29 @@ obs_data_t *obs_data_create()
 	return data;
 }
 
-obs_data_t *obs_data_create_from_json(const char *json_string)
+static obs_data_t *create_from_file_safe(const char *file,
+					 const char *backup_ext,
+					 obs_data_t *(*create)(const char *))
 {
-	obs_data_t *data = obs_data_create();
-
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
-
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
-		blog(LOG_ERROR,
-		     "obs-data.c: [obs_data_create_from_json] "
-		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
-		obs_data_release(data);
-		data = NULL;
-	}
-
-	return data;
-}
-
-obs_data_t *obs_data_create_from_json_file(const char *json_file)
-{
-	char *file_data = os_quick_read_utf8_file(json_file);
-	obs_data_t *data = NULL;
-
-	if (file_data) {
-		data = obs_data_create_from_json(file_data);
-		bfree(file_data);
-	}
-
-	return data;
-}
-
-obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
-						const char *backup_ext)
-{
-	obs_data_t *file_data = obs_data_create_from_json_file(json_file);
+	obs_data_t *file_data = create(file);
 	if (!file_data && backup_ext && *backup_ext) {
 		struct dstr backup_file = {0};
 
-		dstr_copy(&backup_file, json_file);
+		dstr_copy(&backup_file, file);
 		if (*backup_ext != '.')
 			dstr_cat(&backup_file, ".");
 		dstr_cat(&backup_file, backup_ext);
 
 		if (os_file_exists(backup_file.array)) {
-			blog(LOG_WARNING,
-			     "obs-data.c: "
-			     "[obs_data_create_from_json_file_safe] "
-			     "attempting backup file");
+			blog(LOG_WARNING, "obs-data.c: "
+					  "[create_from_file_safe] "
+					  "attempting backup file");
 
 			/* delete current file if corrupt to prevent it from
 			 * being backed up again */
-			os_rename(backup_file.array, json_file);
+			os_rename(backup_file.array, file);
 
-			file_data = obs_data_create_from_json_file(json_file);
+			file_data = create(file);
 		}
 
 		dstr_free(&backup_file);
@@ -696,6 +1276,13 @@ obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
 	return file_data;
 }
 
+obs_data_t *obs_data_create_from_json_file_safe(const char *json_file,
+						const char *backup_ext)
+{
+	return create_from_file_safe(json_file, backup_ext,
+				     obs_data_create_from_json_file);
+}
+
 void obs_data_addref(obs_data_t *data)
 {
 	if (data)
@@ -772,6 +1359,634 @@ bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 	return false;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Binary serialization
+ *
+ *   Objects are stored as the number of items followed by the type, name and
+ * value of each item.  Only user values are stored, same as with JSON.
+ * Strings are only stored the first time they occur, after which they're
+ * referred to by index, so the reader can rebuild the table as it goes.
+ *
+ *   The stream is written in length-prefixed chunks terminated by an empty
+ * chunk, so both sides can buffer without reading past the end of the data.
+ */
+
+#define BINARY_MAGIC "OBSD"
+#define BINARY_MAGIC_SIZE 4
+#define BINARY_VERSION 1
+#define BINARY_CHUNK_SIZE 65536
+#define BINARY_MAX_DEPTH 256
+
+enum binary_type {
+	BINARY_STRING,
+	BINARY_INT,
+	BINARY_DOUBLE,
+	BINARY_FALSE,
+	BINARY_TRUE,
+	BINARY_OBJECT,
+	BINARY_ARRAY,
+};
+
+struct binary_string {
+	const char *str;
+	size_t len;
+	uint32_t hash;
+	uint32_t idx;
+};
+
+struct binary_writer {
+	struct serializer *s;
+	uint8_t *buf;
+	size_t size;
+	bool success;
+
+	/* open addressing, capacity is a power of two */
+	struct binary_string *strings;
+	size_t capacity;
+	size_t count;
+};
+
+struct binary_reader {
+	struct serializer *s;
+	uint8_t *buf;
+	size_t pos;
+	size_t size;
+
+	/* null terminated strings, and their offsets by index */
+	DARRAY(char) chars;
+	DARRAY(size_t) offsets;
+};
+
+static inline size_t encode_varint(uint8_t *buf, uint64_t val)
+{
+	size_t size = 0;
+
+	while (val >= 0x80) {
+		buf[size++] = (uint8_t)val | 0x80;
+		val >>= 7;
+	}
+
+	buf[size++] = (uint8_t)val;
+	return size;
+}
+
+static void bw_flush(struct binary_writer *w)
+{
+	uint8_t header[10];
+	size_t header_size;
+
+	if (!w->size)
+		return;
+
+	header_size = encode_varint(header, w->size);
+	if (s_write(w->s, header, header_size) != header_size ||
+	    s_write(w->s, w->buf, w->size) != w->size)
+		w->success = false;
+
+	w->size = 0;
+}
+
+static void bw_write(struct binary_writer *w, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+
+	while (size) {
+		size_t copy = BINARY_CHUNK_SIZE - w->size;
+		if (copy > size)
+			copy = size;
+
+		memcpy(w->buf + w->size, bytes, copy);
+		w->size += copy;
+		bytes += copy;
+		size -= copy;
+
+		if (w->size == BINARY_CHUNK_SIZE)
+			bw_flush(w);
+	}
+}
+
+static inline void bw_varint(struct binary_writer *w, uint64_t val)
+{
+	uint8_t buf[10];
+	bw_write(w, buf, encode_varint(buf, val));
+}
+
+static inline void bw_byte(struct binary_writer *w, uint8_t val)
+{
+	bw_write(w, &val, 1);
+}
+
+static inline uint32_t hash_string(const char *str, size_t len)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < len; i++)
+		hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+	return hash;
+}
+
+static void bw_grow_strings(struct binary_writer *w)
+{
+	size_t capacity = w->capacity ? w->capacity * 2 : 256;
+	struct binary_string *strings = bzalloc(capacity * sizeof(*strings));
+
+	for (size_t i = 0; i < w->capacity; i++) {
+		struct binary_string *entry = &w->strings[i];
+		size_t pos;
+
+		if (!entry->str)
+			continue;
+
+		pos = entry->hash & (capacity - 1);
+		while (strings[pos].str)
+			pos = (pos + 1) & (capacity - 1);
+		strings[pos] = *entry;
+	}
+
+	bfree(w->strings);
+	w->strings = strings;
+	w->capacity = capacity;
+}
+
+static void bw_string(struct binary_writer *w, const char *str)
+{
+	size_t len = strlen(str);
+	uint32_t hash = hash_string(str, len);
+	struct binary_string *entry;
+	size_t pos;
+
+	if ((w->count + 1) * 2 > w->capacity)
+		bw_grow_strings(w);
+
+	pos = hash & (w->capacity - 1);
+	while ((entry = &w->strings[pos])->str) {
+		if (entry->hash == hash && entry->len == len &&
+		    memcmp(entry->str, str, len) == 0) {
+			bw_varint(w, ((uint64_t)entry->idx << 1) | 1);
+			return;
+		}
+
+		pos = (pos + 1) & (w->capacity - 1);
+	}
+
+	entry->str = str;
+	entry->len = len;
+	entry->hash = hash;
+	entry->idx = (uint32_t)w->count++;
+
+	bw_varint(w, (uint64_t)len << 1);
+	bw_write(w, str, len);
+}
+
+static inline bool binary_item_stored(struct obs_data_item *item)
+{
+	return obs_data_item_has_user_value(item) &&
+	       item->type != OBS_DATA_NULL;
+}
+
+static void bw_object(struct binary_writer *w, obs_data_t *data);
+
+static void bw_array(struct binary_writer *w, obs_data_array_t *array)
+{
+	size_t count = array ? array->objects.num : 0;
+
+	bw_varint(w, count);
+	for (size_t i = 0; i < count; i++)
+		bw_object(w, array->objects.array[i]);
+}
+
+static void bw_number(struct binary_writer *w, struct obs_data_item *item)
+{
+	if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+		long long val = obs_data_item_get_int(item);
+		uint64_t uval;
+
+		memcpy(&uval, &val, sizeof(uval));
+		bw_byte(w, BINARY_INT);
+		bw_string(w, get_item_name(item));
+		bw_varint(w, (uval << 1) ^ (uint64_t)(val >> 63));
+	} else {
+		double val = obs_data_item_get_double(item);
+		uint8_t bytes[8];
+		uint64_t uval;
+
+		memcpy(&uval, &val, sizeof(uval));
+		for (size_t i = 0; i < 8; i++)
+			bytes[i] = (uint8_t)(uval >> (i * 8));
+
+		bw_byte(w, BINARY_DOUBLE);
+		bw_string(w, get_item_name(item));
+		bw_write(w, bytes, sizeof(bytes));
+	}
+}
+
+static void bw_object(struct binary_writer *w, obs_data_t *data)
+{
+	struct obs_data_item *item;
+	size_t count = 0;
+
+	for (item = data ? data->first_item : NULL; item; item = item->next) {
+		if (binary_item_stored(item))
+			count++;
+	}
+
+	bw_varint(w, count);
+
+	for (item = data ? data->first_item : NULL; item; item = item->next) {
+		if (!binary_item_stored(item))
+			continue;
+
+		switch (item->type) {
+		case OBS_DATA_STRING:
+			bw_byte(w, BINARY_STRING);
+			bw_string(w, get_item_name(item));
+			bw_string(w, obs_data_item_get_string(item));
+			break;
+		case OBS_DATA_NUMBER:
+			bw_number(w, item);
+			break;
+		case OBS_DATA_BOOLEAN:
+			bw_byte(w, obs_data_item_get_bool(item) ? BINARY_TRUE
+								: BINARY_FALSE);
+			bw_string(w, get_item_name(item));
+			break;
+		case OBS_DATA_OBJECT:
+			bw_byte(w, BINARY_OBJECT);
+			bw_string(w, get_item_name(item));
+			bw_object(w, get_item_obj(item));
+			break;
+		case OBS_DATA_ARRAY:
+			bw_byte(w, BINARY_ARRAY);
+			bw_string(w, get_item_name(item));
+			bw_array(w, get_item_array(item));
+			break;
+		case OBS_DATA_NULL:
+			break;
+		}
+	}
+}
+
+bool obs_data_write_binary(obs_data_t *data, struct serializer *s)
+{
+	struct binary_writer w = {0};
+	uint8_t header[BINARY_MAGIC_SIZE + 1];
+
+	if (!data || !s)
+		return false;
+
+	memcpy(header, BINARY_MAGIC, BINARY_MAGIC_SIZE);
+	header[BINARY_MAGIC_SIZE] = BINARY_VERSION;
+	if (s_write(s, header, sizeof(header)) != sizeof(header))
+		return false;
+
+	w.s = s;
+	w.buf = bmalloc(BINARY_CHUNK_SIZE);
+	w.success = true;
+
+	bw_object(&w, data);
+	bw_flush(&w);
+
+	/* empty chunk */
+	s_w8(s, 0);
+
+	bfree(w.strings);
+	bfree(w.buf);
+	return w.success;
+}
+
+static bool br_chunk(struct binary_reader *r)
+{
+	uint64_t size = 0;
+	uint8_t byte;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (s_read(r->s, &byte, 1) != 1)
+			return false;
+
+		size |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			break;
+	}
+
+	if (!size || size > BINARY_CHUNK_SIZE)
+		return false;
+
+	r->pos = 0;
+	r->size = (size_t)size;
+	return s_read(r->s, r->buf, r->size) == r->size;
+}
+
+static bool br_read(struct binary_reader *r, void *data, size_t size)
+{
+	uint8_t *bytes = data;
+
+	while (size) {
+		size_t copy;
+
+		if (r->pos == r->size && !br_chunk(r))
+			return false;
+
+		copy = r->size - r->pos;
+		if (copy > size)
+			copy = size;
+
+		memcpy(bytes, r->buf + r->pos, copy);
+		r->pos += copy;
+		bytes += copy;
+		size -= copy;
+	}
+
+	return true;
+}
+
+static inline bool br_byte(struct binary_reader *r, uint8_t *val)
+{
+	if (r->pos < r->size) {
+		*val = r->buf[r->pos++];
+		return true;
+	}
+
+	return br_read(r, val, 1);
+}
+
+static bool br_varint(struct binary_reader *r, uint64_t *val)
+{
+	uint8_t byte;
+
+	*val = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (!br_byte(r, &byte))
+			return false;
+
+		*val |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+/* returns the offset of the string, as the strings may move while reading */
+static bool br_string(struct binary_reader *r, size_t *offset)
+{
+	uint64_t val;
+	size_t len;
+
+	if (!br_varint(r, &val))
+		return false;
+
+	if (val & 1) {
+		val >>= 1;
+		if (val >= r->offsets.num)
+			return false;
+
+		*offset = r->offsets.array[val];
+		return true;
+	}
+
+	if ((val >> 1) > SIZE_MAX / 2)
+		return false;
+
+	*offset = r->chars.num;
+	len = (size_t)(val >> 1);
+
+	/* grow along with the data actually read, so a corrupt length can't
+	 * make it allocate more than the size of the input */
+	while (len) {
+		size_t pos = r->chars.num;
+		size_t size = len < BINARY_CHUNK_SIZE ? len : BINARY_CHUNK_SIZE;
+
+		da_resize(r->chars, pos + size);
+		if (!br_read(r, r->chars.array + pos, size))
+			return false;
+
+		len -= size;
+	}
+
+	da_push_back(r->chars, "");
+	da_push_back(r->offsets, offset);
+	return true;
+}
+
+static inline const char *br_str(struct binary_reader *r, size_t offset)
+{
+	return r->chars.array + offset;
+}
+
+static bool br_object(struct binary_reader *r, obs_data_t *data, int depth);
+
+static bool br_array(struct binary_reader *r, obs_data_array_t *array,
+		     int depth)
+{
+	uint64_t count;
+
+	if (!br_varint(r, &count))
+		return false;
+
+	for (uint64_t i = 0; i < count; i++) {
+		obs_data_t *obj = obs_data_create();
+		bool success = br_object(r, obj, depth + 1);
+
+		obs_data_array_push_back(array, obj);
+		obs_data_release(obj);
+
+		if (!success)
+			return false;
+	}
+
+	return true;
+}
+
+static bool br_item(struct binary_reader *r, obs_data_t *data, int depth)
+{
+	uint8_t type, bytes[8];
+	size_t name, str;
+	uint64_t val;
+	bool success;
+
+	if (!br_byte(r, &type) || !br_string(r, &name))
+		return false;
+
+	switch ((enum binary_type)type) {
+	case BINARY_STRING:
+		if (!br_string(r, &str))
+			return false;
+		obs_data_set_string(data, br_str(r, name), br_str(r, str));
+		return true;
+
+	case BINARY_INT:
+		if (!br_varint(r, &val))
+			return false;
+		val = (val >> 1) ^ (~(val & 1) + 1);
+		obs_data_set_int(data, br_str(r, name), (long long)val);
+		return true;
+
+	case BINARY_DOUBLE: {
+		double dval;
+
+		if (!br_read(r, bytes, sizeof(bytes)))
+			return false;
+
+		val = 0;
+		for (size_t i = 0; i < 8; i++)
+			val |= (uint64_t)bytes[i] << (i * 8);
+		memcpy(&dval, &val, sizeof(dval));
+
+		obs_data_set_double(data, br_str(r, name), dval);
+		return true;
+	}
+
+	case BINARY_FALSE:
+	case BINARY_TRUE:
+		obs_data_set_bool(data, br_str(r, name), type == BINARY_TRUE);
+		return true;
+
+	case BINARY_OBJECT: {
+		obs_data_t *obj = obs_data_create();
+
+		success = br_object(r, obj, depth + 1);
+		obs_data_set_obj(data, br_str(r, name), obj);
+		obs_data_release(obj);
+		return success;
+	}
+
+	case BINARY_ARRAY: {
+		obs_data_array_t *array = obs_data_array_create();
+
+		success = br_array(r, array, depth);
+		obs_data_set_array(data, br_str(r, name), array);
+		obs_data_array_release(array);
+		return success;
+	}
+	}
+
+	return false;
+}
+
+static bool br_object(struct binary_reader *r, obs_data_t *data, int depth)
+{
+	uint64_t count;
+
+	if (depth > BINARY_MAX_DEPTH || !br_varint(r, &count))
+		return false;
+
+	for (uint64_t i = 0; i < count; i++) {
+		if (!br_item(r, data, depth))
+			return false;
+	}
+
+	return true;
+}
+
+obs_data_t *obs_data_create_from_binary(struct serializer *s)
+{
+	struct binary_reader r = {0};
+	uint8_t header[BINARY_MAGIC_SIZE + 1];
+	obs_data_t *data;
+	uint8_t end;
+	bool success;
+
+	if (s_read(s, header, sizeof(header)) != sizeof(header) ||
+	    memcmp(header, BINARY_MAGIC, BINARY_MAGIC_SIZE) != 0 ||
+	    header[BINARY_MAGIC_SIZE] != BINARY_VERSION) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_binary] "
+				"Not binary obs_data or unsupported version");
+		return NULL;
+	}
+
+	r.s = s;
+	r.buf = bmalloc(BINARY_CHUNK_SIZE);
+
+	data = obs_data_create();
+	success = br_object(&r, data, 0) && r.pos == r.size &&
+		  s_read(s, &end, 1) == 1 && end == 0;
+
+	if (!success) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_binary] "
+				"Failed reading binary data");
+		obs_data_release(data);
+		data = NULL;
+	}
+
+	da_free(r.offsets);
+	da_free(r.chars);
+	bfree(r.buf);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file(const char *file)
+{
+	struct serializer s;
+	obs_data_t *data;
+
+	if (!file_input_serializer_init(&s, file))
+		return NULL;
+
+	data = obs_data_create_from_binary(&s);
+	file_input_serializer_free(&s);
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file_safe(const char *file,
+						  const char *backup_ext)
+{
+	return create_from_file_safe(file, backup_ext,
+				     obs_data_create_from_binary_file);
+}
+
+bool obs_data_save_binary(obs_data_t *data, const char *file)
+{
+	struct serializer s;
+	bool success;
+
+	if (!file_output_serializer_init(&s, file))
+		return false;
+
+	success = obs_data_write_binary(data, &s);
+	file_output_serializer_free(&s);
+	return success;
+}
+
+bool obs_data_save_binary_safe(obs_data_t *data, const char *file,
+			       const char *temp_ext, const char *backup_ext)
+{
+	struct dstr backup_path = {0};
+	struct dstr temp_path = {0};
+	bool success = false;
+
+	if (!temp_ext || !*temp_ext)
+		return false;
+
+	dstr_copy(&temp_path, file);
+	if (*temp_ext != '.')
+		dstr_cat(&temp_path, ".");
+	dstr_cat(&temp_path, temp_ext);
+
+	if (!obs_data_save_binary(data, temp_path.array)) {
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_save_binary_safe] "
+		     "Failed to write to %s",
+		     temp_path.array);
+		goto cleanup;
+	}
+
+	if (backup_ext && *backup_ext) {
+		dstr_copy(&backup_path, file);
+		if (*backup_ext != '.')
+			dstr_cat(&backup_path, ".");
+		dstr_cat(&backup_path, backup_ext);
+	}
+
+	success = os_safe_replace(file, temp_path.array, backup_path.array) ==
+		  0;
+
+cleanup:
+	dstr_free(&backup_path);
+	dstr_free(&temp_path);
+	return success;
+}
+
 static void get_defaults_array_cb(obs_data_t *data, void *vp)
 {
 	obs_data_array_t *defs = (obs_data_array_t *)vp;
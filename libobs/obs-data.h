@@ -24,6 +24,7 @@
 extern "C" {
 #endif
 
+struct serializer;
 struct vec2;
 struct vec3;
 struct vec4;
@@ -76,6 +77,18 @@ EXPORT bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 				    const char *temp_ext,
 				    const char *backup_ext);
 
+/* Compact binary encoding, much faster to save and load than JSON.  Only
+ * user values are stored, like with JSON. */
+EXPORT bool obs_data_write_binary(obs_data_t *data, struct serializer *s);
+EXPORT obs_data_t *obs_data_create_from_binary(struct serializer *s);
+EXPORT obs_data_t *obs_data_create_from_binary_file(const char *file);
+EXPORT obs_data_t *obs_data_create_from_binary_file_safe(const char *file,
+							 const char *backup_ext);
+EXPORT bool obs_data_save_binary(obs_data_t *data, const char *file);
+EXPORT bool obs_data_save_binary_safe(obs_data_t *data, const char *file,
+				      const char *temp_ext,
+				      const char *backup_ext);
+
 EXPORT void obs_data_apply(obs_data_t *target, obs_data_t *apply_data);
 
 EXPORT void obs_data_erase(obs_data_t *data, const char *name);
@@ -1336,10 +1336,12 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 					const struct encoder_packet *src)
 {
+	const char *prev_tag = bmem_set_thread_tag("encoder packets");
 	long *p_refs;
 
 	*dst = *src;
 	p_refs = bmalloc(src->size + sizeof(long));
+	bmem_set_thread_tag(prev_tag);
 	dst->data = (void *)(p_refs + 1);
 	*p_refs = 1;
 	memcpy(dst->data, src->data, src->size);
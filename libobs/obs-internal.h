@@ -20,6 +20,8 @@
 #include "util/c99defs.h"
 #include "util/darray.h"
 #include "util/circlebuf.h"
+#include "util/arena.h"
+#include "util/audio-ring.h"
 #include "util/dstr.h"
 #include "util/threading.h"
 #include "util/platform.h"
@@ -291,8 +293,13 @@ struct obs_core_video {
 	volatile bool gpu_encode_stop;
 
 	uint64_t video_time;
+	uint64_t clock_time;
 	uint64_t video_frame_interval_ns;
 	uint64_t video_avg_frame_time_ns;
+	uint64_t video_last_wake_ns;
+	volatile long pacing_spin_us;
+	pthread_mutex_t pacing_mutex;
+	struct obs_frame_pacing_stats pacing_stats;
 	double video_fps;
 	video_t *video;
 	pthread_t video_thread;
@@ -333,6 +340,8 @@ struct obs_core_video {
 };
 
 struct audio_monitor;
+struct monitoring_bus;
+struct monitoring_bus_input;
 
 struct obs_core_audio {
 	audio_t *audio;
@@ -345,6 +354,15 @@ struct obs_core_audio {
 	uint64_t buffering_wait_ticks;
 	int total_buffering_ticks;
 
+	/* adaptive buffering: after every source has been at least a tick
+	 * early for buffering_shrink_ms, a buffered tick is output early */
+	volatile long buffering_shrink_ms;
+	bool buffering_catch_up;
+	uint64_t buffering_stable_ts;
+	uint64_t buffering_min_headroom;
+	pthread_mutex_t buffering_mutex;
+	struct obs_audio_buffering_stats buffering_stats;
+
 	float user_volume;
 
 	pthread_mutex_t monitoring_mutex;
@@ -352,6 +370,16 @@ struct obs_core_audio {
 	char *monitoring_device_name;
 	char *monitoring_device_id;
 
+	pthread_mutex_t monitoring_bus_mutex;
+	struct monitoring_bus *monitoring_bus;
+	DARRAY(struct monitoring_bus_input *) monitoring_bus_orphans;
+
+	/* audio buses in topological order, and the pool of send buffers of
+	 * the sources feeding them */
+	pthread_mutex_t buses_mutex;
+	DARRAY(struct obs_source *) buses;
+	DARRAY(float *) bus_buffer_pool;
+
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
 };
@@ -419,6 +447,34 @@ struct obs_core_hotkeys {
 	char *sceneitem_hide;
 };
 
+/* ------------------------------------------------------------------------- */
+/* master clock */
+
+struct obs_core_clock {
+	pthread_mutex_t mutex;
+	struct obs_clock_info info;
+
+	/* added to the time of the clock to absorb its discontinuities */
+	int64_t adjust;
+
+	int64_t last_offset;
+	uint64_t last_sys_time;
+	int64_t base_offset;
+	uint64_t base_sys_time;
+	uint64_t resyncs;
+
+	uint64_t software_start;
+	double software_rate;
+};
+
+extern const struct audio_output_clock obs_audio_clock;
+
+extern bool obs_init_clock(void);
+extern void obs_free_clock(void);
+extern uint64_t obs_clock_get_time_ns(void);
+extern uint64_t obs_clock_to_system_ns(uint64_t time);
+extern bool obs_clock_sleep_to_ns(uint64_t time, uint64_t spin_ns);
+
 struct obs_core {
 	struct obs_module *first_module;
 	DARRAY(struct obs_module_path) module_paths;
@@ -445,12 +501,15 @@ struct obs_core {
 	 * clean and organized */
 	struct obs_core_video video;
 	struct obs_core_audio audio;
+	struct obs_core_clock clock;
 	struct obs_core_data data;
 	struct obs_core_hotkeys hotkeys;
 
 	os_task_queue_t *destruction_task_thread;
 
 	obs_task_handler_t ui_task_handler;
+
+	volatile bool realtime_threads;
 };
 
 extern struct obs_core *obs;
@@ -466,10 +525,13 @@ struct obs_graphics_context {
 #endif
 	bool raw_was_active;
 	bool was_active;
+	bool realtime;
 	const char *video_thread_name;
+	os_arena_t *frame_arena;
 };
 
 extern void *obs_graphics_thread(void *param);
+extern void log_frame_pacing(struct obs_core_video *video);
 extern bool obs_graphics_thread_loop(struct obs_graphics_context *context);
 #ifdef __APPLE__
 extern void *obs_graphics_thread_autorelease(void *param);
@@ -678,6 +740,9 @@ struct obs_source {
 	uint64_t last_audio_ts;
 	uint64_t next_audio_ts_min;
 	uint64_t next_audio_sys_ts_min;
+	/* mixer timestamp of the audio passed to the capture callbacks,
+	 * including the sync offset, valid while they run */
+	uint64_t audio_signal_ts;
 	uint64_t last_frame_ts;
 	uint64_t last_sys_timestamp;
 	bool async_rendered;
@@ -694,13 +759,19 @@ struct obs_source {
 	uint64_t audio_ts;
 	struct circlebuf audio_input_buf[MAX_AUDIO_CHANNELS];
 	size_t last_audio_input_buf_size;
+
+	/* audio handed from the capture thread to the audio thread, which
+	 * owns audio_ts and audio_input_buf.  pushed under audio_mutex. */
+	struct audio_ring audio_ring;
 	DARRAY(struct audio_action) audio_actions;
 	float *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS];
 	float *audio_mix_buf[MAX_AUDIO_CHANNELS];
+	float *audio_send_buf;
+	long audio_send_refs;
 	struct resample_info sample_info;
 	audio_resampler_t *resampler;
 	pthread_mutex_t audio_actions_mutex;
-	pthread_mutex_t audio_buf_mutex;
+	pthread_mutex_t audio_buf_mutex; /* audio_send_buf */
 	pthread_mutex_t audio_mutex;
 	pthread_mutex_t audio_cb_mutex;
 	DARRAY(struct audio_cb_info) audio_cb_list;
@@ -838,6 +909,16 @@ struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
 
+extern bool audio_monitoring_bus_add(obs_source_t *source);
+extern void audio_monitoring_bus_remove(obs_source_t *source);
+extern void audio_monitoring_bus_tick(uint64_t start_ts);
+extern void audio_monitoring_bus_free(void);
+
+extern void audio_bus_push_render_order(uint64_t ts,
+					obs_source_enum_proc_t push,
+					void *param);
+extern void audio_bus_free_pool(void);
+
 extern obs_source_t *
 obs_source_create_set_last_ver(const char *id, const char *name,
 			       obs_data_t *settings, obs_data_t *hotkey_data,
@@ -916,6 +997,11 @@ extern void obs_source_video_tick(obs_source_t *source, float seconds);
 extern float obs_source_get_target_volume(obs_source_t *source,
 					  obs_source_t *target);
 
+extern void obs_source_init_audio_ring(struct obs_source *source,
+				       size_t channels, uint32_t sample_rate);
+extern void obs_source_drain_audio_ring(obs_source_t *source, size_t channels);
+extern size_t obs_source_audio_frame_at(const obs_source_t *source,
+					size_t sample_rate, uint64_t ts);
 extern void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 				    size_t channels, size_t sample_rate,
 				    size_t size);
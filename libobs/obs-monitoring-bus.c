@@ -0,0 +1,587 @@
+/******************************************************************************
+    Copyright (C) 2023 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * Aggregated audio monitoring.
+ *
+ * When the monitoring bus is enabled, monitored sources no longer get their
+ * own audio_monitor (and with it their own device stream and resampler).
+ * Instead their audio is queued per input, mixed once per audio tick on the
+ * audio thread, and output through a single private "audio_line" source
+ * which is the only thing the monitoring backend sees.
+ *
+ * Like the core mixer, the bus places the audio of each input by its
+ * timestamp (including the sync offset of the source) and mixes the same
+ * time window as the outputs, so monitored sources stay in sync with each
+ * other and with what is streamed or recorded.
+ */
+
+#include <inttypes.h>
+#include "obs-internal.h"
+
+/* audio that continues the buffered audio within this much is appended
+ * as-is (same threshold as the source timestamp smoothing), larger gaps are
+ * filled with silence up to BUS_MAX_GAP, anything else restarts the input */
+#define BUS_TS_SMOOTHING_THRESHOLD 70000000ULL
+#define BUS_MAX_GAP 1000000000ULL
+
+/* an input may queue this much audio ahead of the mixed window (about as
+ * much as the core mixer can buffer) before the oldest audio is dropped */
+#define BUS_MAX_BUFFERED_FRAMES (AUDIO_OUTPUT_FRAMES * 48)
+
+struct monitoring_bus_input {
+	obs_source_t *source;
+	struct circlebuf buffer[MAX_AUDIO_CHANNELS];
+
+	/* timestamp of the first buffered frame, or of the next expected one
+	 * when the buffer is empty.  0 until the first audio arrives. */
+	uint64_t buffer_ts;
+};
+
+struct monitoring_bus {
+	obs_source_t *source;
+	DARRAY(struct monitoring_bus_input *) inputs;
+
+	float mix[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES];
+	float scratch[AUDIO_OUTPUT_FRAMES];
+	DARRAY(float) volume_buf;
+
+	uint64_t mixed_frames;
+	uint64_t underruns;
+	uint64_t dropped_frames;
+	double latency_ms;
+	double max_latency_ms;
+};
+
+static inline bool bus_eligible(obs_source_t *source)
+{
+	/* sources that can feed back into the monitoring device keep their
+	 * own monitor, which knows how to detect that */
+	return (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) ==
+		       0 &&
+	       (!obs->audio.monitoring_bus ||
+		source != obs->audio.monitoring_bus->source);
+}
+
+static struct monitoring_bus_input *find_input(struct monitoring_bus *bus,
+					       obs_source_t *source)
+{
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct monitoring_bus_input *input = bus->inputs.array[i];
+		if (input->source == source)
+			return input;
+	}
+
+	return NULL;
+}
+
+static inline size_t input_frames(const struct monitoring_bus_input *input)
+{
+	return input->buffer[0].size / sizeof(float);
+}
+
+static void input_clear(struct monitoring_bus_input *input)
+{
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		circlebuf_pop_front(&input->buffer[ch], NULL,
+				    input->buffer[ch].size);
+}
+
+static void input_pop(struct monitoring_bus_input *input, size_t channels,
+		      size_t frames, uint32_t sample_rate)
+{
+	for (size_t ch = 0; ch < channels; ch++)
+		circlebuf_pop_front(&input->buffer[ch], NULL,
+				    frames * sizeof(float));
+	input->buffer_ts += audio_frames_to_ns(sample_rate, frames);
+}
+
+/* lines the end of the buffered audio up with ts, the timestamp of the
+ * audio about to be appended */
+static void place_input(struct monitoring_bus_input *input, size_t channels,
+			uint64_t ts, uint32_t sample_rate)
+{
+	uint64_t end_ts;
+
+	if (!input->buffer_ts) {
+		input->buffer_ts = ts;
+		return;
+	}
+
+	end_ts = input->buffer_ts +
+		 audio_frames_to_ns(sample_rate, input_frames(input));
+
+	if (ts + BUS_TS_SMOOTHING_THRESHOLD >= end_ts &&
+	    ts <= end_ts + BUS_TS_SMOOTHING_THRESHOLD)
+		return;
+
+	if (ts > end_ts && ts - end_ts < BUS_MAX_GAP) {
+		size_t gap = (size_t)ns_to_audio_frames(sample_rate,
+							ts - end_ts);
+		for (size_t ch = 0; ch < channels; ch++)
+			circlebuf_push_back_zero(&input->buffer[ch],
+						 gap * sizeof(float));
+		return;
+	}
+
+	/* went backwards or jumped, start over from the new audio */
+	input_clear(input);
+	input->buffer_ts = ts;
+}
+
+static void bus_input_capture(void *param, obs_source_t *source,
+			      const struct audio_data *data, bool muted)
+{
+	struct monitoring_bus_input *input = param;
+	struct obs_core_audio *audio = &obs->audio;
+	size_t channels = audio_output_get_channels(audio->audio);
+	uint32_t sample_rate = audio_output_get_sample_rate(audio->audio);
+	size_t size = data->frames * sizeof(float);
+	float vol = source->user_volume;
+
+	if (os_atomic_load_long(&source->activate_refs) == 0)
+		return;
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+
+	struct monitoring_bus *bus = audio->monitoring_bus;
+	if (!bus)
+		goto unlock;
+
+	place_input(input, channels, source->audio_signal_ts, sample_rate);
+
+	for (size_t ch = 0; ch < channels; ch++) {
+		const float *in = (const float *)data->data[ch];
+
+		if (muted || !in) {
+			circlebuf_push_back_zero(&input->buffer[ch], size);
+
+		} else if (close_float(vol, 1.0f, EPSILON)) {
+			circlebuf_push_back(&input->buffer[ch], in, size);
+
+		} else {
+			da_resize(bus->volume_buf, data->frames);
+			for (size_t i = 0; i < data->frames; i++)
+				bus->volume_buf.array[i] = in[i] * vol;
+			circlebuf_push_back(&input->buffer[ch],
+					    bus->volume_buf.array, size);
+		}
+	}
+
+	size_t frames = input_frames(input);
+	if (frames > BUS_MAX_BUFFERED_FRAMES) {
+		size_t drop = frames - BUS_MAX_BUFFERED_FRAMES;
+		input_pop(input, channels, drop, sample_rate);
+		bus->dropped_frames += drop;
+	}
+
+unlock:
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+}
+
+static void input_free(struct monitoring_bus_input *input)
+{
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		circlebuf_free(&input->buffer[ch]);
+	bfree(input);
+}
+
+bool audio_monitoring_bus_add(obs_source_t *source)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct monitoring_bus_input *input;
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+
+	if (!audio->monitoring_bus || !bus_eligible(source)) {
+		pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+		return false;
+	}
+
+	input = bzalloc(sizeof(*input));
+	input->source = source;
+	da_push_back(audio->monitoring_bus->inputs, &input);
+
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+	/* the capture callback takes the bus mutex while the source holds its
+	 * callback mutex, so the callback list must never be modified while
+	 * holding the bus mutex */
+	obs_source_add_audio_capture_callback(source, bus_input_capture, input);
+	return true;
+}
+
+/* takes the input of a source out of the bus, or out of the orphans left
+ * behind by disable_bus.  the caller owns the returned input.  must be called
+ * with the bus mutex held. */
+static struct monitoring_bus_input *take_input(struct obs_core_audio *audio,
+					       obs_source_t *source)
+{
+	struct monitoring_bus_input *input;
+
+	if (audio->monitoring_bus) {
+		input = find_input(audio->monitoring_bus, source);
+		if (input) {
+			da_erase_item(audio->monitoring_bus->inputs, &input);
+			return input;
+		}
+	}
+
+	for (size_t i = 0; i < audio->monitoring_bus_orphans.num; i++) {
+		input = audio->monitoring_bus_orphans.array[i];
+		if (input->source == source) {
+			da_erase(audio->monitoring_bus_orphans, i);
+			return input;
+		}
+	}
+
+	return NULL;
+}
+
+static void release_input(struct monitoring_bus_input *input)
+{
+	obs_source_remove_audio_capture_callback(input->source,
+						 bus_input_capture, input);
+	input_free(input);
+}
+
+void audio_monitoring_bus_remove(obs_source_t *source)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct monitoring_bus_input *input;
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+	input = take_input(audio, source);
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+	if (input)
+		release_input(input);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* mixes the part of each input that falls into the window starting at
+ * start_ts, the same window the core mixer just mixed */
+static bool mix_inputs(struct monitoring_bus *bus, size_t channels,
+		       uint32_t sample_rate, uint64_t start_ts)
+{
+	const size_t size = AUDIO_OUTPUT_FRAMES * sizeof(float);
+	bool active = false;
+
+	for (size_t ch = 0; ch < channels; ch++)
+		memset(bus->mix[ch], 0, size);
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct monitoring_bus_input *input = bus->inputs.array[i];
+		size_t offset = 0;
+		size_t frames;
+
+		if (!input->buffer_ts)
+			continue;
+
+		/* audio from before the window is too late to be heard */
+		if (input->buffer_ts < start_ts) {
+			size_t late = (size_t)ns_to_audio_frames(
+				sample_rate, start_ts - input->buffer_ts);
+			size_t drop = late < input_frames(input)
+					      ? late
+					      : input_frames(input);
+
+			if (drop) {
+				input_pop(input, channels, drop, sample_rate);
+				bus->dropped_frames += drop;
+			}
+			if (!input_frames(input)) {
+				/* all of it was late, start over from the
+				 * next audio */
+				input->buffer_ts = 0;
+				continue;
+			}
+		} else {
+			offset = (size_t)ns_to_audio_frames(
+				sample_rate, input->buffer_ts - start_ts);
+			if (offset >= AUDIO_OUTPUT_FRAMES)
+				continue;
+		}
+
+		frames = input_frames(input);
+		if (!frames)
+			continue;
+
+		if (frames < AUDIO_OUTPUT_FRAMES - offset)
+			bus->underruns++;
+		else
+			frames = AUDIO_OUTPUT_FRAMES - offset;
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = bus->mix[ch] + offset;
+
+			circlebuf_peek_front(&input->buffer[ch], bus->scratch,
+					     frames * sizeof(float));
+			for (size_t j = 0; j < frames; j++)
+				mix[j] += bus->scratch[j];
+		}
+
+		input_pop(input, channels, frames, sample_rate);
+		active = true;
+	}
+
+	if (active) {
+		uint64_t now = os_gettime_ns();
+
+		bus->mixed_frames += AUDIO_OUTPUT_FRAMES;
+		bus->latency_ms = now > start_ts
+					  ? (double)(now - start_ts) / 1000000.0
+					  : 0.0;
+		if (bus->latency_ms > bus->max_latency_ms)
+			bus->max_latency_ms = bus->latency_ms;
+	}
+
+	return active;
+}
+
+void audio_monitoring_bus_tick(uint64_t start_ts)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	const struct audio_output_info *info =
+		audio_output_get_info(audio->audio);
+	size_t channels = audio_output_get_channels(audio->audio);
+	struct monitoring_bus *bus;
+
+	/* the bus mutex stays locked while outputting.  this is safe because
+	 * the only capture callback on the bus source is the monitor itself,
+	 * which never takes the bus mutex. */
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+
+	bus = audio->monitoring_bus;
+	if (bus &&
+	    mix_inputs(bus, channels, info->samples_per_sec, start_ts)) {
+		struct obs_source_audio out = {0};
+
+		for (size_t ch = 0; ch < channels; ch++)
+			out.data[ch] = (const uint8_t *)bus->mix[ch];
+		out.frames = AUDIO_OUTPUT_FRAMES;
+		out.speakers = info->speakers;
+		out.format = AUDIO_FORMAT_FLOAT_PLANAR;
+		out.samples_per_sec = info->samples_per_sec;
+		out.timestamp = start_ts;
+
+		obs_source_output_audio(bus->source, &out);
+	}
+
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void log_bus_stats(const struct monitoring_bus *bus)
+{
+	blog(LOG_INFO,
+	     "Audio monitoring bus: %" PRIu64 " frames mixed, %" PRIu64
+	     " underruns, %" PRIu64 " frames dropped, "
+	     "latency %.1fms (max %.1fms)",
+	     bus->mixed_frames, bus->underruns, bus->dropped_frames,
+	     bus->latency_ms, bus->max_latency_ms);
+}
+
+static obs_source_t *create_bus_source(void)
+{
+	obs_source_t *source = obs_source_create_private(
+		"audio_line", "Audio monitoring bus", NULL);
+	if (!source)
+		return NULL;
+
+	/* monitoring backends skip inactive sources, and the bus is never
+	 * part of a scene */
+	os_atomic_inc_long(&source->activate_refs);
+	return source;
+}
+
+static void enable_bus(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct obs_core_data *data = &obs->data;
+	DARRAY(obs_source_t *) monitored = {0};
+	struct monitoring_bus *bus;
+	obs_source_t *source;
+
+	source = create_bus_source();
+	if (!source) {
+		blog(LOG_WARNING, "Failed to create audio monitoring bus");
+		return;
+	}
+
+	bus = bzalloc(sizeof(*bus));
+	bus->source = source;
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+	audio->monitoring_bus = bus;
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+	obs_source_set_monitoring_type(source,
+				       OBS_MONITORING_TYPE_MONITOR_ONLY);
+
+	/* move every source that currently has its own monitor on to the
+	 * bus */
+	pthread_mutex_lock(&data->sources_mutex);
+	source = data->first_source;
+	while (source) {
+		if (source->monitor && source != bus->source &&
+		    bus_eligible(source)) {
+			obs_source_t *ref = obs_source_get_ref(source);
+			if (ref)
+				da_push_back(monitored, &ref);
+		}
+		source = (obs_source_t *)source->context.next;
+	}
+	pthread_mutex_unlock(&data->sources_mutex);
+
+	for (size_t i = 0; i < monitored.num; i++) {
+		source = monitored.array[i];
+
+		audio_monitor_destroy(source->monitor);
+		source->monitor = NULL;
+
+		if (!audio_monitoring_bus_add(source))
+			source->monitor = audio_monitor_create(source);
+
+		obs_source_release(source);
+	}
+	da_free(monitored);
+
+	blog(LOG_INFO, "Audio monitoring bus enabled");
+}
+
+/* removes all inputs and frees the bus.  when restore is true, the inputs get
+ * their own monitors back. */
+static void disable_bus(bool restore)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	struct monitoring_bus *bus = audio->monitoring_bus;
+
+	while (true) {
+		struct monitoring_bus_input *input;
+		obs_source_t *source;
+
+		pthread_mutex_lock(&audio->monitoring_bus_mutex);
+
+		if (!bus->inputs.num) {
+			pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+			break;
+		}
+
+		input = bus->inputs.array[bus->inputs.num - 1];
+		da_pop_back(bus->inputs);
+
+		/* a source whose last reference is already gone may be freed
+		 * at any time.  its input is left to the destroy path, which
+		 * still calls audio_monitoring_bus_remove. */
+		source = obs_source_get_ref(input->source);
+		if (!source)
+			da_push_back(audio->monitoring_bus_orphans, &input);
+
+		pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+		if (!source)
+			continue;
+
+		release_input(input);
+
+		if (restore && source->monitoring_type !=
+				       OBS_MONITORING_TYPE_NONE)
+			source->monitor = audio_monitor_create(source);
+
+		obs_source_release(source);
+	}
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+	audio->monitoring_bus = NULL;
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+	log_bus_stats(bus);
+
+	obs_source_set_monitoring_type(bus->source, OBS_MONITORING_TYPE_NONE);
+	obs_source_release(bus->source);
+	da_free(bus->volume_buf);
+	da_free(bus->inputs);
+	bfree(bus);
+}
+
+void audio_monitoring_bus_free(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+
+	if (audio->monitoring_bus)
+		disable_bus(false);
+
+	/* only left if their sources were never destroyed */
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+	for (size_t i = 0; i < audio->monitoring_bus_orphans.num; i++)
+		input_free(audio->monitoring_bus_orphans.array[i]);
+	da_free(audio->monitoring_bus_orphans);
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+}
+
+void obs_set_audio_monitoring_bus_enabled(bool enable)
+{
+	struct obs_core_audio *audio;
+
+	if (!obs)
+		return;
+
+	audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->monitoring_mutex);
+
+	if (enable && !audio->monitoring_bus)
+		enable_bus();
+	else if (!enable && audio->monitoring_bus)
+		disable_bus(true);
+
+	pthread_mutex_unlock(&audio->monitoring_mutex);
+}
+
+bool obs_audio_monitoring_bus_enabled(void)
+{
+	return obs && obs->audio.monitoring_bus != NULL;
+}
+
+bool obs_get_audio_monitoring_bus_stats(
+	struct obs_audio_monitoring_bus_stats *stats)
+{
+	struct obs_core_audio *audio;
+	struct monitoring_bus *bus;
+
+	if (!obs || !stats)
+		return false;
+
+	audio = &obs->audio;
+
+	pthread_mutex_lock(&audio->monitoring_bus_mutex);
+	bus = audio->monitoring_bus;
+	if (bus) {
+		stats->inputs = (uint32_t)bus->inputs.num;
+		stats->mixed_frames = bus->mixed_frames;
+		stats->underruns = bus->underruns;
+		stats->dropped_frames = bus->dropped_frames;
+		stats->latency_ms = bus->latency_ms;
+		stats->max_latency_ms = bus->max_latency_ms;
+	}
+	pthread_mutex_unlock(&audio->monitoring_bus_mutex);
+
+	return bus != NULL;
+}
@@ -21,6 +21,7 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-mix.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/util_uint64.h"
@@ -91,6 +92,7 @@ static const char *source_signals[] = {
 	"void enable(ptr source, bool enabled)",
 	"void rename(ptr source, string new_name, string prev_name)",
 	"void volume(ptr source, in out float volume)",
+	"void update(ptr source)",
 	"void update_properties(ptr source)",
 	"void update_flags(ptr source, int flags)",
 	"void audio_sync(ptr source, int out int offset)",
@@ -160,6 +162,25 @@ static void allocate_audio_mix_buffer(struct obs_source *source)
 	}
 }
 
+/* maximum buffer size */
+#define MAX_BUF_SIZE (1000 * AUDIO_OUTPUT_FRAMES * sizeof(float))
+
+/* audio the capture threads can get ahead of the audio thread, which drains
+ * the ring every tick.  larger packets and backlogs go to the ring overflow,
+ * which holds as much as the input buffers do.  the ring only allocates once
+ * the source outputs audio. */
+#define AUDIO_RING_MS 250
+#define AUDIO_RING_PACKETS 256
+
+void obs_source_init_audio_ring(struct obs_source *source, size_t channels,
+				uint32_t sample_rate)
+{
+	audio_ring_free(&source->audio_ring);
+	audio_ring_init(&source->audio_ring, channels,
+			(size_t)sample_rate * AUDIO_RING_MS / 1000,
+			AUDIO_RING_PACKETS, MAX_BUF_SIZE / sizeof(float));
+}
+
 static inline bool is_async_video_source(const struct obs_source *source)
 {
 	return (source->info.output_flags & OBS_SOURCE_ASYNC_VIDEO) ==
@@ -210,6 +231,10 @@ static bool obs_source_init(struct obs_source *source)
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
+	if (is_audio_source(source) && obs->audio.audio)
+		obs_source_init_audio_ring(
+			source, audio_output_get_channels(obs->audio.audio),
+			audio_output_get_sample_rate(obs->audio.audio));
 	if (source->info.audio_mix)
 		allocate_audio_mix_buffer(source);
 
@@ -686,6 +711,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	     source->context.private ? "private " : "", source->context.name);
 
 	audio_monitor_destroy(source->monitor);
+	audio_monitoring_bus_remove(source);
 
 	obs_hotkey_unregister(source->push_to_talk_key);
 	obs_hotkey_unregister(source->push_to_mute_key);
@@ -713,6 +739,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 		bfree(source->audio_data.data[i]);
 	for (i = 0; i < MAX_AUDIO_CHANNELS; i++)
 		circlebuf_free(&source->audio_input_buf[i]);
+	audio_ring_free(&source->audio_ring);
 	audio_resampler_destroy(source->resampler);
 	bfree(source->audio_output_buf[0][0]);
 	bfree(source->audio_mix_buf[0]);
@@ -925,6 +952,12 @@ bool obs_source_configurable(const obs_source_t *source)
 	       (source->info.get_properties || source->info.get_properties2);
 }
 
+bool obs_source_has_save_callback(const obs_source_t *source)
+{
+	return obs_source_valid(source, "obs_source_has_save_callback") &&
+	       source->info.save != NULL;
+}
+
 obs_properties_t *obs_source_properties(const obs_source_t *source)
 {
 	if (!data_valid(source, "obs_source_properties"))
@@ -986,6 +1019,8 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 		source->info.update(source->context.data,
 				    source->context.settings);
 	}
+
+	obs_source_dosignal(source, NULL, "update");
 }
 
 void obs_source_reset_settings(obs_source_t *source, obs_data_t *settings)
@@ -1303,8 +1338,18 @@ static inline size_t conv_time_to_frames(const size_t sample_rate,
 	return (size_t)util_mul_div64(duration, sample_rate, 1000000000ULL);
 }
 
-/* maximum buffer size */
-#define MAX_BUF_SIZE (1000 * AUDIO_OUTPUT_FRAMES * sizeof(float))
+/* audio thread.  the input buffers hold contiguous audio starting at
+ * audio_ts, so the frame for a timestamp is a plain offset from it rather
+ * than a search through the buffered packets.  timestamps before audio_ts
+ * map to the first frame. */
+size_t obs_source_audio_frame_at(const obs_source_t *source,
+				 size_t sample_rate, uint64_t ts)
+{
+	if (ts <= source->audio_ts)
+		return 0;
+
+	return conv_time_to_frames(sample_rate, ts - source->audio_ts);
+}
 
 /* time threshold in nanoseconds to ensure audio timing is as seamless as
  * possible */
@@ -1317,6 +1362,7 @@ static inline void reset_audio_timing(obs_source_t *source, uint64_t timestamp,
 	source->timing_adjust = os_time - timestamp;
 }
 
+/* audio thread */
 static void reset_audio_data(obs_source_t *source, uint64_t os_time)
 {
 	for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
@@ -1327,7 +1373,14 @@ static void reset_audio_data(obs_source_t *source, uint64_t os_time)
 
 	source->last_audio_input_buf_size = 0;
 	source->audio_ts = os_time;
+}
+
+/* capture side, audio_mutex must be held.  the audio data itself is reset
+ * by the audio thread once it reaches the marker in the ring. */
+static void request_audio_reset(obs_source_t *source, uint64_t os_time)
+{
 	source->next_audio_sys_ts_min = os_time;
+	audio_ring_push_reset(&source->audio_ring, os_time);
 }
 
 static void handle_ts_jump(obs_source_t *source, uint64_t expected, uint64_t ts,
@@ -1338,10 +1391,8 @@ static void handle_ts_jump(obs_source_t *source, uint64_t expected, uint64_t ts,
 	     "expected value %" PRIu64 ", input value %" PRIu64,
 	     source->context.name, diff, expected, ts);
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
 	reset_audio_timing(source, ts, os_time);
-	reset_audio_data(source, os_time);
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	request_audio_reset(source, os_time);
 }
 
 static void source_signal_audio_data(obs_source_t *source,
@@ -1362,25 +1413,20 @@ static inline uint64_t uint64_diff(uint64_t ts1, uint64_t ts2)
 	return (ts1 < ts2) ? (ts2 - ts1) : (ts1 - ts2);
 }
 
-static inline size_t get_buf_placement(audio_t *audio, uint64_t offset)
-{
-	uint32_t sample_rate = audio_output_get_sample_rate(audio);
-	return (size_t)util_mul_div64(offset, sample_rate, 1000000000ULL);
-}
-
 static void source_output_audio_place(obs_source_t *source,
 				      const struct audio_data *in)
 {
 	audio_t *audio = obs->audio.audio;
 	size_t buf_placement;
 	size_t channels = audio_output_get_channels(audio);
+	size_t sample_rate = audio_output_get_sample_rate(audio);
 	size_t size = in->frames * sizeof(float);
 
 	if (!source->audio_ts || in->timestamp < source->audio_ts)
 		reset_audio_data(source, in->timestamp);
 
 	buf_placement =
-		get_buf_placement(audio, in->timestamp - source->audio_ts) *
+		obs_source_audio_frame_at(source, sample_rate, in->timestamp) *
 		sizeof(float);
 
 #if DEBUG_AUDIO == 1
@@ -1488,8 +1534,6 @@ static void source_output_audio_data(obs_source_t *source,
 
 	in.timestamp += source->timing_adjust;
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
-
 	if (source->next_audio_sys_ts_min == in.timestamp) {
 		push_back = true;
 
@@ -1524,15 +1568,12 @@ static void source_output_audio_data(obs_source_t *source,
 		source->last_sync_offset = sync_offset;
 	}
 
-	if (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY) {
-		if (push_back && source->audio_ts)
-			source_output_audio_push_back(source, &in);
-		else
-			source_output_audio_place(source, &in);
-	}
-
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	if (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY)
+		audio_ring_push(&source->audio_ring, in.timestamp,
+				(const float *const *)in.data, in.frames,
+				push_back ? AUDIO_RING_CONTIGUOUS : 0);
 
+	source->audio_signal_ts = in.timestamp;
 	source_signal_audio_data(source, data, source_muted(source, os_time));
 }
 
@@ -3308,9 +3349,11 @@ cache_video(struct obs_source *source, const struct obs_source_frame *frame)
 
 	if (!new_frame) {
 		struct async_frame new_af;
+		const char *prev_tag = bmem_set_thread_tag("async frames");
 
 		new_frame = obs_source_frame_create(format, frame->width,
 						    frame->height);
+		bmem_set_thread_tag(prev_tag);
 		new_af.frame = new_frame;
 		new_af.used = true;
 		new_af.unused_count = 0;
@@ -3576,13 +3619,13 @@ void obs_source_show_preloaded_video(obs_source_t *source)
 
 	obs_leave_graphics();
 
-	pthread_mutex_lock(&source->audio_buf_mutex);
+	pthread_mutex_lock(&source->audio_mutex);
 	sys_ts = (source->monitoring_type != OBS_MONITORING_TYPE_MONITOR_ONLY)
 			 ? os_gettime_ns()
 			 : 0;
 	reset_audio_timing(source, source->last_frame_ts, sys_ts);
-	reset_audio_data(source, sys_ts);
-	pthread_mutex_unlock(&source->audio_buf_mutex);
+	request_audio_reset(source, sys_ts);
+	pthread_mutex_unlock(&source->audio_mutex);
 }
 
 static void
@@ -3723,81 +3766,72 @@ static inline void reset_resampler(obs_source_t *source,
 		blog(LOG_ERROR, "creation of resampler failed");
 }
 
+static void get_balance_gains(float gain[2], float balance,
+			      enum obs_balance_type type)
+{
+	switch (type) {
+	case OBS_BALANCE_TYPE_SINE_LAW:
+		gain[0] = sinf((1.0f - balance) * (M_PI / 2.0f));
+		gain[1] = sinf(balance * (M_PI / 2.0f));
+		break;
+	case OBS_BALANCE_TYPE_SQUARE_LAW:
+		gain[0] = sqrtf(1.0f - balance);
+		gain[1] = sqrtf(balance);
+		break;
+	case OBS_BALANCE_TYPE_LINEAR:
+		gain[0] = 1.0f - balance;
+		gain[1] = balance;
+		break;
+	default:
+		break;
+	}
+}
+
+/* copies new audio to the source's storage, applying balance and the forced
+ * mono downmix on the way so the data is only touched once */
 static void copy_audio_data(obs_source_t *source, const uint8_t *const data[],
 			    uint32_t frames, uint64_t ts)
 {
 	size_t planes = audio_output_get_planes(obs->audio.audio);
 	size_t blocksize = audio_output_get_block_size(obs->audio.audio);
 	size_t size = (size_t)frames * blocksize;
+	size_t channels = audio_output_get_channels(obs->audio.audio);
 	bool resize = source->audio_storage_size < size;
+	bool mono_output = channels == 1;
+	bool downmix = false;
+	float gain[MAX_AV_PLANES];
 
 	source->audio_data.frames = frames;
 	source->audio_data.timestamp = ts;
 
-	for (size_t i = 0; i < planes; i++) {
-		/* ensure audio storage capacity */
-		if (resize) {
+	/* ensure audio storage capacity */
+	if (resize) {
+		for (size_t i = 0; i < planes; i++) {
 			bfree(source->audio_data.data[i]);
 			source->audio_data.data[i] = bmalloc(size);
 		}
 
-		memcpy(source->audio_data.data[i], data[i], size);
-	}
-
-	if (resize)
 		source->audio_storage_size = size;
-}
-
-/* TODO: SSE optimization */
-static void downmix_to_mono_planar(struct obs_source *source, uint32_t frames)
-{
-	size_t channels = audio_output_get_channels(obs->audio.audio);
-	const float channels_i = 1.0f / (float)channels;
-	float **data = (float **)source->audio_data.data;
-
-	for (size_t channel = 1; channel < channels; channel++) {
-		for (uint32_t frame = 0; frame < frames; frame++)
-			data[0][frame] += data[channel][frame];
 	}
 
-	for (uint32_t frame = 0; frame < frames; frame++)
-		data[0][frame] *= channels_i;
+	for (size_t i = 0; i < planes; i++)
+		gain[i] = 1.0f;
 
-	for (size_t channel = 1; channel < channels; channel++) {
-		for (uint32_t frame = 0; frame < frames; frame++)
-			data[channel][frame] = data[0][frame];
+	if (!mono_output && source->sample_info.speakers == SPEAKERS_STEREO &&
+	    (source->balance > 0.51f || source->balance < 0.49f)) {
+		get_balance_gains(gain, source->balance,
+				  OBS_BALANCE_TYPE_SINE_LAW);
 	}
-}
-
-static void process_audio_balancing(struct obs_source *source, uint32_t frames,
-				    float balance, enum obs_balance_type type)
-{
-	float **data = (float **)source->audio_data.data;
 
-	switch (type) {
-	case OBS_BALANCE_TYPE_SINE_LAW:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] *
-					 sinf((1.0f - balance) * (M_PI / 2.0f));
-			data[1][frame] =
-				data[1][frame] * sinf(balance * (M_PI / 2.0f));
-		}
-		break;
-	case OBS_BALANCE_TYPE_SQUARE_LAW:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] * sqrtf(1.0f - balance);
-			data[1][frame] = data[1][frame] * sqrtf(balance);
-		}
-		break;
-	case OBS_BALANCE_TYPE_LINEAR:
-		for (uint32_t frame = 0; frame < frames; frame++) {
-			data[0][frame] = data[0][frame] * (1.0f - balance);
-			data[1][frame] = data[1][frame] * balance;
-		}
-		break;
-	default:
-		break;
+	if (!mono_output && (source->flags & OBS_SOURCE_FLAG_FORCE_MONO) != 0) {
+		for (size_t i = 0; i < planes; i++)
+			gain[i] /= (float)channels;
+		downmix = true;
 	}
+
+	audio_mix_copy_gain((float *const *)source->audio_data.data,
+			    (const float *const *)data, planes, gain, downmix,
+			    frames);
 }
 
 /* resamples/remixes new audio to the designated main audio output format */
@@ -3805,7 +3839,6 @@ static void process_audio(obs_source_t *source,
 			  const struct obs_source_audio *audio)
 {
 	uint32_t frames = audio->frames;
-	bool mono_output;
 
 	if (source->sample_info.samples_per_sec != audio->samples_per_sec ||
 	    source->sample_info.format != audio->format ||
@@ -3830,17 +3863,6 @@ static void process_audio(obs_source_t *source,
 		copy_audio_data(source, audio->data, audio->frames,
 				audio->timestamp);
 	}
-
-	mono_output = audio_output_get_channels(obs->audio.audio) == 1;
-
-	if (!mono_output && source->sample_info.speakers == SPEAKERS_STEREO &&
-	    (source->balance > 0.51f || source->balance < 0.49f)) {
-		process_audio_balancing(source, frames, source->balance,
-					OBS_BALANCE_TYPE_SINE_LAW);
-	}
-
-	if (!mono_output && (source->flags & OBS_SOURCE_FLAG_FORCE_MONO) != 0)
-		downmix_to_mono_planar(source, frames);
 }
 
 void obs_source_output_audio(obs_source_t *source,
@@ -5124,24 +5146,16 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 static inline void multiply_output_audio(obs_source_t *source, size_t mix,
 					 size_t channels, float vol)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-	while (out < end)
-		*(out++) *= vol;
+	audio_mix_mul(source->audio_output_buf[mix][0], vol,
+		      AUDIO_OUTPUT_FRAMES * channels);
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix,
 				     size_t channels, float *vol_data)
 {
-	for (size_t ch = 0; ch < channels; ch++) {
-		register float *out = source->audio_output_buf[mix][ch];
-		register float *end = out + AUDIO_OUTPUT_FRAMES;
-		register float *vol = vol_data;
-
-		while (out < end)
-			*(out++) *= *(vol++);
-	}
+	for (size_t ch = 0; ch < channels; ch++)
+		audio_mix_mul_vec(source->audio_output_buf[mix][ch], vol_data,
+				  AUDIO_OUTPUT_FRAMES);
 }
 
 static inline void apply_audio_action(obs_source_t *source,
@@ -5163,8 +5177,27 @@ static inline void apply_audio_action(obs_source_t *source,
 	}
 }
 
+/* applies the gain of this tick to the send buffer, either per frame or
+ * flat, so the buses get the audio the mixes get */
+static void multiply_send_audio(obs_source_t *source, size_t channels,
+				const float *vol_data, float vol)
+{
+	pthread_mutex_lock(&source->audio_buf_mutex);
+
+	for (size_t ch = 0; source->audio_send_buf && ch < channels; ch++) {
+		float *out = source->audio_send_buf + AUDIO_OUTPUT_FRAMES * ch;
+
+		if (vol_data)
+			audio_mix_mul_vec(out, vol_data, AUDIO_OUTPUT_FRAMES);
+		else if (vol != 1.0f)
+			audio_mix_mul(out, vol, AUDIO_OUTPUT_FRAMES);
+	}
+
+	pthread_mutex_unlock(&source->audio_buf_mutex);
+}
+
 static void apply_audio_actions(obs_source_t *source, size_t channels,
-				size_t sample_rate)
+				size_t sample_rate, bool send)
 {
 	float vol_data[AUDIO_OUTPUT_FRAMES];
 	float cur_vol = get_source_volume(source, source->audio_ts);
@@ -5203,14 +5236,19 @@ static void apply_audio_actions(obs_source_t *source, size_t channels,
 
 	pthread_mutex_unlock(&source->audio_actions_mutex);
 
+	if (send)
+		multiply_send_audio(source, channels, vol_data, 0.0f);
+
 	for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
 		if ((source->audio_mixers & (1 << mix)) != 0)
 			multiply_vol_data(source, mix, channels, vol_data);
 	}
 }
 
+/* send is set when the send buffer was filled this tick and needs the same
+ * gain as the mixes */
 static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
-			       size_t channels, size_t sample_rate)
+			       size_t channels, size_t sample_rate, bool send)
 {
 	struct audio_action action;
 	bool actions_pending;
@@ -5229,12 +5267,15 @@ static void apply_audio_volume(obs_source_t *source, uint32_t mixers,
 			conv_frames_to_time(sample_rate, AUDIO_OUTPUT_FRAMES);
 
 		if (action.timestamp < (source->audio_ts + duration)) {
-			apply_audio_actions(source, channels, sample_rate);
+			apply_audio_actions(source, channels, sample_rate,
+					    send);
 			return;
 		}
 	}
 
 	vol = get_source_volume(source, source->audio_ts);
+	if (send)
+		multiply_send_audio(source, channels, NULL, vol);
 	if (vol == 1.0f)
 		return;
 
@@ -5293,7 +5334,7 @@ static void custom_audio_render(obs_source_t *source, uint32_t mixers,
 		}
 	}
 
-	apply_audio_volume(source, mixers, channels, sample_rate);
+	apply_audio_volume(source, mixers, channels, sample_rate, false);
 }
 
 static void audio_submix(obs_source_t *source, size_t channels,
@@ -5329,17 +5370,57 @@ static void audio_submix(obs_source_t *source, size_t channels,
 	obs_source_output_audio(source, &audio);
 }
 
+/* pre-fader audio for the audio buses this source feeds, the fader is
+ * applied by apply_audio_volume along with the mixes */
+static void fill_audio_send_buffer(obs_source_t *source, size_t channels)
+{
+	for (size_t ch = 0; ch < channels; ch++)
+		memcpy(source->audio_send_buf + AUDIO_OUTPUT_FRAMES * ch,
+		       source->audio_output_buf[0][ch],
+		       AUDIO_OUTPUT_FRAMES * sizeof(float));
+}
+
+/* moves the audio handed over by the capture side into the input buffers */
+void obs_source_drain_audio_ring(obs_source_t *source, size_t channels)
+{
+	struct audio_ring_packet packet;
+
+	while (audio_ring_peek(&source->audio_ring, &packet)) {
+		if (packet.flags & AUDIO_RING_RESET) {
+			reset_audio_data(source, packet.timestamp);
+
+		} else if (source->audio_ring.channels >= channels) {
+			struct audio_data in = {0};
+
+			for (size_t ch = 0; ch < channels; ch++)
+				in.data[ch] = (uint8_t *)packet.data[ch];
+			in.frames = packet.frames;
+			in.timestamp = packet.timestamp;
+
+			/* after dropped packets the audio no longer lines
+			 * up with the previous packet, so place it by its own
+			 * timestamp instead */
+			if ((packet.flags & AUDIO_RING_CONTIGUOUS) &&
+			    !(packet.flags & AUDIO_RING_GAP) &&
+			    source->audio_ts)
+				source_output_audio_push_back(source, &in);
+			else
+				source_output_audio_place(source, &in);
+		}
+
+		audio_ring_pop(&source->audio_ring, &packet);
+	}
+}
+
 static inline void process_audio_source_tick(obs_source_t *source,
 					     uint32_t mixers, size_t channels,
 					     size_t sample_rate, size_t size)
 {
 	bool audio_submix = !!(source->info.output_flags & OBS_SOURCE_SUBMIX);
-
-	pthread_mutex_lock(&source->audio_buf_mutex);
+	bool send;
 
 	if (source->audio_input_buf[0].size < size) {
 		source->audio_pending = true;
-		pthread_mutex_unlock(&source->audio_buf_mutex);
 		return;
 	}
 
@@ -5347,6 +5428,10 @@ static inline void process_audio_source_tick(obs_source_t *source,
 		circlebuf_peek_front(&source->audio_input_buf[ch],
 				     source->audio_output_buf[0][ch], size);
 
+	pthread_mutex_lock(&source->audio_buf_mutex);
+	send = source->audio_send_buf != NULL;
+	if (send)
+		fill_audio_send_buffer(source, channels);
 	pthread_mutex_unlock(&source->audio_buf_mutex);
 
 	for (size_t mix = 1; mix < MAX_AUDIO_MIXES; mix++) {
@@ -5373,6 +5458,11 @@ static inline void process_audio_source_tick(obs_source_t *source,
 	}
 
 	if (audio_submix) {
+		/* the mixes of a submix are not faded here, only its sends */
+		if (send)
+			multiply_send_audio(
+				source, channels, NULL,
+				get_source_volume(source, source->audio_ts));
 		source->audio_pending = false;
 		return;
 	}
@@ -5380,7 +5470,7 @@ static inline void process_audio_source_tick(obs_source_t *source,
 	if ((source->audio_mixers & 1) == 0 || (mixers & 1) == 0)
 		memset(source->audio_output_buf[0][0], 0, size * channels);
 
-	apply_audio_volume(source, mixers, channels, sample_rate);
+	apply_audio_volume(source, mixers, channels, sample_rate, send);
 	source->audio_pending = false;
 }
 
@@ -5405,6 +5495,8 @@ void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 		audio_submix(source, channels, sample_rate);
 	}
 
+	obs_source_drain_audio_ring(source, channels);
+
 	if (!source->audio_ts) {
 		source->audio_pending = true;
 		return;
@@ -5499,8 +5591,10 @@ void obs_source_set_monitoring_type(obs_source_t *source,
 
 	if (was_on != now_on) {
 		if (!was_on) {
-			source->monitor = audio_monitor_create(source);
+			if (!audio_monitoring_bus_add(source))
+				source->monitor = audio_monitor_create(source);
 		} else {
+			audio_monitoring_bus_remove(source);
 			audio_monitor_destroy(source->monitor);
 			source->monitor = NULL;
 		}
@@ -5548,10 +5642,10 @@ void obs_source_set_async_decoupled(obs_source_t *source, bool decouple)
 
 	source->async_decoupled = decouple;
 	if (decouple) {
-		pthread_mutex_lock(&source->audio_buf_mutex);
+		pthread_mutex_lock(&source->audio_mutex);
 		source->timing_set = false;
-		reset_audio_data(source, 0);
-		pthread_mutex_unlock(&source->audio_buf_mutex);
+		request_audio_reset(source, 0);
+		pthread_mutex_unlock(&source->audio_mutex);
 	}
 }
 
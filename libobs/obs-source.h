@@ -202,6 +202,12 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_CAP_DONT_SHOW_PROPERTIES (1 << 16)
 
+/**
+ * Source type can be created on any thread, at the same time as other
+ * sources are created.  Used to create sources in parallel when loading.
+ */
+#define OBS_SOURCE_THREADSAFE_CREATE (1 << 17)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
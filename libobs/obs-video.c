@@ -781,31 +781,102 @@ static inline void output_video_data(struct obs_core_video *video,
 	}
 }
 
+static const uint64_t frame_jitter_limits_us[OBS_FRAME_JITTER_BUCKETS - 1] = {
+	100, 250, 500, 1000, 2000, 4000, 8000};
+
+static void update_frame_pacing(struct obs_core_video *video,
+				uint64_t interval_ns)
+{
+	struct obs_frame_pacing_stats *stats = &video->pacing_stats;
+	uint64_t now = os_gettime_ns();
+	uint64_t last = video->video_last_wake_ns;
+	uint64_t elapsed, jitter_us;
+	size_t bucket = 0;
+
+	video->video_last_wake_ns = now;
+	if (!last)
+		return;
+
+	elapsed = now - last;
+	jitter_us = (elapsed > interval_ns ? elapsed - interval_ns
+					   : interval_ns - elapsed) /
+		    1000;
+
+	while (bucket < OBS_FRAME_JITTER_BUCKETS - 1 &&
+	       jitter_us >= frame_jitter_limits_us[bucket])
+		bucket++;
+
+	pthread_mutex_lock(&video->pacing_mutex);
+	stats->intervals++;
+	stats->total_jitter_us += jitter_us;
+	if (jitter_us > stats->max_jitter_us)
+		stats->max_jitter_us = jitter_us;
+	stats->buckets[bucket]++;
+	pthread_mutex_unlock(&video->pacing_mutex);
+}
+
+void log_frame_pacing(struct obs_core_video *video)
+{
+	struct obs_frame_pacing_stats *stats = &video->pacing_stats;
+	struct dstr buckets = {0};
+
+	if (!stats->intervals)
+		return;
+
+	for (size_t i = 0; i < OBS_FRAME_JITTER_BUCKETS; i++) {
+		double percent = (double)stats->buckets[i] /
+				 (double)stats->intervals * 100.0;
+
+		if (i < OBS_FRAME_JITTER_BUCKETS - 1)
+			dstr_catf(&buckets, " <%" PRIu64 "us: %.2f%%",
+				  frame_jitter_limits_us[i], percent);
+		else
+			dstr_catf(&buckets, " >=%" PRIu64 "us: %.2f%%",
+				  frame_jitter_limits_us[i - 1], percent);
+	}
+
+	blog(LOG_INFO,
+	     "Frame interval jitter over %" PRIu64 " frames: "
+	     "average %" PRIu64 "us, max %" PRIu64 "us,%s",
+	     stats->intervals, stats->total_jitter_us / stats->intervals,
+	     stats->max_jitter_us, buckets.array);
+	dstr_free(&buckets);
+}
+
 static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 			       const bool gpu_active, uint64_t *p_time,
 			       uint64_t interval_ns)
 {
 	struct obs_vframe_info vframe_info;
 	uint64_t cur_time = *p_time;
-	uint64_t t = cur_time + interval_ns;
+	uint64_t t = video->clock_time + interval_ns;
+	uint64_t spin_ns =
+		(uint64_t)os_atomic_load_long(&video->pacing_spin_us) * 1000;
 	int count;
 
-	if (os_sleepto_ns(t)) {
-		*p_time = t;
+	/* frames are paced by the master clock, but timestamped in system
+	 * time */
+	if (obs_clock_sleep_to_ns(t, spin_ns)) {
+		video->clock_time = t;
 		count = 1;
 	} else {
-		const uint64_t udiff = os_gettime_ns() - cur_time;
+		const uint64_t udiff =
+			obs_clock_get_time_ns() - video->clock_time;
 		int64_t diff;
 		memcpy(&diff, &udiff, sizeof(diff));
 		const uint64_t clamped_diff =
 			(diff > (int64_t)interval_ns) ? diff : interval_ns;
 		count = (int)(clamped_diff / interval_ns);
-		*p_time = cur_time + interval_ns * count;
+		video->clock_time += interval_ns * count;
 	}
 
+	*p_time = obs_clock_to_system_ns(video->clock_time);
+
 	video->total_frames += count;
 	video->lagged_frames += count - 1;
 
+	update_frame_pacing(video, interval_ns);
+
 	vframe_info.timestamp = cur_time;
 	vframe_info.count = count;
 
@@ -899,20 +970,24 @@ static void clear_gpu_frame_data(void)
 
 extern THREAD_LOCAL bool is_graphics_thread;
 
+/* tasks are run without task_mutex: a task may queue further tasks, or wait
+ * on a lock (such as a script's) whose holder is queueing a task */
 static void execute_graphics_tasks(void)
 {
 	struct obs_core_video *video = &obs->video;
-	bool tasks_remaining = true;
 
-	while (tasks_remaining) {
+	for (;;) {
+		struct obs_task_info info;
+
 		pthread_mutex_lock(&video->task_mutex);
-		if (video->tasks.size) {
-			struct obs_task_info info;
-			circlebuf_pop_front(&video->tasks, &info, sizeof(info));
-			info.task(info.param);
+		if (!video->tasks.size) {
+			pthread_mutex_unlock(&video->task_mutex);
+			break;
 		}
-		tasks_remaining = !!video->tasks.size;
+		circlebuf_pop_front(&video->tasks, &info, sizeof(info));
 		pthread_mutex_unlock(&video->task_mutex);
+
+		info.task(info.param);
 	}
 }
 
@@ -1008,6 +1083,7 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	uint64_t frame_start = os_gettime_ns();
 	uint64_t frame_time_ns;
 	bool raw_active = os_atomic_load_long(&obs->video.raw_active) > 0;
+	const bool realtime = os_atomic_load_bool(&obs->realtime_threads);
 #ifdef _WIN32
 	const bool gpu_active =
 		os_atomic_load_long(&obs->video.gpu_encoder_active) > 0;
@@ -1030,6 +1106,13 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	context->raw_was_active = raw_active;
 	context->was_active = active;
 
+	if (context->realtime != realtime) {
+		context->realtime = realtime;
+		if (!os_set_thread_realtime(realtime))
+			blog(LOG_WARNING, "Failed to change the scheduling of "
+					  "the graphics thread");
+	}
+
 	profile_start(context->video_thread_name);
 
 	gs_enter_context(obs->video.graphics);
@@ -1065,6 +1148,8 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 
 	profile_reenable_thread();
 
+	os_arena_reset(context->frame_arena);
+
 	video_sleep(&obs->video, raw_active, gpu_active, &obs->video.video_time,
 		    context->interval);
 
@@ -1099,7 +1184,8 @@ void *obs_graphics_thread(void *param)
 
 	const uint64_t interval = video_output_get_frame_time(obs->video.video);
 
-	obs->video.video_time = os_gettime_ns();
+	obs->video.clock_time = obs_clock_get_time_ns();
+	obs->video.video_time = obs_clock_to_system_ns(obs->video.clock_time);
 	obs->video.video_frame_interval_ns = interval;
 
 	os_set_thread_name("libobs: graphics thread");
@@ -1122,7 +1208,10 @@ void *obs_graphics_thread(void *param)
 #endif
 	context.raw_was_active = false;
 	context.was_active = false;
+	context.realtime = false;
 	context.video_thread_name = video_thread_name;
+	context.frame_arena = os_arena_create(0);
+	os_set_thread_frame_arena(context.frame_arena);
 
 #ifdef __APPLE__
 	while (obs_graphics_thread_loop_autorelease(&context))
@@ -1131,6 +1220,8 @@ void *obs_graphics_thread(void *param)
 #endif
 		;
 
+	os_arena_destroy(context.frame_arena);
+
 #ifdef _WIN32
 	uninit_winrt_state(&winrt);
 #endif
@@ -19,6 +19,7 @@
 
 #include "graphics/matrix4.h"
 #include "callback/calldata.h"
+#include "util/thread-pool.h"
 
 #include "obs.h"
 #include "obs-internal.h"
@@ -619,6 +620,11 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->task_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->pacing_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
+
+	video->video_last_wake_ns = 0;
+	memset(&video->pacing_stats, 0, sizeof(video->pacing_stats));
 
 #ifdef __APPLE__
 	errorcode = pthread_create(&video->video_thread, NULL,
@@ -645,6 +651,7 @@ static void stop_video(void)
 		if (video->thread_initialized) {
 			pthread_join(video->video_thread, &thread_retval);
 			video->thread_initialized = false;
+			log_frame_pacing(video);
 		}
 	}
 }
@@ -727,6 +734,9 @@ static void obs_free_video(void)
 		pthread_mutex_init_value(&video->task_mutex);
 		circlebuf_free(&video->tasks);
 
+		pthread_mutex_destroy(&video->pacing_mutex);
+		pthread_mutex_init_value(&video->pacing_mutex);
+
 		video->gpu_encoder_active = 0;
 		video->cur_texture = 0;
 	}
@@ -770,9 +780,18 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	int errorcode;
 
 	pthread_mutex_init_value(&audio->monitoring_mutex);
+	pthread_mutex_init_value(&audio->monitoring_bus_mutex);
+	pthread_mutex_init_value(&audio->buses_mutex);
+	pthread_mutex_init_value(&audio->buffering_mutex);
 
 	if (pthread_mutex_init_recursive(&audio->monitoring_mutex) != 0)
 		return false;
+	if (pthread_mutex_init(&audio->monitoring_bus_mutex, NULL) != 0)
+		return false;
+	if (pthread_mutex_init_recursive(&audio->buses_mutex) != 0)
+		return false;
+	if (pthread_mutex_init(&audio->buffering_mutex, NULL) != 0)
+		return false;
 	if (pthread_mutex_init(&audio->task_mutex, NULL) != 0)
 		return false;
 
@@ -785,9 +804,10 @@ static bool obs_init_audio(struct audio_output_info *ai)
 	audio->monitoring_device_id = bstrdup("default");
 
 	errorcode = audio_output_open(&audio->audio, ai);
-	if (errorcode == AUDIO_OUTPUT_SUCCESS)
+	if (errorcode == AUDIO_OUTPUT_SUCCESS) {
+		audio_output_set_realtime(audio->audio, obs->realtime_threads);
 		return true;
-	else if (errorcode == AUDIO_OUTPUT_INVALIDPARAM)
+	} else if (errorcode == AUDIO_OUTPUT_INVALIDPARAM)
 		blog(LOG_ERROR, "Invalid audio parameters specified");
 	else
 		blog(LOG_ERROR, "Could not open audio output");
@@ -808,21 +828,30 @@ static void stop_audio(void)
 static void obs_free_audio(void)
 {
 	struct obs_core_audio *audio = &obs->audio;
+	long shrink_ms = audio->buffering_shrink_ms;
+
 	if (audio->audio)
 		audio_output_close(audio->audio);
 
+	audio_monitoring_bus_free();
+
 	circlebuf_free(&audio->buffered_timestamps);
 	da_free(audio->render_order);
 	da_free(audio->root_nodes);
 
 	da_free(audio->monitors);
+	audio_bus_free_pool();
 	bfree(audio->monitoring_device_name);
 	bfree(audio->monitoring_device_id);
 	circlebuf_free(&audio->tasks);
 	pthread_mutex_destroy(&audio->task_mutex);
 	pthread_mutex_destroy(&audio->monitoring_mutex);
+	pthread_mutex_destroy(&audio->monitoring_bus_mutex);
+	pthread_mutex_destroy(&audio->buses_mutex);
+	pthread_mutex_destroy(&audio->buffering_mutex);
 
 	memset(audio, 0, sizeof(struct obs_core_audio));
+	audio->buffering_shrink_ms = shrink_ms;
 }
 
 static bool obs_init_data(void)
@@ -1029,6 +1058,7 @@ static inline void obs_free_hotkeys(void)
 
 extern const struct obs_source_info scene_info;
 extern const struct obs_source_info group_info;
+extern const struct obs_source_info audio_bus_info;
 
 static const char *submix_name(void *unused)
 {
@@ -1052,9 +1082,13 @@ static bool obs_init(const char *locale, const char *module_config_path,
 	obs = bzalloc(sizeof(struct obs_core));
 
 	pthread_mutex_init_value(&obs->audio.monitoring_mutex);
+	pthread_mutex_init_value(&obs->audio.monitoring_bus_mutex);
+	pthread_mutex_init_value(&obs->audio.buses_mutex);
 	pthread_mutex_init_value(&obs->audio.task_mutex);
 	pthread_mutex_init_value(&obs->video.gpu_encoder_mutex);
 	pthread_mutex_init_value(&obs->video.task_mutex);
+	pthread_mutex_init_value(&obs->video.pacing_mutex);
+	pthread_mutex_init_value(&obs->clock.mutex);
 
 	obs->name_store_owned = !store;
 	obs->name_store = store ? store : profiler_name_store_create();
@@ -1065,6 +1099,8 @@ static bool obs_init(const char *locale, const char *module_config_path,
 
 	log_system_info();
 
+	if (!obs_init_clock())
+		return false;
 	if (!obs_init_data())
 		return false;
 	if (!obs_init_handlers())
@@ -1082,6 +1118,7 @@ static bool obs_init(const char *locale, const char *module_config_path,
 	obs_register_source(&scene_info);
 	obs_register_source(&group_info);
 	obs_register_source(&audio_line_info);
+	obs_register_source(&audio_bus_info);
 	add_default_module_paths();
 	return true;
 }
@@ -1237,6 +1274,9 @@ void obs_shutdown(void)
 	stop_audio();
 	stop_hotkeys();
 
+	/* the bus holds a reference to its own private source */
+	audio_monitoring_bus_free();
+
 	module = obs->first_module;
 	while (module) {
 		struct obs_module *next = module->next;
@@ -1248,6 +1288,7 @@ void obs_shutdown(void)
 	obs_free_data();
 	obs_free_audio();
 	obs_free_video();
+	obs_free_clock();
 	os_task_queue_destroy(obs->destruction_task_thread);
 	obs_free_hotkeys();
 	obs_free_graphics();
@@ -1395,6 +1436,26 @@ int obs_reset_video(struct obs_video_info *ovi)
 	return obs_init_video(ovi);
 }
 
+/* the audio thread is stopped at this point, capture threads are held off
+ * with each source's audio_mutex */
+static void reset_source_audio_rings(size_t channels, uint32_t sample_rate)
+{
+	struct obs_source *source;
+
+	pthread_mutex_lock(&obs->data.audio_sources_mutex);
+
+	source = obs->data.first_audio_source;
+	while (source) {
+		pthread_mutex_lock(&source->audio_mutex);
+		obs_source_init_audio_ring(source, channels, sample_rate);
+		pthread_mutex_unlock(&source->audio_mutex);
+
+		source = (struct obs_source *)source->next_audio_source;
+	}
+
+	pthread_mutex_unlock(&obs->data.audio_sources_mutex);
+}
+
 bool obs_reset_audio(const struct obs_audio_info *oai)
 {
 	struct audio_output_info ai;
@@ -1412,6 +1473,7 @@ bool obs_reset_audio(const struct obs_audio_info *oai)
 	ai.format = AUDIO_FORMAT_FLOAT_PLANAR;
 	ai.speakers = oai->speakers;
 	ai.input_callback = audio_callback;
+	ai.clock = &obs_audio_clock;
 
 	blog(LOG_INFO, "---------------------------------");
 	blog(LOG_INFO,
@@ -1420,6 +1482,8 @@ bool obs_reset_audio(const struct obs_audio_info *oai)
 	     "\tspeakers:        %d",
 	     (int)ai.samples_per_sec, (int)ai.speakers);
 
+	reset_source_audio_rings(get_audio_channels(ai.speakers),
+				 ai.samples_per_sec);
 	return obs_init_audio(&ai);
 }
 
@@ -2165,50 +2229,215 @@ obs_source_t *obs_load_private_source(obs_data_t *source_data)
 	return obs_load_source_type(source_data, true);
 }
 
-void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
-		      void *private_data)
+struct source_load_info {
+	obs_data_t *data;
+	obs_source_t *source;
+	uint64_t create_ns;
+	uint64_t load_ns;
+	bool parallel;
+};
+
+struct source_type_load_time {
+	const char *id;
+	size_t count;
+	uint64_t create_ns;
+	uint64_t load_ns;
+};
+
+static inline bool threadsafe_create(obs_data_t *source_data)
+{
+	const char *id = obs_data_get_string(source_data, "versioned_id");
+	if (!*id)
+		id = obs_data_get_string(source_data, "id");
+
+	return (obs_get_source_output_flags(id) &
+		OBS_SOURCE_THREADSAFE_CREATE) != 0;
+}
+
+/* filters are created along with their source, so they have to be
+ * thread-safe as well */
+static bool can_load_in_parallel(obs_data_t *source_data)
+{
+	obs_data_array_t *filters;
+	bool parallel;
+
+	if (!threadsafe_create(source_data))
+		return false;
+
+	filters = obs_data_get_array(source_data, "filters");
+	parallel = true;
+
+	for (size_t i = 0; parallel && i < obs_data_array_count(filters); i++) {
+		obs_data_t *filter_data = obs_data_array_item(filters, i);
+		parallel = threadsafe_create(filter_data);
+		obs_data_release(filter_data);
+	}
+
+	obs_data_array_release(filters);
+	return parallel;
+}
+
+static void load_source_task(void *param)
+{
+	struct source_load_info *info = param;
+	uint64_t start = os_gettime_ns();
+
+	info->source = obs_load_source(info->data);
+	info->create_ns = os_gettime_ns() - start;
+}
+
+static int cmp_load_time(const void *a, const void *b)
+{
+	const struct source_type_load_time *time_a = a;
+	const struct source_type_load_time *time_b = b;
+	uint64_t total_a = time_a->create_ns + time_a->load_ns;
+	uint64_t total_b = time_b->create_ns + time_b->load_ns;
+
+	return total_a < total_b ? 1 : (total_a > total_b ? -1 : 0);
+}
+
+static void log_source_load_times(struct source_load_info *infos,
+				  size_t count, size_t parallel_count,
+				  uint64_t total_ns)
+{
+	DARRAY(struct source_type_load_time) times;
+
+	da_init(times);
+
+	for (size_t i = 0; i < count; i++) {
+		struct source_type_load_time *time = NULL;
+		const char *id;
+
+		if (!infos[i].source)
+			continue;
+
+		id = infos[i].source->info.id;
+		for (size_t j = 0; j < times.num; j++) {
+			if (strcmp(times.array[j].id, id) == 0) {
+				time = &times.array[j];
+				break;
+			}
+		}
+
+		if (!time) {
+			time = da_push_back_new(times);
+			time->id = id;
+		}
+
+		time->count++;
+		time->create_ns += infos[i].create_ns;
+		time->load_ns += infos[i].load_ns;
+	}
+
+	qsort(times.array, times.num, sizeof(*times.array), cmp_load_time);
+
+	blog(LOG_INFO, "Loaded %zu sources in %.1f ms (%zu created in parallel)",
+	     count, (double)total_ns / 1000000.0, parallel_count);
+
+	for (size_t i = 0; i < times.num; i++) {
+		struct source_type_load_time *time = &times.array[i];
+		blog(LOG_INFO, "    %s: %zu, create %.1f ms, load %.1f ms",
+		     time->id, time->count,
+		     (double)time->create_ns / 1000000.0,
+		     (double)time->load_ns / 1000000.0);
+	}
+
+	da_free(times);
+}
+
+static void load_sources(obs_data_array_t *array, obs_load_source_cb cb,
+			 void *private_data, bool parallel)
 {
 	struct obs_core_data *data = &obs->data;
-	DARRAY(obs_source_t *) sources;
+	struct source_load_info *infos;
+	uint64_t start = os_gettime_ns();
+	size_t parallel_count = 0;
 	size_t count;
 	size_t i;
 
-	da_init(sources);
-
 	count = obs_data_array_count(array);
-	da_reserve(sources, count);
+	if (!count)
+		return;
 
-	pthread_mutex_lock(&data->sources_mutex);
+	infos = bzalloc(sizeof(*infos) * count);
 
 	for (i = 0; i < count; i++) {
-		obs_data_t *source_data = obs_data_array_item(array, i);
-		obs_source_t *source = obs_load_source(source_data);
+		infos[i].data = obs_data_array_item(array, i);
+		infos[i].parallel = parallel &&
+				    can_load_in_parallel(infos[i].data);
+		if (infos[i].parallel)
+			parallel_count++;
+	}
 
-		da_push_back(sources, &source);
+	/* done before locking the sources mutex, the workers need it to add
+	 * their sources */
+	if (parallel_count) {
+		struct os_thread_pool_info pool_info = {
+			.name = "libobs: source loading"};
+		os_thread_pool_t *pool = os_thread_pool_create(&pool_info);
+		os_task_group_t *group = os_task_group_create();
+
+		for (i = 0; i < count; i++) {
+			if (infos[i].parallel &&
+			    !os_thread_pool_submit(pool,
+						   OS_TASK_PRIORITY_NORMAL,
+						   load_source_task, &infos[i],
+						   group)) {
+				infos[i].parallel = false;
+				parallel_count--;
+			}
+		}
+
+		os_task_group_wait(pool, group);
+		os_task_group_destroy(group);
+		os_thread_pool_destroy(pool);
+	}
 
-		obs_data_release(source_data);
+	pthread_mutex_lock(&data->sources_mutex);
+
+	for (i = 0; i < count; i++) {
+		if (!infos[i].parallel)
+			load_source_task(&infos[i]);
 	}
 
-	/* tell sources that we want to load */
-	for (i = 0; i < sources.num; i++) {
-		obs_source_t *source = sources.array[i];
-		obs_data_t *source_data = obs_data_array_item(array, i);
+	/* tell sources that we want to load, once all of them exist */
+	for (i = 0; i < count; i++) {
+		obs_source_t *source = infos[i].source;
+		uint64_t load_start = os_gettime_ns();
+
 		if (source) {
 			if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
-				obs_transition_load(source, source_data);
+				obs_transition_load(source, infos[i].data);
 			obs_source_load2(source);
+			infos[i].load_ns = os_gettime_ns() - load_start;
 			if (cb)
 				cb(private_data, source);
 		}
-		obs_data_release(source_data);
 	}
 
-	for (i = 0; i < sources.num; i++)
-		obs_source_release(sources.array[i]);
+	log_source_load_times(infos, count, parallel_count,
+			      os_gettime_ns() - start);
+
+	for (i = 0; i < count; i++) {
+		obs_source_release(infos[i].source);
+		obs_data_release(infos[i].data);
+	}
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
-	da_free(sources);
+	bfree(infos);
+}
+
+void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
+		      void *private_data)
+{
+	load_sources(array, cb, private_data, false);
+}
+
+void obs_load_sources_parallel(obs_data_array_t *array, obs_load_source_cb cb,
+			       void *private_data)
+{
+	load_sources(array, cb, private_data, true);
 }
 
 obs_data_t *obs_save_source(obs_source_t *source)
@@ -2296,6 +2525,13 @@ obs_data_t *obs_save_source(obs_source_t *source)
 
 obs_data_array_t *obs_save_sources_filtered(obs_save_source_filter_cb cb,
 					    void *data_)
+{
+	return obs_save_sources_custom(cb, NULL, data_);
+}
+
+obs_data_array_t *obs_save_sources_custom(obs_save_source_filter_cb filter_cb,
+					  obs_save_source_cb save_cb,
+					  void *data_)
 {
 	struct obs_core_data *data = &obs->data;
 	obs_data_array_t *array;
@@ -2310,8 +2546,10 @@ obs_data_array_t *obs_save_sources_filtered(obs_save_source_filter_cb cb,
 	while (source) {
 		if ((source->info.type != OBS_SOURCE_TYPE_FILTER) != 0 &&
 		    !source->context.private && !source->removed &&
-		    !source->temp_removed && cb(data_, source)) {
-			obs_data_t *source_data = obs_save_source(source);
+		    !source->temp_removed && filter_cb(data_, source)) {
+			obs_data_t *source_data =
+				save_cb ? save_cb(data_, source)
+					: obs_save_source(source);
 
 			obs_data_array_push_back(array, source_data);
 			obs_data_release(source_data);
@@ -2642,6 +2880,41 @@ uint32_t obs_get_lagged_frames(void)
 	return obs->video.lagged_frames;
 }
 
+void obs_get_frame_pacing_stats(struct obs_frame_pacing_stats *stats)
+{
+	struct obs_core_video *video = &obs->video;
+
+	if (!stats)
+		return;
+
+	pthread_mutex_lock(&video->pacing_mutex);
+	*stats = video->pacing_stats;
+	pthread_mutex_unlock(&video->pacing_mutex);
+}
+
+void obs_set_frame_pacing_spin(uint32_t us)
+{
+	os_atomic_set_long(&obs->video.pacing_spin_us, (long)us);
+}
+
+uint32_t obs_get_frame_pacing_spin(void)
+{
+	return (uint32_t)os_atomic_load_long(&obs->video.pacing_spin_us);
+}
+
+void obs_set_realtime_threads(bool enable)
+{
+	os_atomic_set_bool(&obs->realtime_threads, enable);
+
+	if (obs->audio.audio)
+		audio_output_set_realtime(obs->audio.audio, enable);
+}
+
+bool obs_get_realtime_threads(void)
+{
+	return os_atomic_load_bool(&obs->realtime_threads);
+}
+
 void start_raw_video(video_t *v, const struct video_scale_info *conversion,
 		     void (*callback)(void *param, struct video_data *frame),
 		     void *param)
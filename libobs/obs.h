@@ -752,6 +752,14 @@ typedef void (*obs_load_source_cb)(void *private_data, obs_source_t *source);
 EXPORT void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
 			     void *private_data);
 
+/**
+ * Loads sources from a data array, creating sources of types with the
+ * OBS_SOURCE_THREADSAFE_CREATE flag in parallel
+ */
+EXPORT void obs_load_sources_parallel(obs_data_array_t *array,
+				      obs_load_source_cb cb,
+				      void *private_data);
+
 /** Saves sources to a data array */
 EXPORT obs_data_array_t *obs_save_sources(void);
 
@@ -759,6 +767,13 @@ typedef bool (*obs_save_source_filter_cb)(void *data, obs_source_t *source);
 EXPORT obs_data_array_t *obs_save_sources_filtered(obs_save_source_filter_cb cb,
 						   void *data);
 
+/** Like obs_save_sources_filtered, but the saved data of each source is
+ * returned by save_cb (with a reference), for example from a cache */
+typedef obs_data_t *(*obs_save_source_cb)(void *data, obs_source_t *source);
+EXPORT obs_data_array_t *
+obs_save_sources_custom(obs_save_source_filter_cb filter_cb,
+			obs_save_source_cb save_cb, void *data);
+
 enum obs_obj_type {
 	OBS_OBJ_TYPE_INVALID,
 	OBS_OBJ_TYPE_SOURCE,
@@ -784,6 +799,53 @@ EXPORT void obs_enum_audio_monitoring_devices(obs_enum_audio_device_cb cb,
 EXPORT bool obs_set_audio_monitoring_device(const char *name, const char *id);
 EXPORT void obs_get_audio_monitoring_device(const char **name, const char **id);
 
+struct obs_audio_monitoring_bus_stats {
+	uint32_t inputs;
+	uint64_t mixed_frames;
+	uint64_t underruns;
+	uint64_t dropped_frames;
+	double latency_ms;
+	double max_latency_ms;
+};
+
+/**
+ * Enables or disables the audio monitoring bus.  When enabled, all monitored
+ * sources are mixed into a single buffer on the audio thread and played back
+ * through one stream on the monitoring device instead of one stream per
+ * source.  Audio is placed by timestamp, including the sync offset, and the
+ * bus mixes the same window as the outputs.  Sources flagged with
+ * OBS_SOURCE_DO_NOT_SELF_MONITOR keep their own stream so that feedback loops
+ * can still be detected.
+ */
+EXPORT void obs_set_audio_monitoring_bus_enabled(bool enable);
+EXPORT bool obs_audio_monitoring_bus_enabled(void);
+
+/** Returns false if the monitoring bus is not enabled */
+EXPORT bool obs_get_audio_monitoring_bus_stats(
+	struct obs_audio_monitoring_bus_stats *stats);
+
+struct obs_audio_buffering_stats {
+	uint32_t buffering_ms;
+	uint32_t max_buffering_ms;
+	uint32_t headroom_ms;
+	uint32_t increases;
+	uint32_t decreases;
+};
+
+/**
+ * Allows audio buffering to shrink again.  Buffering is added whenever a
+ * source is late; when every source has had at least one audio tick of
+ * headroom for the given number of milliseconds, one buffered tick is output
+ * early, which reduces the latency by a tick without dropping or stretching
+ * any audio.  0 disables shrinking, which is the default.
+ */
+EXPORT void obs_set_audio_buffering_shrink_delay(uint32_t ms);
+EXPORT uint32_t obs_get_audio_buffering_shrink_delay(void);
+
+/** Returns false if audio is not initialized */
+EXPORT bool
+obs_get_audio_buffering_stats(struct obs_audio_buffering_stats *stats);
+
 EXPORT void obs_add_tick_callback(void (*tick)(void *param, float seconds),
 				  void *param);
 EXPORT void obs_remove_tick_callback(void (*tick)(void *param, float seconds),
@@ -818,6 +880,69 @@ EXPORT uint64_t obs_get_frame_interval_ns(void);
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
+#define OBS_FRAME_JITTER_BUCKETS 8
+
+/**
+ * Deviation of the graphics thread's frame intervals from the nominal frame
+ * interval since video was last reset.  The buckets count intervals that
+ * deviated by less than 100us, 250us, 500us, 1ms, 2ms, 4ms and 8ms, and the
+ * last one everything above.
+ */
+struct obs_frame_pacing_stats {
+	uint64_t intervals;
+	uint64_t total_jitter_us;
+	uint64_t max_jitter_us;
+	uint64_t buckets[OBS_FRAME_JITTER_BUCKETS];
+};
+
+EXPORT void obs_get_frame_pacing_stats(struct obs_frame_pacing_stats *stats);
+
+/**
+ * Busy waits for the last part of each frame interval to pace frames more
+ * precisely than the system timer allows, at the cost of CPU time.  Disabled
+ * (0) by default.
+ */
+EXPORT void obs_set_frame_pacing_spin(uint32_t us);
+EXPORT uint32_t obs_get_frame_pacing_spin(void);
+
+/**
+ * Opts the graphics and audio threads in to real-time scheduling.  This
+ * usually requires elevated privileges, failures are logged.
+ */
+EXPORT void obs_set_realtime_threads(bool enable);
+EXPORT bool obs_get_realtime_threads(void);
+
+/**
+ * Master clock the graphics and audio threads pace their output to.  The
+ * system clock is used by default.  Discontinuities of the clock are
+ * absorbed, only its rate is followed.
+ */
+struct obs_clock_info {
+	/** Current time of the clock in nanoseconds */
+	uint64_t (*get_time_ns)(void *data);
+	void *data;
+};
+
+struct obs_clock_stats {
+	/** Rate of the master clock relative to the system clock */
+	double drift_ppm;
+	/** How far output timing has moved away from the system clock */
+	int64_t correction_ns;
+	/** Number of discontinuities of the master clock absorbed */
+	uint64_t resyncs;
+};
+
+/** Sets the master clock, NULL for the system clock.  The data of the
+ * previous clock is no longer used once this returns. */
+EXPORT void obs_set_master_clock(const struct obs_clock_info *info);
+
+/** Uses a software clock running drift_ppm faster than the system clock as
+ * master clock, as a stand-in for an external reference when testing. */
+EXPORT void obs_set_software_master_clock(double drift_ppm);
+
+EXPORT uint64_t obs_get_master_clock_time(void);
+EXPORT void obs_get_master_clock_stats(struct obs_clock_stats *stats);
+
 EXPORT bool obs_nv12_tex_active(void);
 EXPORT bool obs_p010_tex_active(void);
 
@@ -1009,6 +1134,12 @@ EXPORT bool obs_is_source_configurable(const char *id);
 
 EXPORT bool obs_source_configurable(const obs_source_t *source);
 
+/**
+ * Returns whether the source saves data of its own through a save callback,
+ * which can change without any signal
+ */
+EXPORT bool obs_source_has_save_callback(const obs_source_t *source);
+
 /**
  * Returns the properties list for a specific existing source.  Free with
  * obs_properties_destroy
@@ -1156,6 +1287,41 @@ EXPORT void obs_source_set_audio_mixers(obs_source_t *source, uint32_t mixers);
 /** Gets audio mixer flags */
 EXPORT uint32_t obs_source_get_audio_mixers(const obs_source_t *source);
 
+/* ------------------------------------------------------------------------- */
+/* Audio buses */
+
+/**
+ * Creates an audio bus.  A bus is an audio source whose audio is the sum of
+ * the post-fader audio of its inputs, so it can have its own filters, volume
+ * and monitoring.  Its audio mixer flags select the output tracks it feeds.
+ * Buses are mixed into the tracks directly and should not be added to scenes.
+ */
+EXPORT obs_source_t *obs_audio_bus_create(const char *name,
+					  obs_data_t *settings);
+
+EXPORT bool obs_source_is_audio_bus(const obs_source_t *source);
+
+/**
+ * Adds an input to a bus.  The input can be any non-composite audio source,
+ * or another bus as long as that doesn't create a loop.
+ */
+EXPORT bool obs_audio_bus_add_input(obs_source_t *bus, obs_source_t *input,
+				    float gain);
+EXPORT void obs_audio_bus_remove_input(obs_source_t *bus, obs_source_t *input);
+EXPORT void obs_audio_bus_set_input_gain(obs_source_t *bus,
+					 obs_source_t *input, float gain);
+
+typedef bool (*obs_audio_bus_enum_proc_t)(void *param, obs_source_t *input,
+					  float gain);
+
+EXPORT void obs_audio_bus_enum_inputs(obs_source_t *bus,
+				      obs_audio_bus_enum_proc_t enum_proc,
+				      void *param);
+
+/** Enumerates audio buses, in the order they are evaluated */
+EXPORT void obs_enum_audio_buses(bool (*enum_proc)(void *, obs_source_t *),
+				 void *param);
+
 /**
  * Increments the 'showing' reference counter to indicate that the source is
  * being shown somewhere.  If the reference counter was 0, will call the 'show'
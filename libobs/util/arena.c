@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "arena.h"
+#include "bmem.h"
+#include "threading.h"
+
+#define DEFAULT_BLOCK_SIZE (64 * 1024)
+
+struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+};
+
+struct os_arena {
+	struct arena_block *block;
+	size_t block_size;
+	size_t used;
+	size_t capacity;
+};
+
+static THREAD_LOCAL os_arena_t *thread_frame_arena = NULL;
+
+static inline size_t align_size(size_t size)
+{
+	const size_t alignment = (size_t)base_get_alignment();
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static inline uint8_t *block_data(struct arena_block *block)
+{
+	return (uint8_t *)block + align_size(sizeof(struct arena_block));
+}
+
+static struct arena_block *add_block(os_arena_t *arena, size_t size)
+{
+	struct arena_block *block =
+		bmalloc(align_size(sizeof(struct arena_block)) + size);
+
+	block->next = arena->block;
+	block->size = size;
+	block->used = 0;
+
+	arena->block = block;
+	arena->capacity += size;
+	return block;
+}
+
+static void free_blocks(os_arena_t *arena)
+{
+	struct arena_block *block = arena->block;
+
+	while (block) {
+		struct arena_block *next = block->next;
+		bfree(block);
+		block = next;
+	}
+
+	arena->block = NULL;
+	arena->capacity = 0;
+}
+
+os_arena_t *os_arena_create(size_t block_size)
+{
+	os_arena_t *arena = bzalloc(sizeof(struct os_arena));
+	arena->block_size = align_size(block_size ? block_size
+						  : DEFAULT_BLOCK_SIZE);
+	return arena;
+}
+
+void os_arena_destroy(os_arena_t *arena)
+{
+	if (!arena)
+		return;
+
+	if (thread_frame_arena == arena)
+		thread_frame_arena = NULL;
+
+	free_blocks(arena);
+	bfree(arena);
+}
+
+void *os_arena_alloc(os_arena_t *arena, size_t size)
+{
+	struct arena_block *block;
+	void *ptr;
+
+	if (!arena)
+		return NULL;
+
+	size = align_size(size ? size : 1);
+	block = arena->block;
+
+	if (!block || block->size - block->used < size) {
+		size_t block_size = arena->block_size;
+		while (block_size < size)
+			block_size *= 2;
+
+		block = add_block(arena, block_size);
+	}
+
+	ptr = block_data(block) + block->used;
+	block->used += size;
+	arena->used += size;
+	return ptr;
+}
+
+void os_arena_reset(os_arena_t *arena)
+{
+	struct arena_block *block;
+
+	if (!arena)
+		return;
+
+	block = arena->block;
+	if (block && block->next) {
+		size_t capacity = arena->capacity;
+
+		free_blocks(arena);
+		add_block(arena, capacity);
+		arena->block_size = capacity;
+
+	} else if (block) {
+		block->used = 0;
+	}
+
+	arena->used = 0;
+}
+
+size_t os_arena_used(const os_arena_t *arena)
+{
+	return arena ? arena->used : 0;
+}
+
+size_t os_arena_capacity(const os_arena_t *arena)
+{
+	return arena ? arena->capacity : 0;
+}
+
+void os_set_thread_frame_arena(os_arena_t *arena)
+{
+	thread_frame_arena = arena;
+}
+
+os_arena_t *os_get_thread_frame_arena(void)
+{
+	return thread_frame_arena;
+}
+
+void *os_frame_alloc(size_t size)
+{
+	return os_arena_alloc(thread_frame_arena, size);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ * Arena allocator
+ *
+ *   Hands out memory by bumping a pointer, and releases all of it at once
+ * when the arena is reset.  If the memory handed out between two resets
+ * didn't fit in one block, the blocks are merged into a single larger one
+ * on reset, so an arena that is reset regularly stops allocating once it
+ * has grown to its working size.
+ *
+ *   The graphics and audio threads each have a frame arena that is reset
+ * after every tick, for memory that is only needed during the tick.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_arena;
+typedef struct os_arena os_arena_t;
+
+/* block_size is the size of the first block, 0 for a default size */
+EXPORT os_arena_t *os_arena_create(size_t block_size);
+EXPORT void os_arena_destroy(os_arena_t *arena);
+
+/* memory is aligned like bmalloc, and valid until the arena is reset */
+EXPORT void *os_arena_alloc(os_arena_t *arena, size_t size);
+EXPORT void os_arena_reset(os_arena_t *arena);
+
+/* bytes handed out since the last reset, and memory held by the arena */
+EXPORT size_t os_arena_used(const os_arena_t *arena);
+EXPORT size_t os_arena_capacity(const os_arena_t *arena);
+
+/* sets the frame arena of the calling thread, which owns it */
+EXPORT void os_set_thread_frame_arena(os_arena_t *arena);
+EXPORT os_arena_t *os_get_thread_frame_arena(void);
+
+/* allocates from the calling thread's frame arena, the memory is valid until
+ * the end of the current tick.  returns NULL if the thread has no frame
+ * arena, i.e. if it isn't the graphics or audio thread. */
+EXPORT void *os_frame_alloc(size_t size);
+
+#ifdef __cplusplus
+}
+#endif
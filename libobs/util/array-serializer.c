@@ -44,3 +44,35 @@ void array_output_serializer_free(struct array_output_data *data)
 {
 	da_free(data->bytes);
 }
+
+static size_t array_input_read(void *param, void *data, size_t size)
+{
+	struct array_input_data *input = param;
+	size_t left = input->size - input->pos;
+
+	if (size > left)
+		size = left;
+
+	memcpy(data, input->bytes + input->pos, size);
+	input->pos += size;
+	return size;
+}
+
+static int64_t array_input_get_pos(void *param)
+{
+	struct array_input_data *input = param;
+	return (int64_t)input->pos;
+}
+
+void array_input_serializer_init(struct serializer *s,
+				 struct array_input_data *data,
+				 const void *bytes, size_t size)
+{
+	memset(s, 0, sizeof(struct serializer));
+	data->bytes = bytes;
+	data->size = size;
+	data->pos = 0;
+	s->data = data;
+	s->read = array_input_read;
+	s->get_pos = array_input_get_pos;
+}
@@ -26,3 +26,14 @@ struct array_output_data {
 EXPORT void array_output_serializer_init(struct serializer *s,
 					 struct array_output_data *data);
 EXPORT void array_output_serializer_free(struct array_output_data *data);
+
+struct array_input_data {
+	const uint8_t *bytes;
+	size_t size;
+	size_t pos;
+};
+
+/* bytes are not copied, and must stay valid while reading */
+EXPORT void array_input_serializer_init(struct serializer *s,
+					struct array_input_data *data,
+					const void *bytes, size_t size);
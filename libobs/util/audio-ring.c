@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "audio-ring.h"
+#include "bmem.h"
+#include "threading.h"
+
+/* Indices are free running counters that are only ever compared through
+ * their unsigned difference, so wrapping around is harmless. */
+
+static inline unsigned long load_index(const volatile long *ptr)
+{
+	return (unsigned long)os_atomic_load_long(ptr);
+}
+
+static inline void store_index(volatile long *ptr, unsigned long val)
+{
+	os_atomic_store_long(ptr, (long)val);
+}
+
+static inline size_t round_pow2(size_t val)
+{
+	size_t pow2 = 1;
+	while (pow2 < val)
+		pow2 <<= 1;
+	return pow2;
+}
+
+void audio_ring_init(struct audio_ring *ring, size_t channels,
+		     size_t capacity, size_t max_packets,
+		     size_t max_overflow_frames)
+{
+	memset(ring, 0, sizeof(*ring));
+
+	if (channels > AUDIO_RING_MAX_CHANNELS)
+		channels = AUDIO_RING_MAX_CHANNELS;
+
+	ring->channels = channels;
+	ring->capacity = round_pow2(capacity);
+	ring->max_packets = round_pow2(max_packets);
+
+	if (max_overflow_frames &&
+	    pthread_mutex_init(&ring->overflow_mutex, NULL) == 0)
+		ring->max_overflow_frames = max_overflow_frames;
+}
+
+/* producer side.  the consumer only looks at the buffers once a packet has
+ * been published, which happens after they are allocated. */
+static void allocate(struct audio_ring *ring)
+{
+	if (ring->channels) {
+		float *ptr = bmalloc(sizeof(float) * ring->capacity *
+				     ring->channels);
+
+		for (size_t i = 0; i < ring->channels; i++)
+			ring->data[i] = ptr + ring->capacity * i;
+	}
+
+	ring->slots =
+		bzalloc(sizeof(struct audio_ring_slot) * ring->max_packets);
+}
+
+void audio_ring_free(struct audio_ring *ring)
+{
+	if (ring->max_overflow_frames) {
+		pthread_mutex_destroy(&ring->overflow_mutex);
+		circlebuf_free(&ring->overflow);
+		bfree(ring->overflow_data);
+	}
+
+	bfree(ring->data[0]);
+	bfree(ring->slots);
+	memset(ring, 0, sizeof(*ring));
+}
+
+/* ------------------------------------------------------------------------- */
+/* overflow, each packet is stored as its header followed by its planes */
+
+struct overflow_header {
+	uint64_t timestamp;
+	uint32_t frames;
+	uint32_t flags;
+};
+
+static bool push_overflow(struct audio_ring *ring, uint64_t timestamp,
+			  const float *const *data, uint32_t frames,
+			  uint32_t flags)
+{
+	struct overflow_header header = {timestamp, frames, flags};
+	size_t size = frames * sizeof(float);
+	size_t total;
+
+	pthread_mutex_lock(&ring->overflow_mutex);
+
+	total = (size_t)os_atomic_load_long(&ring->overflow_frames) + frames;
+	if (total > ring->max_overflow_frames) {
+		pthread_mutex_unlock(&ring->overflow_mutex);
+		return false;
+	}
+
+	circlebuf_push_back(&ring->overflow, &header, sizeof(header));
+	for (size_t i = 0; i < ring->channels && frames; i++) {
+		if (data && data[i])
+			circlebuf_push_back(&ring->overflow, data[i], size);
+		else
+			circlebuf_push_back_zero(&ring->overflow, size);
+	}
+
+	os_atomic_set_long(&ring->overflow_frames, (long)total);
+	os_atomic_inc_long(&ring->overflow_packets);
+
+	pthread_mutex_unlock(&ring->overflow_mutex);
+	return true;
+}
+
+/* consumer side, moves the oldest overflow packet to overflow_data where it
+ * stays until it is popped */
+static void peek_overflow(struct audio_ring *ring,
+			  struct audio_ring_packet *packet)
+{
+	struct overflow_header header;
+	size_t size;
+
+	pthread_mutex_lock(&ring->overflow_mutex);
+
+	circlebuf_pop_front(&ring->overflow, &header, sizeof(header));
+	size = header.frames * sizeof(float);
+
+	if (header.frames > ring->overflow_data_frames) {
+		ring->overflow_data =
+			brealloc(ring->overflow_data,
+				 size * (ring->channels ? ring->channels : 1));
+		ring->overflow_data_frames = header.frames;
+	}
+
+	for (size_t i = 0; i < ring->channels && header.frames; i++)
+		circlebuf_pop_front(&ring->overflow,
+				    ring->overflow_data + header.frames * i,
+				    size);
+
+	os_atomic_set_long(
+		&ring->overflow_frames,
+		os_atomic_load_long(&ring->overflow_frames) - header.frames);
+	os_atomic_dec_long(&ring->overflow_packets);
+
+	pthread_mutex_unlock(&ring->overflow_mutex);
+
+	memset(packet, 0, sizeof(*packet));
+	packet->timestamp = header.timestamp;
+	packet->frames = header.frames;
+	packet->flags = header.flags;
+
+	for (size_t i = 0; i < ring->channels; i++)
+		packet->data[i] = ring->overflow_data + header.frames * i;
+
+	ring->overflow_packet = *packet;
+	ring->overflow_peeked = true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool push_internal(struct audio_ring *ring, uint64_t timestamp,
+			  const float *const *data, uint32_t frames,
+			  uint32_t flags)
+{
+	unsigned long w_frame = load_index(&ring->write_frame);
+	unsigned long w_packet = load_index(&ring->write_packet);
+	unsigned long r_frame = load_index(&ring->read_frame);
+	unsigned long r_packet = load_index(&ring->read_packet);
+	size_t mask = ring->capacity - 1;
+	size_t pos = w_frame & mask;
+	unsigned long start = w_frame;
+	struct audio_ring_slot *slot;
+
+	if (!ring->max_packets)
+		return false;
+	if (!ring->slots)
+		allocate(ring);
+
+	/* the consumer has not caught up with the overflow yet, keep the
+	 * packets in order */
+	if (os_atomic_load_long(&ring->overflow_packets))
+		goto overflow;
+	if (w_packet - r_packet >= ring->max_packets)
+		goto overflow;
+	if (frames > ring->capacity)
+		goto overflow;
+
+	/* never let a packet wrap around the end of the ring, skip the
+	 * remaining tail instead so the consumer gets contiguous planes */
+	if (pos + frames > ring->capacity)
+		start += (unsigned long)(ring->capacity - pos);
+	if (start + frames - r_frame > ring->capacity)
+		goto overflow;
+
+	for (size_t i = 0; i < ring->channels && frames; i++) {
+		float *dst = ring->data[i] + (start & mask);
+
+		if (data && data[i])
+			memcpy(dst, data[i], frames * sizeof(float));
+		else
+			memset(dst, 0, frames * sizeof(float));
+	}
+
+	slot = &ring->slots[w_packet & (ring->max_packets - 1)];
+	slot->timestamp = timestamp;
+	slot->frames = frames;
+	slot->flags = ring->gap ? flags | AUDIO_RING_GAP : flags;
+	slot->start = start;
+	slot->end = start + frames;
+
+	/* the packet store publishes the samples and the slot */
+	store_index(&ring->write_frame, start + frames);
+	store_index(&ring->write_packet, w_packet + 1);
+	ring->gap = false;
+	return true;
+
+overflow:
+	if (ring->max_overflow_frames &&
+	    push_overflow(ring, timestamp, data, frames,
+			  ring->gap ? flags | AUDIO_RING_GAP : flags)) {
+		ring->gap = false;
+		return true;
+	}
+
+	os_atomic_inc_long(&ring->dropped);
+	ring->gap = true;
+	return false;
+}
+
+bool audio_ring_push(struct audio_ring *ring, uint64_t timestamp,
+		     const float *const *data, uint32_t frames, uint32_t flags)
+{
+	return push_internal(ring, timestamp, data, frames,
+			     flags & AUDIO_RING_CONTIGUOUS);
+}
+
+bool audio_ring_push_reset(struct audio_ring *ring, uint64_t timestamp)
+{
+	return push_internal(ring, timestamp, NULL, 0, AUDIO_RING_RESET);
+}
+
+bool audio_ring_peek(struct audio_ring *ring, struct audio_ring_packet *packet)
+{
+	/* the overflow count is loaded first: every packet the producer put in
+	 * the ring before the counted overflow packets is then visible, and
+	 * ring packets are always older than the overflow ones */
+	long overflow_packets = os_atomic_load_long(&ring->overflow_packets);
+	unsigned long r_packet = load_index(&ring->read_packet);
+	unsigned long w_packet = load_index(&ring->write_packet);
+	const struct audio_ring_slot *slot;
+	size_t mask = ring->capacity - 1;
+
+	if (ring->overflow_peeked) {
+		*packet = ring->overflow_packet;
+		return true;
+	}
+
+	if (r_packet == w_packet) {
+		if (!overflow_packets)
+			return false;
+
+		peek_overflow(ring, packet);
+		return true;
+	}
+
+	slot = &ring->slots[r_packet & (ring->max_packets - 1)];
+	packet->timestamp = slot->timestamp;
+	packet->frames = slot->frames;
+	packet->flags = slot->flags;
+	packet->end = slot->end;
+
+	for (size_t i = 0; i < AUDIO_RING_MAX_CHANNELS; i++)
+		packet->data[i] = i < ring->channels
+					  ? ring->data[i] + (slot->start & mask)
+					  : NULL;
+	return true;
+}
+
+void audio_ring_pop(struct audio_ring *ring,
+		    const struct audio_ring_packet *packet)
+{
+	unsigned long r_packet = load_index(&ring->read_packet);
+
+	if (ring->overflow_peeked) {
+		ring->overflow_peeked = false;
+		return;
+	}
+
+	store_index(&ring->read_frame, packet->end);
+	store_index(&ring->read_packet, r_packet + 1);
+}
+
+size_t audio_ring_buffered_frames(const struct audio_ring *ring)
+{
+	unsigned long w_frame = load_index(&ring->write_frame);
+	unsigned long r_frame = load_index(&ring->read_frame);
+	long overflow = os_atomic_load_long(&ring->overflow_frames);
+	return (size_t)(w_frame - r_frame) + (size_t)overflow;
+}
+
+size_t audio_ring_dropped_packets(const struct audio_ring *ring)
+{
+	return (size_t)(unsigned long)os_atomic_load_long(&ring->dropped);
+}
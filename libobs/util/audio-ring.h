@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+#include "circlebuf.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lock-free single producer / single consumer ring of timestamped planar
+ * float audio packets.
+ *
+ * The producer copies each packet into the ring and publishes it with a
+ * single atomic store, the consumer reads the packet samples in place and
+ * releases them with another.  Packets are never split across the end of
+ * the ring, so a consumer always sees contiguous planes.  Neither side ever
+ * blocks: a push that does not fit is dropped and counted, and the next
+ * packet that makes it into the ring is flagged with AUDIO_RING_GAP.
+ *
+ * A ring can be given an overflow of up to max_overflow_frames: packets that
+ * do not fit in the ring, because they are larger than it or because the
+ * consumer fell behind, go to a mutex protected circlebuf instead of being
+ * dropped, along with every packet after them until the consumer has caught
+ * up.  Only pushes beyond the overflow are dropped.
+ *
+ * The buffers are allocated by the first push, so rings of sources that
+ * never output anything cost no sample memory.
+ *
+ * Only one thread at a time may push and only one thread at a time may
+ * peek/pop; callers serialize each side themselves if needed.
+ */
+
+#define AUDIO_RING_MAX_CHANNELS 8
+
+/* packet flags */
+#define AUDIO_RING_CONTIGUOUS (1 << 0) /* continues the previous packet */
+#define AUDIO_RING_RESET (1 << 1)      /* marker, carries no samples */
+#define AUDIO_RING_GAP (1 << 2)        /* packets were dropped before it */
+
+struct audio_ring_packet {
+	uint64_t timestamp;
+	uint32_t frames;
+	uint32_t flags;
+	const float *data[AUDIO_RING_MAX_CHANNELS];
+
+	/* internal */
+	unsigned long end;
+};
+
+struct audio_ring_slot {
+	uint64_t timestamp;
+	uint32_t frames;
+	uint32_t flags;
+	unsigned long start;
+	unsigned long end;
+};
+
+struct audio_ring {
+	size_t channels;
+	size_t capacity;
+	size_t max_packets;
+	float *data[AUDIO_RING_MAX_CHANNELS];
+	struct audio_ring_slot *slots;
+
+	volatile long write_frame;
+	volatile long write_packet;
+	volatile long read_frame;
+	volatile long read_packet;
+	volatile long dropped;
+
+	/* producer side only */
+	bool gap;
+
+	/* overflow, see above */
+	size_t max_overflow_frames;
+	pthread_mutex_t overflow_mutex;
+	struct circlebuf overflow;
+	volatile long overflow_packets;
+	volatile long overflow_frames;
+
+	/* consumer side only, the overflow packet being peeked */
+	bool overflow_peeked;
+	struct audio_ring_packet overflow_packet;
+	float *overflow_data;
+	size_t overflow_data_frames;
+};
+
+/* capacity and max_packets are rounded up to powers of two, and a
+ * max_overflow_frames of 0 disables the overflow.  nothing is allocated until
+ * the first push. */
+EXPORT void audio_ring_init(struct audio_ring *ring, size_t channels,
+			    size_t capacity, size_t max_packets,
+			    size_t max_overflow_frames);
+EXPORT void audio_ring_free(struct audio_ring *ring);
+
+/* producer side */
+EXPORT bool audio_ring_push(struct audio_ring *ring, uint64_t timestamp,
+			    const float *const *data, uint32_t frames,
+			    uint32_t flags);
+EXPORT bool audio_ring_push_reset(struct audio_ring *ring,
+				  uint64_t timestamp);
+
+/* consumer side */
+EXPORT bool audio_ring_peek(struct audio_ring *ring,
+			    struct audio_ring_packet *packet);
+EXPORT void audio_ring_pop(struct audio_ring *ring,
+			   const struct audio_ring_packet *packet);
+
+/* either side */
+EXPORT size_t audio_ring_buffered_frames(const struct audio_ring *ring);
+EXPORT size_t audio_ring_dropped_packets(const struct audio_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,7 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include "base.h"
@@ -95,11 +96,150 @@ void base_set_allocator(struct base_allocator *defs)
 	memcpy(&alloc, defs, sizeof(struct base_allocator));
 }
 
+/* ------------------------------------------------------------------------- */
+/* Allocation tagging
+ *
+ *   When enabled, every allocation is prefixed with a header holding its size
+ * and tag, so it can be accounted to the right tag when it is freed from any
+ * thread.  Whether tagging is enabled is decided once on the first
+ * allocation, as allocations made without the header can't be freed with it
+ * and vice versa. */
+
+#define MAX_TAGS 64
+#define TAG_HEADER_SIZE ALIGNMENT
+
+struct tag_header {
+	size_t size;
+	long tag;
+};
+
+struct bmem_tag {
+	pthread_mutex_t mutex;
+	struct bmem_tag_stats stats;
+};
+
+enum tag_op {
+	TAG_ALLOC,
+	TAG_REALLOC,
+	TAG_FREE,
+};
+
+static volatile long tagging = -1;
+static pthread_once_t tagging_once = PTHREAD_ONCE_INIT;
+static uint64_t tagging_start_ns = 0;
+static struct bmem_tag tags[MAX_TAGS];
+static volatile long num_tags = 0;
+static pthread_mutex_t tags_mutex = PTHREAD_MUTEX_INITIALIZER;
+static THREAD_LOCAL long thread_tag = 0;
+
+static void init_tagging(void)
+{
+	bool enabled = getenv("OBS_MEMORY_TAGS") != NULL;
+
+	if (enabled) {
+		tagging_start_ns = os_gettime_ns();
+		pthread_mutex_init(&tags[0].mutex, NULL);
+		tags[0].stats.name = "untagged";
+		os_atomic_store_long(&num_tags, 1);
+	}
+
+	os_atomic_store_long(&tagging, enabled);
+}
+
+static inline bool tagging_enabled(void)
+{
+	long enabled = os_atomic_load_long(&tagging);
+
+	if (enabled < 0) {
+		pthread_once(&tagging_once, init_tagging);
+		enabled = os_atomic_load_long(&tagging);
+	}
+
+	return enabled > 0;
+}
+
+static void tag_account(long tag, enum tag_op op, size_t old_size,
+			size_t new_size)
+{
+	struct bmem_tag_stats *stats = &tags[tag].stats;
+
+	pthread_mutex_lock(&tags[tag].mutex);
+	if (op == TAG_ALLOC) {
+		stats->live_allocs++;
+		stats->total_allocs++;
+	} else if (op == TAG_FREE) {
+		stats->live_allocs--;
+	}
+
+	stats->live_bytes += new_size;
+	stats->live_bytes -= old_size;
+	if (new_size > old_size)
+		stats->total_bytes += new_size - old_size;
+	if (stats->live_bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->live_bytes;
+	pthread_mutex_unlock(&tags[tag].mutex);
+}
+
+static void *tag_alloc(void *block, size_t size)
+{
+	struct tag_header *header = block;
+	if (!header)
+		return NULL;
+
+	header->size = size;
+	header->tag = thread_tag;
+	tag_account(header->tag, TAG_ALLOC, 0, size);
+	return (char *)block + TAG_HEADER_SIZE;
+}
+
+static inline struct tag_header *get_tag_header(void *ptr)
+{
+	return (struct tag_header *)((char *)ptr - TAG_HEADER_SIZE);
+}
+
+static void *tagged_malloc(size_t size)
+{
+	return tag_alloc(alloc.malloc(size + TAG_HEADER_SIZE), size);
+}
+
+static void *tagged_realloc(void *ptr, size_t size)
+{
+	struct tag_header *header;
+	size_t old_size;
+
+	if (!ptr)
+		return tagged_malloc(size);
+
+	header = get_tag_header(ptr);
+	old_size = header->size;
+	header = alloc.realloc(header, size + TAG_HEADER_SIZE);
+	if (!header)
+		return NULL;
+
+	header->size = size;
+	tag_account(header->tag, TAG_REALLOC, old_size, size);
+	return (char *)header + TAG_HEADER_SIZE;
+}
+
+static void tagged_free(void *ptr)
+{
+	struct tag_header *header = get_tag_header(ptr);
+
+	tag_account(header->tag, TAG_FREE, header->size, 0);
+	alloc.free(header);
+}
+
 void *bmalloc(size_t size)
 {
-	void *ptr = alloc.malloc(size);
-	if (!ptr && !size)
-		ptr = alloc.malloc(1);
+	void *ptr;
+
+	if (tagging_enabled()) {
+		ptr = tagged_malloc(size);
+	} else {
+		ptr = alloc.malloc(size);
+		if (!ptr && !size)
+			ptr = alloc.malloc(1);
+	}
 	if (!ptr) {
 		os_breakpoint();
 		bcrash("Out of memory while trying to allocate %lu bytes",
@@ -115,9 +255,13 @@ void *brealloc(void *ptr, size_t size)
 	if (!ptr)
 		os_atomic_inc_long(&num_allocs);
 
-	ptr = alloc.realloc(ptr, size);
-	if (!ptr && !size)
-		ptr = alloc.realloc(ptr, 1);
+	if (tagging_enabled()) {
+		ptr = tagged_realloc(ptr, size);
+	} else {
+		ptr = alloc.realloc(ptr, size);
+		if (!ptr && !size)
+			ptr = alloc.realloc(ptr, 1);
+	}
 	if (!ptr) {
 		os_breakpoint();
 		bcrash("Out of memory while trying to allocate %lu bytes",
@@ -131,7 +275,10 @@ void bfree(void *ptr)
 {
 	if (ptr) {
 		os_atomic_dec_long(&num_allocs);
-		alloc.free(ptr);
+		if (os_atomic_load_long(&tagging) > 0)
+			tagged_free(ptr);
+		else
+			alloc.free(ptr);
 	}
 }
 
@@ -140,6 +287,95 @@ long bnum_allocs(void)
 	return num_allocs;
 }
 
+bool bmem_tagging_enabled(void)
+{
+	return tagging_enabled();
+}
+
+static long find_tag(const char *name)
+{
+	long count = os_atomic_load_long(&num_tags);
+
+	for (long i = 1; i < count; i++) {
+		if (strcmp(tags[i].stats.name, name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+const char *bmem_set_thread_tag(const char *name)
+{
+	const char *prev;
+	long tag = 0;
+
+	if (!tagging_enabled())
+		return NULL;
+
+	prev = thread_tag ? tags[thread_tag].stats.name : NULL;
+
+	if (name) {
+		pthread_mutex_lock(&tags_mutex);
+		tag = find_tag(name);
+		if (tag < 0 && num_tags < MAX_TAGS) {
+			tag = num_tags;
+			pthread_mutex_init(&tags[tag].mutex, NULL);
+			tags[tag].stats.name = name;
+			os_atomic_inc_long(&num_tags);
+		}
+		pthread_mutex_unlock(&tags_mutex);
+
+		/* accounted as untagged once all tags are in use */
+		if (tag < 0)
+			tag = 0;
+	}
+
+	thread_tag = tag;
+	return prev;
+}
+
+size_t bmem_num_tags(void)
+{
+	return tagging_enabled() ? (size_t)os_atomic_load_long(&num_tags) : 0;
+}
+
+bool bmem_get_tag_stats(size_t idx, struct bmem_tag_stats *stats)
+{
+	if (idx >= bmem_num_tags())
+		return false;
+
+	pthread_mutex_lock(&tags[idx].mutex);
+	*stats = tags[idx].stats;
+	pthread_mutex_unlock(&tags[idx].mutex);
+	return true;
+}
+
+void bmem_log_tag_stats(void)
+{
+	struct bmem_tag_stats stats;
+	double seconds;
+	size_t count = bmem_num_tags();
+
+	if (!count)
+		return;
+
+	seconds = (double)(os_gettime_ns() - tagging_start_ns) / 1000000000.0;
+	if (seconds <= 0.0)
+		seconds = 1.0;
+
+	blog(LOG_INFO, "Memory usage by tag:");
+	for (size_t i = 0; i < count; i++) {
+		bmem_get_tag_stats(i, &stats);
+		blog(LOG_INFO,
+		     "\t%s: %" PRIu64 " bytes in %" PRIu64 " allocations, "
+		     "peak %" PRIu64 " bytes, %.1f allocations/s, "
+		     "%.1f KiB/s",
+		     stats.name, stats.live_bytes, stats.live_allocs,
+		     stats.peak_bytes, (double)stats.total_allocs / seconds,
+		     (double)stats.total_bytes / seconds / 1024.0);
+	}
+}
+
 int base_get_alignment(void)
 {
 	return ALIGNMENT;
@@ -41,6 +41,34 @@ EXPORT int base_get_alignment(void);
 
 EXPORT long bnum_allocs(void);
 
+/* ------------------------------------------------------------------------- */
+/* Allocation tagging
+ *
+ *   Accounts memory to the tag set on the allocating thread, enabled by
+ * setting the OBS_MEMORY_TAGS environment variable before the process starts.
+ * When disabled, tags can still be set but have no effect. */
+
+struct bmem_tag_stats {
+	const char *name;
+	uint64_t live_bytes;
+	uint64_t live_allocs;
+	uint64_t peak_bytes;
+	uint64_t total_allocs;
+	uint64_t total_bytes;
+};
+
+EXPORT bool bmem_tagging_enabled(void);
+
+/* sets the tag for allocations made by the calling thread and returns the
+ * previous one to restore afterwards.  NULL for untagged.  the name must
+ * stay valid for the lifetime of the process. */
+EXPORT const char *bmem_set_thread_tag(const char *name);
+
+/* tag 0 holds all untagged allocations */
+EXPORT size_t bmem_num_tags(void);
+EXPORT bool bmem_get_tag_stats(size_t idx, struct bmem_tag_stats *stats);
+EXPORT void bmem_log_tag_stats(void);
+
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
 static inline void *bzalloc(size_t size)
@@ -158,11 +158,12 @@ void os_cpu_usage_info_destroy(os_cpu_usage_info_t *info)
 
 #endif
 
-bool os_sleepto_ns(uint64_t time_target)
+static void sleep_until(uint64_t time_target)
 {
+#if defined(__APPLE__)
 	uint64_t current = os_gettime_ns();
-	if (time_target < current)
-		return false;
+	if (time_target <= current)
+		return;
 
 	time_target -= current;
 
@@ -176,6 +177,40 @@ bool os_sleepto_ns(uint64_t time_target)
 		req = remain;
 		memset(&remain, 0, sizeof(remain));
 	}
+#else
+	/* sleeping to an absolute deadline doesn't accumulate the error of
+	 * getting preempted between reading the clock and going to sleep */
+	struct timespec ts;
+	ts.tv_sec = (time_t)(time_target / 1000000000);
+	ts.tv_nsec = (long)(time_target % 1000000000);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
+#endif
+}
+
+bool os_sleepto_ns(uint64_t time_target)
+{
+	uint64_t current = os_gettime_ns();
+	if (time_target < current)
+		return false;
+
+	sleep_until(time_target);
+	return true;
+}
+
+bool os_sleepto_ns_spin(uint64_t time_target, uint64_t spin_ns)
+{
+	uint64_t current = os_gettime_ns();
+	if (time_target < current)
+		return false;
+
+	if (time_target - current > spin_ns)
+		sleep_until(time_target - spin_ns);
+
+	while (os_gettime_ns() < time_target)
+		;
 
 	return true;
 }
@@ -360,6 +360,19 @@ bool os_sleepto_ns(uint64_t time_target)
 	return stall;
 }
 
+bool os_sleepto_ns_spin(uint64_t time_target, uint64_t spin_ns)
+{
+	uint64_t current = os_gettime_ns();
+	if (time_target < current)
+		return false;
+
+	/* os_sleepto_ns already spins for the last partial millisecond */
+	if (time_target - current > spin_ns)
+		os_sleepto_ns(time_target - spin_ns);
+	os_sleepto_ns(time_target);
+	return true;
+}
+
 void os_sleep_ms(uint32_t duration)
 {
 	/* windows 8+ appears to have decreased sleep precision */
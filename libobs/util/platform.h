@@ -103,6 +103,12 @@ EXPORT void os_end_high_performance(os_performance_token_t *);
  * Returns false if already at or past target time.
  */
 EXPORT bool os_sleepto_ns(uint64_t time_target);
+
+/**
+ * Same as os_sleepto_ns, but busy waits for the last spin_ns nanoseconds to
+ * wake up closer to the target time than the system timer allows.
+ */
+EXPORT bool os_sleepto_ns_spin(uint64_t time_target, uint64_t spin_ns);
 EXPORT void os_sleep_ms(uint32_t duration);
 
 EXPORT uint64_t os_gettime_ns(void);
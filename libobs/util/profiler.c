@@ -1,6 +1,7 @@
 #include <inttypes.h>
 #include "profiler.h"
 
+#include "arena.h"
 #include "darray.h"
 #include "dstr.h"
 #include "platform.h"
@@ -83,7 +84,7 @@ struct profile_root_entry {
 	pthread_mutex_t *mutex;
 	const char *name;
 	profile_entry *entry;
-	profile_call *prev_call;
+	uint64_t prev_start_time;
 };
 
 static inline uint64_t diff_ns_to_usec(uint64_t prev, uint64_t next)
@@ -229,18 +230,18 @@ static profile_entry *get_child(profile_entry *parent, const char *name)
 }
 
 static void merge_call(profile_entry *entry, profile_call *call,
-		       profile_call *prev_call)
+		       uint64_t prev_start_time)
 {
 	const size_t num = call->children.num;
 	for (size_t i = 0; i < num; i++) {
 		profile_call *child = &call->children.array[i];
-		merge_call(get_child(entry, child->name), child, NULL);
+		merge_call(get_child(entry, child->name), child, 0);
 	}
 
-	if (entry->expected_time_between_calls != 0 && prev_call) {
+	if (entry->expected_time_between_calls != 0 && prev_start_time) {
 		migrate_old_entries(&entry->times_between_calls, true);
-		uint64_t usec = diff_ns_to_usec(prev_call->start_time,
-						call->start_time);
+		uint64_t usec =
+			diff_ns_to_usec(prev_start_time, call->start_time);
 		add_hashmap_entry(&entry->times_between_calls, usec, 1);
 	}
 
@@ -263,6 +264,13 @@ static DARRAY(profile_root_entry) root_entries;
 static THREAD_LOCAL profile_call *thread_context = NULL;
 static THREAD_LOCAL bool thread_enabled = true;
 
+/* calls of the current root are allocated from the frame arena of the
+ * thread, or from an arena of their own on threads without one */
+#define CALL_ARENA_BLOCK_SIZE 4096
+
+static THREAD_LOCAL os_arena_t *call_arena = NULL;
+static THREAD_LOCAL bool call_arena_owned = false;
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
@@ -287,12 +295,23 @@ void profile_reenable_thread(void)
 	pthread_mutex_unlock(&root_mutex);
 }
 
+static void free_call_context(void)
+{
+	if (call_arena_owned)
+		os_arena_destroy(call_arena);
+
+	call_arena = NULL;
+	call_arena_owned = false;
+}
+
 static bool lock_root(void)
 {
 	pthread_mutex_lock(&root_mutex);
 	if (!enabled) {
 		pthread_mutex_unlock(&root_mutex);
 		thread_enabled = false;
+		thread_context = NULL;
+		free_call_context();
 		return false;
 	}
 
@@ -334,16 +353,51 @@ void profile_register_root(const char *name,
 	pthread_mutex_unlock(&root_mutex);
 }
 
-static void free_call_context(profile_call *context);
+static profile_call *new_root_call(const profile_call *new_call)
+{
+	profile_call *call;
+
+	call_arena = os_get_thread_frame_arena();
+	call_arena_owned = !call_arena;
+	if (call_arena_owned)
+		call_arena = os_arena_create(CALL_ARENA_BLOCK_SIZE);
+
+	call = os_arena_alloc(call_arena, sizeof(profile_call));
+	memcpy(call, new_call, sizeof(profile_call));
+	return call;
+}
+
+static profile_call *push_child_call(profile_call *parent,
+				     const profile_call *new_call)
+{
+	if (parent->children.num == parent->children.capacity) {
+		size_t capacity = parent->children.capacity
+					  ? parent->children.capacity * 2
+					  : 4;
+		profile_call *array = os_arena_alloc(
+			call_arena, capacity * sizeof(profile_call));
+
+		if (parent->children.num)
+			memcpy(array, parent->children.array,
+			       parent->children.num * sizeof(profile_call));
+
+		parent->children.array = array;
+		parent->children.capacity = capacity;
+	}
+
+	profile_call *call = &parent->children.array[parent->children.num++];
+	memcpy(call, new_call, sizeof(profile_call));
+	return call;
+}
 
 static void merge_context(profile_call *context)
 {
 	pthread_mutex_t *mutex = NULL;
 	profile_entry *entry = NULL;
-	profile_call *prev_call = NULL;
+	uint64_t prev_start_time = 0;
 
 	if (!lock_root()) {
-		free_call_context(context);
+		free_call_context();
 		return;
 	}
 
@@ -351,24 +405,299 @@ static void merge_context(profile_call *context)
 
 	mutex = r_entry->mutex;
 	entry = r_entry->entry;
-	prev_call = r_entry->prev_call;
+	prev_start_time = r_entry->prev_start_time;
 
-	r_entry->prev_call = context;
+	r_entry->prev_start_time = context->start_time;
 
 	pthread_mutex_lock(mutex);
 	pthread_mutex_unlock(&root_mutex);
 
-	merge_call(entry, context, prev_call);
+	merge_call(entry, context, prev_start_time);
 
 	pthread_mutex_unlock(mutex);
 
-	free_call_context(prev_call);
+	free_call_context();
+}
+
+/* ------------------------------------------------------------------------- */
+/* Trace recording */
+
+#define TRACE_EVENTS_PER_THREAD (1 << 15)
+
+enum trace_event_type {
+	TRACE_EVENT_BEGIN,
+	TRACE_EVENT_END,
+	TRACE_EVENT_COUNTER,
+};
+
+struct trace_event {
+	const char *name;
+	uint64_t time;
+	int64_t value;
+	enum trace_event_type type;
+};
+
+/* written only by the owning thread, the write position is published after
+ * the event so readers can tell which events weren't overwritten while they
+ * were copying them */
+struct trace_buffer {
+	volatile long generation;
+	volatile long head;
+	const char *thread_name;
+	size_t id;
+	bool exited;
+	struct trace_event events[TRACE_EVENTS_PER_THREAD];
+};
+
+static volatile bool trace_active = false;
+static volatile long trace_generation = 0;
+static uint64_t trace_start_ns = 0;
+static volatile uint64_t trace_end_ns = 0;
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct trace_buffer *) trace_buffers;
+static size_t trace_next_id = 0;
+
+/* only used for its destructor, which hands the buffer of an exiting thread
+ * back */
+static pthread_key_t trace_key;
+static bool trace_key_created = false;
+
+static THREAD_LOCAL struct trace_buffer *thread_trace = NULL;
+
+static inline void free_trace_buffer(struct trace_buffer *buf)
+{
+	da_erase_item(trace_buffers, &buf);
+	bfree(buf);
+}
+
+/* buffers of exited threads are kept until their events can no longer be
+ * dumped, which is when the next recording starts.  must be called with
+ * trace_mutex held. */
+static void free_exited_trace_buffers(void)
+{
+	long generation = os_atomic_load_long(&trace_generation);
+
+	for (size_t i = trace_buffers.num; i > 0; i--) {
+		struct trace_buffer *buf = trace_buffers.array[i - 1];
+
+		if (buf->exited && buf->generation != generation)
+			free_trace_buffer(buf);
+	}
+}
+
+static void trace_thread_exit(void *data)
+{
+	struct trace_buffer *buf = data;
+
+	pthread_mutex_lock(&trace_mutex);
+	if (trace_key_created) {
+		buf->exited = true;
+		if (os_atomic_load_long(&buf->head) == 0 ||
+		    buf->generation != os_atomic_load_long(&trace_generation))
+			free_trace_buffer(buf);
+	}
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+static struct trace_buffer *get_thread_trace(void)
+{
+	struct trace_buffer *buf = thread_trace;
+	long generation = os_atomic_load_long(&trace_generation);
+
+	if (!buf) {
+		buf = bzalloc(sizeof(struct trace_buffer));
+		buf->generation = generation;
+
+		pthread_mutex_lock(&trace_mutex);
+		if (!trace_key_created)
+			trace_key_created = pthread_key_create(
+						    &trace_key,
+						    trace_thread_exit) == 0;
+		if (trace_key_created)
+			pthread_setspecific(trace_key, buf);
+		buf->id = trace_next_id++;
+		da_push_back(trace_buffers, &buf);
+		pthread_mutex_unlock(&trace_mutex);
+
+		thread_trace = buf;
+
+	} else if (buf->generation != generation) {
+		buf->thread_name = NULL;
+		os_atomic_store_long(&buf->head, 0);
+		os_atomic_store_long(&buf->generation, generation);
+	}
+
+	return buf;
+}
+
+static void trace_event(enum trace_event_type type, const char *name,
+			uint64_t time, int64_t value, bool root)
+{
+	if (time > os_atomic_load_uint64(&trace_end_ns))
+		return;
+
+	struct trace_buffer *buf = get_thread_trace();
+	long head = buf->head;
+	struct trace_event *event =
+		&buf->events[head & (TRACE_EVENTS_PER_THREAD - 1)];
+
+	/* threads are named after the first profiler root they enter */
+	if (root && !buf->thread_name)
+		buf->thread_name = name;
+
+	event->name = name;
+	event->time = time;
+	event->value = value;
+	event->type = type;
+	os_atomic_store_long(&buf->head, head + 1);
+}
+
+void profiler_trace_start(uint32_t seconds)
+{
+	pthread_mutex_lock(&trace_mutex);
+	trace_start_ns = os_gettime_ns();
+	os_atomic_store_uint64(&trace_end_ns,
+			       seconds ? trace_start_ns +
+						 seconds * 1000000000ULL
+				       : UINT64_MAX);
+	os_atomic_inc_long(&trace_generation);
+	free_exited_trace_buffers();
+	os_atomic_set_bool(&trace_active, true);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	os_atomic_set_bool(&trace_active, false);
+}
+
+bool profiler_trace_active(void)
+{
+	return os_atomic_load_bool(&trace_active) &&
+	       os_gettime_ns() <= os_atomic_load_uint64(&trace_end_ns);
+}
+
+void profiler_trace_counter(const char *name, int64_t value)
+{
+	if (os_atomic_load_bool(&trace_active))
+		trace_event(TRACE_EVENT_COUNTER, name, os_gettime_ns(), value,
+			    false);
+}
+
+static void json_escape(struct dstr *str, const char *text)
+{
+	for (; *text; text++) {
+		unsigned char ch = (unsigned char)*text;
+
+		if (ch == '"' || ch == '\\')
+			dstr_catf(str, "\\%c", ch);
+		else if (ch < 0x20)
+			dstr_catf(str, "\\u%04x", ch);
+		else
+			dstr_cat_ch(str, (char)ch);
+	}
+}
+
+static void trace_dump_event(struct dstr *str, const struct trace_buffer *buf,
+			     const struct trace_event *event)
+{
+	static const char phases[] = {'B', 'E', 'C'};
+	uint64_t time = event->time - trace_start_ns;
+
+	dstr_catf(str, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%zu,"
+		       "\"ts\":%" PRIu64 ".%03" PRIu64,
+		  phases[event->type], buf->id, time / 1000, time % 1000);
+
+	if (event->type != TRACE_EVENT_END && event->name) {
+		dstr_cat(str, ",\"name\":\"");
+		json_escape(str, event->name);
+		dstr_cat(str, "\"");
+	}
+	if (event->type == TRACE_EVENT_COUNTER)
+		dstr_catf(str, ",\"args\":{\"value\":%" PRId64 "}",
+			  event->value);
+
+	dstr_cat(str, "}");
+}
+
+static void trace_dump_buffer(struct dstr *str, struct trace_buffer *buf,
+			      struct trace_event *copy)
+{
+	long generation = os_atomic_load_long(&trace_generation);
+	long start, first, last, head;
+
+	if (os_atomic_load_long(&buf->generation) != generation)
+		return;
+
+	last = os_atomic_load_long(&buf->head);
+	start = last > TRACE_EVENTS_PER_THREAD ? last - TRACE_EVENTS_PER_THREAD
+					       : 0;
+	for (long i = start; i < last; i++)
+		copy[i - start] = buf->events[i & (TRACE_EVENTS_PER_THREAD - 1)];
+
+	/* skip events the thread overwrote while they were being copied */
+	head = os_atomic_load_long(&buf->head);
+	if (os_atomic_load_long(&buf->generation) != generation || head < last)
+		return;
+
+	first = start;
+	if (head - first >= TRACE_EVENTS_PER_THREAD)
+		first = head - TRACE_EVENTS_PER_THREAD + 1;
+
+	if (buf->thread_name) {
+		dstr_catf(str,
+			  ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%zu,"
+			  "\"name\":\"thread_name\",\"args\":{\"name\":\"",
+			  buf->id);
+		json_escape(str, buf->thread_name);
+		dstr_cat(str, "\"}}");
+	}
+
+	for (long i = first; i < last; i++)
+		trace_dump_event(str, buf, &copy[i - start]);
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	struct trace_event *copy;
+	struct dstr str = {0};
+	bool success;
+	FILE *f;
+
+	copy = bmalloc(sizeof(struct trace_event) * TRACE_EVENTS_PER_THREAD);
+	dstr_copy(&str, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+			"{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+			"\"args\":{\"name\":\"libobs\"}}");
+
+	pthread_mutex_lock(&trace_mutex);
+	for (size_t i = 0; i < trace_buffers.num; i++)
+		trace_dump_buffer(&str, trace_buffers.array[i], copy);
+	pthread_mutex_unlock(&trace_mutex);
+
+	dstr_cat(&str, "\n]}\n");
+	bfree(copy);
+
+	f = os_fopen(filename, "wb");
+	success = !!f;
+	if (f) {
+		success = fwrite(str.array, 1, str.len, f) == str.len;
+		fclose(f);
+	}
+
+	dstr_free(&str);
+	return success;
 }
 
 void profile_start(const char *name)
 {
-	if (!thread_enabled)
+	bool trace = os_atomic_load_bool(&trace_active);
+
+	if (!thread_enabled) {
+		if (trace)
+			trace_event(TRACE_EVENT_BEGIN, name, os_gettime_ns(), 0,
+				    !thread_context);
 		return;
+	}
 
 	profile_call new_call = {
 		.name = name,
@@ -380,21 +709,26 @@ void profile_start(const char *name)
 
 	profile_call *call = NULL;
 
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
-	}
+	if (new_call.parent)
+		call = push_child_call(new_call.parent, &new_call);
+	else
+		call = new_root_call(&new_call);
 
 	thread_context = call;
 	call->start_time = os_gettime_ns();
+
+	if (trace)
+		trace_event(TRACE_EVENT_BEGIN, name, call->start_time, 0,
+			    !call->parent);
 }
 
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
+
+	if (os_atomic_load_bool(&trace_active))
+		trace_event(TRACE_EVENT_END, name, end, 0, false);
+
 	if (!thread_enabled)
 		return;
 
@@ -759,24 +1093,6 @@ void profiler_print_time_between_calls(profiler_snapshot_t *snap)
 			   profile_print_entry_expected, snap);
 }
 
-static void free_call_children(profile_call *call)
-{
-	if (!call)
-		return;
-
-	const size_t num = call->children.num;
-	for (size_t i = 0; i < num; i++)
-		free_call_children(&call->children.array[i]);
-
-	da_free(call->children);
-}
-
-static void free_call_context(profile_call *context)
-{
-	free_call_children(context);
-	bfree(context);
-}
-
 static void free_hashmap(profile_times_table *map)
 {
 	map->size = 0;
@@ -818,8 +1134,6 @@ void profiler_free(void)
 		bfree(entry->mutex);
 		entry->mutex = NULL;
 
-		free_call_context(entry->prev_call);
-
 		free_profile_entry(entry->entry);
 		bfree(entry->entry);
 	}
@@ -827,6 +1141,17 @@ void profiler_free(void)
 	da_free(old_root_entries);
 
 	pthread_mutex_destroy(&root_mutex);
+
+	os_atomic_set_bool(&trace_active, false);
+	pthread_mutex_lock(&trace_mutex);
+	if (trace_key_created) {
+		pthread_key_delete(trace_key);
+		trace_key_created = false;
+	}
+	for (size_t i = 0; i < trace_buffers.num; i++)
+		bfree(trace_buffers.array[i]);
+	da_free(trace_buffers);
+	pthread_mutex_unlock(&trace_mutex);
 }
 
 /* ------------------------------------------------------------------------- */
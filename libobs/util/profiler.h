@@ -33,6 +33,26 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Trace recording
+ *
+ *   Records every profile_start/profile_end and trace counter with its
+ * timestamp into a per-thread ring buffer, independently of the aggregated
+ * profiler.  Only the most recent events of each thread are kept if a
+ * thread records more than its buffer holds.  Names must stay valid until
+ * the trace has been dumped. */
+
+/* records for the given number of seconds, 0 records until stopped */
+EXPORT void profiler_trace_start(uint32_t seconds);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_active(void);
+
+EXPORT void profiler_trace_counter(const char *name, int64_t value);
+
+/* writes the last recording in the Chrome trace event format, which can be
+ * opened in chrome://tracing and Perfetto */
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "thread-pool.h"
+#include "threading.h"
+#include "circlebuf.h"
+#include "platform.h"
+#include "bmem.h"
+#include "base.h"
+
+struct pool_task {
+	os_task_t task;
+	void *param;
+	struct os_task_group *group;
+	enum os_task_priority priority;
+};
+
+struct pool_worker {
+	struct os_thread_pool *pool;
+	size_t index;
+	uint64_t affinity;
+
+	pthread_t thread;
+	bool thread_created;
+
+	/* set while the worker waits for its event to be signalled */
+	volatile bool sleeping;
+	os_event_t *event;
+
+	pthread_mutex_t mutex;
+	struct circlebuf queues[OS_TASK_PRIORITY_COUNT];
+	struct os_thread_pool_stats stats;
+	uint64_t start_ns;
+
+	/* tasks run by tasks waiting on a group, only used by the worker */
+	size_t depth;
+};
+
+struct os_thread_pool {
+	char *name;
+	struct pool_worker *workers;
+	size_t num_workers;
+	long background_limit;
+
+	/* queued tasks per priority, can briefly go negative when a task is
+	 * taken before its submitter counted it */
+	volatile long pending[OS_TASK_PRIORITY_COUNT];
+	volatile long background_running;
+	volatile long next_worker;
+	volatile bool stop;
+};
+
+struct os_task_group {
+	volatile long remaining;
+	pthread_mutex_t mutex;
+	os_event_t *event;
+};
+
+static THREAD_LOCAL struct pool_worker *current_worker = NULL;
+
+static inline struct pool_worker *get_worker(const os_thread_pool_t *pool)
+{
+	return current_worker && current_worker->pool == pool ? current_worker
+							       : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool acquire_background(struct os_thread_pool *pool)
+{
+	long cur = os_atomic_load_long(&pool->background_running);
+
+	while (cur < pool->background_limit) {
+		if (os_atomic_compare_exchange_long(&pool->background_running,
+						    &cur, cur + 1))
+			return true;
+	}
+
+	return false;
+}
+
+static bool has_runnable_tasks(struct os_thread_pool *pool)
+{
+	if (os_atomic_load_long(&pool->pending[OS_TASK_PRIORITY_REALTIME]) > 0)
+		return true;
+	if (os_atomic_load_long(&pool->pending[OS_TASK_PRIORITY_NORMAL]) > 0)
+		return true;
+
+	return os_atomic_load_long(
+		       &pool->pending[OS_TASK_PRIORITY_BACKGROUND]) > 0 &&
+	       os_atomic_load_long(&pool->background_running) <
+		       pool->background_limit;
+}
+
+/* wakers always update the counters checked by has_runnable_tasks before
+ * looking for a sleeping worker, and workers always mark themselves as
+ * sleeping before checking those counters, so a wakeup can't be missed */
+static void wake_worker(struct os_thread_pool *pool)
+{
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		if (os_atomic_load_bool(&worker->sleeping) &&
+		    os_atomic_set_bool(&worker->sleeping, false)) {
+			os_event_signal(worker->event);
+			break;
+		}
+	}
+}
+
+static bool pop_task(struct pool_worker *worker, size_t priority, bool steal,
+		     struct pool_task *task)
+{
+	struct circlebuf *queue = &worker->queues[priority];
+	bool success = false;
+
+	pthread_mutex_lock(&worker->mutex);
+	if (queue->size) {
+		if (steal)
+			circlebuf_pop_front(queue, task, sizeof(*task));
+		else
+			circlebuf_pop_back(queue, task, sizeof(*task));
+		success = true;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+
+	return success;
+}
+
+static bool take_task(struct os_thread_pool *pool, struct pool_worker *self,
+		      bool allow_background, struct pool_task *task,
+		      bool *stolen)
+{
+	size_t start = self ? self->index : 0;
+
+	for (size_t priority = 0; priority < OS_TASK_PRIORITY_COUNT;
+	     priority++) {
+		bool background = priority == OS_TASK_PRIORITY_BACKGROUND;
+
+		if (os_atomic_load_long(&pool->pending[priority]) <= 0)
+			continue;
+		if (background &&
+		    (!allow_background || !acquire_background(pool)))
+			continue;
+
+		for (size_t i = 0; i < pool->num_workers; i++) {
+			size_t idx = (start + i) % pool->num_workers;
+			struct pool_worker *worker = &pool->workers[idx];
+
+			if (pop_task(worker, priority, worker != self, task)) {
+				os_atomic_dec_long(&pool->pending[priority]);
+				*stolen = worker != self;
+				return true;
+			}
+		}
+
+		if (background)
+			os_atomic_dec_long(&pool->background_running);
+	}
+
+	return false;
+}
+
+static void finish_group_task(struct os_task_group *group)
+{
+	pthread_mutex_lock(&group->mutex);
+	if (os_atomic_dec_long(&group->remaining) == 0)
+		os_event_signal(group->event);
+	pthread_mutex_unlock(&group->mutex);
+}
+
+static void run_task(struct os_thread_pool *pool, struct pool_worker *self,
+		     struct pool_task *task, bool stolen)
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t end;
+
+	if (self)
+		self->depth++;
+	task->task(task->param);
+	if (self)
+		self->depth--;
+	end = os_gettime_ns();
+
+	if (task->priority == OS_TASK_PRIORITY_BACKGROUND) {
+		os_atomic_dec_long(&pool->background_running);
+		if (os_atomic_load_long(
+			    &pool->pending[OS_TASK_PRIORITY_BACKGROUND]) > 0)
+			wake_worker(pool);
+	}
+
+	if (self) {
+		pthread_mutex_lock(&self->mutex);
+		self->stats.tasks++;
+		if (!self->depth)
+			self->stats.busy_ns += end - start;
+		if (stolen)
+			self->stats.steals++;
+		pthread_mutex_unlock(&self->mutex);
+	}
+
+	if (task->group)
+		finish_group_task(task->group);
+}
+
+static void *worker_thread(void *data)
+{
+	struct pool_worker *self = data;
+	struct os_thread_pool *pool = self->pool;
+
+	current_worker = self;
+	os_set_thread_name(pool->name);
+
+	if (self->affinity && !os_set_thread_affinity(self->affinity))
+		blog(LOG_WARNING, "%s: Failed to set affinity of worker %d",
+		     pool->name, (int)self->index);
+
+	for (;;) {
+		struct pool_task task;
+		bool stolen;
+
+		if (take_task(pool, self, true, &task, &stolen)) {
+			run_task(pool, self, &task, stolen);
+			continue;
+		}
+
+		os_atomic_set_bool(&self->sleeping, true);
+
+		if (has_runnable_tasks(pool)) {
+			os_atomic_set_bool(&self->sleeping, false);
+			continue;
+		}
+		if (os_atomic_load_bool(&pool->stop))
+			break;
+
+		os_event_wait(self->event);
+		os_atomic_set_bool(&self->sleeping, false);
+	}
+
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint64_t get_worker_affinity(const struct os_thread_pool_info *info,
+				    size_t index)
+{
+	uint64_t mask = info->affinity_mask;
+	size_t cores = 0;
+
+	if (!info->pin_threads)
+		return mask;
+
+	if (!mask) {
+		int logical = os_get_logical_cores();
+		if (logical <= 0)
+			return 0;
+
+		mask = logical >= 64 ? ~0ULL : (1ULL << logical) - 1;
+	}
+
+	for (size_t i = 0; i < 64; i++) {
+		if (mask & (1ULL << i))
+			cores++;
+	}
+
+	index %= cores;
+
+	for (size_t i = 0; i < 64; i++) {
+		if ((mask & (1ULL << i)) && index-- == 0)
+			return 1ULL << i;
+	}
+
+	return 0;
+}
+
+os_thread_pool_t *os_thread_pool_create(const struct os_thread_pool_info *info)
+{
+	struct os_thread_pool_info defaults = {0};
+	struct os_thread_pool *pool;
+	size_t threads;
+
+	if (!info)
+		info = &defaults;
+
+	threads = info->threads;
+	if (!threads) {
+		int logical = os_get_logical_cores();
+		threads = logical > 0 ? (size_t)logical : 1;
+	}
+
+	pool = bzalloc(sizeof(*pool));
+	pool->name = bstrdup(info->name ? info->name : "thread pool");
+	pool->num_workers = threads;
+	pool->workers = bzalloc(sizeof(struct pool_worker) * threads);
+
+	if (info->background_threads)
+		pool->background_limit = (long)info->background_threads;
+	else
+		pool->background_limit = threads > 1 ? (long)threads - 1 : 1;
+
+	for (size_t i = 0; i < threads; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		worker->pool = pool;
+		worker->index = i;
+		worker->affinity = get_worker_affinity(info, i);
+		worker->start_ns = os_gettime_ns();
+
+		if (pthread_mutex_init(&worker->mutex, NULL) != 0)
+			goto fail;
+		if (os_event_init(&worker->event, OS_EVENT_TYPE_AUTO) != 0) {
+			pthread_mutex_destroy(&worker->mutex);
+			worker->event = NULL;
+			goto fail;
+		}
+	}
+
+	for (size_t i = 0; i < threads; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		if (pthread_create(&worker->thread, NULL, worker_thread,
+				   worker) != 0)
+			goto fail;
+		worker->thread_created = true;
+	}
+
+	return pool;
+
+fail:
+	blog(LOG_ERROR, "%s: Failed to create thread pool", pool->name);
+	os_thread_pool_destroy(pool);
+	return NULL;
+}
+
+void os_thread_pool_destroy(os_thread_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	os_atomic_set_bool(&pool->stop, true);
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		if (worker->event) {
+			os_atomic_set_bool(&worker->sleeping, false);
+			os_event_signal(worker->event);
+		}
+	}
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		if (worker->thread_created)
+			pthread_join(worker->thread, NULL);
+	}
+
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct pool_worker *worker = &pool->workers[i];
+
+		for (size_t j = 0; j < OS_TASK_PRIORITY_COUNT; j++)
+			circlebuf_free(&worker->queues[j]);
+		if (worker->event) {
+			os_event_destroy(worker->event);
+			pthread_mutex_destroy(&worker->mutex);
+		}
+	}
+
+	bfree(pool->workers);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_thread_pool_num_threads(const os_thread_pool_t *pool)
+{
+	return pool ? pool->num_workers : 0;
+}
+
+bool os_thread_pool_inside(const os_thread_pool_t *pool)
+{
+	return pool && get_worker(pool) != NULL;
+}
+
+bool os_thread_pool_submit(os_thread_pool_t *pool,
+			   enum os_task_priority priority, os_task_t task,
+			   void *param, os_task_group_t *group)
+{
+	struct pool_task info = {task, param, group, priority};
+	struct pool_worker *worker;
+
+	if (!pool || !task)
+		return false;
+	if ((size_t)priority >= OS_TASK_PRIORITY_COUNT)
+		return false;
+
+	/* keep tasks spawned by a task local to its worker */
+	worker = get_worker(pool);
+	if (!worker) {
+		unsigned long idx =
+			(unsigned long)os_atomic_inc_long(&pool->next_worker);
+		worker = &pool->workers[idx % pool->num_workers];
+	}
+
+	if (group)
+		os_atomic_inc_long(&group->remaining);
+
+	pthread_mutex_lock(&worker->mutex);
+	circlebuf_push_back(&worker->queues[priority], &info, sizeof(info));
+	pthread_mutex_unlock(&worker->mutex);
+
+	os_atomic_inc_long(&pool->pending[priority]);
+	wake_worker(pool);
+	return true;
+}
+
+bool os_thread_pool_get_stats(os_thread_pool_t *pool, size_t idx,
+			      struct os_thread_pool_stats *stats)
+{
+	struct pool_worker *worker;
+
+	if (!pool || !stats || idx >= pool->num_workers)
+		return false;
+
+	worker = &pool->workers[idx];
+
+	pthread_mutex_lock(&worker->mutex);
+	*stats = worker->stats;
+	stats->total_ns = os_gettime_ns() - worker->start_ns;
+	pthread_mutex_unlock(&worker->mutex);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+os_task_group_t *os_task_group_create(void)
+{
+	struct os_task_group *group = bzalloc(sizeof(*group));
+
+	if (pthread_mutex_init(&group->mutex, NULL) != 0)
+		goto fail1;
+	if (os_event_init(&group->event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail2;
+
+	return group;
+
+fail2:
+	pthread_mutex_destroy(&group->mutex);
+fail1:
+	bfree(group);
+	return NULL;
+}
+
+void os_task_group_destroy(os_task_group_t *group)
+{
+	if (!group)
+		return;
+
+	/* the last task may still be signalling the group */
+	pthread_mutex_lock(&group->mutex);
+	pthread_mutex_unlock(&group->mutex);
+
+	os_event_destroy(group->event);
+	pthread_mutex_destroy(&group->mutex);
+	bfree(group);
+}
+
+bool os_task_group_done(const os_task_group_t *group)
+{
+	return !group || os_atomic_load_long(&group->remaining) <= 0;
+}
+
+void os_task_group_wait(os_thread_pool_t *pool, os_task_group_t *group)
+{
+	struct pool_worker *self = get_worker(pool);
+
+	if (!group)
+		return;
+
+	while (os_atomic_load_long(&group->remaining) > 0) {
+		struct pool_task task;
+		bool stolen;
+
+		/* threads outside the pool only help with tasks that are
+		 * expected to be short */
+		if (pool && take_task(pool, self, self != NULL, &task, &stolen)) {
+			run_task(pool, self, &task, stolen);
+			continue;
+		}
+
+		/* a waiting worker can still be handed new tasks from outside
+		 * the pool, so check back periodically */
+		if (self)
+			os_event_timedwait(group->event, 1);
+		else
+			os_event_wait(group->event);
+	}
+}
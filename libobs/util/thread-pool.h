@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+#include "task.h"
+
+/*
+ * Work stealing thread pool
+ *
+ *   Each worker owns a queue per priority.  Tasks submitted from a worker go
+ * to that worker's own queue and are run newest first, idle workers steal
+ * the oldest tasks from the others.  Tasks submitted from other threads are
+ * spread over the workers.
+ *
+ *   Background tasks are never allowed to occupy every worker, so real-time
+ * and normal tasks always have a worker available to them.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_thread_pool;
+struct os_task_group;
+typedef struct os_thread_pool os_thread_pool_t;
+typedef struct os_task_group os_task_group_t;
+
+enum os_task_priority {
+	OS_TASK_PRIORITY_REALTIME,
+	OS_TASK_PRIORITY_NORMAL,
+	OS_TASK_PRIORITY_BACKGROUND,
+};
+
+#define OS_TASK_PRIORITY_COUNT 3
+
+struct os_thread_pool_info {
+	/* worker thread name, defaults to "thread pool" */
+	const char *name;
+
+	/* number of workers, 0 for one per logical core */
+	size_t threads;
+
+	/* maximum number of workers running background tasks at the same
+	 * time, 0 for all but one worker */
+	size_t background_threads;
+
+	/* logical cores the workers may run on, 0 for any */
+	uint64_t affinity_mask;
+
+	/* pin each worker to a single logical core of the affinity mask */
+	bool pin_threads;
+};
+
+struct os_thread_pool_stats {
+	uint64_t tasks;
+	uint64_t steals;
+	uint64_t busy_ns;
+	uint64_t total_ns;
+};
+
+EXPORT os_thread_pool_t *
+os_thread_pool_create(const struct os_thread_pool_info *info);
+
+/* runs all remaining tasks before returning */
+EXPORT void os_thread_pool_destroy(os_thread_pool_t *pool);
+
+EXPORT size_t os_thread_pool_num_threads(const os_thread_pool_t *pool);
+
+/* returns whether the calling thread is one of the pool's workers */
+EXPORT bool os_thread_pool_inside(const os_thread_pool_t *pool);
+
+/* group is optional, and must not be destroyed before its tasks finished */
+EXPORT bool os_thread_pool_submit(os_thread_pool_t *pool,
+				  enum os_task_priority priority,
+				  os_task_t task, void *param,
+				  os_task_group_t *group);
+
+/* utilization of a worker is busy_ns / total_ns */
+EXPORT bool os_thread_pool_get_stats(os_thread_pool_t *pool, size_t worker,
+				     struct os_thread_pool_stats *stats);
+
+EXPORT os_task_group_t *os_task_group_create(void);
+EXPORT void os_task_group_destroy(os_task_group_t *group);
+
+/* returns whether all tasks of the group have finished */
+EXPORT bool os_task_group_done(const os_task_group_t *group);
+
+/* waits for all tasks of the group to finish, running queued tasks of the
+ * pool on the calling thread in the meantime.  tasks may wait on other
+ * groups from inside the pool.  only one thread may wait on a group. */
+EXPORT void os_task_group_wait(os_thread_pool_t *pool, os_task_group_t *group);
+
+#ifdef __cplusplus
+}
+#endif
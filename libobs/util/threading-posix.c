@@ -26,6 +26,8 @@
 #include <semaphore.h>
 #endif
 
+#include <sched.h>
+
 #if defined(__FreeBSD__)
 #include <pthread_np.h>
 #endif
@@ -271,3 +273,38 @@ void os_set_thread_name(const char *name)
 	}
 #endif
 }
+
+bool os_set_thread_affinity(uint64_t cpu_mask)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	for (int i = 0; i < 64; i++) {
+		if (cpu_mask & (1ULL << i))
+			CPU_SET(i, &set);
+	}
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	UNUSED_PARAMETER(cpu_mask);
+	return false;
+#endif
+}
+
+bool os_set_thread_realtime(bool realtime)
+{
+	struct sched_param param = {0};
+	int policy = SCHED_OTHER;
+
+	if (realtime) {
+		int min = sched_get_priority_min(SCHED_RR);
+		int max = sched_get_priority_max(SCHED_RR);
+
+		/* leave room above for system audio and interrupt threads */
+		policy = SCHED_RR;
+		param.sched_priority = min + (max - min) / 4;
+	}
+
+	return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+}
@@ -214,3 +214,16 @@ void os_set_thread_name(const char *name)
 		FreeLibrary(hModule);
 	}
 }
+
+bool os_set_thread_affinity(uint64_t cpu_mask)
+{
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)cpu_mask) !=
+	       0;
+}
+
+bool os_set_thread_realtime(bool realtime)
+{
+	int priority = realtime ? THREAD_PRIORITY_TIME_CRITICAL
+				: THREAD_PRIORITY_NORMAL;
+	return !!SetThreadPriority(GetCurrentThread(), priority);
+}
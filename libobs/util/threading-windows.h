@@ -144,3 +144,22 @@ static inline bool os_atomic_load_bool(const volatile bool *ptr)
 
 	return b;
 }
+
+/* 32-bit x86 has no plain 64-bit atomic load/store, go through a
+ * compare-exchange there as well */
+static inline void os_atomic_store_uint64(volatile uint64_t *ptr, uint64_t val)
+{
+	volatile __int64 *p = (volatile __int64 *)ptr;
+	__int64 old_val = *p;
+	__int64 previous;
+
+	while ((previous = _InterlockedCompareExchange64(p, (__int64)val,
+							 old_val)) != old_val)
+		old_val = previous;
+}
+
+static inline uint64_t os_atomic_load_uint64(const volatile uint64_t *ptr)
+{
+	return (uint64_t)_InterlockedCompareExchange64(
+		(volatile __int64 *)ptr, 0, 0);
+}
@@ -94,6 +94,14 @@ EXPORT int os_sem_wait(os_sem_t *sem);
 
 EXPORT void os_set_thread_name(const char *name);
 
+/* restricts the calling thread to the logical cores set in the mask, returns
+ * false if that is not supported on this platform */
+EXPORT bool os_set_thread_affinity(uint64_t cpu_mask);
+
+/* switches the calling thread to or from real-time (round robin) scheduling,
+ * which usually requires elevated privileges.  returns false on failure. */
+EXPORT bool os_set_thread_realtime(bool realtime);
+
 #ifdef _MSC_VER
 #define THREAD_LOCAL __declspec(thread)
 #else
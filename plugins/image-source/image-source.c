@@ -50,12 +50,15 @@ static void image_source_load(struct image_source *context)
 	obs_leave_graphics();
 
 	if (file && *file) {
+		const char *prev_tag = bmem_set_thread_tag("image sources");
+
 		debug("loading texture '%s'", file);
 		context->file_timestamp = get_modified_timestamp(file);
 		gs_image_file3_init(&context->if3, file,
 				    context->linear_alpha
 					    ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
 					    : GS_IMAGE_ALPHA_PREMULTIPLY);
+		bmem_set_thread_tag(prev_tag);
 		context->update_time_elapsed = 0;
 
 		obs_enter_graphics();
@@ -326,7 +329,8 @@ static obs_missing_files_t *image_source_missingfiles(void *data)
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB |
+			OBS_SOURCE_THREADSAFE_CREATE,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
@@ -0,0 +1,430 @@
+#include <math.h>
+#include <string.h>
+
+#include <util/bmem.h>
+#include <util/sse-intrin.h>
+
+#include "audio-dynamics.h"
+
+/* -------------------------------------------------------- */
+
+#define DB_PER_LN 8.68588963806503655302f  /* 20 / ln(10) */
+#define LN_PER_DB 0.115129254649702284201f /* ln(10) / 20 */
+
+/* Natural logarithm of four positive floats (Cephes single precision
+ * approximation, ~1 ulp).  Zero and denormals are clamped to the smallest
+ * normal float, which yields about -87.3. */
+static inline __m128 log_ps(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i emm0;
+	__m128 e, mask, tmp, y, z;
+
+	x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+
+	emm0 = _mm_srli_epi32(_mm_castps_si128(x), 23);
+	x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000)));
+	x = _mm_or_ps(x, _mm_set1_ps(0.5f));
+
+	emm0 = _mm_sub_epi32(emm0, _mm_set1_epi32(0x7f));
+	e = _mm_add_ps(_mm_cvtepi32_ps(emm0), one);
+
+	mask = _mm_cmplt_ps(x, _mm_set1_ps(0.707106781186547524f));
+	tmp = _mm_and_ps(x, mask);
+	x = _mm_sub_ps(x, one);
+	e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+	x = _mm_add_ps(x, tmp);
+
+	z = _mm_mul_ps(x, x);
+
+	y = _mm_set1_ps(7.0376836292E-2f);
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.1514610310E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.1676998740E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.2420140846E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.4249322787E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.6668057665E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(2.0000714765E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-2.4999993993E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(3.3333331174E-1f));
+	y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+
+	x = _mm_add_ps(x, y);
+	return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+/* e^x for four floats (Cephes single precision approximation, ~1 ulp),
+ * with the input clamped to the normal float range. */
+static inline __m128 exp_ps(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i emm0;
+	__m128 fx, tmp, mask, y, z;
+
+	x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+	x = _mm_max_ps(x, _mm_set1_ps(-87.3365447504f));
+
+	/* fx = floor(x / ln(2) + 0.5) */
+	fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)),
+			_mm_set1_ps(0.5f));
+	tmp = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+	mask = _mm_and_ps(_mm_cmpgt_ps(tmp, fx), one);
+	fx = _mm_sub_ps(tmp, mask);
+
+	x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+	z = _mm_mul_ps(x, x);
+
+	y = _mm_set1_ps(1.9875691500E-4f);
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507E-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073E-3f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894E-2f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, z), x);
+	y = _mm_add_ps(y, one);
+
+	emm0 = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(0x7f));
+	emm0 = _mm_slli_epi32(emm0, 23);
+	return _mm_mul_ps(y, _mm_castsi128_ps(emm0));
+}
+
+/* Loads/stores up to four floats, padding partial vectors with zeros so the
+ * end of a buffer goes through the same math as the rest of it. */
+static inline __m128 load_ps(const float *src, uint32_t count)
+{
+	float tmp[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+	if (count >= 4)
+		return _mm_loadu_ps(src);
+
+	memcpy(tmp, src, count * sizeof(float));
+	return _mm_loadu_ps(tmp);
+}
+
+static inline void store_ps(float *dst, __m128 v, uint32_t count)
+{
+	float tmp[4];
+
+	if (count >= 4) {
+		_mm_storeu_ps(dst, v);
+		return;
+	}
+
+	_mm_storeu_ps(tmp, v);
+	memcpy(dst, tmp, count * sizeof(float));
+}
+
+/* -------------------------------------------------------- */
+
+static inline float follow(float env, float env_in, float attack_gain,
+			   float release_gain)
+{
+	/* branchless form of the usual attack/release selection */
+	const float coef = env < env_in ? attack_gain : release_gain;
+	return env_in + coef * (env - env_in);
+}
+
+void dyn_peak_envelope(float *env_buf, float *const *samples, size_t channels,
+		       uint32_t frames, float *envelope, float attack_gain,
+		       float release_gain)
+{
+	if (!frames)
+		return;
+
+	memset(env_buf, 0, frames * sizeof(env_buf[0]));
+
+	for (size_t chan = 0; chan < channels; ++chan) {
+		const float *in = samples[chan];
+		float env = *envelope;
+
+		if (!in)
+			continue;
+
+		for (uint32_t i = 0; i < frames; ++i) {
+			env = follow(env, fabsf(in[i]), attack_gain,
+				     release_gain);
+			env_buf[i] = fmaxf(env_buf[i], env);
+		}
+	}
+
+	*envelope = env_buf[frames - 1];
+}
+
+void dyn_follow_envelope(float *env_buf, const float *detector,
+			 uint32_t frames, float *envelope, float attack_gain,
+			 float release_gain)
+{
+	float env = *envelope;
+
+	for (uint32_t i = 0; i < frames; ++i) {
+		env = follow(env, detector[i], attack_gain, release_gain);
+		env_buf[i] = env;
+	}
+
+	*envelope = env;
+}
+
+void dyn_compressor_gain(float *gain, const float *env, uint32_t frames,
+			 float threshold, float slope, float output_gain)
+{
+	const __m128 thr = _mm_set1_ps(threshold);
+	const __m128 slp = _mm_set1_ps(slope);
+	const __m128 out = _mm_set1_ps(output_gain);
+	const __m128 db_per_ln = _mm_set1_ps(DB_PER_LN);
+	const __m128 ln_per_db = _mm_set1_ps(LN_PER_DB);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < frames; i += 4) {
+		const uint32_t count = frames - i;
+		__m128 env_db = _mm_mul_ps(log_ps(load_ps(&env[i], count)),
+					   db_per_ln);
+		__m128 g = _mm_mul_ps(slp, _mm_sub_ps(thr, env_db));
+
+		g = exp_ps(_mm_mul_ps(_mm_min_ps(zero, g), ln_per_db));
+		store_ps(&gain[i], _mm_mul_ps(g, out), count);
+	}
+}
+
+void dyn_mul_to_db(float *dst, const float *src, uint32_t frames)
+{
+	const __m128 db_per_ln = _mm_set1_ps(DB_PER_LN);
+
+	for (uint32_t i = 0; i < frames; i += 4) {
+		const uint32_t count = frames - i;
+		__m128 v = log_ps(load_ps(&src[i], count));
+
+		store_ps(&dst[i], _mm_mul_ps(v, db_per_ln), count);
+	}
+}
+
+void dyn_db_to_gain(float *dst, const float *src, uint32_t frames,
+		    float output_gain)
+{
+	const __m128 ln_per_db = _mm_set1_ps(LN_PER_DB);
+	const __m128 out = _mm_set1_ps(output_gain);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < frames; i += 4) {
+		const uint32_t count = frames - i;
+		__m128 v = _mm_min_ps(zero, load_ps(&src[i], count));
+
+		v = exp_ps(_mm_mul_ps(v, ln_per_db));
+		store_ps(&dst[i], _mm_mul_ps(v, out), count);
+	}
+}
+
+void dyn_apply_gain(float *const *samples, size_t channels, const float *gain,
+		    uint32_t frames)
+{
+	for (size_t c = 0; c < channels; c++) {
+		float *data = samples[c];
+		uint32_t i = 0;
+
+		if (!data)
+			continue;
+
+		for (; i + 4 <= frames; i += 4) {
+			__m128 v = _mm_loadu_ps(&data[i]);
+			v = _mm_mul_ps(v, _mm_loadu_ps(&gain[i]));
+			_mm_storeu_ps(&data[i], v);
+		}
+		for (; i < frames; i++)
+			data[i] *= gain[i];
+	}
+}
+
+/* -------------------------------------------------------- */
+
+#define abs_ps(v) _mm_andnot_ps(_mm_set1_ps(-0.f), v)
+
+void dyn_detector_free(struct dyn_detector *det)
+{
+	bfree(det->scratch);
+	det->scratch = NULL;
+	det->scratch_len = 0;
+}
+
+void dyn_detector_reset(struct dyn_detector *det)
+{
+	memset(det->history, 0, sizeof(det->history));
+}
+
+/* Interpolates four points between x[i - 2] and x[i - 1] using the
+ * normalized-sinc kernel of the volume meter's true peak measurement.
+ * ext points at the channel data preceded by three samples of history. */
+static inline __m128 true_peak_ps(const float *ext, uint32_t i)
+{
+	/* kernel[k][t]: weight of tap t (x[i - 3 + t]) for oversample k */
+	static const float kernel[4][4] = {
+		{-0.103943f, 0.233872f, 0.935489f, -0.155915f},
+		{-0.189207f, 0.504551f, 0.756827f, -0.216236f},
+		{-0.216236f, 0.756827f, 0.504551f, -0.189207f},
+		{-0.155915f, 0.935489f, 0.233872f, -0.103943f},
+	};
+
+	const __m128 x0 = _mm_loadu_ps(&ext[i]);
+	const __m128 x1 = _mm_loadu_ps(&ext[i + 1]);
+	const __m128 x2 = _mm_loadu_ps(&ext[i + 2]);
+	const __m128 x3 = _mm_loadu_ps(&ext[i + 3]);
+	__m128 peak = abs_ps(x3);
+
+	for (int k = 0; k < 4; k++) {
+		__m128 s = _mm_mul_ps(x0, _mm_set1_ps(kernel[k][0]));
+		s = _mm_add_ps(s, _mm_mul_ps(x1, _mm_set1_ps(kernel[k][1])));
+		s = _mm_add_ps(s, _mm_mul_ps(x2, _mm_set1_ps(kernel[k][2])));
+		s = _mm_add_ps(s, _mm_mul_ps(x3, _mm_set1_ps(kernel[k][3])));
+		peak = _mm_max_ps(peak, abs_ps(s));
+	}
+
+	return peak;
+}
+
+void dyn_detect_peak(struct dyn_detector *det, float *out,
+		     float *const *samples, size_t channels, uint32_t frames)
+{
+	const bool true_peak = det->true_peak;
+
+	if (!frames)
+		return;
+
+	memset(out, 0, frames * sizeof(out[0]));
+
+	if (true_peak && det->scratch_len < frames + 7) {
+		det->scratch_len = frames + 7;
+		det->scratch = brealloc(det->scratch,
+					det->scratch_len * sizeof(float));
+	}
+
+	for (size_t c = 0; c < channels; c++) {
+		const float *in = samples[c];
+		uint32_t i = 0;
+
+		if (!in)
+			continue;
+
+		if (!true_peak) {
+			for (; i + 4 <= frames; i += 4) {
+				__m128 v = abs_ps(_mm_loadu_ps(&in[i]));
+				v = _mm_max_ps(v, _mm_loadu_ps(&out[i]));
+				_mm_storeu_ps(&out[i], v);
+			}
+			for (; i < frames; i++)
+				out[i] = fmaxf(out[i], fabsf(in[i]));
+			continue;
+		}
+
+		float *ext = det->scratch;
+		memcpy(ext, det->history[c], 3 * sizeof(float));
+		memcpy(ext + 3, in, frames * sizeof(float));
+		memset(ext + 3 + frames, 0, 4 * sizeof(float));
+
+		for (; i < frames; i += 4) {
+			float peak[4];
+			_mm_storeu_ps(peak, true_peak_ps(ext, i));
+
+			for (uint32_t k = 0; k < 4 && i + k < frames; k++)
+				out[i + k] = fmaxf(out[i + k], peak[k]);
+		}
+
+		memcpy(det->history[c], ext + frames, 3 * sizeof(float));
+	}
+}
+
+/* -------------------------------------------------------- */
+
+void dyn_lookahead_init(struct dyn_lookahead *la, size_t channels,
+			size_t frames)
+{
+	dyn_lookahead_free(la);
+
+	la->frames = frames;
+	la->channels = channels;
+	la->gain = 1.0f;
+
+	if (!frames)
+		return;
+
+	la->min_val = bmalloc((frames + 1) * sizeof(float));
+	la->min_idx = bmalloc((frames + 1) * sizeof(uint64_t));
+	la->avg_ring = bmalloc((frames + 1) * sizeof(float));
+
+	for (size_t i = 0; i <= frames; i++)
+		la->avg_ring[i] = 1.0f;
+	la->avg_sum = (double)(frames + 1);
+
+	for (size_t c = 0; c < channels; c++)
+		circlebuf_push_back_zero(&la->delay[c], frames * sizeof(float));
+}
+
+void dyn_lookahead_free(struct dyn_lookahead *la)
+{
+	for (size_t c = 0; c < MAX_AUDIO_CHANNELS; c++)
+		circlebuf_free(&la->delay[c]);
+
+	bfree(la->min_val);
+	bfree(la->min_idx);
+	bfree(la->avg_ring);
+	memset(la, 0, sizeof(*la));
+}
+
+void dyn_lookahead_gain(struct dyn_lookahead *la, float *gain,
+			const float *required, uint32_t frames,
+			float release_gain)
+{
+	const size_t cap = la->frames + 1;
+	const double inv_len = 1.0 / (double)cap;
+
+	for (uint32_t i = 0; i < frames; i++) {
+		const uint64_t idx = la->index++;
+		const float r = required[i];
+		size_t tail;
+
+		/* expire the value that left the window */
+		if (la->min_count &&
+		    la->min_idx[la->min_head] + la->frames < idx) {
+			la->min_head = (la->min_head + 1) % cap;
+			la->min_count--;
+		}
+
+		/* push into the monotonic queue, dropping larger values */
+		while (la->min_count) {
+			tail = (la->min_head + la->min_count - 1) % cap;
+			if (la->min_val[tail] < r)
+				break;
+			la->min_count--;
+		}
+		tail = (la->min_head + la->min_count) % cap;
+		la->min_val[tail] = r;
+		la->min_idx[tail] = idx;
+		la->min_count++;
+
+		/* average the window minimum to ramp the gain linearly */
+		const float m = la->min_val[la->min_head];
+		la->avg_sum += (double)m - (double)la->avg_ring[la->avg_pos];
+		la->avg_ring[la->avg_pos] = m;
+		la->avg_pos = (la->avg_pos + 1) % cap;
+
+		float g = fminf((float)(la->avg_sum * inv_len), 1.0f);
+		if (g > la->gain)
+			g = g + release_gain * (la->gain - g);
+		la->gain = g;
+		gain[i] = g;
+	}
+}
+
+void dyn_lookahead_delay(struct dyn_lookahead *la, float *const *samples,
+			 uint32_t frames)
+{
+	const size_t size = frames * sizeof(float);
+
+	for (size_t c = 0; c < la->channels; c++) {
+		if (!samples[c])
+			continue;
+
+		circlebuf_push_back(&la->delay[c], samples[c], size);
+		circlebuf_pop_front(&la->delay[c], samples[c], size);
+	}
+}
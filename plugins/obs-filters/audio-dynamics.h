@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <obs-module.h>
+#include <util/circlebuf.h>
+
+/* -------------------------------------------------------- */
+/* Shared gain computer and envelope helpers for the compressor, limiter and
+ * expander filters.  Gains are computed block-wise with SSE (SIMDe on other
+ * architectures) instead of calling log10f/powf once per sample. */
+
+/* Peak envelope follower.  Each non-NULL channel runs its own follower
+ * starting at *envelope, and env_buf receives the maximum over channels.
+ * *envelope is updated to the last value of env_buf. */
+extern void dyn_peak_envelope(float *env_buf, float *const *samples,
+			      size_t channels, uint32_t frames,
+			      float *envelope, float attack_gain,
+			      float release_gain);
+
+/* Peak follower over an already combined detector signal. */
+extern void dyn_follow_envelope(float *env_buf, const float *detector,
+				uint32_t frames, float *envelope,
+				float attack_gain, float release_gain);
+
+/* gain[i] = db_to_mul(min(0, slope * (threshold - mul_to_db(env[i]))))
+ *           * output_gain */
+extern void dyn_compressor_gain(float *gain, const float *env,
+				uint32_t frames, float threshold, float slope,
+				float output_gain);
+
+/* dst[i] = mul_to_db(src[i]), with 0 mapped to a very low finite level */
+extern void dyn_mul_to_db(float *dst, const float *src, uint32_t frames);
+
+/* dst[i] = db_to_mul(min(0, src[i])) * output_gain */
+extern void dyn_db_to_gain(float *dst, const float *src, uint32_t frames,
+			   float output_gain);
+
+/* samples[c][i] *= gain[i] for every non-NULL channel */
+extern void dyn_apply_gain(float *const *samples, size_t channels,
+			   const float *gain, uint32_t frames);
+
+/* -------------------------------------------------------- */
+/* Detector: per-sample maximum over channels of the sample peak, or of the
+ * 4x oversampled true peak (same interpolation kernel as the volume meter) */
+
+struct dyn_detector {
+	bool true_peak;
+	float history[MAX_AUDIO_CHANNELS][3];
+	float *scratch;
+	size_t scratch_len;
+};
+
+extern void dyn_detector_free(struct dyn_detector *det);
+extern void dyn_detector_reset(struct dyn_detector *det);
+extern void dyn_detect_peak(struct dyn_detector *det, float *out,
+			    float *const *samples, size_t channels,
+			    uint32_t frames);
+
+/* -------------------------------------------------------- */
+/* Look-ahead brick-wall gain: the audio is delayed by `frames` samples and
+ * the gain reaching each delayed sample is ramped down over the look-ahead
+ * window, so it never exceeds the gain required by any sample inside it. */
+
+struct dyn_lookahead {
+	size_t frames;
+	size_t channels;
+	struct circlebuf delay[MAX_AUDIO_CHANNELS];
+
+	/* sliding window minimum of the required gain (monotonic queue) */
+	float *min_val;
+	uint64_t *min_idx;
+	size_t min_head;
+	size_t min_count;
+
+	/* moving average over the window minimum */
+	float *avg_ring;
+	size_t avg_pos;
+	double avg_sum;
+
+	uint64_t index;
+	float gain;
+};
+
+extern void dyn_lookahead_init(struct dyn_lookahead *la, size_t channels,
+			       size_t frames);
+extern void dyn_lookahead_free(struct dyn_lookahead *la);
+
+/* Turns the per-sample required gain of the undelayed input into the gain
+ * to apply to the delayed output, with release smoothing. */
+extern void dyn_lookahead_gain(struct dyn_lookahead *la, float *gain,
+			       const float *required, uint32_t frames,
+			       float release_gain);
+
+/* Delays the audio in place by the look-ahead length. */
+extern void dyn_lookahead_delay(struct dyn_lookahead *la,
+				float *const *samples, uint32_t frames);
@@ -8,6 +8,8 @@
 #include <util/circlebuf.h>
 #include <util/threading.h>
 
+#include "audio-dynamics.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)              \
@@ -313,50 +315,46 @@ static inline void process_expansion(struct expander_data *cd, float **samples,
 
 	if (cd->gaindB_len < num_samples)
 		resize_gaindB_buffer(cd, num_samples);
+	if (cd->env_in_len < num_samples)
+		resize_env_in_buffer(cd, num_samples);
 	for (int i = 0; i < MAX_AUDIO_CHANNELS; i++)
 		memset(cd->gaindB[i], 0,
 		       num_samples * sizeof(cd->gaindB[i][0]));
 
+	/* env_in is free after detection, reuse it for the dB/gain values */
+	float *scratch = cd->env_in;
+
 	for (size_t chan = 0; chan < cd->num_channels; chan++) {
+		float *gaindB = cd->gaindB[chan];
+		float prev = cd->gaindB_buf[chan];
+
+		dyn_mul_to_db(scratch, cd->envelope_buf[chan], num_samples);
+
 		for (size_t i = 0; i < num_samples; ++i) {
 			// gain stage of expansion
-			float env_db = mul_to_db(cd->envelope_buf[chan][i]);
-			float gain =
+			const float env_db = scratch[i];
+			const float gain =
 				cd->threshold - env_db > 0.0f
 					? fmaxf(cd->slope * (cd->threshold -
 							     env_db),
 						-60.0f)
 					: 0.0f;
 			// ballistics (attack/release)
-			if (i > 0) {
-				if (gain > cd->gaindB[chan][i - 1])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB[chan][i - 1] +
-						(1.0f - release_gain) * gain;
-			} else {
-				if (gain > cd->gaindB_buf[chan])
-					cd->gaindB[chan][i] =
-						attack_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - attack_gain) * gain;
-				else
-					cd->gaindB[chan][i] =
-						release_gain *
-							cd->gaindB_buf[chan] +
-						(1.0f - release_gain) * gain;
-			}
+			if (gain > prev)
+				prev = attack_gain * prev +
+				       (1.0f - attack_gain) * gain;
+			else
+				prev = release_gain * prev +
+				       (1.0f - release_gain) * gain;
+			gaindB[i] = prev;
+		}
+		cd->gaindB_buf[chan] = prev;
 
-			gain = db_to_mul(fminf(0, cd->gaindB[chan][i]));
-			if (samples[chan])
-				samples[chan][i] *= gain * cd->output_gain;
+		if (samples[chan]) {
+			dyn_db_to_gain(scratch, gaindB, num_samples,
+				       cd->output_gain);
+			dyn_apply_gain(&samples[chan], 1, scratch, num_samples);
 		}
-		cd->gaindB_buf[chan] = cd->gaindB[chan][num_samples - 1];
 	}
 }
 
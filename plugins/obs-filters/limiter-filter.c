@@ -6,6 +6,8 @@
 #include <media-io/audio-math.h>
 #include <util/platform.h>
 
+#include "audio-dynamics.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)             \
@@ -27,15 +29,20 @@
 
 #define S_THRESHOLD                     "threshold"
 #define S_RELEASE_TIME                  "release_time"
+#define S_LOOKAHEAD                     "lookahead"
+#define S_TRUE_PEAK                     "true_peak"
 
 #define MT_ obs_module_text
 #define TEXT_THRESHOLD                  MT_("Limiter.Threshold")
 #define TEXT_RELEASE_TIME               MT_("Limiter.ReleaseTime")
+#define TEXT_LOOKAHEAD                  MT_("Limiter.Lookahead")
+#define TEXT_TRUE_PEAK                  MT_("Limiter.TruePeak")
 
 #define MIN_THRESHOLD_DB                -60.0
 #define MAX_THRESHOLD_DB                0.0f
 #define MIN_ATK_RLS_MS                  1
 #define MAX_RLS_MS                      1000
+#define MAX_LOOKAHEAD_MS                20
 #define DEFAULT_AUDIO_BUF_MS            10
 #define ATK_TIME                        0.001f
 #define MS_IN_S                         1000
@@ -59,6 +66,12 @@ struct limiter_data {
 	size_t sample_rate;
 	float envelope;
 	float slope;
+
+	size_t lookahead_frames;
+	uint64_t lookahead_ns;
+	struct dyn_lookahead lookahead;
+	struct dyn_detector detector;
+	float *gain_buf;
 };
 
 /* -------------------------------------------------------- */
@@ -67,6 +80,7 @@ static void resize_env_buffer(struct limiter_data *cd, size_t len)
 {
 	cd->envelope_buf_len = len;
 	cd->envelope_buf = brealloc(cd->envelope_buf, len * sizeof(float));
+	cd->gain_buf = brealloc(cd->gain_buf, len * sizeof(float));
 }
 
 static inline float gain_coefficient(uint32_t sample_rate, float time)
@@ -103,6 +117,13 @@ static void limiter_update(void *data, obs_data_t *s)
 	cd->num_channels = num_channels;
 	cd->sample_rate = sample_rate;
 	cd->slope = 1.0f;
+	cd->detector.true_peak = obs_data_get_bool(s, S_TRUE_PEAK);
+
+	/* the look-ahead buffers are (re)created on the audio thread */
+	const size_t lookahead_ms = (size_t)obs_data_get_int(s, S_LOOKAHEAD);
+	cd->lookahead_frames = sample_rate * lookahead_ms / MS_IN_S;
+	cd->lookahead_ns = (uint64_t)cd->lookahead_frames * 1000000000ULL /
+			   sample_rate;
 
 	size_t sample_len = sample_rate * DEFAULT_AUDIO_BUF_MS / MS_IN_S;
 	if (cd->envelope_buf_len == 0)
@@ -122,54 +143,62 @@ static void limiter_destroy(void *data)
 {
 	struct limiter_data *cd = data;
 
+	dyn_lookahead_free(&cd->lookahead);
+	dyn_detector_free(&cd->detector);
 	bfree(cd->envelope_buf);
+	bfree(cd->gain_buf);
 	bfree(cd);
 }
 
 static void analyze_envelope(struct limiter_data *cd, float **samples,
 			     const uint32_t num_samples)
 {
-	if (cd->envelope_buf_len < num_samples) {
-		resize_env_buffer(cd, num_samples);
-	}
-
-	const float attack_gain = cd->attack_gain;
-	const float release_gain = cd->release_gain;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!samples[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(samples[chan][i]);
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
+	if (cd->detector.true_peak) {
+		dyn_detect_peak(&cd->detector, cd->envelope_buf, samples,
+				cd->num_channels, num_samples);
+		dyn_follow_envelope(cd->envelope_buf, cd->envelope_buf,
+				    num_samples, &cd->envelope,
+				    cd->attack_gain, cd->release_gain);
+	} else {
+		dyn_peak_envelope(cd->envelope_buf, samples, cd->num_channels,
+				  num_samples, &cd->envelope, cd->attack_gain,
+				  cd->release_gain);
 	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
 }
 
 static inline void process_compression(const struct limiter_data *cd,
 				       float **samples, uint32_t num_samples)
 {
-	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
-
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
+	dyn_compressor_gain(cd->gain_buf, cd->envelope_buf, num_samples,
+			    cd->threshold, cd->slope, cd->output_gain);
+	dyn_apply_gain(samples, cd->num_channels, cd->gain_buf, num_samples);
+}
+
+/* Look-ahead mode: the gain required by every input sample is known one
+ * look-ahead window before the sample is output, so the gain can be ramped
+ * down in time and the output never exceeds the threshold. */
+static void process_lookahead(struct limiter_data *cd, float **samples,
+			      uint32_t num_samples)
+{
+	const float threshold = db_to_mul(cd->threshold);
+	float *required = cd->envelope_buf;
+
+	dyn_detect_peak(&cd->detector, required, samples, cd->num_channels,
+			num_samples);
+
+	for (uint32_t i = 0; i < num_samples; i++)
+		required[i] = fminf(threshold / required[i], 1.0f);
+
+	dyn_lookahead_gain(&cd->lookahead, cd->gain_buf, required, num_samples,
+			   cd->release_gain);
+	dyn_lookahead_delay(&cd->lookahead, samples, num_samples);
+
+	if (cd->output_gain != 1.0f) {
+		for (uint32_t i = 0; i < num_samples; i++)
+			cd->gain_buf[i] *= cd->output_gain;
 	}
+
+	dyn_apply_gain(samples, cd->num_channels, cd->gain_buf, num_samples);
 }
 
 static struct obs_audio_data *limiter_filter_audio(void *data,
@@ -181,9 +210,25 @@ static struct obs_audio_data *limiter_filter_audio(void *data,
 	if (num_samples == 0)
 		return audio;
 
+	if (cd->envelope_buf_len < num_samples)
+		resize_env_buffer(cd, num_samples);
+
+	if (cd->lookahead.frames != cd->lookahead_frames ||
+	    cd->lookahead.channels != cd->num_channels) {
+		dyn_lookahead_init(&cd->lookahead, cd->num_channels,
+				   cd->lookahead_frames);
+		dyn_detector_reset(&cd->detector);
+	}
+
 	float **samples = (float **)audio->data;
-	analyze_envelope(cd, samples, num_samples);
-	process_compression(cd, samples, num_samples);
+
+	if (cd->lookahead.frames) {
+		process_lookahead(cd, samples, num_samples);
+		audio->timestamp -= cd->lookahead_ns;
+	} else {
+		analyze_envelope(cd, samples, num_samples);
+		process_compression(cd, samples, num_samples);
+	}
 	return audio;
 }
 
@@ -191,6 +236,8 @@ static void limiter_defaults(obs_data_t *s)
 {
 	obs_data_set_default_double(s, S_THRESHOLD, -6.0f);
 	obs_data_set_default_int(s, S_RELEASE_TIME, 60);
+	obs_data_set_default_int(s, S_LOOKAHEAD, 0);
+	obs_data_set_default_bool(s, S_TRUE_PEAK, false);
 }
 
 static obs_properties_t *limiter_properties(void *data)
@@ -206,6 +253,10 @@ static obs_properties_t *limiter_properties(void *data)
 					  TEXT_RELEASE_TIME, MIN_ATK_RLS_MS,
 					  MAX_RLS_MS, 1);
 	obs_property_int_set_suffix(p, " ms");
+	p = obs_properties_add_int_slider(props, S_LOOKAHEAD, TEXT_LOOKAHEAD,
+					  0, MAX_LOOKAHEAD_MS, 1);
+	obs_property_int_set_suffix(p, " ms");
+	obs_properties_add_bool(props, S_TRUE_PEAK, TEXT_TRUE_PEAK);
 
 	UNUSED_PARAMETER(data);
 	return props;
@@ -2,6 +2,8 @@
 #include <inttypes.h>
 
 #include <util/circlebuf.h>
+#include <util/platform.h>
+#include <util/threading.h>
 #include <obs-module.h>
 
 #ifdef LIBSPEEXDSP_ENABLED
@@ -14,6 +16,7 @@
 #endif
 #include <rnnoise.h>
 #include <media-io/audio-resampler.h>
+#include "rnnoise-engine.h"
 #endif
 
 bool nvafx_loaded = false;
@@ -88,6 +91,12 @@ struct noise_suppress_data {
 	bool use_nvafx;
 	bool nvafx_enabled;
 
+	/* Processing time spent in the suppression backends, queryable with
+	 * the get_process_stats procedure */
+	pthread_mutex_t stats_mutex;
+	uint64_t process_time_ns;
+	uint64_t process_segments;
+
 #ifdef LIBSPEEXDSP_ENABLED
 	/* Speex preprocessor state */
 	SpeexPreprocessState *spx_states[MAX_PREPROC_CHANNELS];
@@ -97,6 +106,11 @@ struct noise_suppress_data {
 	/* RNNoise state */
 	DenoiseState *rnn_states[MAX_PREPROC_CHANNELS];
 
+	/* Segment in flight in the shared RNNoise engine */
+	struct rnnoise_job rnn_job;
+	bool rnn_job_queued;
+	bool rnn_engine;
+
 	/* Resampler */
 	audio_resampler_t *rnn_resampler;
 	audio_resampler_t *rnn_resampler_back;
@@ -162,10 +176,30 @@ static const char *noise_suppress_name(void *unused)
 	return obs_module_text("NoiseSuppress");
 }
 
+static void log_process_time(struct noise_suppress_data *ng)
+{
+	if (!ng->process_segments)
+		return;
+
+	info("processed %" PRIu64 " segments in %.3f ms, "
+	     "average %.1f us per %d ms segment",
+	     ng->process_segments, (double)ng->process_time_ns / 1000000.0,
+	     (double)ng->process_time_ns / 1000.0 /
+		     (double)ng->process_segments,
+	     BUFFER_SIZE_MSEC);
+}
+
 static void noise_suppress_destroy(void *data)
 {
 	struct noise_suppress_data *ng = data;
 
+	log_process_time(ng);
+
+#ifdef LIBRNNOISE_ENABLED
+	if (ng->rnn_job_queued)
+		rnnoise_engine_wait(&ng->rnn_job);
+#endif
+
 #ifdef LIBNVAFX_ENABLED
 	if (ng->nvafx_enabled)
 		pthread_mutex_lock(&ng->nvafx_mutex);
@@ -195,6 +229,10 @@ static void noise_suppress_destroy(void *data)
 #endif
 #ifdef LIBRNNOISE_ENABLED
 	bfree(ng->rnn_segment_buffers[0]);
+	bfree(ng->rnn_job.frames[0]);
+
+	if (ng->rnn_engine)
+		rnnoise_engine_release();
 
 	if (ng->rnn_resampler) {
 		audio_resampler_destroy(ng->rnn_resampler);
@@ -221,6 +259,7 @@ static void noise_suppress_destroy(void *data)
 	bfree(ng->copy_buffers[0]);
 	circlebuf_free(&ng->info_buffer);
 	da_free(ng->output_data);
+	pthread_mutex_destroy(&ng->stats_mutex);
 	bfree(ng);
 }
 
@@ -383,10 +422,22 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 	size_t frames = (size_t)sample_rate / (1000 / BUFFER_SIZE_MSEC);
 	const char *method = obs_data_get_string(s, S_METHOD);
 
+#ifdef LIBRNNOISE_ENABLED
+	/* start the shared engine here, not on the audio thread */
+	if (!ng->rnn_engine && strcmp(method, S_METHOD_RNN) == 0) {
+		rnnoise_engine_acquire();
+		ng->rnn_engine = true;
+	}
+#endif
+
 	ng->suppress_level = (int)obs_data_get_int(s, S_SUPPRESS_LEVEL);
 	ng->latency = 1000000000LL / (1000 / BUFFER_SIZE_MSEC);
 	ng->use_rnnoise = strcmp(method, S_METHOD_RNN) == 0;
 
+	/* the shared RNNoise engine returns each segment one segment later */
+	if (ng->use_rnnoise)
+		ng->latency *= 2;
+
 	ng->use_nvafx = ng->nvafx_enabled &&
 			strcmp(method, S_METHOD_NVAFX) == 0;
 
@@ -440,6 +491,8 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 #ifdef LIBRNNOISE_ENABLED
 	ng->rnn_segment_buffers[0] =
 		bmalloc(RNNOISE_FRAME_SIZE * channels * sizeof(float));
+	ng->rnn_job.frames[0] =
+		bmalloc(RNNOISE_FRAME_SIZE * channels * sizeof(float));
 #endif
 #ifdef LIBNVAFX_ENABLED
 	ng->nvafx_segment_buffers[0] =
@@ -454,6 +507,8 @@ static void noise_suppress_update(void *data, obs_data_t *s)
 #ifdef LIBRNNOISE_ENABLED
 		ng->rnn_segment_buffers[c] =
 			ng->rnn_segment_buffers[c - 1] + RNNOISE_FRAME_SIZE;
+		ng->rnn_job.frames[c] =
+			ng->rnn_job.frames[c - 1] + RNNOISE_FRAME_SIZE;
 #endif
 #ifdef LIBNVAFX_ENABLED
 		ng->nvafx_segment_buffers[c] =
@@ -594,12 +649,33 @@ void unload_nvafx(void)
 #endif
 }
 
+static void get_process_stats(void *data, calldata_t *cd)
+{
+	struct noise_suppress_data *ng = data;
+	uint64_t time_ns, segments;
+
+	pthread_mutex_lock(&ng->stats_mutex);
+	time_ns = ng->process_time_ns;
+	segments = ng->process_segments;
+	pthread_mutex_unlock(&ng->stats_mutex);
+
+	calldata_set_int(cd, "segments", (long long)segments);
+	calldata_set_int(cd, "time_ns", (long long)time_ns);
+}
+
 static void *noise_suppress_create(obs_data_t *settings, obs_source_t *filter)
 {
 	struct noise_suppress_data *ng =
 		bzalloc(sizeof(struct noise_suppress_data));
 
 	ng->context = filter;
+	pthread_mutex_init(&ng->stats_mutex, NULL);
+
+	proc_handler_t *ph = obs_source_get_proc_handler(filter);
+	proc_handler_add(ph,
+			 "void get_process_stats(out int segments, "
+			 "out int time_ns)",
+			 get_process_stats, ng);
 
 #ifdef LIBNVAFX_ENABLED
 	char sdk_path[MAX_PATH];
@@ -699,13 +775,27 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 		}
 	}
 
-	/* Execute */
+	/* Execute: collect the previous segment from the shared engine and
+	 * submit this one, the segment buffers then hold the previous result
+	 * (silence for the first segment after a reset) */
+	if (ng->rnn_job_queued)
+		rnnoise_engine_wait(&ng->rnn_job);
+
 	for (size_t i = 0; i < ng->channels; i++) {
-		rnnoise_process_frame(ng->rnn_states[i],
-				      ng->rnn_segment_buffers[i],
-				      ng->rnn_segment_buffers[i]);
+		float *frame = ng->rnn_job.frames[i];
+		ng->rnn_job.frames[i] = ng->rnn_segment_buffers[i];
+		ng->rnn_segment_buffers[i] = frame;
+
+		if (!ng->rnn_job_queued)
+			memset(frame, 0, RNNOISE_FRAME_SIZE * sizeof(float));
+
+		ng->rnn_job.states[i] = ng->rnn_states[i];
 	}
 
+	ng->rnn_job.channels = ng->channels;
+	rnnoise_engine_submit(&ng->rnn_job);
+	ng->rnn_job_queued = true;
+
 	/* Revert signal level adjustment, resample back if necessary */
 	if (ng->rnn_resampler) {
 		float *output[MAX_PREPROC_CHANNELS];
@@ -827,23 +917,50 @@ static inline void process_nvafx(struct noise_suppress_data *ng)
 #endif
 }
 
+static inline void flush_rnnoise(struct noise_suppress_data *ng)
+{
+#ifdef LIBRNNOISE_ENABLED
+	/* drop the segment in flight, its output no longer belongs to the
+	 * audio that follows */
+	if (ng->rnn_job_queued) {
+		rnnoise_engine_wait(&ng->rnn_job);
+		ng->rnn_job_queued = false;
+	}
+#else
+	UNUSED_PARAMETER(ng);
+#endif
+}
+
 static inline void process(struct noise_suppress_data *ng)
 {
+	uint64_t start_time, elapsed;
+
 	/* Pop from input circlebuf */
 	for (size_t i = 0; i < ng->channels; i++)
 		circlebuf_pop_front(&ng->input_buffers[i], ng->copy_buffers[i],
 				    ng->frames * sizeof(float));
 
+	start_time = os_gettime_ns();
+
 	if (ng->use_rnnoise) {
 		process_rnnoise(ng);
 	} else if (ng->use_nvafx) {
+		flush_rnnoise(ng);
 		if (nvafx_loaded) {
 			process_nvafx(ng);
 		}
 	} else {
+		flush_rnnoise(ng);
 		process_speexdsp(ng);
 	}
 
+	elapsed = os_gettime_ns() - start_time;
+
+	pthread_mutex_lock(&ng->stats_mutex);
+	ng->process_time_ns += elapsed;
+	ng->process_segments++;
+	pthread_mutex_unlock(&ng->stats_mutex);
+
 	/* Push to output circlebuf */
 	for (size_t i = 0; i < ng->channels; i++)
 		circlebuf_push_back(&ng->output_buffers[i], ng->copy_buffers[i],
@@ -862,6 +979,8 @@ static inline void clear_circlebuf(struct circlebuf *buf)
 
 static void reset_data(struct noise_suppress_data *ng)
 {
+	flush_rnnoise(ng);
+
 	for (size_t i = 0; i < ng->channels; i++) {
 		clear_circlebuf(&ng->input_buffers[i]);
 		clear_circlebuf(&ng->output_buffers[i]);
@@ -0,0 +1,274 @@
+#include "rnnoise-engine.h"
+
+#include <inttypes.h>
+
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define do_log(level, format, ...) \
+	blog(level, "[noise suppress: rnnoise engine] " format, ##__VA_ARGS__)
+
+#define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
+
+/* protects the lifetime of the worker thread */
+static pthread_mutex_t engine_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long engine_refs = 0;
+static bool thread_created = false;
+static pthread_t thread;
+
+/* protects the queue and the done/claimed flags of the jobs.  stopped is
+ * set while there is no worker thread accepting jobs, submitted jobs are
+ * then processed inline. */
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static struct rnnoise_job *first_job = NULL;
+static struct rnnoise_job *last_job = NULL;
+static bool stopped = true;
+
+/* only touched by the worker thread */
+static uint64_t total_batches = 0;
+static uint64_t total_frames = 0;
+
+static void process_frames(DenoiseState **states, float **frames,
+			   size_t count)
+{
+#ifdef RNNOISE_HAS_PROCESS_FRAMES
+	rnnoise_process_frames(states, frames, (const float **)frames, NULL,
+			       (int)count);
+#else
+	for (size_t i = 0; i < count; i++)
+		rnnoise_process_frame(states[i], frames[i], frames[i]);
+#endif
+}
+
+static void process_jobs(struct rnnoise_job *jobs)
+{
+	DenoiseState *states[RNNOISE_ENGINE_MAX_BATCH];
+	float *frames[RNNOISE_ENGINE_MAX_BATCH];
+	size_t count = 0;
+
+	for (struct rnnoise_job *job = jobs; job; job = job->next) {
+		for (size_t i = 0; i < job->channels; i++) {
+			states[count] = job->states[i];
+			frames[count] = job->frames[i];
+			count++;
+		}
+	}
+
+	if (!count)
+		return;
+
+	process_frames(states, frames, count);
+
+	total_batches++;
+	total_frames += count;
+}
+
+/* Takes the jobs at the front of the queue that fit in one batch, at least
+ * one.  Jobs queued behind them stay available to rnnoise_engine_wait(). */
+static struct rnnoise_job *claim_jobs(void)
+{
+	struct rnnoise_job *jobs = first_job;
+	struct rnnoise_job *last = first_job;
+	size_t count = last->channels;
+
+	last->claimed = true;
+
+	while (last->next &&
+	       count + last->next->channels <= RNNOISE_ENGINE_MAX_BATCH) {
+		last = last->next;
+		last->claimed = true;
+		count += last->channels;
+	}
+
+	first_job = last->next;
+	if (!first_job)
+		last_job = NULL;
+	last->next = NULL;
+
+	return jobs;
+}
+
+static void unlink_job(struct rnnoise_job *job)
+{
+	struct rnnoise_job *prev = NULL;
+	struct rnnoise_job *cur = first_job;
+
+	while (cur && cur != job) {
+		prev = cur;
+		cur = cur->next;
+	}
+
+	if (!cur)
+		return;
+
+	if (prev)
+		prev->next = job->next;
+	else
+		first_job = job->next;
+	if (last_job == job)
+		last_job = prev;
+	job->next = NULL;
+}
+
+static void finish_jobs(struct rnnoise_job *jobs)
+{
+	struct rnnoise_job *job = jobs;
+
+	/* a job may be submitted again as soon as it is done, so its next
+	 * pointer has to be read first */
+	while (job) {
+		struct rnnoise_job *next = job->next;
+		job->done = true;
+		job = next;
+	}
+
+	pthread_cond_broadcast(&done_cond);
+}
+
+static void *engine_thread(void *unused)
+{
+	os_set_thread_name("rnnoise engine");
+
+	pthread_mutex_lock(&queue_mutex);
+
+	for (;;) {
+		struct rnnoise_job *jobs;
+
+		while (!first_job && !stopped)
+			pthread_cond_wait(&work_cond, &queue_mutex);
+
+		if (!first_job)
+			break;
+
+		/* what is queued by now is evaluated in batches, frames
+		 * submitted meanwhile go to a later one */
+		jobs = claim_jobs();
+
+		pthread_mutex_unlock(&queue_mutex);
+		process_jobs(jobs);
+		pthread_mutex_lock(&queue_mutex);
+
+		finish_jobs(jobs);
+	}
+
+	pthread_mutex_unlock(&queue_mutex);
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+/* RNNoise lazily initializes its shared FFT and DCT tables on the first
+ * frame, which is not thread safe.  Frames are processed both on the worker
+ * and on the threads collecting their jobs, so make sure the tables exist
+ * before either of them runs. */
+static void init_rnnoise_tables(void)
+{
+	static bool initialized = false;
+	float frame[RNNOISE_ENGINE_FRAME_SIZE] = {0};
+	DenoiseState *st;
+
+	if (initialized)
+		return;
+
+	st = rnnoise_create(NULL);
+	rnnoise_process_frame(st, frame, frame);
+	rnnoise_destroy(st);
+	initialized = true;
+}
+
+void rnnoise_engine_acquire(void)
+{
+	pthread_mutex_lock(&engine_mutex);
+
+	if (engine_refs++ == 0) {
+		init_rnnoise_tables();
+
+		pthread_mutex_lock(&queue_mutex);
+		thread_created = pthread_create(&thread, NULL, engine_thread,
+						NULL) == 0;
+		stopped = !thread_created;
+		pthread_mutex_unlock(&queue_mutex);
+
+		if (!thread_created)
+			do_log(LOG_WARNING, "Failed to create worker thread, "
+					    "frames are processed inline");
+	}
+
+	pthread_mutex_unlock(&engine_mutex);
+}
+
+void rnnoise_engine_release(void)
+{
+	pthread_mutex_lock(&engine_mutex);
+
+	if (--engine_refs == 0) {
+		if (thread_created) {
+			pthread_mutex_lock(&queue_mutex);
+			stopped = true;
+			pthread_cond_signal(&work_cond);
+			pthread_mutex_unlock(&queue_mutex);
+
+			pthread_join(thread, NULL);
+			thread_created = false;
+		}
+
+		if (total_batches)
+			info("evaluated %" PRIu64 " frames in %" PRIu64
+			     " batches (%.2f frames per batch)",
+			     total_frames, total_batches,
+			     (double)total_frames / (double)total_batches);
+
+		total_batches = 0;
+		total_frames = 0;
+	}
+
+	pthread_mutex_unlock(&engine_mutex);
+}
+
+void rnnoise_engine_submit(struct rnnoise_job *job)
+{
+	job->done = false;
+	job->claimed = false;
+	job->next = NULL;
+
+	pthread_mutex_lock(&queue_mutex);
+
+	if (stopped) {
+		pthread_mutex_unlock(&queue_mutex);
+		process_frames(job->states, job->frames, job->channels);
+		job->done = true;
+		return;
+	}
+
+	if (last_job)
+		last_job->next = job;
+	else
+		first_job = job;
+	last_job = job;
+
+	pthread_cond_signal(&work_cond);
+	pthread_mutex_unlock(&queue_mutex);
+}
+
+void rnnoise_engine_wait(struct rnnoise_job *job)
+{
+	pthread_mutex_lock(&queue_mutex);
+
+	/* not picked up by the worker yet, process it here rather than wait
+	 * for the frames of other sources queued before it */
+	if (!job->done && !job->claimed) {
+		unlink_job(job);
+		pthread_mutex_unlock(&queue_mutex);
+
+		process_frames(job->states, job->frames, job->channels);
+		job->done = true;
+		return;
+	}
+
+	while (!job->done)
+		pthread_cond_wait(&done_cond, &queue_mutex);
+	pthread_mutex_unlock(&queue_mutex);
+}
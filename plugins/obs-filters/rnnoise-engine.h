@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <rnnoise.h>
+
+/* -------------------------------------------------------- */
+/* Shared RNNoise engine.  Every noise suppression filter instance submits
+ * its 10 ms frames to one worker thread, which evaluates the frames queued
+ * by the instances of an audio tick in batches of up to
+ * RNNOISE_ENGINE_MAX_BATCH frames, so the network weights are walked once
+ * per batch instead of once per channel of every source.
+ *
+ * An instance has at most one job in flight: it submits segment n and
+ * collects it while submitting segment n + 1, which adds exactly one
+ * segment of latency to the filter.  A job the worker has not picked up by
+ * the time it is collected is processed by the collecting thread instead,
+ * so the audio thread waits at most for one batch, never for the whole
+ * queue of other sources.  Frames of the same instance are never batched
+ * with each other, the denoiser state of a channel is sequential.
+ *
+ * Acquire the engine outside of the audio thread (in create/update), it
+ * starts the worker thread. */
+
+#define RNNOISE_ENGINE_MAX_CHANNELS 8
+#define RNNOISE_ENGINE_MAX_BATCH 8
+#define RNNOISE_ENGINE_FRAME_SIZE 480
+
+struct rnnoise_job {
+	DenoiseState *states[RNNOISE_ENGINE_MAX_CHANNELS];
+	size_t channels;
+
+	/* one RNNoise frame per channel, processed in place */
+	float *frames[RNNOISE_ENGINE_MAX_CHANNELS];
+
+	/* owned by the engine */
+	bool done;
+	bool claimed;
+	struct rnnoise_job *next;
+};
+
+extern void rnnoise_engine_acquire(void);
+extern void rnnoise_engine_release(void);
+
+extern void rnnoise_engine_submit(struct rnnoise_job *job);
+extern void rnnoise_engine_wait(struct rnnoise_job *job);
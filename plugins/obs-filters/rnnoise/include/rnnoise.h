@@ -61,6 +61,20 @@ RNNOISE_EXPORT void rnnoise_destroy(DenoiseState *st);
 
 RNNOISE_EXPORT float rnnoise_process_frame(DenoiseState *st, float *out, const float *in);
 
+/* Processes one frame for each of count states (which must share the same
+ * model), evaluating the network for all of them together. vad may be NULL.
+ * Results are identical to calling rnnoise_process_frame() on each state. */
+#define RNNOISE_HAS_PROCESS_FRAMES 1
+RNNOISE_EXPORT void rnnoise_process_frames(DenoiseState **st, float **out, const float **in, float *vad, int count);
+
+/* Selects the SIMD kernels (the default when built with RNNOISE_USE_SIMD)
+ * or the scalar reference ones for st, mostly for comparing the two. Only
+ * affects st, from its next frame on; when frames of several states are
+ * processed together the scalar kernels are used unless all of them enable
+ * SIMD. */
+#define RNNOISE_HAS_SIMD_TOGGLE 1
+RNNOISE_EXPORT void rnnoise_set_simd_enabled(DenoiseState *st, int enabled);
+
 RNNOISE_EXPORT RNNModel *rnnoise_model_from_file(FILE *f);
 
 RNNOISE_EXPORT void rnnoise_model_free(RNNModel *model);
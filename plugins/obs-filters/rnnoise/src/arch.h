@@ -37,6 +37,25 @@
 #include "opus_types.h"
 #include "common.h"
 
+/* RNNOISE_USE_SIMD is set by the OBS build. The kernels are written against
+   the libobs SSE2 wrapper, which SIMDe maps to NEON (or plain C) on other
+   architectures. */
+#if defined(RNNOISE_USE_SIMD) && !defined(FIXED_POINT)
+#include <util/sse-intrin.h>
+#define RNN_ENABLE_SIMD
+#endif
+
+/* Kernels used by a DenoiseState, passed down to them as the arch argument
+   like in Opus, see rnnoise_set_simd_enabled(). */
+#define RNN_ARCH_C    0
+#define RNN_ARCH_SIMD 1
+
+#ifdef RNN_ENABLE_SIMD
+#define RNN_ARCH_DEFAULT RNN_ARCH_SIMD
+#else
+#define RNN_ARCH_DEFAULT RNN_ARCH_C
+#endif
+
 # if !defined(__GNUC_PREREQ)
 #  if defined(__GNUC__)&&defined(__GNUC_MINOR__)
 #   define __GNUC_PREREQ(_maj,_min) \
@@ -93,7 +93,8 @@ void celt_fir(
          const opus_val16 *num,
          opus_val16 *y,
          int N,
-         int ord)
+         int ord,
+         int arch)
 {
    int i,j;
    opus_val16 *rnum = malloc(sizeof(opus_val16) * ord);
@@ -106,7 +107,7 @@ void celt_fir(
       sum[1] = SHL32(EXTEND32(x[i+1]), SIG_SHIFT);
       sum[2] = SHL32(EXTEND32(x[i+2]), SIG_SHIFT);
       sum[3] = SHL32(EXTEND32(x[i+3]), SIG_SHIFT);
-      xcorr_kernel(rnum, x+i-ord, sum, ord);
+      xcorr_kernel(rnum, x+i-ord, sum, ord, arch);
       y[i  ] = ROUND16(sum[0], SIG_SHIFT);
       y[i+1] = ROUND16(sum[1], SIG_SHIFT);
       y[i+2] = ROUND16(sum[2], SIG_SHIFT);
@@ -127,7 +128,8 @@ void celt_iir(const opus_val32 *_x,
          opus_val32 *_y,
          int N,
          int ord,
-         opus_val16 *mem)
+         opus_val16 *mem,
+         int arch)
 {
 #ifdef SMALL_FOOTPRINT
    int i,j;
@@ -164,7 +166,7 @@ void celt_iir(const opus_val32 *_x,
       sum[1]=_x[i+1];
       sum[2]=_x[i+2];
       sum[3]=_x[i+3];
-      xcorr_kernel(rden, y+i, sum, ord);
+      xcorr_kernel(rden, y+i, sum, ord, arch);
 
       /* Patch up the result to compensate for the fact that this is an IIR */
       y[i+ord  ] = -SROUND16(sum[0],SIG_SHIFT);
@@ -204,7 +206,8 @@ int _celt_autocorr(
                    const opus_val16       *window,
                    int          overlap,
                    int          lag,
-                   int          n)
+                   int          n,
+                   int          arch)
 {
    opus_val32 d;
    int i, k;
@@ -250,7 +253,7 @@ int _celt_autocorr(
          shift = 0;
    }
 #endif
-   celt_pitch_xcorr(xptr, xptr, ac, fastN, lag+1);
+   celt_pitch_xcorr(xptr, xptr, ac, fastN, lag+1, arch);
    for (k=0;k<=lag;k++)
    {
       for (i = k+fastN, d = 0; i < n; i++)
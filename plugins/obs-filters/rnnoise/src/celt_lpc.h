@@ -44,16 +44,18 @@ void celt_fir(
          const opus_val16 *num,
          opus_val16 *y,
          int N,
-         int ord);
+         int ord,
+         int arch);
 
 void celt_iir(const opus_val32 *x,
          const opus_val16 *den,
          opus_val32 *y,
          int N,
          int ord,
-         opus_val16 *mem);
+         opus_val16 *mem,
+         int arch);
 
 int _celt_autocorr(const opus_val16 *x, opus_val32 *ac,
-         const opus_val16 *window, int overlap, int lag, int n);
+         const opus_val16 *window, int overlap, int lag, int n, int arch);
 
 #endif /* PLC_H */
@@ -85,6 +85,19 @@ typedef struct {
   float dct_table[NB_BANDS*NB_BANDS];
 } CommonState;
 
+/* Per-frame analysis results, kept in the state so that several frames can
+   be analyzed before the network is evaluated for all of them at once. */
+typedef struct {
+  kiss_fft_cpx X[FREQ_SIZE];
+  kiss_fft_cpx P[WINDOW_SIZE];
+  float Ex[NB_BANDS], Ep[NB_BANDS];
+  float Exp[NB_BANDS];
+  float features[NB_FEATURES];
+  float g[NB_BANDS];
+  float vad_prob;
+  int silence;
+} FrameState;
+
 struct DenoiseState {
   float analysis_mem[FRAME_SIZE];
   float cepstral_mem[CEPS_MEM][NB_BANDS];
@@ -97,6 +110,8 @@ struct DenoiseState {
   float mem_hp_x[2];
   float lastg[NB_BANDS];
   RNNState rnn;
+  FrameState frame;
+  int arch;
 };
 
 void compute_band_energy(float *bandE, const kiss_fft_cpx *X) {
@@ -265,12 +280,17 @@ int rnnoise_init(DenoiseState *st, RNNModel *model) {
     st->rnn.model = model;
   else
     st->rnn.model = &rnnoise_model_orig;
+  st->arch = RNN_ARCH_DEFAULT;
   st->rnn.vad_gru_state = calloc(sizeof(float), st->rnn.model->vad_gru_size);
   st->rnn.noise_gru_state = calloc(sizeof(float), st->rnn.model->noise_gru_size);
   st->rnn.denoise_gru_state = calloc(sizeof(float), st->rnn.model->denoise_gru_size);
   return 0;
 }
 
+void rnnoise_set_simd_enabled(DenoiseState *st, int enabled) {
+  st->arch = enabled ? RNN_ARCH_DEFAULT : RNN_ARCH_C;
+}
+
 DenoiseState *rnnoise_create(RNNModel *model) {
   DenoiseState *st;
   st = malloc(rnnoise_get_size());
@@ -323,9 +343,9 @@ static int compute_frame_features(DenoiseState *st, kiss_fft_cpx *X, kiss_fft_cp
   RNN_MOVE(st->pitch_buf, &st->pitch_buf[FRAME_SIZE], PITCH_BUF_SIZE-FRAME_SIZE);
   RNN_COPY(&st->pitch_buf[PITCH_BUF_SIZE-FRAME_SIZE], in, FRAME_SIZE);
   pre[0] = &st->pitch_buf[0];
-  pitch_downsample(pre, pitch_buf, PITCH_BUF_SIZE, 1);
+  pitch_downsample(pre, pitch_buf, PITCH_BUF_SIZE, 1, st->arch);
   pitch_search(pitch_buf+(PITCH_MAX_PERIOD>>1), pitch_buf, PITCH_FRAME_SIZE,
-               PITCH_MAX_PERIOD-3*PITCH_MIN_PERIOD, &pitch_index);
+               PITCH_MAX_PERIOD-3*PITCH_MIN_PERIOD, &pitch_index, st->arch);
   pitch_index = PITCH_MAX_PERIOD-pitch_index;
 
   gain = remove_doubling(pitch_buf, PITCH_MAX_PERIOD, PITCH_MIN_PERIOD,
@@ -453,44 +473,90 @@ void pitch_filter(kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const
   }
 }
 
-float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
-  int i;
-  kiss_fft_cpx X[FREQ_SIZE];
-  kiss_fft_cpx P[WINDOW_SIZE];
+static void process_frame_begin(DenoiseState *st, const float *in) {
+  FrameState *f = &st->frame;
   float x[FRAME_SIZE];
-  float Ex[NB_BANDS], Ep[NB_BANDS];
-  float Exp[NB_BANDS];
-  float features[NB_FEATURES];
-  float g[NB_BANDS];
-  float gf[FREQ_SIZE]={1};
-  float vad_prob = 0;
-  int silence;
   static const float a_hp[2] = {-1.99599f, 0.99600f};
   static const float b_hp[2] = {-2, 1};
   biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-  silence = compute_frame_features(st, X, P, Ex, Ep, Exp, features, x);
+  f->vad_prob = 0;
+  f->silence = compute_frame_features(st, f->X, f->P, f->Ex, f->Ep, f->Exp, f->features, x);
+}
 
-  if (!silence) {
-    compute_rnn(&st->rnn, g, &vad_prob, features);
-    pitch_filter(X, P, Ex, Ep, Exp, g);
+static void process_frame_end(DenoiseState *st, float *out) {
+  int i;
+  FrameState *f = &st->frame;
+  float gf[FREQ_SIZE]={1};
+  if (!f->silence) {
+    pitch_filter(f->X, f->P, f->Ex, f->Ep, f->Exp, f->g);
     for (i=0;i<NB_BANDS;i++) {
       float alpha = .6f;
-      g[i] = MAX16(g[i], alpha*st->lastg[i]);
-      st->lastg[i] = g[i];
+      f->g[i] = MAX16(f->g[i], alpha*st->lastg[i]);
+      st->lastg[i] = f->g[i];
     }
-    interp_band_gain(gf, g);
+    interp_band_gain(gf, f->g);
 #if 1
     for (i=0;i<FREQ_SIZE;i++) {
-      X[i].r *= gf[i];
-      X[i].i *= gf[i];
+      f->X[i].r *= gf[i];
+      f->X[i].i *= gf[i];
     }
 #endif
   }
 
-  frame_synthesis(st, out, X);
+  frame_synthesis(st, out, f->X);
+}
+
+float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
+  float vad_prob;
+  rnnoise_process_frames(&st, &out, &in, &vad_prob, 1);
   return vad_prob;
 }
 
+void rnnoise_process_frames(DenoiseState **st, float **out, const float **in, float *vad, int count) {
+  while (count > 0) {
+    int i;
+    int batch = IMIN(count, RNN_MAX_BATCH);
+    int active = 0;
+    int arch = RNN_ARCH_DEFAULT;
+    RNNState *rnn[RNN_MAX_BATCH];
+    float *gains[RNN_MAX_BATCH];
+    float *vad_probs[RNN_MAX_BATCH];
+    const float *features[RNN_MAX_BATCH];
+
+    /* Analyze every frame first, then evaluate the network once for all
+       non-silent frames, then apply the gains and synthesize. Each state
+       only reads its own input before writing its own output, so in-place
+       processing (out[i] == in[i]) still works. */
+    for (i=0;i<batch;i++) {
+      FrameState *f = &st[i]->frame;
+      process_frame_begin(st[i], in[i]);
+      if (st[i]->arch != arch)
+        arch = RNN_ARCH_C;
+      if (!f->silence) {
+        rnn[active] = &st[i]->rnn;
+        gains[active] = f->g;
+        vad_probs[active] = &f->vad_prob;
+        features[active] = f->features;
+        active++;
+      }
+    }
+    if (active)
+      compute_rnn_batch(rnn, gains, vad_probs, features, active, arch);
+    for (i=0;i<batch;i++) {
+      process_frame_end(st[i], out[i]);
+      if (vad)
+        vad[i] = st[i]->frame.vad_prob;
+    }
+
+    st += batch;
+    out += batch;
+    in += batch;
+    if (vad)
+      vad += batch;
+    count -= batch;
+  }
+}
+
 #if TRAINING
 
 static float uni_rand() {
@@ -39,10 +39,10 @@
 #include "arch.h"
 
 void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
-      int len, int C);
+      int len, int C, int arch);
 
 void pitch_search(const opus_val16 *x_lp, opus_val16 *y,
-                  int len, int max_pitch, int *pitch);
+                  int len, int max_pitch, int *pitch, int arch);
 
 opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
       int N, int *T0, int prev_period, opus_val16 prev_gain);
@@ -50,7 +50,22 @@ opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
 
 /* OPT: This is the kernel you really want to optimize. It gets used a lot
    by the prefilter and by the PLC. */
-static OPUS_INLINE void xcorr_kernel(const opus_val16 * x, const opus_val16 * y, opus_val32 sum[4], int len)
+#ifdef RNN_ENABLE_SIMD
+/* Same accumulation order per lag as the scalar kernel below, so the
+   results are identical; only the four lags are computed in one vector. */
+static OPUS_INLINE void xcorr_kernel_simd(const opus_val16 * x, const opus_val16 * y, opus_val32 sum[4], int len)
+{
+   int j;
+   __m128 acc;
+   celt_assert(len>=3);
+   acc = _mm_loadu_ps(sum);
+   for (j=0;j<len;j++)
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(x[j]), _mm_loadu_ps(y+j)));
+   _mm_storeu_ps(sum, acc);
+}
+#endif
+
+static OPUS_INLINE void xcorr_kernel_c(const opus_val16 * x, const opus_val16 * y, opus_val32 sum[4], int len)
 {
    int j;
    opus_val16 y_0, y_1, y_2, y_3;
@@ -116,6 +131,18 @@ static OPUS_INLINE void xcorr_kernel(const opus_val16 * x, const opus_val16 * y,
    }
 }
 
+static OPUS_INLINE void xcorr_kernel(const opus_val16 * x, const opus_val16 * y, opus_val32 sum[4], int len, int arch)
+{
+#ifdef RNN_ENABLE_SIMD
+   if (arch == RNN_ARCH_SIMD) {
+      xcorr_kernel_simd(x, y, sum, len);
+      return;
+   }
+#endif
+   (void)arch;
+   xcorr_kernel_c(x, y, sum, len);
+}
+
 static OPUS_INLINE void dual_inner_prod(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
       int N, opus_val32 *xy1, opus_val32 *xy2)
 {
@@ -144,6 +171,6 @@ static OPUS_INLINE opus_val32 celt_inner_prod(const opus_val16 *x,
 }
 
 void celt_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
-      opus_val32 *xcorr, int len, int max_pitch);
+      opus_val32 *xcorr, int len, int max_pitch, int arch);
 
 #endif
@@ -36,7 +36,9 @@
 #include "tansig_table.h"
 #include "rnn.h"
 #include "rnn_data.h"
+#include "rnnoise.h"
 #include <stdio.h>
+#include <string.h>
 
 static OPUS_INLINE float tansig_approx(float x)
 {
@@ -76,103 +78,204 @@ static OPUS_INLINE float relu(float x)
    return x < 0 ? 0 : x;
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+#ifdef RNN_ENABLE_SIMD
+/* Loads four consecutive int8 weights and converts them to float. */
+static OPUS_INLINE __m128 load_weights4(const rnn_weight *w)
 {
-   int i, j;
-   int N, M;
-   int stride;
-   M = layer->nb_inputs;
-   N = layer->nb_neurons;
-   stride = N;
-   for (i=0;i<N;i++)
+   int packed;
+   __m128i v;
+   memcpy(&packed, w, sizeof(packed));
+   v = _mm_cvtsi32_si128(packed);
+   v = _mm_unpacklo_epi8(v, v);
+   v = _mm_unpacklo_epi16(v, v);
+   return _mm_cvtepi32_ps(_mm_srai_epi32(v, 24));
+}
+#endif
+
+/* Computes sum[c][i] += weights[j*stride + i]*input[c][j] (times
+   scale[c][j] when scale is non-NULL) for all i < N, j < M and each of the
+   count frames in the batch. The weights are stored with the neuron index
+   contiguous, so the SIMD path evaluates four neurons per iteration and
+   converts each group of weights once for the whole batch, while keeping
+   the per-neuron accumulation order of the scalar code, which makes both
+   paths (and any batch size) produce identical results. */
+static void accumulate_weights(float **sum, const rnn_weight *weights,
+      int stride, const float **input, const float **scale, int M, int N,
+      int count, int arch)
+{
+   int i = 0, j, c;
+   (void)arch;
+#ifdef RNN_ENABLE_SIMD
+   for (;arch == RNN_ARCH_SIMD && i<N-3;i+=4)
    {
-      /* Compute update gate. */
-      float sum = layer->bias[i];
-      for (j=0;j<M;j++)
-         sum += layer->input_weights[j*stride + i]*input[j];
-      output[i] = WEIGHTS_SCALE*sum;
+      const rnn_weight *w = weights + i;
+      __m128 acc[RNN_MAX_BATCH];
+      for (c=0;c<count;c++)
+         acc[c] = _mm_loadu_ps(&sum[c][i]);
+      for (j=0;j<M;j++, w+=stride) {
+         __m128 wv = load_weights4(w);
+         if (scale) {
+            for (c=0;c<count;c++) {
+               __m128 prod = _mm_mul_ps(wv, _mm_set1_ps(input[c][j]));
+               acc[c] = _mm_add_ps(acc[c], _mm_mul_ps(prod, _mm_set1_ps(scale[c][j])));
+            }
+         } else {
+            for (c=0;c<count;c++)
+               acc[c] = _mm_add_ps(acc[c], _mm_mul_ps(wv, _mm_set1_ps(input[c][j])));
+         }
+      }
+      for (c=0;c<count;c++)
+         _mm_storeu_ps(&sum[c][i], acc[c]);
    }
-   if (layer->activation == ACTIVATION_SIGMOID) {
+#endif
+   for (;i<N;i++)
+   {
+      for (c=0;c<count;c++)
+      {
+         float s = sum[c][i];
+         if (scale) {
+            for (j=0;j<M;j++)
+               s += weights[j*stride + i]*input[c][j]*scale[c][j];
+         } else {
+            for (j=0;j<M;j++)
+               s += weights[j*stride + i]*input[c][j];
+         }
+         sum[c][i] = s;
+      }
+   }
+}
+
+static void apply_activation(int activation, float *x, int N)
+{
+   int i;
+   if (activation == ACTIVATION_SIGMOID) {
       for (i=0;i<N;i++)
-         output[i] = sigmoid_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_TANH) {
+         x[i] = sigmoid_approx(x[i]);
+   } else if (activation == ACTIVATION_TANH) {
       for (i=0;i<N;i++)
-         output[i] = tansig_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_RELU) {
+         x[i] = tansig_approx(x[i]);
+   } else if (activation == ACTIVATION_RELU) {
       for (i=0;i<N;i++)
-         output[i] = relu(output[i]);
+         x[i] = relu(x[i]);
    } else {
      *(int*)0=0;
    }
 }
 
-static void compute_gru(const GRULayer *gru, float *state, const float *input)
+static void compute_dense(const DenseLayer *layer, float **output, const float **input, int count, int arch)
+{
+   int i, c;
+   int N, M;
+   int stride;
+   M = layer->nb_inputs;
+   N = layer->nb_neurons;
+   stride = N;
+   for (c=0;c<count;c++)
+      for (i=0;i<N;i++)
+         output[c][i] = layer->bias[i];
+   accumulate_weights(output, layer->input_weights, stride, input, NULL, M, N, count, arch);
+   for (c=0;c<count;c++)
+   {
+      for (i=0;i<N;i++)
+         output[c][i] = WEIGHTS_SCALE*output[c][i];
+      apply_activation(layer->activation, output[c], N);
+   }
+}
+
+static void compute_gru(const GRULayer *gru, float **state, const float **input, int count, int arch)
 {
-   int i, j;
+   int i, c;
    int N, M;
    int stride;
-   float z[MAX_NEURONS];
-   float r[MAX_NEURONS];
-   float h[MAX_NEURONS];
+   float z[RNN_MAX_BATCH][MAX_NEURONS];
+   float r[RNN_MAX_BATCH][MAX_NEURONS];
+   float h[RNN_MAX_BATCH][MAX_NEURONS];
+   float *zp[RNN_MAX_BATCH], *rp[RNN_MAX_BATCH], *hp[RNN_MAX_BATCH];
    M = gru->nb_inputs;
    N = gru->nb_neurons;
    stride = 3*N;
-   for (i=0;i<N;i++)
+   for (c=0;c<count;c++)
    {
-      /* Compute update gate. */
-      float sum = gru->bias[i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[j*stride + i]*state[j];
-      z[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      zp[c] = z[c];
+      rp[c] = r[c];
+      hp[c] = h[c];
+      for (i=0;i<N;i++)
+      {
+         z[c][i] = gru->bias[i];
+         r[c][i] = gru->bias[N + i];
+         h[c][i] = gru->bias[2*N + i];
+      }
    }
-   for (i=0;i<N;i++)
+   /* Compute update gate. */
+   accumulate_weights(zp, gru->input_weights, stride, input, NULL, M, N, count, arch);
+   accumulate_weights(zp, gru->recurrent_weights, stride, (const float **)state, NULL, N, N, count, arch);
+   /* Compute reset gate. */
+   accumulate_weights(rp, gru->input_weights + N, stride, input, NULL, M, N, count, arch);
+   accumulate_weights(rp, gru->recurrent_weights + N, stride, (const float **)state, NULL, N, N, count, arch);
+   for (c=0;c<count;c++)
    {
-      /* Compute reset gate. */
-      float sum = gru->bias[N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[N + j*stride + i]*state[j];
-      r[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+      for (i=0;i<N;i++)
+      {
+         z[c][i] = sigmoid_approx(WEIGHTS_SCALE*z[c][i]);
+         r[c][i] = sigmoid_approx(WEIGHTS_SCALE*r[c][i]);
+      }
    }
-   for (i=0;i<N;i++)
+   /* Compute output. */
+   accumulate_weights(hp, gru->input_weights + 2*N, stride, input, NULL, M, N, count, arch);
+   accumulate_weights(hp, gru->recurrent_weights + 2*N, stride, (const float **)state, (const float **)rp, N, N, count, arch);
+   for (c=0;c<count;c++)
    {
-      /* Compute output. */
-      float sum = gru->bias[2*N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[2*N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[2*N + j*stride + i]*state[j]*r[j];
-      if (gru->activation == ACTIVATION_SIGMOID) sum = sigmoid_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_TANH) sum = tansig_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_RELU) sum = relu(WEIGHTS_SCALE*sum);
-      else *(int*)0=0;
-      h[i] = z[i]*state[i] + (1-z[i])*sum;
+      for (i=0;i<N;i++)
+         h[c][i] = WEIGHTS_SCALE*h[c][i];
+      apply_activation(gru->activation, h[c], N);
+      for (i=0;i<N;i++)
+         state[c][i] = z[c][i]*state[c][i] + (1-z[c][i])*h[c][i];
    }
-   for (i=0;i<N;i++)
-      state[i] = h[i];
 }
 
 #define INPUT_SIZE 42
 
-void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input) {
-  int i;
-  float dense_out[MAX_NEURONS];
-  float noise_input[MAX_NEURONS*3];
-  float denoise_input[MAX_NEURONS*3];
-  compute_dense(rnn->model->input_dense, dense_out, input);
-  compute_gru(rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-  compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
-  for (i=0;i<rnn->model->input_dense_size;i++) noise_input[i] = dense_out[i];
-  for (i=0;i<rnn->model->vad_gru_size;i++) noise_input[i+rnn->model->input_dense_size] = rnn->vad_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) noise_input[i+rnn->model->input_dense_size+rnn->model->vad_gru_size] = input[i];
-  compute_gru(rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
-
-  for (i=0;i<rnn->model->vad_gru_size;i++) denoise_input[i] = rnn->vad_gru_state[i];
-  for (i=0;i<rnn->model->noise_gru_size;i++) denoise_input[i+rnn->model->vad_gru_size] = rnn->noise_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) denoise_input[i+rnn->model->vad_gru_size+rnn->model->noise_gru_size] = input[i];
-  compute_gru(rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-  compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+void compute_rnn_batch(RNNState **rnn, float **gains, float **vad, const float **input, int count, int arch) {
+  int i, c;
+  const RNNModel *model = rnn[0]->model;
+  float dense_out[RNN_MAX_BATCH][MAX_NEURONS];
+  float noise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float denoise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float *dense_out_p[RNN_MAX_BATCH];
+  float *noise_input_p[RNN_MAX_BATCH];
+  float *denoise_input_p[RNN_MAX_BATCH];
+  float *vad_state[RNN_MAX_BATCH];
+  float *noise_state[RNN_MAX_BATCH];
+  float *denoise_state[RNN_MAX_BATCH];
+  celt_assert(count <= RNN_MAX_BATCH);
+  for (c=0;c<count;c++) {
+    celt_assert(rnn[c]->model == model);
+    dense_out_p[c] = dense_out[c];
+    noise_input_p[c] = noise_input[c];
+    denoise_input_p[c] = denoise_input[c];
+    vad_state[c] = rnn[c]->vad_gru_state;
+    noise_state[c] = rnn[c]->noise_gru_state;
+    denoise_state[c] = rnn[c]->denoise_gru_state;
+  }
+  compute_dense(model->input_dense, dense_out_p, input, count, arch);
+  compute_gru(model->vad_gru, vad_state, (const float **)dense_out_p, count, arch);
+  compute_dense(model->vad_output, vad, (const float **)vad_state, count, arch);
+  for (c=0;c<count;c++) {
+    for (i=0;i<model->input_dense_size;i++) noise_input[c][i] = dense_out[c][i];
+    for (i=0;i<model->vad_gru_size;i++) noise_input[c][i+model->input_dense_size] = vad_state[c][i];
+    for (i=0;i<INPUT_SIZE;i++) noise_input[c][i+model->input_dense_size+model->vad_gru_size] = input[c][i];
+  }
+  compute_gru(model->noise_gru, noise_state, (const float **)noise_input_p, count, arch);
+
+  for (c=0;c<count;c++) {
+    for (i=0;i<model->vad_gru_size;i++) denoise_input[c][i] = vad_state[c][i];
+    for (i=0;i<model->noise_gru_size;i++) denoise_input[c][i+model->vad_gru_size] = noise_state[c][i];
+    for (i=0;i<INPUT_SIZE;i++) denoise_input[c][i+model->vad_gru_size+model->noise_gru_size] = input[c][i];
+  }
+  compute_gru(model->denoise_gru, denoise_state, (const float **)denoise_input_p, count, arch);
+  compute_dense(model->denoise_output, gains, (const float **)denoise_state, count, arch);
+}
+
+void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input, int arch) {
+  compute_rnn_batch(&rnn, &gains, &vad, &input, 1, arch);
 }
@@ -35,6 +35,9 @@
 
 #define MAX_NEURONS 128
 
+/* Maximum number of frames evaluated together by compute_rnn_batch(). */
+#define RNN_MAX_BATCH 8
+
 #define ACTIVATION_TANH    0
 #define ACTIVATION_SIGMOID 1
 #define ACTIVATION_RELU    2
@@ -60,6 +63,11 @@ typedef struct {
 
 typedef struct RNNState RNNState;
 
-void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input);
+void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input, int arch);
+
+/* Evaluates the network for count (<= RNN_MAX_BATCH) independent states that
+   share the same model, reusing each weight load across the whole batch.
+   arch selects the kernels (RNN_ARCH_*). */
+void compute_rnn_batch(RNNState **rnn, float **gains, float **vad, const float **input, int count, int arch);
 
 #endif /* _MLP_H_ */
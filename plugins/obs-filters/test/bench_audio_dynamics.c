@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <util/platform.h>
+#include <media-io/audio-math.h>
+
+#include "audio-dynamics.h"
+
+/* compares the vectorized gain computer of the compressor and limiter
+ * filters with the per-sample log10f/powf version they replaced, and times
+ * the look-ahead limiter, not part of the test suite */
+
+#define BENCH_CHANNELS 2
+#define BENCH_FRAMES 1024
+#define BENCH_BLOCKS 4000 /* about 85 s of 48 kHz audio */
+
+static uint32_t rand_state = 1;
+
+static float noise(void)
+{
+	rand_state = rand_state * 1664525 + 1013904223;
+	return (float)(rand_state >> 8) / (float)(1 << 24) - 0.5f;
+}
+
+static void scalar_gain(float *gain, const float *env, uint32_t frames,
+			float threshold, float slope, float output_gain)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		float g = slope * (threshold - mul_to_db(env[i]));
+		gain[i] = db_to_mul(fminf(0, g)) * output_gain;
+	}
+}
+
+static void lookahead_limit(struct dyn_lookahead *la,
+			    struct dyn_detector *det, float **samples,
+			    float *required, float *gain, float threshold)
+{
+	dyn_detect_peak(det, required, samples, BENCH_CHANNELS, BENCH_FRAMES);
+	for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+		required[i] = fminf(threshold / required[i], 1.0f);
+
+	dyn_lookahead_gain(la, gain, required, BENCH_FRAMES, 0.9983f);
+	dyn_lookahead_delay(la, samples, BENCH_FRAMES);
+	dyn_apply_gain(samples, BENCH_CHANNELS, gain, BENCH_FRAMES);
+}
+
+int main(void)
+{
+	float *samples[BENCH_CHANNELS];
+	float env[BENCH_FRAMES];
+	float gain[BENCH_FRAMES];
+	float required[BENCH_FRAMES];
+	struct dyn_detector det = {.true_peak = true};
+	struct dyn_lookahead la = {0};
+	uint64_t start, scalar_time, simd_time, lookahead_time;
+	float envelope = 0.0f;
+	double checksum = 0.0;
+
+	for (size_t c = 0; c < BENCH_CHANNELS; c++) {
+		samples[c] = malloc(BENCH_FRAMES * sizeof(float));
+		for (size_t i = 0; i < BENCH_FRAMES; i++)
+			samples[c][i] = 2.0f * noise();
+	}
+
+	dyn_peak_envelope(env, samples, BENCH_CHANNELS, BENCH_FRAMES,
+			  &envelope, 0.0f, 0.9983f);
+
+	start = os_gettime_ns();
+	for (int b = 0; b < BENCH_BLOCKS; b++) {
+		scalar_gain(gain, env, BENCH_FRAMES, -6.0f, 1.0f, 1.0f);
+		checksum += gain[b % BENCH_FRAMES];
+	}
+	scalar_time = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int b = 0; b < BENCH_BLOCKS; b++) {
+		dyn_compressor_gain(gain, env, BENCH_FRAMES, -6.0f, 1.0f,
+				    1.0f);
+		checksum += gain[b % BENCH_FRAMES];
+	}
+	simd_time = os_gettime_ns() - start;
+
+	dyn_lookahead_init(&la, BENCH_CHANNELS, 240);
+	start = os_gettime_ns();
+	for (int b = 0; b < BENCH_BLOCKS; b++) {
+		lookahead_limit(&la, &det, samples, required, gain,
+				db_to_mul(-6.0f));
+		checksum += samples[0][b % BENCH_FRAMES];
+	}
+	lookahead_time = os_gettime_ns() - start;
+
+	printf("gain computer, %d x %d frames:\n", BENCH_BLOCKS,
+	       BENCH_FRAMES);
+	printf("  scalar:     %.1f ms\n", scalar_time / 1000000.0);
+	printf("  vectorized: %.1f ms\n", simd_time / 1000000.0);
+	printf("look-ahead limiter, %d channels, true peak: %.1f ms\n",
+	       BENCH_CHANNELS, lookahead_time / 1000000.0);
+	printf("(checksum %g)\n", checksum);
+
+	dyn_lookahead_free(&la);
+	dyn_detector_free(&det);
+	for (size_t c = 0; c < BENCH_CHANNELS; c++)
+		free(samples[c]);
+
+	return 0;
+}
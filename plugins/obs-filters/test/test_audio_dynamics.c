@@ -0,0 +1,396 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <media-io/audio-math.h>
+
+#include "audio-dynamics.h"
+
+#define TEST_CHANNELS 2
+#define TEST_FRAMES 1031 /* not a multiple of the vector width */
+#define TEST_BLOCKS 8
+
+/* the vectorized log/exp approximations are accurate to a few ulp, the
+ * gains are compared relative to the scalar log10f/powf reference */
+#define MAX_RELATIVE_ERROR 1e-4f
+
+static uint32_t rand_state;
+
+static float noise(void)
+{
+	rand_state = rand_state * 1664525 + 1013904223;
+	return (float)(rand_state >> 8) / (float)(1 << 24) - 0.5f;
+}
+
+/* bursts of noise at levels from far below to above full scale, with
+ * stretches of digital silence so the gain computer sees zero envelopes */
+static void generate_block(float **samples, uint32_t block)
+{
+	static const float levels[] = {0.0f, 0.001f, 0.05f, 0.5f, 1.0f, 2.0f};
+
+	for (size_t c = 0; c < TEST_CHANNELS; c++) {
+		for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+			size_t level = ((block * TEST_FRAMES + i) / 300 + c) %
+				       (sizeof(levels) / sizeof(levels[0]));
+			samples[c][i] = levels[level] * 2.0f * noise();
+		}
+	}
+}
+
+static float **alloc_channels(void)
+{
+	float **samples = calloc(TEST_CHANNELS, sizeof(float *));
+
+	for (size_t c = 0; c < TEST_CHANNELS; c++)
+		samples[c] = calloc(TEST_FRAMES, sizeof(float));
+	return samples;
+}
+
+static void free_channels(float **samples)
+{
+	for (size_t c = 0; c < TEST_CHANNELS; c++)
+		free(samples[c]);
+	free(samples);
+}
+
+static void copy_channels(float **dst, float **src)
+{
+	for (size_t c = 0; c < TEST_CHANNELS; c++)
+		memcpy(dst[c], src[c], TEST_FRAMES * sizeof(float));
+}
+
+static void assert_close(float **ref, float **out, float **in)
+{
+	for (size_t c = 0; c < TEST_CHANNELS; c++) {
+		for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+			/* compare the gains, not the samples */
+			float scale = fmaxf(fabsf(in[c][i]), 1e-20f);
+			float diff = fabsf(ref[c][i] - out[c][i]) / scale;
+			float tolerance =
+				MAX_RELATIVE_ERROR * fabsf(ref[c][i]) / scale;
+
+			assert_true(diff <= fmaxf(tolerance, 1e-7f));
+		}
+	}
+}
+
+/* -------------------------------------------------------- */
+/* scalar reference implementations, as the filters computed them before
+ * they moved to the shared vectorized helpers */
+
+static void ref_peak_envelope(float *env_buf, float **samples,
+			      uint32_t frames, float *envelope,
+			      float attack_gain, float release_gain)
+{
+	memset(env_buf, 0, frames * sizeof(env_buf[0]));
+	for (size_t chan = 0; chan < TEST_CHANNELS; ++chan) {
+		float env = *envelope;
+		for (uint32_t i = 0; i < frames; ++i) {
+			const float env_in = fabsf(samples[chan][i]);
+			if (env < env_in) {
+				env = env_in + attack_gain * (env - env_in);
+			} else {
+				env = env_in + release_gain * (env - env_in);
+			}
+			env_buf[i] = fmaxf(env_buf[i], env);
+		}
+	}
+	*envelope = env_buf[frames - 1];
+}
+
+static void ref_compression(const float *env_buf, float **samples,
+			    uint32_t frames, float threshold, float slope,
+			    float output_gain)
+{
+	for (size_t i = 0; i < frames; ++i) {
+		const float env_db = mul_to_db(env_buf[i]);
+		float gain = slope * (threshold - env_db);
+		gain = db_to_mul(fminf(0, gain));
+
+		for (size_t c = 0; c < TEST_CHANNELS; ++c)
+			samples[c][i] *= gain * output_gain;
+	}
+}
+
+static void ref_expansion(float **samples, uint32_t frames, float *gain_db,
+			  float threshold, float slope, float attack_gain,
+			  float release_gain, float output_gain)
+{
+	for (size_t chan = 0; chan < TEST_CHANNELS; chan++) {
+		float prev = gain_db[chan];
+
+		for (size_t i = 0; i < frames; ++i) {
+			float env_db = mul_to_db(fabsf(samples[chan][i]));
+			float gain = threshold - env_db > 0.0f
+					     ? fmaxf(slope * (threshold -
+							      env_db),
+						     -60.0f)
+					     : 0.0f;
+			if (gain > prev)
+				prev = attack_gain * prev +
+				       (1.0f - attack_gain) * gain;
+			else
+				prev = release_gain * prev +
+				       (1.0f - release_gain) * gain;
+
+			gain = db_to_mul(fminf(0, prev));
+			samples[chan][i] *= gain * output_gain;
+		}
+		gain_db[chan] = prev;
+	}
+}
+
+/* -------------------------------------------------------- */
+
+static void run_compressor(float threshold, float slope, float attack_gain,
+			   float release_gain, float output_gain)
+{
+	float **in = alloc_channels();
+	float **ref = alloc_channels();
+	float **out = alloc_channels();
+	float *ref_env = calloc(TEST_FRAMES, sizeof(float));
+	float *env = calloc(TEST_FRAMES, sizeof(float));
+	float ref_envelope = 0.0f;
+	float envelope = 0.0f;
+
+	rand_state = 1;
+
+	for (uint32_t block = 0; block < TEST_BLOCKS; block++) {
+		generate_block(in, block);
+		copy_channels(ref, in);
+		copy_channels(out, in);
+
+		ref_peak_envelope(ref_env, ref, TEST_FRAMES, &ref_envelope,
+				  attack_gain, release_gain);
+		ref_compression(ref_env, ref, TEST_FRAMES, threshold, slope,
+				output_gain);
+
+		dyn_peak_envelope(env, out, TEST_CHANNELS, TEST_FRAMES,
+				  &envelope, attack_gain, release_gain);
+
+		/* the envelope follower is not vectorized, it has to match
+		 * exactly */
+		assert_memory_equal(ref_env, env, TEST_FRAMES * sizeof(float));
+		assert_true(ref_envelope == envelope);
+
+		dyn_compressor_gain(env, env, TEST_FRAMES, threshold, slope,
+				    output_gain);
+		dyn_apply_gain(out, TEST_CHANNELS, env, TEST_FRAMES);
+
+		assert_close(ref, out, in);
+	}
+
+	free(ref_env);
+	free(env);
+	free_channels(in);
+	free_channels(ref);
+	free_channels(out);
+}
+
+static void compressor_test(void **state)
+{
+	/* ratio 10:1, fast attack, slow release, make-up gain */
+	run_compressor(-18.0f, 1.0f - 1.0f / 10.0f, 0.9958f, 0.9997f, 2.0f);
+	/* ratio 2:1 with unity output */
+	run_compressor(-6.0f, 0.5f, 0.9f, 0.99f, 1.0f);
+}
+
+static void limiter_test(void **state)
+{
+	/* the limiter is the compressor gain computer at an infinite ratio */
+	run_compressor(-6.0f, 1.0f, 0.0f, 0.9983f, 1.0f);
+	run_compressor(-30.0f, 1.0f, 0.0f, 0.99f, 4.0f);
+}
+
+static void limiter_detector_test(void **state)
+{
+	float **in = alloc_channels();
+	float *ref = calloc(TEST_FRAMES, sizeof(float));
+	float *out = calloc(TEST_FRAMES, sizeof(float));
+	struct dyn_detector det = {0};
+
+	rand_state = 2;
+
+	for (uint32_t block = 0; block < TEST_BLOCKS; block++) {
+		generate_block(in, block);
+
+		/* sample peak: maximum of the absolute values */
+		det.true_peak = false;
+		for (uint32_t i = 0; i < TEST_FRAMES; i++)
+			ref[i] = fmaxf(fabsf(in[0][i]), fabsf(in[1][i]));
+
+		dyn_detect_peak(&det, out, in, TEST_CHANNELS, TEST_FRAMES);
+		assert_memory_equal(ref, out, TEST_FRAMES * sizeof(float));
+
+		/* the true peak is never below the sample peak */
+		det.true_peak = true;
+		dyn_detect_peak(&det, out, in, TEST_CHANNELS, TEST_FRAMES);
+		for (uint32_t i = 0; i < TEST_FRAMES; i++)
+			assert_true(out[i] >= ref[i] * 0.999f);
+	}
+
+	dyn_detector_free(&det);
+	free(ref);
+	free(out);
+	free_channels(in);
+}
+
+/* look-ahead mode of the limiter filter: whatever the input, no output
+ * sample may exceed the threshold */
+static void run_lookahead_limiter(float threshold_db, size_t lookahead,
+				  bool true_peak, float release_gain)
+{
+	const float threshold = db_to_mul(threshold_db);
+	float **samples = alloc_channels();
+	float *required = calloc(TEST_FRAMES, sizeof(float));
+	float *gain = calloc(TEST_FRAMES, sizeof(float));
+	struct dyn_detector det = {.true_peak = true_peak};
+	struct dyn_lookahead la = {0};
+	float peak = 0.0f;
+
+	dyn_lookahead_init(&la, TEST_CHANNELS, lookahead);
+	rand_state = 4;
+
+	for (uint32_t block = 0; block < TEST_BLOCKS * 4; block++) {
+		/* odd block sizes so the window straddles block boundaries */
+		uint32_t frames = TEST_FRAMES - (block * 97) % 500;
+
+		generate_block(samples, block);
+
+		dyn_detect_peak(&det, required, samples, TEST_CHANNELS,
+				frames);
+		for (uint32_t i = 0; i < frames; i++)
+			required[i] = fminf(threshold / required[i], 1.0f);
+
+		dyn_lookahead_gain(&la, gain, required, frames, release_gain);
+		dyn_lookahead_delay(&la, samples, frames);
+		dyn_apply_gain(samples, TEST_CHANNELS, gain, frames);
+
+		for (size_t c = 0; c < TEST_CHANNELS; c++) {
+			for (uint32_t i = 0; i < frames; i++) {
+				float level = fabsf(samples[c][i]);
+				assert_true(level <= threshold * 1.00001f);
+				peak = fmaxf(peak, level);
+			}
+		}
+	}
+
+	/* the input goes well above the threshold, so it has to be reached */
+	assert_true(peak > threshold * 0.5f);
+
+	dyn_lookahead_free(&la);
+	dyn_detector_free(&det);
+	free(required);
+	free(gain);
+	free_channels(samples);
+}
+
+static void lookahead_limiter_test(void **state)
+{
+	run_lookahead_limiter(-6.0f, 240, false, 0.9983f);
+	run_lookahead_limiter(-1.0f, 48, true, 0.999f);
+	run_lookahead_limiter(-20.0f, 1, false, 0.0f);
+}
+
+static void expander_test(void **state)
+{
+	const float threshold = -40.0f;
+	const float slope = 2.0f - 1.0f;
+	const float attack_gain = 0.9958f;
+	const float release_gain = 0.9997f;
+	const float output_gain = 1.0f;
+
+	float **in = alloc_channels();
+	float **ref = alloc_channels();
+	float **out = alloc_channels();
+	float *scratch = calloc(TEST_FRAMES, sizeof(float));
+	float *gain_db = calloc(TEST_FRAMES, sizeof(float));
+	float ref_state[TEST_CHANNELS] = {0};
+	float state_db[TEST_CHANNELS] = {0};
+
+	rand_state = 3;
+
+	for (uint32_t block = 0; block < TEST_BLOCKS; block++) {
+		generate_block(in, block);
+		copy_channels(ref, in);
+		copy_channels(out, in);
+
+		ref_expansion(ref, TEST_FRAMES, ref_state, threshold, slope,
+			      attack_gain, release_gain, output_gain);
+
+		/* same stages as the expander filter with peak detection */
+		for (size_t chan = 0; chan < TEST_CHANNELS; chan++) {
+			float prev = state_db[chan];
+
+			for (uint32_t i = 0; i < TEST_FRAMES; i++)
+				scratch[i] = fabsf(out[chan][i]);
+			dyn_mul_to_db(scratch, scratch, TEST_FRAMES);
+
+			for (uint32_t i = 0; i < TEST_FRAMES; i++) {
+				const float env_db = scratch[i];
+				const float gain =
+					threshold - env_db > 0.0f
+						? fmaxf(slope * (threshold -
+								 env_db),
+							-60.0f)
+						: 0.0f;
+				if (gain > prev)
+					prev = attack_gain * prev +
+					       (1.0f - attack_gain) * gain;
+				else
+					prev = release_gain * prev +
+					       (1.0f - release_gain) * gain;
+				gain_db[i] = prev;
+			}
+			state_db[chan] = prev;
+
+			dyn_db_to_gain(scratch, gain_db, TEST_FRAMES,
+				       output_gain);
+			dyn_apply_gain(&out[chan], 1, scratch, TEST_FRAMES);
+		}
+
+		assert_close(ref, out, in);
+	}
+
+	free(scratch);
+	free(gain_db);
+	free_channels(in);
+	free_channels(ref);
+	free_channels(out);
+}
+
+static void empty_block_test(void **state)
+{
+	float *samples[TEST_CHANNELS] = {NULL, NULL};
+	struct dyn_detector det = {.true_peak = true};
+	float envelope = 0.25f;
+	float env;
+
+	/* nothing may be read or written for a block without frames */
+	dyn_peak_envelope(&env, samples, TEST_CHANNELS, 0, &envelope, 0.5f,
+			  0.5f);
+	assert_true(envelope == 0.25f);
+
+	dyn_detect_peak(&det, &env, samples, TEST_CHANNELS, 0);
+	assert_null(det.scratch);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(compressor_test),
+		cmocka_unit_test(limiter_test),
+		cmocka_unit_test(limiter_detector_test),
+		cmocka_unit_test(lookahead_limiter_test),
+		cmocka_unit_test(expander_test),
+		cmocka_unit_test(empty_block_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
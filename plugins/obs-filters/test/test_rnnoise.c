@@ -0,0 +1,164 @@
+#define _USE_MATH_DEFINES
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <rnnoise.h>
+
+#define FRAME_SIZE 480
+#define TEST_FRAMES 500
+#define TEST_CHANNELS 2
+
+/* the vectorized kernels keep the accumulation order of the scalar ones,
+ * this only leaves room for compilers contracting the scalar code to fused
+ * multiply-adds on some architectures.  samples are in 16-bit range. */
+#define MAX_DIFFERENCE 0.05f
+
+static uint32_t rand_state;
+
+static float noise(void)
+{
+	rand_state = rand_state * 1664525 + 1013904223;
+	return (float)(rand_state >> 8) / (float)(1 << 24) - 0.5f;
+}
+
+/* deterministic stand-in for a recording: a voiced signal with a moving
+ * pitch and vowel-like harmonics, gated like speech, over broadband noise
+ * and a mains hum, with a stretch of digital silence at the start */
+static void generate_signal(float *out, size_t frames, uint32_t seed)
+{
+	double phase = 0.0;
+
+	rand_state = seed;
+
+	for (size_t i = 0; i < frames * FRAME_SIZE; i++) {
+		double t = (double)i / 48000.0;
+		double pitch = 140.0 + 30.0 * sin(2.0 * M_PI * 0.7 * t);
+		double gate = sin(2.0 * M_PI * 2.5 * t) > 0.5 ? 1.0 : 0.0;
+		double voice = 0.0;
+
+		phase += 2.0 * M_PI * pitch / 48000.0;
+		for (int h = 1; h <= 12; h++)
+			voice += sin(phase * h) / h;
+
+		if (i < FRAME_SIZE * 20) {
+			out[i] = 0.0f;
+			continue;
+		}
+
+		out[i] = (float)(6000.0 * gate * voice +
+				 300.0 * sin(2.0 * M_PI * 50.0 * t)) +
+			 6000.0f * noise();
+	}
+}
+
+static void process(float *out, const float *in, size_t frames, bool simd)
+{
+	DenoiseState *st = rnnoise_create(NULL);
+
+	rnnoise_set_simd_enabled(st, simd);
+
+	for (size_t i = 0; i < frames; i++)
+		rnnoise_process_frame(st, out + i * FRAME_SIZE,
+				      in + i * FRAME_SIZE);
+
+	rnnoise_destroy(st);
+}
+
+static float max_difference(const float *a, const float *b, size_t count)
+{
+	float max = 0.0f;
+
+	for (size_t i = 0; i < count; i++) {
+		float diff = fabsf(a[i] - b[i]);
+		if (diff > max)
+			max = diff;
+	}
+
+	return max;
+}
+
+static void rnnoise_simd_test(void **state)
+{
+	size_t count = TEST_FRAMES * FRAME_SIZE;
+	float *in = malloc(count * sizeof(float));
+	float *ref = malloc(count * sizeof(float));
+	float *out = malloc(count * sizeof(float));
+
+	generate_signal(in, TEST_FRAMES, 1);
+
+	process(ref, in, TEST_FRAMES, false);
+	process(out, in, TEST_FRAMES, true);
+
+	/* the noise has to actually be reduced for the comparison to mean
+	 * anything */
+	double in_energy = 0.0, out_energy = 0.0;
+	for (size_t i = FRAME_SIZE * 20; i < count; i++) {
+		in_energy += (double)in[i] * in[i];
+		out_energy += (double)ref[i] * ref[i];
+	}
+	assert_true(out_energy < in_energy * 0.9);
+
+	assert_true(max_difference(ref, out, count) <= MAX_DIFFERENCE);
+
+	free(in);
+	free(ref);
+	free(out);
+}
+
+static void rnnoise_batch_test(void **state)
+{
+	size_t count = TEST_FRAMES * FRAME_SIZE;
+	DenoiseState *st[TEST_CHANNELS];
+	float *in[TEST_CHANNELS];
+	float *ref[TEST_CHANNELS];
+	float *out[TEST_CHANNELS];
+
+	for (int c = 0; c < TEST_CHANNELS; c++) {
+		in[c] = malloc(count * sizeof(float));
+		ref[c] = malloc(count * sizeof(float));
+		out[c] = malloc(count * sizeof(float));
+		st[c] = rnnoise_create(NULL);
+
+		generate_signal(in[c], TEST_FRAMES, c + 1);
+		process(ref[c], in[c], TEST_FRAMES, true);
+	}
+
+	for (size_t i = 0; i < TEST_FRAMES; i++) {
+		float *frame_out[TEST_CHANNELS];
+		const float *frame_in[TEST_CHANNELS];
+
+		for (int c = 0; c < TEST_CHANNELS; c++) {
+			frame_out[c] = out[c] + i * FRAME_SIZE;
+			frame_in[c] = in[c] + i * FRAME_SIZE;
+		}
+
+		rnnoise_process_frames(st, frame_out, frame_in, NULL,
+				       TEST_CHANNELS);
+	}
+
+	/* batching doesn't change the order of any computation */
+	for (int c = 0; c < TEST_CHANNELS; c++) {
+		assert_memory_equal(ref[c], out[c], count * sizeof(float));
+
+		rnnoise_destroy(st[c]);
+		free(in[c]);
+		free(ref[c]);
+		free(out[c]);
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(rnnoise_simd_test),
+		cmocka_unit_test(rnnoise_batch_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+
+#include <media-io/audio-mix.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+/* compares the audio mix kernels with plain loops for 2, 6 and 8 channel
+ * ticks, not part of the test suite.  the compiler may vectorize the plain
+ * loops as well, which is the baseline the kernels have to beat. */
+
+#define BENCH_FRAMES 1024 /* AUDIO_OUTPUT_FRAMES */
+#define BENCH_TICKS 20000 /* about 7 minutes of 48 kHz audio */
+#define MAX_CHANNELS 8
+
+static uint32_t rand_state = 1;
+
+static float noise(void)
+{
+	rand_state = rand_state * 1664525 + 1013904223;
+	return (float)(rand_state >> 8) / (float)(1 << 24) - 0.5f;
+}
+
+static void scalar_copy_gain(float *const dst[], const float *const src[],
+			     size_t channels, const float gain[], bool mono,
+			     size_t frames)
+{
+	for (size_t i = 0; i < frames; i++) {
+		float sum = 0.0f;
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			dst[ch][i] = src[ch][i] * gain[ch];
+			sum += dst[ch][i];
+		}
+		for (size_t ch = 0; mono && ch < channels; ch++)
+			dst[ch][i] = sum;
+	}
+}
+
+static void scalar_mul(float *data, float gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		data[i] *= gain;
+}
+
+static void scalar_mul_vec(float *data, const float *gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		data[i] *= gain[i];
+}
+
+static void scalar_add(float *dst, const float *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] += src[i];
+}
+
+struct bench_buffers {
+	float *src[MAX_CHANNELS];
+	float *dst[MAX_CHANNELS];
+	float *out[MAX_CHANNELS];
+	float gain[MAX_CHANNELS];
+	float gain_vec[BENCH_FRAMES];
+};
+
+/* one tick of a source: copy with gain (downmixing if mono), fade, then mix
+ * into the output.  the output keeps growing, but not enough to leave the
+ * normal range over the run. */
+static uint64_t run_ticks(struct bench_buffers *b, size_t channels, bool mono,
+			  bool scalar)
+{
+	uint64_t start = os_gettime_ns();
+
+	for (int t = 0; t < BENCH_TICKS; t++) {
+		if (scalar)
+			scalar_copy_gain(b->dst, (const float *const *)b->src,
+					 channels, b->gain, mono, BENCH_FRAMES);
+		else
+			audio_mix_copy_gain(b->dst,
+					    (const float *const *)b->src,
+					    channels, b->gain, mono,
+					    BENCH_FRAMES);
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			if (scalar) {
+				scalar_mul(b->dst[ch], 0.5f, BENCH_FRAMES);
+				scalar_mul_vec(b->dst[ch], b->gain_vec,
+					       BENCH_FRAMES);
+				scalar_add(b->out[ch], b->dst[ch],
+					   BENCH_FRAMES);
+			} else {
+				audio_mix_mul(b->dst[ch], 0.5f, BENCH_FRAMES);
+				audio_mix_mul_vec(b->dst[ch], b->gain_vec,
+						  BENCH_FRAMES);
+				audio_mix_add(b->out[ch], b->dst[ch],
+					      BENCH_FRAMES);
+			}
+		}
+	}
+
+	return os_gettime_ns() - start;
+}
+
+int main(void)
+{
+	static const size_t channel_counts[] = {2, 6, 8};
+	struct bench_buffers b;
+	double checksum = 0.0;
+
+	for (size_t ch = 0; ch < MAX_CHANNELS; ch++) {
+		b.src[ch] = bmalloc(BENCH_FRAMES * sizeof(float));
+		b.dst[ch] = bmalloc(BENCH_FRAMES * sizeof(float));
+		b.out[ch] = bzalloc(BENCH_FRAMES * sizeof(float));
+		b.gain[ch] = 0.9f;
+	}
+	for (size_t i = 0; i < BENCH_FRAMES; i++)
+		b.gain_vec[i] = 1.0f - (float)i / (BENCH_FRAMES * 4);
+
+	printf("%d ticks of %d frames:\n", BENCH_TICKS, BENCH_FRAMES);
+
+	for (size_t c = 0; c < sizeof(channel_counts) / sizeof(size_t); c++) {
+		size_t channels = channel_counts[c];
+
+		for (int mono = 0; mono < 2; mono++) {
+			uint64_t scalar_time, simd_time;
+
+			for (size_t ch = 0; ch < MAX_CHANNELS; ch++)
+				for (size_t i = 0; i < BENCH_FRAMES; i++)
+					b.src[ch][i] = noise();
+
+			scalar_time = run_ticks(&b, channels, mono, true);
+			checksum += b.out[0][c];
+			simd_time = run_ticks(&b, channels, mono, false);
+			checksum += b.out[0][c];
+
+			printf("  %zu channels%s: scalar %.1f ms, "
+			       "vectorized %.1f ms\n",
+			       channels, mono ? ", mono downmix" : "",
+			       scalar_time / 1000000.0,
+			       simd_time / 1000000.0);
+		}
+	}
+
+	printf("(checksum %g)\n", checksum);
+
+	for (size_t ch = 0; ch < MAX_CHANNELS; ch++) {
+		bfree(b.src[ch]);
+		bfree(b.dst[ch]);
+		bfree(b.out[ch]);
+	}
+
+	return 0;
+}
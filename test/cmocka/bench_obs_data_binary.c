@@ -0,0 +1,73 @@
+#include <stdio.h>
+
+#include <util/platform.h>
+
+#include "obs-data-fixtures.h"
+
+/* compares saving and loading a large collection as json and as binary,
+ * not part of the test suite */
+
+#define BENCH_SOURCES 20000
+
+int main(void)
+{
+	struct dstr json_path = {0};
+	struct dstr binary_path = {0};
+	obs_data_t *data = create_collection(BENCH_SOURCES);
+	obs_data_t *json_loaded, *binary_loaded;
+	uint64_t start, json_save, json_load, binary_save, binary_load;
+	int ret = 1;
+
+	temp_file_path(&json_path, "obs_data_binary_bench.json");
+	temp_file_path(&binary_path, "obs_data_binary_bench.bin");
+
+	start = os_gettime_ns();
+	if (!obs_data_save_json(data, json_path.array)) {
+		fprintf(stderr, "failed to write %s\n", json_path.array);
+		goto fail;
+	}
+	json_save = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	json_loaded = obs_data_create_from_json_file(json_path.array);
+	json_load = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	if (!obs_data_save_binary_safe(data, binary_path.array, "tmp", NULL)) {
+		fprintf(stderr, "failed to write %s\n", binary_path.array);
+		obs_data_release(json_loaded);
+		goto fail;
+	}
+	binary_save = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	binary_loaded =
+		obs_data_create_from_binary_file_safe(binary_path.array, NULL);
+	binary_load = os_gettime_ns() - start;
+
+	if (json_loaded && binary_loaded &&
+	    strcmp(obs_data_get_json(binary_loaded),
+		   obs_data_get_json(data)) == 0) {
+		printf("json:   %lld bytes, save %.1f ms, load %.1f ms\n",
+		       (long long)os_get_file_size(json_path.array),
+		       json_save / 1000000.0, json_load / 1000000.0);
+		printf("binary: %lld bytes, save %.1f ms, load %.1f ms\n",
+		       (long long)os_get_file_size(binary_path.array),
+		       binary_save / 1000000.0, binary_load / 1000000.0);
+		ret = 0;
+	} else {
+		fprintf(stderr, "loaded data does not match\n");
+	}
+
+	obs_data_release(json_loaded);
+	obs_data_release(binary_loaded);
+
+fail:
+	os_unlink(json_path.array);
+	os_unlink(binary_path.array);
+	dstr_free(&json_path);
+	dstr_free(&binary_path);
+	obs_data_release(data);
+
+	return ret;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "obs-data-fixtures.h"
+#include "obs-data-jansson.h"
+
+/* compares time and peak memory of loading a large collection with the
+ * streaming json parser and with jansson, not part of the test suite */
+
+#define BENCH_SOURCES 70000
+
+/* tracks the peak amount of memory allocated */
+
+#define HEADER_SIZE 32
+
+static long long cur_bytes = 0;
+static long long peak_bytes = 0;
+
+static void *track_alloc(void *ptr, size_t size)
+{
+	if (!ptr)
+		return NULL;
+
+	*(size_t *)ptr = size;
+	cur_bytes += (long long)size;
+	if (cur_bytes > peak_bytes)
+		peak_bytes = cur_bytes;
+
+	return (char *)ptr + HEADER_SIZE;
+}
+
+static void track_free(void *ptr)
+{
+	if (ptr) {
+		ptr = (char *)ptr - HEADER_SIZE;
+		cur_bytes -= (long long)*(size_t *)ptr;
+		free(ptr);
+	}
+}
+
+static void *track_malloc(size_t size)
+{
+	return track_alloc(malloc(size + HEADER_SIZE), size);
+}
+
+static void *track_realloc(void *ptr, size_t size)
+{
+	if (!ptr)
+		return track_malloc(size);
+
+	ptr = (char *)ptr - HEADER_SIZE;
+	cur_bytes -= (long long)*(size_t *)ptr;
+	return track_alloc(realloc(ptr, size + HEADER_SIZE), size);
+}
+
+static struct base_allocator track_allocator = {track_malloc, track_realloc,
+						track_free};
+
+static void reset_peak(void)
+{
+	peak_bytes = cur_bytes;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(void)
+{
+	struct dstr path = {0};
+	obs_data_t *collection, *expected, *data;
+	long long old_peak, new_peak, base;
+	uint64_t start, old_time, new_time;
+	int ret = 1;
+
+	base_set_allocator(&track_allocator);
+	temp_file_path(&path, "obs_data_json_bench.json");
+
+	collection = create_collection(BENCH_SOURCES);
+	if (!obs_data_save_json(collection, path.array)) {
+		fprintf(stderr, "failed to write %s\n", path.array);
+		obs_data_release(collection);
+		dstr_free(&path);
+		return 1;
+	}
+	obs_data_release(collection);
+
+	base = cur_bytes;
+	reset_peak();
+	start = os_gettime_ns();
+	expected = jansson_create_from_json_file(path.array);
+	old_time = os_gettime_ns() - start;
+	old_peak = peak_bytes - base;
+
+	base = cur_bytes;
+	reset_peak();
+	start = os_gettime_ns();
+	data = obs_data_create_from_json_file(path.array);
+	new_time = os_gettime_ns() - start;
+	new_peak = peak_bytes - base;
+
+	if (expected && data &&
+	    strcmp(obs_data_get_json(data), obs_data_get_json(expected)) == 0) {
+		printf("%lld bytes of json\n",
+		       (long long)os_get_file_size(path.array));
+		printf("jansson:   %.1f ms, peak %.1f MB\n",
+		       old_time / 1000000.0, old_peak / 1048576.0);
+		printf("streaming: %.1f ms, peak %.1f MB\n",
+		       new_time / 1000000.0, new_peak / 1048576.0);
+		ret = 0;
+	} else {
+		fprintf(stderr, "loaded data does not match\n");
+	}
+
+	os_unlink(path.array);
+	dstr_free(&path);
+	obs_data_release(expected);
+	obs_data_release(data);
+	return ret;
+}
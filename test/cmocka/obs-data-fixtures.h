@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <obs-data.h>
+#include <util/dstr.h>
+
+/* scene collection shaped data shared by the obs_data tests and
+ * benchmarks */
+
+static inline obs_data_t *create_source(int idx)
+{
+	obs_data_t *source = obs_data_create();
+	obs_data_t *settings = obs_data_create();
+	obs_data_t *font = obs_data_create();
+	obs_data_array_t *filters = obs_data_array_create();
+	char name[64];
+
+	/* quotes and multibyte characters need escaping in json */
+	snprintf(name, sizeof(name), "Text \"%d\" \xe2\x9c\x93", idx);
+	obs_data_set_string(source, "name", name);
+	obs_data_set_string(source, "id", "text_ft2_source");
+	obs_data_set_string(source, "uuid",
+			    "a0d14c5b-5c7e-4a5b-8f3e-2d8bd6c49f1a");
+	obs_data_set_int(source, "mixers", 255);
+	obs_data_set_int(source, "sync", -idx * 1000000007LL);
+	obs_data_set_double(source, "volume", 1.0 / (idx + 1));
+	obs_data_set_bool(source, "enabled", idx % 2 == 0);
+	obs_data_set_bool(source, "muted", false);
+
+	obs_data_set_string(font, "face", "Sans Serif");
+	obs_data_set_int(font, "size", 72);
+	obs_data_set_string(settings, "text",
+			    "Line one\nLine two\twith a tab\n");
+	obs_data_set_obj(settings, "font", font);
+	obs_data_set_obj(source, "settings", settings);
+
+	for (int i = 0; i < 3; i++) {
+		obs_data_t *filter = obs_data_create();
+		obs_data_set_string(filter, "id", "color_filter");
+		obs_data_set_string(filter, "name", "Color Correction");
+		obs_data_set_obj(filter, "settings", settings);
+		obs_data_array_push_back(filters, filter);
+		obs_data_release(filter);
+	}
+	obs_data_set_array(source, "filters", filters);
+
+	obs_data_array_release(filters);
+	obs_data_release(font);
+	obs_data_release(settings);
+	return source;
+}
+
+static inline obs_data_t *create_collection(int count)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+
+	for (int i = 0; i < count; i++) {
+		obs_data_t *source = create_source(i);
+		obs_data_array_push_back(sources, source);
+		obs_data_release(source);
+	}
+
+	obs_data_set_string(collection, "name", "Untitled \xe2\x9c\x93");
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	return collection;
+}
+
+/* benchmarks write their files to the temporary directory, never into the
+ * working directory */
+static inline void temp_file_path(struct dstr *path, const char *name)
+{
+	const char *dir = getenv("TMPDIR");
+
+	if (!dir || !*dir)
+		dir = getenv("TEMP");
+	if (!dir || !*dir)
+		dir = "/tmp";
+
+	dstr_printf(path, "%s/%s", dir, name);
+}
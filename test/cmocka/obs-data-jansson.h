@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdlib.h>
+
+#include <jansson.h>
+#include <obs-data.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+/* reference loader for the json tests and benchmark, the previous
+ * implementation that built a jansson tree first */
+
+static inline void add_json_item(obs_data_t *data, const char *key,
+				 json_t *json);
+
+static inline void add_json_object_data(obs_data_t *data, json_t *jobj)
+{
+	const char *item_key;
+	json_t *jitem;
+
+	json_object_foreach (jobj, item_key, jitem) {
+		add_json_item(data, item_key, jitem);
+	}
+}
+
+static inline void add_json_item(obs_data_t *data, const char *key,
+				 json_t *json)
+{
+	if (json_is_object(json)) {
+		obs_data_t *sub_obj = obs_data_create();
+		add_json_object_data(sub_obj, json);
+		obs_data_set_obj(data, key, sub_obj);
+		obs_data_release(sub_obj);
+
+	} else if (json_is_array(json)) {
+		obs_data_array_t *array = obs_data_array_create();
+		size_t idx;
+		json_t *jitem;
+
+		json_array_foreach (json, idx, jitem) {
+			if (!json_is_object(jitem))
+				continue;
+
+			obs_data_t *item = obs_data_create();
+			add_json_object_data(item, jitem);
+			obs_data_array_push_back(array, item);
+			obs_data_release(item);
+		}
+
+		obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+
+	} else if (json_is_string(json)) {
+		obs_data_set_string(data, key, json_string_value(json));
+	} else if (json_is_integer(json)) {
+		obs_data_set_int(data, key, json_integer_value(json));
+	} else if (json_is_real(json)) {
+		obs_data_set_double(data, key, json_real_value(json));
+	} else if (json_is_true(json)) {
+		obs_data_set_bool(data, key, true);
+	} else if (json_is_false(json)) {
+		obs_data_set_bool(data, key, false);
+	}
+}
+
+static inline obs_data_t *jansson_create_from_json(const char *json_string)
+{
+	obs_data_t *data = NULL;
+	json_t *root;
+
+	/* tracked as well, but only while loading, obs_data frees the json
+	 * text it gets from jansson with free() */
+	json_set_alloc_funcs(bmalloc, bfree);
+
+	root = json_loads(json_string, JSON_REJECT_DUPLICATES, NULL);
+	if (root) {
+		data = obs_data_create();
+		add_json_object_data(data, root);
+		json_decref(root);
+	}
+
+	json_set_alloc_funcs(malloc, free);
+	return data;
+}
+
+static inline obs_data_t *jansson_create_from_json_file(const char *json_file)
+{
+	char *file_data = os_quick_read_utf8_file(json_file);
+	obs_data_t *data = NULL;
+
+	if (file_data) {
+		data = jansson_create_from_json(file_data);
+		bfree(file_data);
+	}
+
+	return data;
+}
@@ -0,0 +1,152 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <util/arena.h>
+#include <util/bmem.h>
+#include <util/profiler.h>
+#include <util/threading.h>
+
+static long mallocs = 0;
+
+static void *count_malloc(size_t size)
+{
+	os_atomic_inc_long(&mallocs);
+	return malloc(size);
+}
+
+static void *count_realloc(void *ptr, size_t size)
+{
+	os_atomic_inc_long(&mallocs);
+	return realloc(ptr, size);
+}
+
+static struct base_allocator count_allocator = {count_malloc, count_realloc,
+						free};
+
+static void arena_alloc_test(void **state)
+{
+	os_arena_t *arena = os_arena_create(256);
+	uint8_t *a, *b, *c;
+
+	a = os_arena_alloc(arena, 10);
+	b = os_arena_alloc(arena, 100);
+	assert_non_null(a);
+	assert_int_equal((b - a) % base_get_alignment(), 0);
+	assert_true(b >= a + 10);
+	memset(a, 1, 10);
+	memset(b, 2, 100);
+	assert_int_equal(os_arena_capacity(arena), 256);
+
+	/* larger than a block */
+	c = os_arena_alloc(arena, 1000);
+	memset(c, 3, 1000);
+	assert_int_equal(a[9], 1);
+	assert_int_equal(b[99], 2);
+	assert_true(os_arena_capacity(arena) >= 1256);
+	assert_true(os_arena_used(arena) >= 1110);
+
+	/* blocks are merged so the next round fits in one */
+	os_arena_reset(arena);
+	assert_int_equal(os_arena_used(arena), 0);
+
+	long count = mallocs;
+	for (int i = 0; i < 3; i++) {
+		os_arena_alloc(arena, 10);
+		os_arena_alloc(arena, 100);
+		os_arena_alloc(arena, 1000);
+		os_arena_reset(arena);
+	}
+	assert_int_equal(mallocs, count);
+
+	os_arena_destroy(arena);
+}
+
+static void *frame_arena_thread(void *param)
+{
+	*(bool *)param = os_get_thread_frame_arena() == NULL &&
+			 os_frame_alloc(16) == NULL;
+	return NULL;
+}
+
+static void arena_frame_test(void **state)
+{
+	os_arena_t *arena = os_arena_create(0);
+	pthread_t thread;
+	bool no_arena = false;
+
+	assert_null(os_frame_alloc(16));
+
+	os_set_thread_frame_arena(arena);
+	assert_ptr_equal(os_get_thread_frame_arena(), arena);
+	assert_non_null(os_frame_alloc(16));
+	assert_int_equal(os_arena_used(arena), base_get_alignment());
+
+	/* frame arenas are per thread */
+	pthread_create(&thread, NULL, frame_arena_thread, &no_arena);
+	pthread_join(thread, NULL);
+	assert_true(no_arena);
+
+	os_arena_destroy(arena);
+	assert_null(os_get_thread_frame_arena());
+}
+
+static const char *tick_name = "arena_test_tick";
+static const char *child_names[] = {"a", "b", "c", "d", "e", "f"};
+
+static void profile_tick(void)
+{
+	profile_start(tick_name);
+	for (size_t i = 0; i < 6; i++) {
+		profile_start(child_names[i]);
+		for (size_t j = 0; j < 6; j++) {
+			profile_start(child_names[j]);
+			profile_end(child_names[j]);
+		}
+		profile_end(child_names[i]);
+	}
+	profile_end(tick_name);
+}
+
+static void arena_profiler_test(void **state)
+{
+	os_arena_t *arena = os_arena_create(0);
+	long count;
+
+	profiler_start();
+	profile_register_root(tick_name, 0);
+	os_set_thread_frame_arena(arena);
+
+	/* once profiled, a tick's calls don't allocate anymore.  merging the
+	 * times can still grow the profiler's tables once in a while */
+	for (int i = 0; i < 10; i++) {
+		profile_tick();
+		os_arena_reset(arena);
+	}
+
+	count = mallocs;
+	for (int i = 0; i < 100; i++) {
+		profile_tick();
+		os_arena_reset(arena);
+	}
+	assert_true(mallocs - count < 100);
+
+	profiler_stop();
+	profiler_free();
+	os_arena_destroy(arena);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(arena_alloc_test),
+		cmocka_unit_test(arena_frame_test),
+		cmocka_unit_test(arena_profiler_test),
+	};
+
+	base_set_allocator(&count_allocator);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,146 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs.h>
+
+#define MAX_BUSES 8
+
+struct bus_list {
+	obs_source_t *buses[MAX_BUSES];
+	size_t num;
+};
+
+static bool collect_bus(void *param, obs_source_t *bus)
+{
+	struct bus_list *list = param;
+
+	if (list->num < MAX_BUSES)
+		list->buses[list->num++] = bus;
+	return true;
+}
+
+static size_t bus_position(const struct bus_list *list, obs_source_t *bus)
+{
+	for (size_t i = 0; i < list->num; i++) {
+		if (list->buses[i] == bus)
+			return i;
+	}
+
+	fail_msg("bus '%s' not found", obs_source_get_name(bus));
+	return 0;
+}
+
+/* the audio thread renders the buses in this order, so every bus has to come
+ * after the buses feeding it */
+static void assert_feeds_before(obs_source_t *input, obs_source_t *bus)
+{
+	struct bus_list list = {0};
+
+	obs_enum_audio_buses(collect_bus, &list);
+	assert_true(bus_position(&list, input) < bus_position(&list, bus));
+}
+
+static int setup(void **state)
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = 48000,
+		.speakers = SPEAKERS_STEREO,
+	};
+
+	if (!obs_startup("en-US", NULL, NULL))
+		return -1;
+	if (!obs_reset_audio(&oai))
+		return -1;
+
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	obs_shutdown();
+
+	UNUSED_PARAMETER(state);
+	return 0;
+}
+
+static void audio_bus_loop_test(void **state)
+{
+	obs_source_t *a = obs_audio_bus_create("a", NULL);
+	obs_source_t *b = obs_audio_bus_create("b", NULL);
+	obs_source_t *c = obs_audio_bus_create("c", NULL);
+
+	assert_true(obs_source_is_audio_bus(a));
+
+	/* a -> b -> c */
+	assert_true(obs_audio_bus_add_input(b, a, 1.0f));
+	assert_true(obs_audio_bus_add_input(c, b, 1.0f));
+
+	/* a bus cannot feed itself, directly or through other buses */
+	assert_false(obs_audio_bus_add_input(a, a, 1.0f));
+	assert_false(obs_audio_bus_add_input(a, b, 1.0f));
+	assert_false(obs_audio_bus_add_input(a, c, 1.0f));
+
+	/* nor be added twice */
+	assert_false(obs_audio_bus_add_input(b, a, 1.0f));
+
+	/* once the chain is broken, the same link is allowed */
+	obs_audio_bus_remove_input(c, b);
+	assert_true(obs_audio_bus_add_input(a, c, 1.0f));
+
+	/* c -> a -> b, and b -> c would close the loop again */
+	assert_false(obs_audio_bus_add_input(c, b, 1.0f));
+
+	obs_source_release(a);
+	obs_source_release(b);
+	obs_source_release(c);
+
+	UNUSED_PARAMETER(state);
+}
+
+static void audio_bus_order_test(void **state)
+{
+	/* created in the reverse of the render order they need */
+	obs_source_t *out = obs_audio_bus_create("out", NULL);
+	obs_source_t *right = obs_audio_bus_create("right", NULL);
+	obs_source_t *left = obs_audio_bus_create("left", NULL);
+	obs_source_t *in = obs_audio_bus_create("in", NULL);
+
+	/* diamond: in -> left -> out, in -> right -> out */
+	assert_true(obs_audio_bus_add_input(out, left, 1.0f));
+	assert_true(obs_audio_bus_add_input(out, right, 1.0f));
+	assert_true(obs_audio_bus_add_input(left, in, 1.0f));
+	assert_true(obs_audio_bus_add_input(right, in, 0.5f));
+
+	assert_feeds_before(in, left);
+	assert_feeds_before(in, right);
+	assert_feeds_before(left, out);
+	assert_feeds_before(right, out);
+
+	/* moving a bus deeper into the graph reorders the buses after it */
+	obs_audio_bus_remove_input(out, right);
+	assert_true(obs_audio_bus_add_input(right, out, 1.0f));
+
+	assert_feeds_before(in, left);
+	assert_feeds_before(left, out);
+	assert_feeds_before(out, right);
+
+	obs_source_release(in);
+	obs_source_release(left);
+	obs_source_release(right);
+	obs_source_release(out);
+
+	UNUSED_PARAMETER(state);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(audio_bus_loop_test),
+		cmocka_unit_test(audio_bus_order_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,169 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/util_uint64.h>
+
+#define SAMPLE_RATE 48000
+#define TEST_TICKS 32
+#define MAX_WINDOWS 1024
+#define WAIT_TIMEOUT_NS 2000000000ULL
+
+/* -------------------------------------------------------- */
+/* master clock that only moves when the test advances it */
+
+struct fake_clock {
+	pthread_mutex_t mutex;
+	uint64_t time;
+};
+
+static uint64_t fake_clock_time(void *data)
+{
+	struct fake_clock *clock = data;
+	uint64_t time;
+
+	pthread_mutex_lock(&clock->mutex);
+	time = clock->time;
+	pthread_mutex_unlock(&clock->mutex);
+
+	return time;
+}
+
+static void fake_clock_advance(struct fake_clock *clock, uint64_t ns)
+{
+	pthread_mutex_lock(&clock->mutex);
+	clock->time += ns;
+	pthread_mutex_unlock(&clock->mutex);
+}
+
+/* -------------------------------------------------------- */
+
+struct capture {
+	pthread_mutex_t mutex;
+	uint64_t timestamps[MAX_WINDOWS];
+	uint32_t frames[MAX_WINDOWS];
+	size_t count;
+};
+
+static void capture_audio(void *param, size_t mix_idx, struct audio_data *data)
+{
+	struct capture *cap = param;
+
+	pthread_mutex_lock(&cap->mutex);
+	if (cap->count < MAX_WINDOWS) {
+		cap->timestamps[cap->count] = data->timestamp;
+		cap->frames[cap->count] = data->frames;
+		cap->count++;
+	}
+	pthread_mutex_unlock(&cap->mutex);
+
+	UNUSED_PARAMETER(mix_idx);
+}
+
+static size_t capture_count(struct capture *cap)
+{
+	size_t count;
+
+	pthread_mutex_lock(&cap->mutex);
+	count = cap->count;
+	pthread_mutex_unlock(&cap->mutex);
+
+	return count;
+}
+
+static void wait_for_windows(struct capture *cap, size_t count)
+{
+	uint64_t timeout = os_gettime_ns() + WAIT_TIMEOUT_NS;
+
+	while (capture_count(cap) < count) {
+		if (os_gettime_ns() > timeout)
+			fail_msg("timed out waiting for window %zu", count);
+		os_sleep_ms(1);
+	}
+}
+
+static void audio_clock_follow_test(void **state)
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = SAMPLE_RATE,
+		.speakers = SPEAKERS_STEREO,
+	};
+	/* rounded up, so every step reaches the next deadline */
+	const uint64_t tick = util_mul_div64(AUDIO_OUTPUT_FRAMES, 1000000000ULL,
+					     SAMPLE_RATE) +
+			      1;
+	struct fake_clock *clock = bzalloc(sizeof(*clock));
+	struct capture *cap = bzalloc(sizeof(*cap));
+	struct obs_clock_info info = {
+		.get_time_ns = fake_clock_time,
+		.data = clock,
+	};
+	uint64_t frames = 0;
+	size_t first, count;
+
+	assert_true(obs_startup("en-US", NULL, NULL));
+	assert_true(obs_reset_audio(&oai));
+
+	pthread_mutex_init(&cap->mutex, NULL);
+	pthread_mutex_init(&clock->mutex, NULL);
+	assert_true(audio_output_connect(obs_get_audio(), 0, NULL,
+					 capture_audio, cap));
+
+	obs_set_master_clock(&info);
+
+	/* let the audio thread finish the windows that were already due */
+	os_sleep_ms(50);
+	first = capture_count(cap);
+
+	/* every tick of the master clock gives exactly one window, however
+	 * long it takes in system time */
+	for (size_t i = 1; i <= TEST_TICKS; i++) {
+		fake_clock_advance(clock, tick);
+		wait_for_windows(cap, first + i);
+	}
+
+	/* and a stopped master clock stops the audio, system time going on
+	 * doesn't matter */
+	os_sleep_ms(100);
+	count = capture_count(cap);
+	assert_int_equal(count, first + TEST_TICKS);
+
+	audio_output_disconnect(obs_get_audio(), 0, capture_audio, cap);
+	obs_set_master_clock(NULL);
+
+	/* the audio produced follows the master clock, not the system
+	 * clock */
+	for (size_t i = first; i < count; i++) {
+		assert_int_equal(cap->frames[i], AUDIO_OUTPUT_FRAMES);
+		frames += cap->frames[i];
+
+		/* timestamps are in system time, but never run backwards */
+		if (i > 0)
+			assert_true(cap->timestamps[i] >
+				    cap->timestamps[i - 1]);
+	}
+	assert_true(frames == util_mul_div64(TEST_TICKS * tick, SAMPLE_RATE,
+					     1000000000ULL));
+
+	obs_shutdown();
+
+	pthread_mutex_destroy(&clock->mutex);
+	pthread_mutex_destroy(&cap->mutex);
+	bfree(clock);
+	bfree(cap);
+
+	UNUSED_PARAMETER(state);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(audio_clock_follow_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,202 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <media-io/audio-mix.h>
+#include <util/bmem.h>
+
+#define MAX_CHANNELS 8
+#define MAX_FRAMES 1100
+
+/* offset from the allocation, so the kernels also run on unaligned data */
+#define OFFSET 1
+#define GUARD 4
+#define GUARD_VALUE 1234.5f
+
+/* covers empty input, tails shorter than one vector, exact multiples of the
+ * 4 and 8 wide loops and odd lengths on either side of them */
+static const size_t lengths[] = {0,  1,  2,  3,  4,  5,  7,    8,    9,
+				 12, 15, 16, 17, 31, 33, 1023, 1024, 1025};
+
+static uint32_t rand_state = 1;
+
+static float noise(void)
+{
+	rand_state = rand_state * 1664525 + 1013904223;
+	return (float)(rand_state >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+}
+
+struct buffer {
+	float *alloc;
+	float *data;
+};
+
+static void buffer_init(struct buffer *buf, size_t frames)
+{
+	buf->alloc = bmalloc((OFFSET + frames + GUARD) * sizeof(float));
+	buf->data = buf->alloc + OFFSET;
+
+	for (size_t i = 0; i < frames; i++)
+		buf->data[i] = noise();
+	for (size_t i = 0; i < GUARD; i++)
+		buf->data[frames + i] = GUARD_VALUE;
+}
+
+static void check_guard(const struct buffer *buf, size_t frames)
+{
+	for (size_t i = 0; i < GUARD; i++)
+		assert_true(buf->data[frames + i] == GUARD_VALUE);
+}
+
+/* the reference may contract into fused multiply-adds where the kernels
+ * don't, so allow for one rounding */
+static void check_equal(const float *a, const float *b, size_t frames)
+{
+	for (size_t i = 0; i < frames; i++)
+		assert_true(fabsf(a[i] - b[i]) <=
+			    1e-6f * fmaxf(1.0f, fabsf(b[i])));
+}
+
+static void audio_mix_mul_test(void **state)
+{
+	for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		size_t frames = lengths[l];
+		struct buffer buf;
+		float ref[MAX_FRAMES];
+		float gain = noise();
+
+		buffer_init(&buf, frames);
+		for (size_t i = 0; i < frames; i++)
+			ref[i] = buf.data[i] * gain;
+
+		audio_mix_mul(buf.data, gain, frames);
+		check_equal(buf.data, ref, frames);
+		check_guard(&buf, frames);
+		bfree(buf.alloc);
+	}
+
+	UNUSED_PARAMETER(state);
+}
+
+static void audio_mix_mul_vec_test(void **state)
+{
+	for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		size_t frames = lengths[l];
+		struct buffer buf, gain;
+		float ref[MAX_FRAMES];
+
+		buffer_init(&buf, frames);
+		buffer_init(&gain, frames);
+		for (size_t i = 0; i < frames; i++)
+			ref[i] = buf.data[i] * gain.data[i];
+
+		audio_mix_mul_vec(buf.data, gain.data, frames);
+		check_equal(buf.data, ref, frames);
+		check_guard(&buf, frames);
+		bfree(buf.alloc);
+		bfree(gain.alloc);
+	}
+
+	UNUSED_PARAMETER(state);
+}
+
+static void audio_mix_add_test(void **state)
+{
+	for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		size_t frames = lengths[l];
+		struct buffer dst, src;
+		float ref[MAX_FRAMES];
+
+		buffer_init(&dst, frames);
+		buffer_init(&src, frames);
+		for (size_t i = 0; i < frames; i++)
+			ref[i] = dst.data[i] + src.data[i];
+
+		audio_mix_add(dst.data, src.data, frames);
+		check_equal(dst.data, ref, frames);
+		check_guard(&dst, frames);
+		check_guard(&src, frames);
+		bfree(dst.alloc);
+		bfree(src.alloc);
+	}
+
+	UNUSED_PARAMETER(state);
+}
+
+static void check_copy_gain(size_t channels, size_t frames, bool mono,
+			    bool unity)
+{
+	struct buffer src[MAX_CHANNELS], dst[MAX_CHANNELS];
+	float *src_data[MAX_CHANNELS] = {0};
+	float *dst_data[MAX_CHANNELS] = {0};
+	float gain[MAX_CHANNELS] = {0};
+	float ref[MAX_CHANNELS][MAX_FRAMES];
+
+	for (size_t ch = 0; ch < channels; ch++) {
+		buffer_init(&src[ch], frames);
+		buffer_init(&dst[ch], frames);
+		src_data[ch] = src[ch].data;
+		dst_data[ch] = dst[ch].data;
+
+		/* unity gains take the memcpy path */
+		gain[ch] = unity || ch == 1 ? 1.0f : noise();
+	}
+
+	for (size_t i = 0; i < frames; i++) {
+		float sum = 0.0f;
+
+		for (size_t ch = 0; ch < channels; ch++) {
+			ref[ch][i] = src[ch].data[i] * gain[ch];
+			sum += ref[ch][i];
+		}
+
+		if (mono && channels > 1) {
+			for (size_t ch = 0; ch < channels; ch++)
+				ref[ch][i] = sum;
+		}
+	}
+
+	audio_mix_copy_gain(dst_data, (const float *const *)src_data, channels,
+			    gain, mono, frames);
+
+	for (size_t ch = 0; ch < channels; ch++) {
+		check_equal(dst[ch].data, ref[ch], frames);
+		check_guard(&dst[ch], frames);
+		bfree(src[ch].alloc);
+		bfree(dst[ch].alloc);
+	}
+}
+
+static void audio_mix_copy_gain_test(void **state)
+{
+	static const size_t channel_counts[] = {1, 2, 3, 6, 8};
+
+	for (size_t c = 0; c < sizeof(channel_counts) / sizeof(size_t); c++) {
+		for (size_t l = 0; l < sizeof(lengths) / sizeof(size_t); l++) {
+			size_t channels = channel_counts[c];
+			size_t frames = lengths[l];
+
+			check_copy_gain(channels, frames, false, false);
+			check_copy_gain(channels, frames, false, true);
+			check_copy_gain(channels, frames, true, false);
+		}
+	}
+
+	UNUSED_PARAMETER(state);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(audio_mix_mul_test),
+		cmocka_unit_test(audio_mix_mul_vec_test),
+		cmocka_unit_test(audio_mix_add_test),
+		cmocka_unit_test(audio_mix_copy_gain_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,214 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <media-io/audio-resampler.h>
+#include <util/bmem.h>
+
+#define PI 3.14159265358979323846
+
+static audio_resampler_t *create(uint32_t in_rate, enum audio_format in_fmt,
+				 uint32_t out_rate, enum audio_format out_fmt,
+				 enum speaker_layout speakers)
+{
+	struct resample_info src = {in_rate, in_fmt, speakers};
+	struct resample_info dst = {out_rate, out_fmt, speakers};
+	audio_resampler_t *rs = audio_resampler_create(&dst, &src);
+
+	assert_non_null(rs);
+	return rs;
+}
+
+static void s16_to_float_planar_test(void **state)
+{
+	audio_resampler_t *rs = create(48000, AUDIO_FORMAT_16BIT, 48000,
+				       AUDIO_FORMAT_FLOAT_PLANAR,
+				       SPEAKERS_STEREO);
+	int16_t in[38];
+	const uint8_t *input[MAX_AV_PLANES] = {(const uint8_t *)in};
+	uint8_t *output[MAX_AV_PLANES] = {0};
+	uint32_t frames = 0;
+	uint64_t offset = 1;
+
+	for (int i = 0; i < 38; i++)
+		in[i] = (int16_t)(i & 1 ? -32768 + i * 997 : 32767 - i * 1201);
+
+	assert_true(audio_resampler_resample(rs, output, &frames, &offset,
+					     input, 19));
+	assert_int_equal(frames, 19);
+	assert_int_equal(offset, 0);
+
+	for (int i = 0; i < 19; i++) {
+		const float *l = (const float *)output[0];
+		const float *r = (const float *)output[1];
+
+		assert_true(l[i] == (float)in[i * 2] / 32768.0f);
+		assert_true(r[i] == (float)in[i * 2 + 1] / 32768.0f);
+	}
+
+	audio_resampler_destroy(rs);
+}
+
+static void float_planar_to_integer_test(void **state)
+{
+	static const float values[] = {0.0f,   0.5f,   -0.5f,  1.0f,
+				       -1.0f,  1.5f,   -1.5f,  0.25f,
+				       -0.25f, 0.999f, 0.001f, -0.001f};
+	static const int16_t s16[] = {0,      16384, -16384, 32767,
+				      -32768, 32767, -32768, 8192,
+				      -8192,  32735, 33,     -33};
+	static const int32_t s32[] = {0,           1073741824, -1073741824,
+				      2147483520,  -2147483647 - 1,
+				      2147483520,  -2147483647 - 1,
+				      536870912,   -536870912,
+				      2145336192,  2147484,    -2147484};
+	static const uint8_t u8[] = {128, 192, 64, 255, 0,  255,
+				     0,   160, 96, 255, 128, 128};
+	const size_t count = sizeof(values) / sizeof(values[0]);
+	const uint8_t *input[MAX_AV_PLANES] = {(const uint8_t *)values};
+	uint8_t *output[MAX_AV_PLANES] = {0};
+	uint32_t frames;
+	uint64_t offset;
+	audio_resampler_t *rs;
+
+	rs = create(48000, AUDIO_FORMAT_FLOAT_PLANAR, 48000,
+		    AUDIO_FORMAT_16BIT, SPEAKERS_MONO);
+	assert_true(audio_resampler_resample(rs, output, &frames, &offset,
+					     input, (uint32_t)count));
+	assert_int_equal(frames, count);
+	assert_memory_equal(output[0], s16, sizeof(s16));
+	audio_resampler_destroy(rs);
+
+	rs = create(48000, AUDIO_FORMAT_FLOAT_PLANAR, 48000,
+		    AUDIO_FORMAT_32BIT, SPEAKERS_MONO);
+	assert_true(audio_resampler_resample(rs, output, &frames, &offset,
+					     input, (uint32_t)count));
+	for (size_t i = 0; i < count; i++) {
+		int64_t diff = (int64_t)((int32_t *)output[0])[i] - s32[i];
+		assert_true(diff >= -128 && diff <= 128);
+	}
+	audio_resampler_destroy(rs);
+
+	rs = create(48000, AUDIO_FORMAT_FLOAT_PLANAR, 48000,
+		    AUDIO_FORMAT_U8BIT, SPEAKERS_MONO);
+	assert_true(audio_resampler_resample(rs, output, &frames, &offset,
+					     input, (uint32_t)count));
+	assert_memory_equal(output[0], u8, sizeof(u8));
+	audio_resampler_destroy(rs);
+}
+
+/* ------------------------------------------------------------------------- */
+/* resampling accuracy: a sine is resampled in uneven chunks and compared to
+ * the ideal sine at the output rate, using the reported timestamp offset */
+
+struct sine_result {
+	double snr_db;
+	double gain;
+	uint64_t frames;
+	uint64_t expected_frames;
+};
+
+static struct sine_result resample_sine(uint32_t in_rate, uint32_t out_rate,
+					double freq, double amplitude)
+{
+	audio_resampler_t *rs = create(in_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				       out_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				       SPEAKERS_MONO);
+	static const uint32_t chunks[] = {441, 1024, 17, 480, 1, 999};
+	const uint64_t total_in = in_rate;
+	float *in = bmalloc(sizeof(float) * 1024);
+	double signal = 0.0, noise = 0.0, ref = 0.0;
+	struct sine_result result = {0};
+	uint64_t in_pos = 0;
+	size_t chunk = 0;
+
+	while (in_pos < total_in) {
+		uint32_t frames = chunks[chunk++ % 6];
+		const uint8_t *input[MAX_AV_PLANES] = {(const uint8_t *)in};
+		uint8_t *output[MAX_AV_PLANES] = {0};
+		uint32_t out_frames;
+		uint64_t offset;
+		double in_ts;
+
+		for (uint32_t i = 0; i < frames; i++)
+			in[i] = (float)(amplitude *
+					sin(2.0 * PI * freq *
+					    (double)(in_pos + i) / in_rate));
+
+		assert_true(audio_resampler_resample(rs, output, &out_frames,
+						     &offset, input, frames));
+
+		/* time of the first output sample, in seconds */
+		in_ts = (double)in_pos / in_rate - (double)offset / 1e9;
+
+		for (uint32_t i = 0; i < out_frames; i++) {
+			double t = in_ts + (double)i / out_rate;
+			double expected = amplitude * sin(2.0 * PI * freq * t);
+			double out = ((const float *)output[0])[i];
+
+			/* skip the filter settling at the start */
+			if (t > 0.01) {
+				signal += expected * expected;
+				noise += (out - expected) * (out - expected);
+				ref += out * out;
+			}
+		}
+
+		result.frames += out_frames;
+		in_pos += frames;
+	}
+
+	result.expected_frames = in_pos * out_rate / in_rate;
+	result.snr_db = 10.0 * log10(signal / (noise + 1e-30));
+	result.gain = sqrt(ref / signal);
+
+	bfree(in);
+	audio_resampler_destroy(rs);
+	return result;
+}
+
+static void resample_44100_to_48000_test(void **state)
+{
+	struct sine_result r = resample_sine(44100, 48000, 997.0, 0.5);
+
+	assert_true(r.snr_db > 90.0);
+	assert_true(fabs(r.gain - 1.0) < 0.001);
+	assert_true(r.frames <= r.expected_frames &&
+		    r.frames + 32 > r.expected_frames);
+
+	r = resample_sine(44100, 48000, 15000.0, 0.5);
+	assert_true(r.snr_db > 60.0);
+}
+
+static void resample_48000_to_44100_test(void **state)
+{
+	struct sine_result r = resample_sine(48000, 44100, 997.0, 0.5);
+
+	assert_true(r.snr_db > 90.0);
+	assert_true(fabs(r.gain - 1.0) < 0.001);
+	assert_true(r.frames <= r.expected_frames &&
+		    r.frames + 32 > r.expected_frames);
+}
+
+static void resample_alias_rejection_test(void **state)
+{
+	/* above the output nyquist frequency, this must be filtered out */
+	struct sine_result r = resample_sine(48000, 44100, 23500.0, 0.5);
+
+	assert_true(20.0 * log10(r.gain + 1e-30) < -60.0);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(s16_to_float_planar_test),
+		cmocka_unit_test(float_planar_to_integer_test),
+		cmocka_unit_test(resample_44100_to_48000_test),
+		cmocka_unit_test(resample_48000_to_44100_test),
+		cmocka_unit_test(resample_alias_rejection_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,409 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/audio-ring.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/util_uint64.h>
+
+#define CHANNELS 2
+
+static inline float sample_value(uint32_t index, size_t ch)
+{
+	return (float)((index & 0xFFFFF) | ((uint32_t)ch << 20));
+}
+
+static void fill_planes(float planes[CHANNELS][1024], uint32_t index,
+			uint32_t frames)
+{
+	for (size_t ch = 0; ch < CHANNELS; ch++)
+		for (uint32_t i = 0; i < frames; i++)
+			planes[ch][i] = sample_value(index + i, ch);
+}
+
+static bool push_frames(struct audio_ring *ring, uint64_t ts, uint32_t index,
+			uint32_t frames, uint32_t flags)
+{
+	float planes[CHANNELS][1024];
+	const float *data[CHANNELS] = {planes[0], planes[1]};
+
+	fill_planes(planes, index, frames);
+	return audio_ring_push(ring, ts, data, frames, flags);
+}
+
+static void check_frames(const struct audio_ring_packet *packet,
+			 uint32_t index)
+{
+	for (size_t ch = 0; ch < CHANNELS; ch++)
+		for (uint32_t i = 0; i < packet->frames; i++)
+			assert_true(packet->data[ch][i] ==
+				    sample_value(index + i, ch));
+}
+
+static void audio_ring_basic_test(void **state)
+{
+	struct audio_ring ring;
+	struct audio_ring_packet packet;
+
+	audio_ring_init(&ring, CHANNELS, 60, 7, 0);
+	assert_int_equal(ring.capacity, 64);
+	assert_int_equal(ring.max_packets, 8);
+	assert_false(audio_ring_peek(&ring, &packet));
+
+	/* nothing is allocated before the first push */
+	assert_null(ring.slots);
+	assert_null(ring.data[0]);
+
+	assert_true(push_frames(&ring, 1000, 0, 10, 0));
+	assert_true(push_frames(&ring, 2000, 10, 20, AUDIO_RING_CONTIGUOUS));
+	assert_true(audio_ring_push_reset(&ring, 5000));
+	assert_int_equal(audio_ring_buffered_frames(&ring), 30);
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.timestamp, 1000);
+	assert_int_equal(packet.frames, 10);
+	assert_int_equal(packet.flags, 0);
+	check_frames(&packet, 0);
+
+	/* peeking again returns the same packet until it is popped */
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.timestamp, 1000);
+	audio_ring_pop(&ring, &packet);
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.timestamp, 2000);
+	assert_int_equal(packet.flags, AUDIO_RING_CONTIGUOUS);
+	check_frames(&packet, 10);
+	audio_ring_pop(&ring, &packet);
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.timestamp, 5000);
+	assert_int_equal(packet.frames, 0);
+	assert_int_equal(packet.flags, AUDIO_RING_RESET);
+	audio_ring_pop(&ring, &packet);
+
+	assert_false(audio_ring_peek(&ring, &packet));
+	assert_int_equal(audio_ring_buffered_frames(&ring), 0);
+	assert_int_equal(audio_ring_dropped_packets(&ring), 0);
+
+	audio_ring_free(&ring);
+}
+
+static void audio_ring_wrap_test(void **state)
+{
+	struct audio_ring ring;
+	struct audio_ring_packet packet;
+	uint32_t index = 0;
+
+	audio_ring_init(&ring, CHANNELS, 16, 4, 0);
+
+	/* packets that would cross the end of the ring start over at the
+	 * beginning so their planes stay contiguous */
+	for (int i = 0; i < 20; i++) {
+		assert_true(push_frames(&ring, i, index, 10, 0));
+		assert_true(audio_ring_peek(&ring, &packet));
+		assert_int_equal(packet.frames, 10);
+		assert_true(packet.data[0] >= ring.data[0]);
+		assert_true(packet.data[0] + 10 <= ring.data[0] + 16);
+		check_frames(&packet, index);
+		audio_ring_pop(&ring, &packet);
+		index += 10;
+	}
+
+	audio_ring_free(&ring);
+}
+
+static void audio_ring_gap_test(void **state)
+{
+	struct audio_ring ring;
+	struct audio_ring_packet packet;
+
+	audio_ring_init(&ring, CHANNELS, 32, 4, 0);
+
+	assert_true(push_frames(&ring, 0, 0, 20, 0));
+	assert_false(push_frames(&ring, 1, 20, 20, AUDIO_RING_CONTIGUOUS));
+
+	/* only the first packet after a drop is flagged */
+	assert_true(push_frames(&ring, 2, 40, 4, AUDIO_RING_CONTIGUOUS));
+	assert_true(push_frames(&ring, 3, 44, 4, AUDIO_RING_CONTIGUOUS));
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.flags, 0);
+	audio_ring_pop(&ring, &packet);
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.flags, AUDIO_RING_CONTIGUOUS | AUDIO_RING_GAP);
+	check_frames(&packet, 40);
+	audio_ring_pop(&ring, &packet);
+
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.flags, AUDIO_RING_CONTIGUOUS);
+	audio_ring_pop(&ring, &packet);
+
+	/* a dropped reset marker leaves a gap as well */
+	for (int i = 0; i < 4; i++)
+		assert_true(audio_ring_push_reset(&ring, 10 + i));
+	assert_false(audio_ring_push_reset(&ring, 14));
+	for (int i = 0; i < 4; i++) {
+		assert_true(audio_ring_peek(&ring, &packet));
+		audio_ring_pop(&ring, &packet);
+	}
+	assert_true(audio_ring_push_reset(&ring, 15));
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.flags, AUDIO_RING_RESET | AUDIO_RING_GAP);
+	audio_ring_pop(&ring, &packet);
+
+	audio_ring_free(&ring);
+}
+
+static void audio_ring_full_test(void **state)
+{
+	struct audio_ring ring;
+	struct audio_ring_packet packet;
+
+	audio_ring_init(&ring, CHANNELS, 32, 4, 0);
+
+	/* out of frames */
+	assert_true(push_frames(&ring, 0, 0, 20, 0));
+	assert_false(push_frames(&ring, 1, 20, 20, 0));
+	assert_int_equal(audio_ring_dropped_packets(&ring), 1);
+
+	/* larger than the whole ring */
+	assert_false(push_frames(&ring, 1, 20, 40, 0));
+	assert_int_equal(audio_ring_dropped_packets(&ring), 2);
+
+	/* out of packets */
+	assert_true(push_frames(&ring, 2, 20, 4, 0));
+	assert_true(push_frames(&ring, 3, 24, 4, 0));
+	assert_true(audio_ring_push_reset(&ring, 4));
+	assert_false(audio_ring_push_reset(&ring, 5));
+	assert_int_equal(audio_ring_dropped_packets(&ring), 3);
+
+	/* freed space can be reused */
+	assert_true(audio_ring_peek(&ring, &packet));
+	check_frames(&packet, 0);
+	audio_ring_pop(&ring, &packet);
+	assert_true(push_frames(&ring, 6, 28, 16, 0));
+
+	audio_ring_free(&ring);
+}
+
+static void audio_ring_overflow_test(void **state)
+{
+	struct audio_ring ring;
+	struct audio_ring_packet packet;
+
+	audio_ring_init(&ring, CHANNELS, 32, 4, 64);
+
+	/* out of frames and larger than the whole ring, both overflow */
+	assert_true(push_frames(&ring, 0, 0, 20, 0));
+	assert_true(push_frames(&ring, 1, 20, 20, AUDIO_RING_CONTIGUOUS));
+	assert_true(push_frames(&ring, 2, 40, 40, AUDIO_RING_CONTIGUOUS));
+	assert_int_equal(audio_ring_buffered_frames(&ring), 80);
+
+	/* fits in the ring, but has to stay behind the overflow */
+	assert_true(push_frames(&ring, 3, 80, 4, AUDIO_RING_CONTIGUOUS));
+
+	/* beyond the overflow */
+	assert_false(push_frames(&ring, 4, 84, 8, AUDIO_RING_CONTIGUOUS));
+	assert_int_equal(audio_ring_dropped_packets(&ring), 1);
+
+	for (uint64_t ts = 0; ts < 4; ts++) {
+		static const uint32_t index[] = {0, 20, 40, 80};
+
+		assert_true(audio_ring_peek(&ring, &packet));
+		assert_true(packet.timestamp == ts);
+		check_frames(&packet, index[ts]);
+
+		/* peeking again gives the same packet */
+		assert_true(audio_ring_peek(&ring, &packet));
+		assert_true(packet.timestamp == ts);
+		audio_ring_pop(&ring, &packet);
+	}
+	assert_false(audio_ring_peek(&ring, &packet));
+
+	/* once the overflow is drained, packets go back to the ring, and the
+	 * drop is still flagged */
+	assert_true(push_frames(&ring, 5, 92, 8, AUDIO_RING_CONTIGUOUS));
+	assert_int_equal(ring.overflow_packets, 0);
+	assert_true(audio_ring_peek(&ring, &packet));
+	assert_int_equal(packet.flags,
+			 AUDIO_RING_CONTIGUOUS | AUDIO_RING_GAP);
+	check_frames(&packet, 92);
+	audio_ring_pop(&ring, &packet);
+
+	assert_int_equal(audio_ring_buffered_frames(&ring), 0);
+	audio_ring_free(&ring);
+}
+
+/* ------------------------------------------------------------------------- */
+/* stress test: a jittery producer with timestamp jumps and resets against a
+ * jittery consumer.  both sides replay the same pseudo random sequence, so
+ * the consumer knows exactly what it should receive. */
+
+#define STRESS_PACKETS 50000
+#define SAMPLE_RATE 48000
+
+struct stress_packet {
+	uint64_t ts;
+	uint32_t frames;
+	uint32_t flags;
+};
+
+struct stress_gen {
+	uint32_t rand;
+	uint64_t ts;
+};
+
+static inline uint32_t next_rand(struct stress_gen *gen)
+{
+	gen->rand = gen->rand * 1664525 + 1013904223;
+	return gen->rand >> 8;
+}
+
+static struct stress_packet next_packet(struct stress_gen *gen)
+{
+	struct stress_packet p;
+	uint32_t r = next_rand(gen) % 100;
+
+	p.frames = 1 + next_rand(gen) % 1000;
+	p.flags = AUDIO_RING_CONTIGUOUS;
+
+	if (r == 0) {
+		/* jump back in time */
+		gen->ts -= gen->ts / 4;
+		p.flags = 0;
+	} else if (r == 1) {
+		/* jump forward in time */
+		gen->ts += 1000000000ULL + next_rand(gen);
+		p.flags = 0;
+	} else if (r == 2) {
+		p.frames = 0;
+		p.flags = AUDIO_RING_RESET;
+	}
+
+	p.ts = gen->ts;
+	gen->ts += util_mul_div64(p.frames, 1000000000ULL, SAMPLE_RATE);
+	return p;
+}
+
+static void jitter(struct stress_gen *gen)
+{
+	uint32_t r = next_rand(gen) % 64;
+
+	if (r == 0)
+		os_sleep_ms(1);
+	else if (r < 8)
+		os_sleep_ms(0);
+}
+
+struct stress_data {
+	struct audio_ring ring;
+	volatile bool stop;
+};
+
+static void *stress_producer(void *param)
+{
+	struct stress_data *data = param;
+	struct stress_gen gen = {1, 1000000000ULL};
+	struct stress_gen jit = {7, 0};
+	uint32_t index = 0;
+
+	for (int i = 0; i < STRESS_PACKETS && !data->stop; i++) {
+		struct stress_packet p = next_packet(&gen);
+		bool pushed;
+
+		do {
+			if (p.flags & AUDIO_RING_RESET)
+				pushed = audio_ring_push_reset(&data->ring,
+							       p.ts);
+			else
+				pushed = push_frames(&data->ring, p.ts, index,
+						     p.frames, p.flags);
+			if (!pushed)
+				os_sleep_ms(0);
+		} while (!pushed && !data->stop);
+
+		index += p.frames;
+		jitter(&jit);
+	}
+
+	return NULL;
+}
+
+static void run_stress(size_t capacity, size_t max_packets,
+		       size_t max_overflow_frames)
+{
+	struct stress_data data = {0};
+	struct stress_gen gen = {1, 1000000000ULL};
+	struct stress_gen jit = {11, 0};
+	struct audio_ring_packet packet;
+	pthread_t thread;
+	uint32_t index = 0;
+	uint64_t timeout = os_gettime_ns() + 60000000000ULL;
+
+	audio_ring_init(&data.ring, CHANNELS, capacity, max_packets,
+			max_overflow_frames);
+	assert_int_equal(pthread_create(&thread, NULL, stress_producer, &data),
+			 0);
+
+	for (int i = 0; i < STRESS_PACKETS; i++) {
+		struct stress_packet p = next_packet(&gen);
+
+		while (!audio_ring_peek(&data.ring, &packet)) {
+			if (os_gettime_ns() > timeout) {
+				data.stop = true;
+				pthread_join(thread, NULL);
+				fail_msg("timed out at packet %d", i);
+			}
+			os_sleep_ms(0);
+		}
+
+		assert_true(packet.timestamp == p.ts);
+		assert_int_equal(packet.frames, p.frames);
+		/* the producer retries dropped packets, so nothing is lost
+		 * where a gap is flagged */
+		assert_int_equal(packet.flags & ~AUDIO_RING_GAP, p.flags);
+		check_frames(&packet, index);
+
+		audio_ring_pop(&data.ring, &packet);
+		index += p.frames;
+		jitter(&jit);
+	}
+
+	pthread_join(thread, NULL);
+
+	assert_false(audio_ring_peek(&data.ring, &packet));
+	assert_int_equal(audio_ring_buffered_frames(&data.ring), 0);
+
+	audio_ring_free(&data.ring);
+}
+
+static void audio_ring_stress_test(void **state)
+{
+	run_stress(2048, 16, 0);
+}
+
+/* most packets are larger than the ring, so the overflow is used all the
+ * time, and has to keep the order with what is still in the ring */
+static void audio_ring_overflow_stress_test(void **state)
+{
+	run_stress(256, 4, 1 << 20);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(audio_ring_basic_test),
+		cmocka_unit_test(audio_ring_wrap_test),
+		cmocka_unit_test(audio_ring_full_test),
+		cmocka_unit_test(audio_ring_gap_test),
+		cmocka_unit_test(audio_ring_overflow_test),
+		cmocka_unit_test(audio_ring_stress_test),
+		cmocka_unit_test(audio_ring_overflow_stress_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
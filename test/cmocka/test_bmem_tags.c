@@ -0,0 +1,130 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+static bool get_tag(const char *name, struct bmem_tag_stats *stats)
+{
+	for (size_t i = 0; bmem_get_tag_stats(i, stats); i++) {
+		if (strcmp(stats->name, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static void *free_thread(void *param)
+{
+	/* freed memory is accounted to the tag it was allocated with */
+	bmem_set_thread_tag("other");
+	bfree(param);
+	return NULL;
+}
+
+static void bmem_tags_test(void **state)
+{
+	struct bmem_tag_stats stats;
+	const char *prev;
+	pthread_t thread;
+	char *a, *b;
+
+	assert_true(bmem_tagging_enabled());
+	assert_true(bmem_get_tag_stats(0, &stats));
+	assert_string_equal(stats.name, "untagged");
+
+	prev = bmem_set_thread_tag("test");
+	assert_null(prev);
+
+	a = bmalloc(1000);
+	b = bzalloc(24);
+	assert_int_equal((uintptr_t)a % base_get_alignment(), 0);
+	assert_int_equal((uintptr_t)b % base_get_alignment(), 0);
+
+	assert_string_equal(bmem_set_thread_tag(prev), "test");
+
+	assert_true(get_tag("test", &stats));
+	assert_int_equal(stats.live_bytes, 1024);
+	assert_int_equal(stats.live_allocs, 2);
+	assert_int_equal(stats.total_allocs, 2);
+
+	/* untagged again, but reallocations stay with the original tag */
+	a = brealloc(a, 4000);
+	assert_true(get_tag("test", &stats));
+	assert_int_equal(stats.live_bytes, 4024);
+	assert_int_equal(stats.peak_bytes, 4024);
+	assert_int_equal(stats.total_bytes, 4024);
+
+	a = brealloc(a, 10);
+	bfree(b);
+	assert_true(get_tag("test", &stats));
+	assert_int_equal(stats.live_bytes, 10);
+	assert_int_equal(stats.live_allocs, 1);
+	assert_int_equal(stats.peak_bytes, 4024);
+
+	assert_int_equal(pthread_create(&thread, NULL, free_thread, a), 0);
+	pthread_join(thread, NULL);
+
+	assert_true(get_tag("test", &stats));
+	assert_int_equal(stats.live_bytes, 0);
+	assert_int_equal(stats.live_allocs, 0);
+	assert_int_equal(stats.total_allocs, 2);
+
+	assert_true(get_tag("other", &stats));
+	assert_int_equal(stats.live_allocs, 0);
+	assert_int_equal(stats.total_allocs, 0);
+}
+
+static void bmem_tags_zero_size_test(void **state)
+{
+	struct bmem_tag_stats stats;
+	const char *prev;
+	char *a, *b;
+
+	prev = bmem_set_thread_tag("zero");
+	a = bmalloc(0);
+	b = bmalloc(16);
+	bmem_set_thread_tag(prev);
+
+	assert_true(get_tag("zero", &stats));
+	assert_int_equal(stats.live_allocs, 2);
+	assert_int_equal(stats.live_bytes, 16);
+
+	/* shrinking to zero bytes is still a live allocation */
+	b = brealloc(b, 0);
+	assert_true(get_tag("zero", &stats));
+	assert_int_equal(stats.live_allocs, 2);
+	assert_int_equal(stats.live_bytes, 0);
+
+	b = brealloc(b, 8);
+	assert_true(get_tag("zero", &stats));
+	assert_int_equal(stats.live_allocs, 2);
+	assert_int_equal(stats.total_allocs, 2);
+	assert_int_equal(stats.live_bytes, 8);
+
+	bfree(a);
+	bfree(b);
+	assert_true(get_tag("zero", &stats));
+	assert_int_equal(stats.live_allocs, 0);
+	assert_int_equal(stats.live_bytes, 0);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bmem_tags_test),
+		cmocka_unit_test(bmem_tags_zero_size_test),
+	};
+
+	/* has to be set before the first allocation */
+#ifdef _WIN32
+	_putenv_s("OBS_MEMORY_TAGS", "1");
+#else
+	setenv("OBS_MEMORY_TAGS", "1", 1);
+#endif
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,273 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <string.h>
+
+#include <obs.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/util_uint64.h>
+
+#define SAMPLE_RATE 48000
+#define PACKET_FRAMES 480
+#define PULSE_INTERVAL 4800 /* one pulse every 100 ms */
+#define SYNC_OFFSET 30000000LL
+#define LATE_BY 500000000ULL
+#define RUN_TIME_MS 1000
+#define MAX_PULSES 64
+
+/* one frame, plus rounding of the window timestamps */
+#define TOLERANCE_NS 25000
+
+/* -------------------------------------------------------- */
+/* monitored sources producing a pulse every PULSE_INTERVAL frames, all
+ * driven from one thread.  each source pulses at its own level so the bus
+ * output can be traced back to the source. */
+
+enum {
+	SOURCE_ON_TIME,
+	SOURCE_SYNC_OFFSET,
+	SOURCE_LATE,
+	SOURCE_COUNT,
+};
+
+static const float levels[SOURCE_COUNT] = {1.0f, 2.0f, 4.0f};
+
+struct feeder {
+	obs_source_t *sources[SOURCE_COUNT];
+	uint64_t start;
+	pthread_t thread;
+	os_event_t *stop;
+};
+
+static void output_packet(obs_source_t *source, uint64_t ts, uint64_t frame,
+			  float level)
+{
+	float buf[PACKET_FRAMES] = {0};
+	struct obs_source_audio audio = {
+		.data = {(uint8_t *)buf, (uint8_t *)buf},
+		.frames = PACKET_FRAMES,
+		.speakers = SPEAKERS_STEREO,
+		.format = AUDIO_FORMAT_FLOAT_PLANAR,
+		.samples_per_sec = SAMPLE_RATE,
+		.timestamp = ts,
+	};
+
+	for (uint32_t i = 0; i < PACKET_FRAMES; i++) {
+		if ((frame + i) % PULSE_INTERVAL == 0)
+			buf[i] = level;
+	}
+
+	obs_source_output_audio(source, &audio);
+}
+
+static void *feeder_thread(void *param)
+{
+	struct feeder *f = param;
+	uint64_t frames = 0;
+
+	while (os_event_try(f->stop) == EAGAIN) {
+		uint64_t ts = f->start + util_mul_div64(frames, 1000000000ULL,
+							SAMPLE_RATE);
+
+		output_packet(f->sources[SOURCE_ON_TIME], ts, frames,
+			      levels[SOURCE_ON_TIME]);
+		output_packet(f->sources[SOURCE_SYNC_OFFSET], ts, frames,
+			      levels[SOURCE_SYNC_OFFSET]);
+		/* arrives after the bus has already mixed its window */
+		output_packet(f->sources[SOURCE_LATE], ts - LATE_BY, frames,
+			      levels[SOURCE_LATE]);
+
+		frames += PACKET_FRAMES;
+		os_sleepto_ns(f->start + util_mul_div64(frames, 1000000000ULL,
+							SAMPLE_RATE));
+	}
+
+	return NULL;
+}
+
+static const char *source_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "test monitoring bus source";
+}
+
+static void *source_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void source_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static struct obs_source_info test_source_info = {
+	.id = "test_monitoring_bus_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_AUDIO,
+	.get_name = source_name,
+	.create = source_create,
+	.destroy = source_destroy,
+};
+
+/* -------------------------------------------------------- */
+/* pulses found in the bus output, with their timestamps */
+
+struct capture {
+	pthread_mutex_t mutex;
+	uint64_t timestamps[MAX_PULSES];
+	float levels[MAX_PULSES];
+	size_t count;
+	size_t packets;
+};
+
+static void capture_bus(void *param, obs_source_t *source,
+			const struct audio_data *data, bool muted)
+{
+	struct capture *cap = param;
+	const float *samples = (const float *)data->data[0];
+
+	pthread_mutex_lock(&cap->mutex);
+	cap->packets++;
+	for (uint32_t i = 0; i < data->frames; i++) {
+		if (samples[i] == 0.0f || cap->count == MAX_PULSES)
+			continue;
+
+		cap->timestamps[cap->count] =
+			data->timestamp +
+			util_mul_div64(i, 1000000000ULL, SAMPLE_RATE);
+		cap->levels[cap->count] = samples[i];
+		cap->count++;
+	}
+	pthread_mutex_unlock(&cap->mutex);
+
+	UNUSED_PARAMETER(source);
+	UNUSED_PARAMETER(muted);
+}
+
+static bool find_bus(void *param, obs_source_t *source)
+{
+	obs_source_t **bus = param;
+
+	if (strcmp(obs_source_get_name(source), "Audio monitoring bus") == 0) {
+		*bus = source;
+		return false;
+	}
+	return true;
+}
+
+/* distance of ts to the closest pulse of a source whose pulses start at
+ * start */
+static uint64_t pulse_error(uint64_t ts, uint64_t start)
+{
+	const uint64_t interval =
+		util_mul_div64(PULSE_INTERVAL, 1000000000ULL, SAMPLE_RATE);
+	uint64_t phase = (ts - start) % interval;
+
+	return phase < interval - phase ? phase : interval - phase;
+}
+
+static void monitoring_bus_timestamp_test(void **state)
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = SAMPLE_RATE,
+		.speakers = SPEAKERS_STEREO,
+	};
+	struct obs_audio_monitoring_bus_stats stats;
+	struct capture *cap = bzalloc(sizeof(*cap));
+	struct feeder feeder = {0};
+	obs_source_t *bus = NULL;
+	size_t on_time = 0, offset = 0;
+
+	assert_true(obs_startup("en-US", NULL, NULL));
+	assert_true(obs_reset_audio(&oai));
+	obs_register_source(&test_source_info);
+
+	obs_set_audio_monitoring_bus_enabled(true);
+	assert_true(obs_audio_monitoring_bus_enabled());
+
+	obs_enum_all_sources(find_bus, &bus);
+	assert_non_null(bus);
+
+	pthread_mutex_init(&cap->mutex, NULL);
+	obs_source_add_audio_capture_callback(bus, capture_bus, cap);
+
+	for (size_t i = 0; i < SOURCE_COUNT; i++) {
+		obs_source_t *source = obs_source_create(
+			"test_monitoring_bus_source", "monitored", NULL, NULL);
+		assert_non_null(source);
+
+		obs_source_set_monitoring_type(
+			source, OBS_MONITORING_TYPE_MONITOR_ONLY);
+		obs_set_output_source((uint32_t)i, source);
+		feeder.sources[i] = source;
+	}
+	obs_source_set_sync_offset(feeder.sources[SOURCE_SYNC_OFFSET],
+				   SYNC_OFFSET);
+
+	/* some time ahead, so the pulses don't start in a window that is
+	 * being mixed already */
+	feeder.start = os_gettime_ns() + 100000000ULL;
+	os_event_init(&feeder.stop, OS_EVENT_TYPE_MANUAL);
+	pthread_create(&feeder.thread, NULL, feeder_thread, &feeder);
+
+	os_sleep_ms(RUN_TIME_MS);
+
+	os_event_signal(feeder.stop);
+	pthread_join(feeder.thread, NULL);
+	os_event_destroy(feeder.stop);
+
+	assert_true(obs_get_audio_monitoring_bus_stats(&stats));
+	assert_int_equal(stats.inputs, SOURCE_COUNT);
+
+	obs_source_remove_audio_capture_callback(bus, capture_bus, cap);
+
+	/* every pulse is output at its timestamp plus the sync offset of its
+	 * source, and the late source is never heard */
+	pthread_mutex_lock(&cap->mutex);
+	assert_true(cap->packets > 0);
+	for (size_t i = 0; i < cap->count; i++) {
+		uint64_t ts = cap->timestamps[i];
+
+		if (cap->levels[i] == levels[SOURCE_ON_TIME]) {
+			assert_true(pulse_error(ts, feeder.start) <=
+				    TOLERANCE_NS);
+			on_time++;
+		} else if (cap->levels[i] == levels[SOURCE_SYNC_OFFSET]) {
+			assert_true(pulse_error(ts, feeder.start +
+							    SYNC_OFFSET) <=
+				    TOLERANCE_NS);
+			offset++;
+		} else {
+			fail_msg("unexpected level %f", cap->levels[i]);
+		}
+	}
+	pthread_mutex_unlock(&cap->mutex);
+
+	assert_true(on_time > 0);
+	assert_true(offset > 0);
+	assert_true(stats.dropped_frames > 0);
+
+	for (size_t i = 0; i < SOURCE_COUNT; i++) {
+		obs_set_output_source((uint32_t)i, NULL);
+		obs_source_release(feeder.sources[i]);
+	}
+	obs_set_audio_monitoring_bus_enabled(false);
+	obs_shutdown();
+
+	pthread_mutex_destroy(&cap->mutex);
+	bfree(cap);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(monitoring_bus_timestamp_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
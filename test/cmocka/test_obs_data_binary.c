@@ -0,0 +1,65 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <util/array-serializer.h>
+
+#include "obs-data-fixtures.h"
+
+static void obs_data_binary_round_trip_test(void **state)
+{
+	obs_data_t *data = create_collection(10);
+	struct array_output_data output;
+	struct array_input_data input;
+	struct serializer s;
+	obs_data_t *loaded;
+	char *json;
+
+	obs_data_set_int(data, "min", INT64_MIN);
+	obs_data_set_int(data, "max", INT64_MAX);
+	obs_data_set_double(data, "double", -0.1);
+	obs_data_set_string(data, "empty", "");
+	obs_data_set_obj(data, "empty_obj", NULL);
+
+	/* defaults aren't stored, same as with JSON */
+	obs_data_set_default_string(data, "default", "value");
+
+	array_output_serializer_init(&s, &output);
+	assert_true(obs_data_write_binary(data, &s));
+
+	/* repeated names and values are only stored once */
+	json = bstrdup(obs_data_get_json(data));
+	assert_true(output.bytes.num < strlen(json) / 3);
+
+	array_input_serializer_init(&s, &input, output.bytes.array,
+				    output.bytes.num);
+	loaded = obs_data_create_from_binary(&s);
+	assert_non_null(loaded);
+	assert_int_equal(input.pos, output.bytes.num);
+
+	assert_string_equal(obs_data_get_json(loaded), json);
+	assert_int_equal(obs_data_get_int(loaded, "min"), INT64_MIN);
+	assert_false(obs_data_has_user_value(loaded, "default"));
+
+	/* truncated data is rejected */
+	for (size_t i = 0; i < output.bytes.num; i += 7) {
+		array_input_serializer_init(&s, &input, output.bytes.array, i);
+		assert_null(obs_data_create_from_binary(&s));
+	}
+
+	bfree(json);
+	obs_data_release(loaded);
+	obs_data_release(data);
+	array_output_serializer_free(&output);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(obs_data_binary_round_trip_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,146 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "obs-data-jansson.h"
+
+static const char *valid_json[] = {
+	"{}",
+	" \r\n\t{ \"a\" : 1 } \n",
+	"[1, {\"a\": 2}]",
+	"{\"s\": \"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u00e9\\ud83d\\ude00\"}",
+	"{\"utf8\": \"\xc3\xa9\xe2\x9c\x93\xf0\x9f\x98\x80\", \"\\u00fc\": 1}",
+	"{\"min\": -9223372036854775808, \"max\": 9223372036854775807}",
+	"{\"d\": [1.5e3, -0.25, 0.0, 1E-400, 2.5e+2]}",
+	"{\"n\": [0, -0, 10]}",
+	"{\"t\": true, \"f\": false, \"null\": null}",
+	"{\"z\": 1, \"y\": {\"b\": [], \"a\": {}}, \"x\": \"\"}",
+	"{\"arr\": [{\"x\": 1}, 2, \"s\", [{\"y\": 1}], null, {}]}",
+	"{\"nested\": [[[{\"a\": [{\"b\": {\"c\": 1}}]}]]]}",
+};
+
+static const char *invalid_json[] = {
+	"",
+	"   ",
+	"\"str\"",
+	"1",
+	"{",
+	"{\"a\"}",
+	"{\"a\" 1}",
+	"{\"a\": 1,}",
+	"{\"a\": 1 \"b\": 2}",
+	"{a: 1}",
+	"{\"a\": [1,]}",
+	"{\"a\": [1 2]}",
+	"{\"a\": 01}",
+	"{\"a\": 1.}",
+	"{\"a\": .5}",
+	"{\"a\": 1e}",
+	"{\"a\": +1}",
+	"{\"a\": -}",
+	"{\"a\": 99999999999999999999}",
+	"{\"a\": 1e999}",
+	"{\"a\": tru}",
+	"{\"a\": nul}",
+	"{\"a\": \"x}",
+	"{\"a\": \"\\x\"}",
+	"{\"a\": \"\\u00g0\"}",
+	"{\"a\": \"\\u0000\"}",
+	"{\"a\": \"\\ud800\"}",
+	"{\"a\": \"\\udc00\"}",
+	"{\"a\": \"\x01\"}",
+	"{\"a\": \"\xc0\xaf\"}",
+	"{\"a\": \"\xed\xa0\x80\"}",
+	"{\"a\": \"\xe2\x9c\"}",
+	"{\"a\": 1, \"a\": 2}",
+	"{\"b\": 1, \"a\": 2, \"b\": 3}",
+	"{} x",
+	"{}}",
+	"\xef\xbb{}",
+};
+
+static void obs_data_json_parse_test(void **state)
+{
+	for (size_t i = 0; i < sizeof(valid_json) / sizeof(*valid_json); i++) {
+		obs_data_t *expected = jansson_create_from_json(valid_json[i]);
+		obs_data_t *data = obs_data_create_from_json(valid_json[i]);
+
+		assert_non_null(expected);
+		assert_non_null(data);
+		assert_string_equal(obs_data_get_json(data),
+				    obs_data_get_json(expected));
+
+		obs_data_release(expected);
+		obs_data_release(data);
+	}
+
+	for (size_t i = 0; i < sizeof(invalid_json) / sizeof(*invalid_json);
+	     i++) {
+		assert_null(jansson_create_from_json(invalid_json[i]));
+		assert_null(obs_data_create_from_json(invalid_json[i]));
+	}
+
+	/* items are sorted by name, like when they're set */
+	obs_data_t *data = obs_data_create_from_json(
+		"{\"b\": 1, \"c\": {\"s\": \"\\u00e9\"}, \"a\": -1.5}");
+	obs_data_item_t *item = obs_data_first(data);
+	obs_data_t *obj = obs_data_get_obj(data, "c");
+
+	assert_string_equal(obs_data_item_get_name(item), "a");
+	assert_true(obs_data_item_numtype(item) == OBS_DATA_NUM_DOUBLE);
+	obs_data_item_next(&item);
+	assert_string_equal(obs_data_item_get_name(item), "b");
+	assert_true(obs_data_item_numtype(item) == OBS_DATA_NUM_INT);
+	obs_data_item_next(&item);
+	assert_string_equal(obs_data_item_get_name(item), "c");
+	obs_data_item_next(&item);
+	assert_null(item);
+
+	assert_string_equal(obs_data_get_string(obj, "s"), "\xc3\xa9");
+	assert_int_equal(obs_data_get_int(data, "b"), 1);
+
+	obs_data_release(obj);
+	obs_data_release(data);
+}
+
+static obs_data_t *create_nested(size_t depth)
+{
+	char *json = bzalloc(depth * 6 + 2);
+	obs_data_t *data;
+
+	for (size_t i = 0; i < depth; i++)
+		memcpy(json + i * 5, "{\"a\":", 5);
+	json[depth * 5] = '1';
+	memset(json + depth * 5 + 1, '}', depth);
+
+	data = obs_data_create_from_json(json);
+	bfree(json);
+	return data;
+}
+
+static void obs_data_json_misc_test(void **state)
+{
+	obs_data_t *data;
+
+	data = create_nested(2000);
+	assert_non_null(data);
+	obs_data_release(data);
+
+	assert_null(create_nested(3000));
+
+	/* a byte order mark is skipped */
+	data = obs_data_create_from_json("\xef\xbb\xbf{\"bom\": true}");
+	assert_true(obs_data_get_bool(data, "bom"));
+	obs_data_release(data);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(obs_data_json_parse_test),
+		cmocka_unit_test(obs_data_json_misc_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
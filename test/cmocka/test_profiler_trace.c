@@ -0,0 +1,148 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/profiler.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+static const char *thread_root = "trace_test_thread";
+static const char *thread_child = "trace_test \"child\"";
+
+static void *trace_thread(void *param)
+{
+	for (int i = 0; i < 10; i++) {
+		profile_start(thread_root);
+		profile_start(thread_child);
+		profile_end(thread_child);
+		profile_end(thread_root);
+	}
+
+	UNUSED_PARAMETER(param);
+	return NULL;
+}
+
+static size_t count_str(const char *str, const char *find)
+{
+	size_t count = 0;
+
+	while ((str = strstr(str, find)) != NULL) {
+		count++;
+		str += strlen(find);
+	}
+
+	return count;
+}
+
+static void profiler_trace_record_test(void **state)
+{
+	const char *path = "profiler_trace_test.json";
+	const char *root = "trace_test_main";
+	pthread_t thread;
+	char *json;
+
+	/* nothing is recorded before the trace is started */
+	profile_start(root);
+	profile_end(root);
+
+	profiler_trace_start(0);
+	assert_true(profiler_trace_active());
+
+	profile_start(root);
+	profiler_trace_counter("trace_test_counter", -42);
+	profile_end(root);
+
+	assert_int_equal(pthread_create(&thread, NULL, trace_thread, NULL), 0);
+	pthread_join(thread, NULL);
+
+	profiler_trace_stop();
+	assert_false(profiler_trace_active());
+
+	/* or after it was stopped */
+	profile_start(root);
+	profile_end(root);
+
+	assert_true(profiler_trace_dump_json(path));
+	json = os_quick_read_utf8_file(path);
+	os_unlink(path);
+	assert_non_null(json);
+
+	assert_int_equal(count_str(json, "\"ph\":\"B\""), 21);
+	assert_int_equal(count_str(json, "\"ph\":\"E\""), 21);
+	assert_int_equal(count_str(json, "\"name\":\"trace_test_main\""), 2);
+	assert_int_equal(count_str(json, "trace_test \\\"child\\\""), 10);
+	assert_non_null(strstr(json, "\"name\":\"trace_test_counter\","));
+	assert_non_null(strstr(json, "\"args\":{\"value\":-42}"));
+	assert_non_null(
+		strstr(json, "\"args\":{\"name\":\"trace_test_thread\"}"));
+
+	bfree(json);
+}
+
+static void profiler_trace_duration_test(void **state)
+{
+	const char *path = "profiler_trace_test.json";
+	char *json;
+
+	profiler_trace_start(1);
+	profiler_trace_counter("trace_test_counter", 1);
+	os_sleep_ms(1100);
+	profiler_trace_counter("trace_test_counter", 2);
+	assert_false(profiler_trace_active());
+
+	/* a new recording discards the previous one */
+	assert_true(profiler_trace_dump_json(path));
+	json = os_quick_read_utf8_file(path);
+	os_unlink(path);
+	assert_non_null(json);
+
+	assert_int_equal(count_str(json, "\"ph\":\"B\""), 0);
+	assert_int_equal(count_str(json, "\"ph\":\"C\""), 1);
+	assert_non_null(strstr(json, "\"args\":{\"value\":1}"));
+
+	profiler_trace_stop();
+	bfree(json);
+}
+
+static void profiler_trace_thread_exit_test(void **state)
+{
+	pthread_t thread;
+	long allocs;
+
+	profiler_trace_start(0);
+	allocs = bnum_allocs();
+
+	/* the buffer of an exited thread is kept for the dump of the current
+	 * recording, and freed when the next one starts */
+	for (int i = 0; i < 32; i++) {
+		assert_int_equal(
+			pthread_create(&thread, NULL, trace_thread, NULL), 0);
+		pthread_join(thread, NULL);
+		assert_int_equal(bnum_allocs(), allocs + 1);
+
+		profiler_trace_start(0);
+		assert_int_equal(bnum_allocs(), allocs);
+	}
+
+	profiler_trace_stop();
+
+	/* threads don't allocate anything outside of a recording */
+	assert_int_equal(pthread_create(&thread, NULL, trace_thread, NULL), 0);
+	pthread_join(thread, NULL);
+	assert_int_equal(bnum_allocs(), allocs);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(profiler_trace_record_test),
+		cmocka_unit_test(profiler_trace_duration_test),
+		cmocka_unit_test(profiler_trace_thread_exit_test),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	profiler_free();
+	return ret;
+}
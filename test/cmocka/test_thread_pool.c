@@ -0,0 +1,225 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/thread-pool.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+static void count_task(void *param)
+{
+	os_atomic_inc_long(param);
+}
+
+struct inside_data {
+	os_thread_pool_t *pool;
+	os_event_t *event;
+	bool inside;
+};
+
+static void inside_task(void *param)
+{
+	struct inside_data *data = param;
+
+	data->inside = os_thread_pool_inside(data->pool);
+	os_event_signal(data->event);
+}
+
+static void thread_pool_basic_test(void **state)
+{
+	struct os_thread_pool_info info = {.threads = 4};
+	os_thread_pool_t *pool = os_thread_pool_create(&info);
+	os_task_group_t *group = os_task_group_create();
+	struct inside_data inside = {pool};
+	volatile long count = 0;
+
+	assert_non_null(pool);
+	assert_non_null(group);
+	assert_int_equal(os_thread_pool_num_threads(pool), 4);
+	assert_true(os_task_group_done(group));
+
+	for (int i = 0; i < 10000; i++)
+		assert_true(os_thread_pool_submit(pool,
+						  OS_TASK_PRIORITY_NORMAL,
+						  count_task, (void *)&count,
+						  group));
+
+	os_task_group_wait(pool, group);
+	assert_true(os_task_group_done(group));
+	assert_int_equal(count, 10000);
+
+	/* groups can be reused once done */
+	for (int i = 0; i < 100; i++)
+		os_thread_pool_submit(pool, OS_TASK_PRIORITY_REALTIME,
+				      count_task, (void *)&count, group);
+	os_task_group_wait(pool, group);
+	assert_int_equal(count, 10100);
+
+	assert_false(os_thread_pool_submit(pool, OS_TASK_PRIORITY_NORMAL, NULL,
+					   NULL, NULL));
+
+	os_event_init(&inside.event, OS_EVENT_TYPE_AUTO);
+	os_thread_pool_submit(pool, OS_TASK_PRIORITY_NORMAL, inside_task,
+			      &inside, NULL);
+	os_event_wait(inside.event);
+	os_event_destroy(inside.event);
+	assert_true(inside.inside);
+	assert_false(os_thread_pool_inside(pool));
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(pool);
+}
+
+/* ------------------------------------------------------------------------- */
+/* tasks that split themselves up and wait for their halves from inside the
+ * pool */
+
+struct range_sum {
+	os_thread_pool_t *pool;
+	long begin;
+	long end;
+	long sum;
+};
+
+static void range_sum_task(void *param)
+{
+	struct range_sum *range = param;
+	long mid = (range->begin + range->end) / 2;
+
+	if (range->end - range->begin <= 16) {
+		for (long i = range->begin; i < range->end; i++)
+			range->sum += i;
+		return;
+	}
+
+	struct range_sum left = {range->pool, range->begin, mid};
+	struct range_sum right = {range->pool, mid, range->end};
+	os_task_group_t *group = os_task_group_create();
+
+	os_thread_pool_submit(range->pool, OS_TASK_PRIORITY_NORMAL,
+			      range_sum_task, &left, group);
+	os_thread_pool_submit(range->pool, OS_TASK_PRIORITY_NORMAL,
+			      range_sum_task, &right, group);
+	os_task_group_wait(range->pool, group);
+	os_task_group_destroy(group);
+
+	range->sum = left.sum + right.sum;
+}
+
+static void thread_pool_nested_test(void **state)
+{
+	struct os_thread_pool_info info = {.threads = 2};
+	os_thread_pool_t *pool = os_thread_pool_create(&info);
+	os_task_group_t *group = os_task_group_create();
+	struct range_sum range = {pool, 0, 100000};
+	struct os_thread_pool_stats stats;
+	uint64_t tasks = 0;
+
+	assert_false(os_thread_pool_inside(pool));
+
+	os_thread_pool_submit(pool, OS_TASK_PRIORITY_NORMAL, range_sum_task,
+			      &range, group);
+	os_task_group_wait(pool, group);
+	assert_int_equal(range.sum, 100000L * 99999L / 2);
+
+	for (size_t i = 0; i < os_thread_pool_num_threads(pool); i++) {
+		assert_true(os_thread_pool_get_stats(pool, i, &stats));
+		assert_true(stats.busy_ns <= stats.total_ns);
+		tasks += stats.tasks;
+	}
+	assert_false(os_thread_pool_get_stats(pool, 2, &stats));
+
+	assert_true(tasks > 0);
+
+	os_task_group_destroy(group);
+	os_thread_pool_destroy(pool);
+}
+
+/* ------------------------------------------------------------------------- */
+/* background tasks can't block real-time tasks */
+
+struct blocking_data {
+	volatile bool release;
+	volatile long running;
+	volatile long max_running;
+	volatile long finished;
+};
+
+static void blocking_task(void *param)
+{
+	struct blocking_data *data = param;
+	long running = os_atomic_inc_long(&data->running);
+	long max = os_atomic_load_long(&data->max_running);
+
+	while (running > max &&
+	       !os_atomic_compare_exchange_long(&data->max_running, &max,
+						running))
+		;
+
+	while (!os_atomic_load_bool(&data->release))
+		os_sleep_ms(1);
+	os_atomic_dec_long(&data->running);
+	os_atomic_inc_long(&data->finished);
+}
+
+static void thread_pool_priority_test(void **state)
+{
+	struct os_thread_pool_info info = {.threads = 3};
+	os_thread_pool_t *pool = os_thread_pool_create(&info);
+	os_task_group_t *background = os_task_group_create();
+	os_task_group_t *realtime = os_task_group_create();
+	struct blocking_data data = {0};
+	volatile long count = 0;
+
+	for (int i = 0; i < 8; i++)
+		os_thread_pool_submit(pool, OS_TASK_PRIORITY_BACKGROUND,
+				      blocking_task, &data, background);
+
+	for (int i = 0; i < 100; i++)
+		os_thread_pool_submit(pool, OS_TASK_PRIORITY_REALTIME,
+				      count_task, (void *)&count, realtime);
+
+	/* completes while the background tasks are all blocked */
+	os_task_group_wait(pool, realtime);
+	assert_int_equal(count, 100);
+	assert_int_equal(os_atomic_load_long(&data.finished), 0);
+	assert_false(os_task_group_done(background));
+
+	os_atomic_set_bool(&data.release, true);
+	os_task_group_wait(pool, background);
+	assert_int_equal(data.finished, 8);
+	assert_true(data.max_running <= 2);
+
+	os_task_group_destroy(realtime);
+	os_task_group_destroy(background);
+	os_thread_pool_destroy(pool);
+}
+
+static void thread_pool_destroy_test(void **state)
+{
+	struct os_thread_pool_info info = {.threads = 3,
+					   .background_threads = 1};
+	os_thread_pool_t *pool = os_thread_pool_create(&info);
+	volatile long count = 0;
+
+	for (int i = 0; i < 1000; i++)
+		os_thread_pool_submit(pool, (enum os_task_priority)(i % 3),
+				      count_task, (void *)&count, NULL);
+
+	/* all queued tasks run before the pool goes away */
+	os_thread_pool_destroy(pool);
+	assert_int_equal(count, 1000);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(thread_pool_basic_test),
+		cmocka_unit_test(thread_pool_nested_test),
+		cmocka_unit_test(thread_pool_priority_test),
+		cmocka_unit_test(thread_pool_destroy_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
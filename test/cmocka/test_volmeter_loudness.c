@@ -0,0 +1,144 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+
+#include <obs.h>
+#include <util/platform.h>
+#include <util/util_uint64.h>
+
+#define SAMPLE_RATE 48000
+#define PACKET_FRAMES 1024
+#define TONE_SECONDS 20
+
+/* EBU Tech 3341 allows +-0.1 LU for the minimum requirements */
+#define TOLERANCE 0.1f
+
+static const char *source_name(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+	return "test loudness source";
+}
+
+static void *source_create(obs_data_t *settings, obs_source_t *source)
+{
+	UNUSED_PARAMETER(settings);
+	return source;
+}
+
+static void source_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static struct obs_source_info test_source_info = {
+	.id = "test_loudness_source",
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_AUDIO,
+	.get_name = source_name,
+	.create = source_create,
+	.destroy = source_destroy,
+};
+
+static void loudness_updated(void *param,
+			     const struct obs_volmeter_loudness *loudness)
+{
+	size_t *updates = param;
+	(*updates)++;
+
+	UNUSED_PARAMETER(loudness);
+}
+
+/* stereo 997 Hz sine with each channel at level_db dBFS, which measures at
+ * level_db LUFS (EBU Tech 3341 test cases 1 and 2) */
+static void output_tone(obs_source_t *source, float level_db)
+{
+	const double amplitude = pow(10.0, level_db / 20.0);
+	const uint64_t start = os_gettime_ns();
+	float buf[PACKET_FRAMES];
+	uint64_t frame = 0;
+
+	while (frame < (uint64_t)TONE_SECONDS * SAMPLE_RATE) {
+		struct obs_source_audio audio = {
+			.data = {(uint8_t *)buf, (uint8_t *)buf},
+			.frames = PACKET_FRAMES,
+			.speakers = SPEAKERS_STEREO,
+			.format = AUDIO_FORMAT_FLOAT_PLANAR,
+			.samples_per_sec = SAMPLE_RATE,
+			.timestamp = start + util_mul_div64(frame,
+							    1000000000ULL,
+							    SAMPLE_RATE),
+		};
+
+		for (size_t i = 0; i < PACKET_FRAMES; i++, frame++)
+			buf[i] = (float)(amplitude *
+					 sin(2.0 * M_PI * 997.0 *
+					     (double)frame / SAMPLE_RATE));
+
+		obs_source_output_audio(source, &audio);
+	}
+}
+
+static void check_tone(obs_volmeter_t *volmeter, obs_source_t *source,
+		       float level_db)
+{
+	struct obs_volmeter_loudness loudness;
+	size_t updates = 0;
+
+	obs_volmeter_add_loudness_callback(volmeter, loudness_updated,
+					   &updates);
+	output_tone(source, level_db);
+	assert_true(obs_volmeter_get_loudness(volmeter, &loudness));
+	obs_volmeter_remove_loudness_callback(volmeter, loudness_updated,
+					      &updates);
+
+	/* one update per 100 ms block */
+	assert_int_equal(updates, TONE_SECONDS * 10);
+
+	assert_true(fabsf(loudness.momentary - level_db) <= TOLERANCE);
+	assert_true(fabsf(loudness.short_term - level_db) <= TOLERANCE);
+	assert_true(fabsf(loudness.integrated - level_db) <= TOLERANCE);
+}
+
+static void loudness_reference_tone_test(void **state)
+{
+	struct obs_audio_info oai = {
+		.samples_per_sec = SAMPLE_RATE,
+		.speakers = SPEAKERS_STEREO,
+	};
+	struct obs_volmeter_loudness loudness;
+	obs_volmeter_t *volmeter;
+	obs_source_t *source;
+
+	assert_true(obs_startup("en-US", NULL, NULL));
+	assert_true(obs_reset_audio(&oai));
+
+	obs_register_source(&test_source_info);
+	source = obs_source_create("test_loudness_source", "tone", NULL, NULL);
+	assert_non_null(source);
+
+	volmeter = obs_volmeter_create(OBS_FADER_LOG);
+	assert_true(obs_volmeter_attach_source(volmeter, source));
+
+	/* not measured until someone asks for it */
+	assert_false(obs_volmeter_get_loudness(volmeter, &loudness));
+
+	check_tone(volmeter, source, -23.0f);
+	check_tone(volmeter, source, -33.0f);
+
+	obs_volmeter_detach_source(volmeter);
+	obs_volmeter_destroy(volmeter);
+	obs_source_release(source);
+	obs_shutdown();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(loudness_reference_tone_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,101 @@
+-- Compares the time spent per tick querying the state of all sources through
+-- the regular bindings and through obs_get_source_states.  Load it from
+-- Tools -> Scripts, the averages are written to the script log.
+
+obs = obslua
+
+keys        = {}
+ticks       = 0
+single_ns   = 0
+bulk_ns     = 0
+report_rate = 300
+
+----------------------------------------------------------
+
+function source_names()
+	local sources = obs.obs_enum_sources()
+	local names = {}
+	for _, source in ipairs(sources) do
+		table.insert(names, obs.obs_source_get_name(source))
+	end
+	obs.source_list_release(sources)
+	return names
+end
+
+function query_single(names)
+	local states = {}
+	for i, name in ipairs(names) do
+		local source = obs.obs_get_source_by_name(name)
+		if source == nil then
+			states[i] = false
+		else
+			local settings = obs.obs_source_get_settings(source)
+			local values = {}
+			for _, key in ipairs(keys) do
+				values[key] = obs.obs_data_get_string(settings, key)
+			end
+			obs.obs_data_release(settings)
+
+			states[i] = {
+				name = name,
+				width = obs.obs_source_get_width(source),
+				height = obs.obs_source_get_height(source),
+				active = obs.obs_source_active(source),
+				muted = obs.obs_source_muted(source),
+				volume = obs.obs_source_get_volume(source),
+				settings = values,
+			}
+			obs.obs_source_release(source)
+		end
+	end
+	return states
+end
+
+function query_bulk(names)
+	return obs.obs_get_source_states(names, keys)
+end
+
+function script_tick(seconds)
+	local names = source_names()
+
+	local start = obs.os_gettime_ns()
+	query_single(names)
+	single_ns = single_ns + (obs.os_gettime_ns() - start)
+
+	start = obs.os_gettime_ns()
+	query_bulk(names)
+	bulk_ns = bulk_ns + (obs.os_gettime_ns() - start)
+
+	ticks = ticks + 1
+	if ticks == report_rate then
+		obs.script_log(obs.LOG_INFO, string.format(
+			"%d sources: %.1f us per tick (single calls), %.1f us per tick (bulk)",
+			#names, single_ns / ticks / 1000, bulk_ns / ticks / 1000))
+		ticks = 0
+		single_ns = 0
+		bulk_ns = 0
+	end
+end
+
+----------------------------------------------------------
+
+function script_description()
+	return "Benchmarks the bulk source query API against the regular bindings."
+end
+
+function script_update(settings)
+	keys = {}
+	for key in string.gmatch(obs.obs_data_get_string(settings, "keys"), "%S+") do
+		table.insert(keys, key)
+	end
+end
+
+function script_defaults(settings)
+	obs.obs_data_set_default_string(settings, "keys", "text file url")
+end
+
+function script_properties()
+	local props = obs.obs_properties_create()
+	obs.obs_properties_add_text(props, "keys", "Settings to query (space separated)", obs.OBS_TEXT_DEFAULT)
+	return props
+end
@@ -0,0 +1,90 @@
+# Compares the time spent per tick querying the state of all sources through
+# the regular bindings and through obs_get_source_states.  Load it from
+# Tools -> Scripts, the averages are written to the script log.
+
+import obspython as obs
+import time
+
+keys        = []
+ticks       = 0
+single_ns   = 0
+bulk_ns     = 0
+report_rate = 300
+
+# ------------------------------------------------------------
+
+def source_names():
+	sources = obs.obs_enum_sources()
+	names = [obs.obs_source_get_name(source) for source in sources]
+	obs.source_list_release(sources)
+	return names
+
+def query_single(names):
+	states = []
+	for name in names:
+		source = obs.obs_get_source_by_name(name)
+		if source is None:
+			states.append(None)
+			continue
+
+		settings = obs.obs_source_get_settings(source)
+		values = {}
+		for key in keys:
+			values[key] = obs.obs_data_get_string(settings, key)
+		obs.obs_data_release(settings)
+
+		states.append({
+			"name": name,
+			"width": obs.obs_source_get_width(source),
+			"height": obs.obs_source_get_height(source),
+			"active": obs.obs_source_active(source),
+			"muted": obs.obs_source_muted(source),
+			"volume": obs.obs_source_get_volume(source),
+			"settings": values,
+		})
+		obs.obs_source_release(source)
+	return states
+
+def query_bulk(names):
+	return obs.obs_get_source_states(names, keys)
+
+def script_tick(seconds):
+	global ticks
+	global single_ns
+	global bulk_ns
+
+	names = source_names()
+
+	start = time.perf_counter_ns()
+	query_single(names)
+	single_ns += time.perf_counter_ns() - start
+
+	start = time.perf_counter_ns()
+	query_bulk(names)
+	bulk_ns += time.perf_counter_ns() - start
+
+	ticks += 1
+	if ticks == report_rate:
+		obs.script_log(obs.LOG_INFO,
+			"%d sources: %.1f us per tick (single calls), %.1f us per tick (bulk)" %
+			(len(names), single_ns / ticks / 1000, bulk_ns / ticks / 1000))
+		ticks = 0
+		single_ns = 0
+		bulk_ns = 0
+
+# ------------------------------------------------------------
+
+def script_description():
+	return "Benchmarks the bulk source query API against the regular bindings."
+
+def script_update(settings):
+	global keys
+	keys = obs.obs_data_get_string(settings, "keys").split()
+
+def script_defaults(settings):
+	obs.obs_data_set_default_string(settings, "keys", "text file url")
+
+def script_properties():
+	props = obs.obs_properties_create()
+	obs.obs_properties_add_text(props, "keys", "Settings to query (space separated)", obs.OBS_TEXT_DEFAULT)
+	return props